@@ -28,6 +28,8 @@
 #include "pluginterfaces/vst/ivstevents.h"
 #include "pluginterfaces/vst/ivstparameterchanges.h"
 
+#include "../../common/dsp/denormal.hpp"
+
 namespace Steinberg {
 namespace Synth {
 
@@ -83,6 +85,8 @@ tresult PLUGIN_API PlugProcessor::setActive(TBool state)
 
 tresult PLUGIN_API PlugProcessor::process(Vst::ProcessData &data)
 {
+  SomeDSP::ScopedNoDenormals noDenormals;
+
   using ID = ParameterID::ID;
 
   // Read inputs parameter changes.
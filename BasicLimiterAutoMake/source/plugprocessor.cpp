@@ -28,6 +28,8 @@
 #include "pluginterfaces/vst/ivstevents.h"
 #include "pluginterfaces/vst/ivstparameterchanges.h"
 
+#include "../../common/dsp/denormal.hpp"
+
 namespace Steinberg {
 namespace Synth {
 
@@ -85,6 +87,8 @@ uint32 PLUGIN_API PlugProcessor::getLatencySamples() { return uint32(dsp.getLate
 
 tresult PLUGIN_API PlugProcessor::process(Vst::ProcessData &data)
 {
+  SomeDSP::ScopedNoDenormals noDenormals;
+
   using ID = ParameterID::ID;
 
   // Read inputs parameter changes.
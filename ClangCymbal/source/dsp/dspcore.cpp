@@ -58,10 +58,49 @@ Note::Note()
   }
 }
 
+/**
+Longest FDN delay time of each line for the next note. The lowest frequency is
+`fdnFreqOffset` in `ASSIGN_FILTER_PARAMETER` at MIDI note 0, with the lowest modulation.
+
+`noteOn()` draws `overtoneRandomness` from `rng` first, so a copy of `rng` gives the same
+values. It's only valid while resting, because `pulsar` also draws from `rng`.
+*/
+std::array<float, fdnMatrixSize>
+Note::longestFdnDelayTime(float sampleRate, GlobalParameter &param)
+{
+  using ID = ParameterID::ID;
+  auto &pv = param.value;
+
+  auto eqTemp = pv[ID::equalTemperament]->getFloat() + float(1);
+  auto semitone = int_fast32_t(pv[ID::semitone]->getInt()) - 120;
+  auto octave = int_fast32_t(pv[ID::octave]->getInt()) - 12;
+  auto milli = float(0.001) * (int_fast32_t(pv[ID::milli]->getInt()) - 1000);
+  auto a4Hz = pv[ID::pitchA4Hz]->getFloat() + float(100);
+  auto pitchBend = pv[ID::pitchBendRange]->getFloat() * pv[ID::pitchBend]->getFloat();
+  auto modenvToPitch = std::min(float(0), pv[ID::modEnvelopeToFdnPitch]->getFloat());
+  auto lowestPitch = eqTemp * octave + semitone + milli + pitchBend + modenvToPitch;
+  auto lowestFreq = a4Hz * calcNotePitch(lowestPitch, eqTemp);
+
+  // `Reset to 0` slides up from 0 Hz.
+  if (pv[ID::slideType]->getInt() == 2) lowestFreq = 0;
+
+  auto peek = rng;
+  std::uniform_real_distribution<float> overtoneDist(-1.0, 1.0);
+  std::array<float, fdnMatrixSize> randomness;
+  for (auto &value : randomness) {
+    value = overtoneDist(peek) * pv[ID::fdnOvertoneRandomness]->getFloat();
+  }
+
+  return longestDelayTime<float, fdnMatrixSize>(
+    sampleRate, lowestFreq, pv[ID::fdnOvertoneOffset]->getFloat(),
+    pv[ID::fdnOvertoneMul]->getFloat(), pv[ID::fdnOvertoneAdd]->getFloat(),
+    pv[ID::fdnOvertoneModulo]->getFloat(), randomness);
+}
+
 void Note::setup(float sampleRate)
 {
   oscEnvelopeSmoother.setCutoff(sampleRate, float(4000));
-  fdn.setup(sampleRate, maxDelayTime);
+  fdn.setup(sampleRate);
   tremolo.setup(sampleRate, float(Scales::tremoloDelayTime.getMax()));
 }
 
@@ -82,6 +121,9 @@ void DSPCore::setup(double sampleRate)
 
   reset();
 
+  // After `reset()` which seeds the random number generator of `note`.
+  note.setupDelay(upRate, param);
+
   isInitialized = true;
 }
 
@@ -285,6 +327,22 @@ void Note::setParameters(float sampleRate, GlobalParameter &param)
       : float(1) / gateAttackSecond);
 }
 
+void Note::setupDelay(float sampleRate, GlobalParameter &param)
+{
+  fdn.delay.setup(sampleRate, maxDelayTime, longestFdnDelayTime(sampleRate, param));
+}
+
+/**
+Grows FDN delay lines at the start of next `DSPCore::process()`. While a note is
+playing, `fdn.delay.setDelayTimeAt()` reserves the delay time instead. Then a note-on
+without reset may clamp the delay time for a moment until the lines are grown.
+*/
+void Note::reserveDelay(float sampleRate, GlobalParameter &param)
+{
+  auto longest = longestFdnDelayTime(sampleRate, param);
+  for (size_t idx = 0; idx < fdnMatrixSize; ++idx) fdn.delay.reserve(idx, longest[idx]);
+}
+
 void DSPCore::setParameters()
 {
   using ID = ParameterID::ID;
@@ -292,7 +350,11 @@ void DSPCore::setParameters()
 
   ASSIGN_PARAMETER(push);
 
-  if (note.state != NoteState::rest) note.setParameters(upRate, param);
+  if (note.state == NoteState::rest) {
+    note.reserveDelay(upRate, param);
+  } else {
+    note.setParameters(upRate, param);
+  }
 }
 
 inline float alignModValue(float amount, float alignment, float value)
@@ -403,6 +465,8 @@ void DSPCore::process(const size_t length, float *out0, float *out1)
   SmootherCommon<float>::setTime(pv[ID::commonSmoothingTimeSecond]->getFloat());
   SmootherCommon<float>::setBufferSize(float(length));
 
+  note.updateBuffer();
+
   bool overSampling = pv[ID::overSampling]->getInt();
 
   for (size_t i = 0; i < length; ++i) {
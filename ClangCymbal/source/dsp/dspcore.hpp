@@ -18,6 +18,7 @@
 #pragma once
 
 #include "../../../common/dsp/constants.hpp"
+#include "../../../common/dsp/eventring.hpp"
 #include "../../../common/dsp/multirate.hpp"
 #include "../../../common/dsp/smoother.hpp"
 #include "../../../lib/pcg-cpp/pcg_random.hpp"
@@ -45,6 +46,9 @@ private:
   pcg64 rng;
   std::vector<std::vector<float>> fdnMatrixRandomBase;
 
+  std::array<float, fdnMatrixSize>
+  longestFdnDelayTime(float sampleRate, GlobalParameter &param);
+
   ExpSmoother<float> modEnvelopeToFdnPitch;
   ExpSmoother<float> modEnvelopeToFdnOvertoneAdd;
   ExpSmoother<float> modEnvelopeToOscJitter;
@@ -94,8 +98,11 @@ public:
 
   Note();
   void setup(float sampleRate);
+  void setupDelay(float sampleRate, GlobalParameter &param);
   void reset(float sampleRate, GlobalParameter &param);
   void setParameters(float sampleRate, GlobalParameter &param);
+  void reserveDelay(float sampleRate, GlobalParameter &param);
+  void updateBuffer() { fdn.delay.updateBuffer(); }
   void noteOn(
     int_fast32_t noteId,
     float notePitch,
@@ -134,7 +141,7 @@ public:
     float velocity;
   };
 
-  std::vector<MidiNote> midiNotes;
+  MidiEventRing<MidiNote> midiNotes;
 
   void pushMidiNote(
     bool isNoteOn,
@@ -151,22 +158,17 @@ public:
     note.pitch = pitch;
     note.tuning = tuning;
     note.velocity = velocityMap.map(velocity);
-    midiNotes.push_back(note);
+    midiNotes.push(note);
   }
 
   void processMidiNote(size_t frame)
   {
-    while (true) {
-      auto it = std::find_if(midiNotes.begin(), midiNotes.end(), [&](const MidiNote &nt) {
-        return nt.frame == frame;
-      });
-      if (it == std::end(midiNotes)) return;
-      if (it->isNoteOn)
-        noteOn(it->id, it->pitch, it->tuning, it->velocity);
+    midiNotes.dispatch(frame, [&](MidiNote &note) {
+      if (note.isNoteOn)
+        noteOn(note.id, note.pitch, note.tuning, note.velocity);
       else
-        noteOff(it->id);
-      midiNotes.erase(it);
-    }
+        noteOff(note.id);
+    });
   }
 
 private:
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include "../../../common/dsp/bufferallocator.hpp"
 #include "../../../common/dsp/constants.hpp"
 #include "../../../common/dsp/smoother.hpp"
 #include "../../../lib/pcg-cpp/pcg_random.hpp"
@@ -24,8 +25,11 @@
 
 #include <algorithm>
 #include <array>
+#include <limits>
 #include <numeric>
 #include <random>
+#include <utility>
+#include <vector>
 
 namespace SomeDSP {
 
@@ -65,20 +69,78 @@ public:
   }
 };
 
+/**
+Returns the longest delay time in samples of each line, for notes at or above
+`lowestFreq`. `randomness` is the overtone randomness of each line. The overtone goes
+lower only by `modulo`, which wraps it to 0. Modulation adds positive value to it.
+*/
+template<typename Sample, size_t length>
+std::array<Sample, length> longestDelayTime(
+  Sample sampleRate,
+  Sample lowestFreq,
+  Sample offset,
+  Sample mul,
+  Sample add,
+  Sample modulo,
+  const std::array<Sample, length> &randomness)
+{
+  constexpr auto eps = std::numeric_limits<Sample>::epsilon();
+  lowestFreq = std::max(eps, lowestFreq);
+
+  std::array<Sample, length> timeInSample;
+  Sample overtone = Sample(1); // Lower bound.
+  for (size_t idx = 0; idx < length; ++idx) {
+    auto ot = std::max(eps, offset + (Sample(1) + randomness[idx]) * overtone);
+    timeInSample[idx] = sampleRate / ot / lowestFreq;
+    overtone = modulo >= eps ? Sample(0) : overtone * mul + add;
+  }
+  return timeInSample;
+}
+
+/**
+Each line is sized in `setup()` for the longest delay time that the parameters allow.
+Delay time longer than the buffer is clamped, and the line is grown by `updateBuffer()`.
+The larger buffer is allocated on a worker thread, and the history is moved to it in
+`process()` a few samples at a time. `maxTime` is the upper limit of growth.
+
+`reset()` doesn't clear buffers. Instead, samples older than the ones written after the
+last reset are read as 0. The output is same as clearing all buffers.
+*/
 template<typename Sample, size_t length> class ParallelDelay {
 public:
+  // Samples of history moved to the grown buffer for each processed sample.
+  static constexpr size_t growthRate = 4;
+
   std::array<Sample, length> targetTime{};
   std::array<Sample, length> time{};
   std::array<size_t, length> wptr{};
+  std::array<size_t, length> nWritten{};
+  std::array<size_t, length> wantSize{};
   std::array<std::vector<Sample>, length> buffer;
+  size_t maxSize = 4;
 
   Sample rate = Sample(0.25);
   Sample kp = Sample(1);
 
-  void setup(Sample sampleRate, Sample maxTime)
+private:
+  BackgroundBufferAllocator<Sample, length> allocator;
+  std::array<std::vector<Sample>, length> next; // Grown buffers.
+  std::array<RingBufferGrowth, length> growth{};
+  size_t nGrowing = 0;
+
+public:
+  void setup(Sample sampleRate, Sample maxTime, const std::array<Sample, length> &longest)
   {
-    auto size = size_t(sampleRate * maxTime) + 2;
-    for (auto &bf : buffer) bf.resize(size < 4 ? 4 : size);
+    maxSize = std::max(size_t(4), size_t(sampleRate * maxTime) + 2);
+
+    allocator.reset(next);
+    growth.fill({});
+    nGrowing = 0;
+    for (size_t idx = 0; idx < length; ++idx) {
+      wantSize[idx] = toSize(longest[idx]);
+      buffer[idx] = std::vector<Sample>(wantSize[idx], Sample(0));
+    }
+    wptr.fill(0);
 
     reset();
   }
@@ -87,7 +149,40 @@ public:
   {
     targetTime.fill(timeInSample);
     time.fill(timeInSample);
-    for (auto &bf : buffer) std::fill(bf.begin(), bf.end(), Sample(0));
+    nWritten.fill(0);
+  }
+
+  // Grows the line in `updateBuffer()` if it's shorter than `timeInSample`.
+  void reserve(size_t index, Sample timeInSample)
+  {
+    wantSize[index] = std::max(wantSize[index], toSize(timeInSample));
+  }
+
+  // Called once per block from audio thread.
+  void updateBuffer()
+  {
+    if (nGrowing > 0) return;
+
+    if (allocator.isIdle()) {
+      typename BackgroundBufferAllocator<Sample, length>::Sizes size{};
+      bool isShort = false;
+      for (size_t idx = 0; idx < length; ++idx) {
+        const auto current = buffer[idx].size();
+        if (wantSize[idx] <= current) continue;
+        size[idx] = std::min(maxSize, std::max(wantSize[idx], 2 * current));
+        isShort = true;
+      }
+      if (isShort) allocator.request(size);
+    }
+
+    if (!allocator.receive(next)) return;
+    for (size_t idx = 0; idx < length; ++idx) {
+      if (next[idx].size() <= buffer[idx].size()) continue;
+      growth[idx].start(buffer[idx].size(), wptr[idx], nWritten[idx]);
+      ++nGrowing;
+      if (growth[idx].isDone()) finishGrowth(idx);
+    }
+    if (nGrowing == 0) allocator.release(next);
   }
 
   void setDelayTimeAt(size_t index, Sample sampleRate, Sample overtone, Sample noteFreq)
@@ -95,8 +190,10 @@ public:
     constexpr auto eps = std::numeric_limits<Sample>::epsilon();
     overtone = std::max(eps, overtone);
     noteFreq = std::max(eps, noteFreq);
-    targetTime[index] = std::clamp(
-      sampleRate / overtone / noteFreq, Sample(0), Sample(buffer[index].size() - 1));
+    auto timeInSample = sampleRate / overtone / noteFreq;
+    auto upper = Sample(buffer[index].size() - 1);
+    if (timeInSample > upper) reserve(index, timeInSample);
+    targetTime[index] = std::clamp(timeInSample, Sample(0), upper);
   }
 
   void resetDelayTimeAt(size_t index, Sample sampleRate, Sample overtone, Sample noteFreq)
@@ -130,13 +227,43 @@ public:
       if (rptr1 >= buf.size()) rptr1 += buf.size(); // Unsigned negative overflow case.
 
       // Write to buffer.
+      auto &gr = growth[idx];
+      if (gr.isActive) {
+        gr.copyHistory(buf.data(), next[idx].data(), 1, growthRate);
+        next[idx][gr.nextWptr] = input[idx];
+      }
       buf[wptr[idx]] = input[idx];
       if (++wptr[idx] >= buf.size()) wptr[idx] -= buf.size();
+      if (nWritten[idx] < buf.size()) ++nWritten[idx];
+
+      // Read from buffer. Samples written before `reset()` are treated as 0.
+      Sample s0 = timeInt < nWritten[idx] ? buf[rptr0] : Sample(0);
+      Sample s1 = timeInt + 1 < nWritten[idx] ? buf[rptr1] : Sample(0);
+      input[idx] = s0 + rFraction * (s1 - s0);
 
-      // Read from buffer.
-      input[idx] = buf[rptr0] + rFraction * (buf[rptr1] - buf[rptr0]);
+      if (gr.isActive) {
+        gr.advance(next[idx].size());
+        if (gr.isDone()) finishGrowth(idx);
+        if (nGrowing == 0) allocator.release(next);
+      }
     }
   }
+
+private:
+  size_t toSize(Sample timeInSample)
+  {
+    // Negated to send NaN to `maxSize`.
+    if (!(timeInSample < Sample(maxSize - 2))) return maxSize;
+    return std::max(size_t(4), size_t(std::max(Sample(0), timeInSample)) + 2);
+  }
+
+  void finishGrowth(size_t idx)
+  {
+    std::swap(buffer[idx], next[idx]);
+    wptr[idx] = growth[idx].nextWptr;
+    growth[idx].isActive = false;
+    --nGrowing;
+  }
 };
 
 template<typename Sample, size_t length> class FeedbackDelayNetwork {
@@ -199,9 +326,9 @@ public:
     }
   }
 
-  void setup(Sample sampleRate, Sample maxTime)
+  // `delay` is allocated by `delay.setup()`.
+  void setup(Sample sampleRate)
   {
-    delay.setup(sampleRate, maxTime);
 
     // Slightly below nyquist to prevent blow up.
     for (size_t idx = 0; idx < length; ++idx) {
@@ -24,6 +24,8 @@
 #include "pluginterfaces/vst/ivstevents.h"
 #include "pluginterfaces/vst/ivstparameterchanges.h"
 
+#include "../../common/dsp/denormal.hpp"
+
 #include <cstring>
 #include <iostream>
 
@@ -80,6 +82,8 @@ tresult PLUGIN_API PlugProcessor::setActive(TBool state)
 
 tresult PLUGIN_API PlugProcessor::process(Vst::ProcessData &data)
 {
+  SomeDSP::ScopedNoDenormals noDenormals;
+
   // Read inputs parameter changes.
   if (data.inputParameterChanges) {
     int32 parameterCount = data.inputParameterChanges->getParameterCount();
@@ -41,14 +41,43 @@ semitoneToHz(float notePitch, float equalTemperament = float(12), float a4Hz = f
   return a4Hz * std::exp2((notePitch - float(69)) / equalTemperament);
 }
 
+/**
+Longest FDN delay time of each line for the notes that current parameters can play.
+The lowest frequency is `fdnFreqOffset` in `NOTE_PROCESS_INFO_SMOOTHER` at MIDI note 0,
+with the lowest modulation. Unison only raises the pitch.
+*/
+inline std::array<float, fdnMatrixSize>
+longestFdnDelayTime(float sampleRate, GlobalParameter &param)
+{
+  using ID = ParameterID::ID;
+  auto &pv = param.value;
+
+  auto eqTemp = pv[ID::equalTemperament]->getFloat() + float(1);
+  auto semitone = int_fast32_t(pv[ID::semitone]->getInt()) - 120;
+  auto octave = int_fast32_t(pv[ID::octave]->getInt()) - 12;
+  auto milli = float(0.001) * (int_fast32_t(pv[ID::milli]->getInt()) - 1000);
+  auto a4Hz = pv[ID::pitchA4Hz]->getFloat() + float(100);
+  auto pitchBend = pv[ID::pitchBendRange]->getFloat() * pv[ID::pitchBend]->getFloat();
+  auto modulation = std::abs(pv[ID::modEnvelopeToFdnPitch]->getFloat())
+    + std::abs(pv[ID::lfoToFdnPitchAmount]->getFloat())
+    + float(0.5) * pv[ID::lfoToFdnPitchAlignment]->getFloat();
+  auto lowestFreq = a4Hz
+    * calcNotePitch(eqTemp * octave + semitone + milli + pitchBend - modulation, eqTemp);
+
+  return longestDelayTime<float, fdnMatrixSize>(
+    sampleRate, lowestFreq, pv[ID::fdnOvertoneOffset]->getFloat(),
+    pv[ID::fdnOvertoneMul]->getFloat(), pv[ID::fdnOvertoneAdd]->getFloat(),
+    pv[ID::fdnOvertoneModulo]->getFloat(), pv[ID::fdnOvertoneRandomness]->getFloat());
+}
+
 DSPCore::DSPCore()
 {
   unisonPan.reserve(maximumVoice);
   noteIndices.reserve(maximumVoice);
   voiceIndices.reserve(maximumVoice);
-}
 
-void Note::setup(float sampleRate) { fdn.setup(sampleRate, maxDelayTime); }
+  for (size_t idx = 0; idx < notes.size(); ++idx) notes[idx].voice = idx;
+}
 
 void DSPCore::setup(double sampleRate)
 {
@@ -63,7 +92,9 @@ void DSPCore::setup(double sampleRate)
   // 10 msec + 1 sample transition time.
   transitionBuffer.resize(1 + size_t(upRate * double(0.005)), {float(0), float(0)});
 
-  for (auto &note : notes) note.setup(upRate);
+  // `fillTransitionBuffer()` renders notes ahead by the length of `transitionBuffer`.
+  info.fdn.setup(
+    upRate, maxDelayTime, longestFdnDelayTime(upRate, param), transitionBuffer.size());
 
   reset();
 }
@@ -101,7 +132,7 @@ void Note::reset(float sampleRate, NoteProcessInfo &info, GlobalParameter &param
   modEnvelopePhase.counter = 0;
   osc.reset();
 
-  fdn.reset();
+  info.fdn.reset(voice);
   auto fdnFreq = info.fdnFreqOffset.getValue() * fdnPitch;
   SET_NOTE_FILTER_CUTOFF(reset);
 
@@ -173,9 +204,9 @@ void Note::setParameters(float sampleRate, NoteProcessInfo &info, GlobalParamete
       ? sampleRate
       : float(1) / gateAttackSecond);
 
-  fdn.delay.rate = pv[ID::fdnInterpRate]->getFloat();
+  info.fdn.delay.rate[voice] = pv[ID::fdnInterpRate]->getFloat();
   auto fdnInterpLowpassSecond = pv[ID::fdnInterpLowpassSecond]->getFloat();
-  fdn.delay.kp = fdnInterpLowpassSecond == 0
+  info.fdn.delay.kp[voice] = fdnInterpLowpassSecond == 0
     ? float(1)
     : float(EMAFilter<double>::cutoffToP(sampleRate, double(1) / fdnInterpLowpassSecond));
   auto fdnFreq = info.fdnFreqOffset.getValue() * fdnPitch;
@@ -191,6 +222,12 @@ void DSPCore::setParameters()
 
   ASSIGN_PARAMETER(push);
 
+  // Lines are grown at the start of next `process()`.
+  auto longest = longestFdnDelayTime(upRate, param);
+  for (size_t line = 0; line < fdnMatrixSize; ++line) {
+    info.fdn.delay.reserve(line, longest[line]);
+  }
+
   for (auto &note : notes) {
     if (note.state == NoteState::rest) continue;
     note.setParameters(upRate, info, param);
@@ -221,12 +258,10 @@ inline float alignModValue(float amount, float alignment, float value)
   return alignment * std::floor(value * amount / alignment + float(0.5));
 }
 
-std::array<float, 2> Note::process(float sampleRate, NoteProcessInfo &info)
+float Note::processInput(float sampleRate, NoteProcessInfo &info)
 {
   constexpr auto eps = std::numeric_limits<float>::epsilon();
 
-  if (state == NoteState::rest) return {float(0), float(0)};
-
   auto modenv = info.envelope.process(modEnvelopePhase.process());
   auto modenvToFdnLp
     = noteToPitch(modenv * info.modEnvelopeToFdnLowpassCutoff.getValue(), info.eqTemp);
@@ -254,52 +289,62 @@ std::array<float, 2> Note::process(float sampleRate, NoteProcessInfo &info)
     sig += oscGain * osc.process(sampleRate, nt, info.wavetable);
   }
 
+  info.fdn.input[voice] = sig;
   if (info.fdnEnable) {
-    auto fdnFreq = info.fdnFreqOffset.getValue() * fdnPitch * fdnPitchMod;
-    float overtone = float(1);
-    for (size_t idx = 0; idx < fdnMatrixSize; ++idx) {
-      fdn.delay.setDelayTimeAt(
-        idx, sampleRate,
-        info.fdnOvertoneOffset.getValue()
-          + (float(1) + overtoneRandomness[idx]) * overtone,
-        fdnFreq);
-      auto ot = overtone * info.fdnOvertoneMul.getValue() + info.fdnOvertoneAdd.getValue()
-        + modEnvelopeToFdnOvertoneAdd;
-      if (info.fdnOvertoneModulo.getValue() >= std::numeric_limits<float>::epsilon()) {
-        // Almost same operation as `std::fmod()`.
-        ot /= float(1) + info.fdnOvertoneModulo.getValue();
-        ot -= std::floor(ot);
-        ot *= float(1) + info.fdnOvertoneModulo.getValue();
-      }
-      overtone = ot;
-    }
+    // Delay times are computed in `info.fdn.process()` for all voices at once.
+    info.fdn.noteFreq[voice] = info.fdnFreqOffset.getValue() * fdnPitch * fdnPitchMod;
+    info.fdn.overtoneAddMod[voice] = modEnvelopeToFdnOvertoneAdd;
 
     constexpr auto minCutoff = float(0.00001);
     constexpr auto nyquist = float(0.49998);
-    fdn.lowpass.setCutoff(
+    info.fdn.lowpass.setCutoff(
+      voice,
       std::clamp(
         modenvToFdnLp * fdnLowpassCutoff.process(info.smootherKp), minCutoff, nyquist),
       info.fdnLowpassQ.getValue());
-    fdn.highpass.setCutoff(
+    info.fdn.highpass.setCutoff(
+      voice,
       std::clamp(
         modenvToFdnHp * fdnHighpassCutoff.process(info.smootherKp), minCutoff, nyquist),
       info.fdnHighpassQ.getValue());
-
-    // TODO: FDN gain.
-    sig = float(0.01 * pi) * fdn.process(sig, info.fdnFeedback.getValue());
   }
 
+  return sig;
+}
+
+std::array<float, 2> Note::processOutput(float sig, NoteProcessInfo &info)
+{
+  constexpr auto eps = std::numeric_limits<float>::epsilon();
+
+  // TODO: FDN gain.
+  if (info.fdnEnable) sig *= float(0.01 * pi);
+
   auto gateGain = gate.process();
   gain = gateGain * releaseSwitch;
   auto outputGain = gateSmoother.process(gateGain);
   sig *= outputGain;
 
-  if (state == NoteState::release && outputGain <= eps) state = NoteState::rest;
+  if (state == NoteState::release && outputGain <= eps) {
+    state = NoteState::rest;
+
+    // Resting lanes below `nActive` are still processed in `info.fdn.process()`. Clearing
+    // the lane makes them process only zeros, and no state is left for the next note.
+    info.fdn.reset(voice);
+  }
 
   auto panGain = pan.process(info.smootherKp);
   return {(float(1) - panGain) * sig, panGain * sig};
 }
 
+std::array<float, 2> Note::process(float sampleRate, NoteProcessInfo &info, size_t offset)
+{
+  if (state == NoteState::rest) return {float(0), float(0)};
+
+  auto sig = processInput(sampleRate, info);
+  if (info.fdnEnable) sig = info.fdn.process(voice, offset);
+  return processOutput(sig, info);
+}
+
 void DSPCore::process(const size_t length, float *out0, float *out1)
 {
   using ID = ParameterID::ID;
@@ -308,6 +353,8 @@ void DSPCore::process(const size_t length, float *out0, float *out1)
   SmootherCommon<float>::setTime(pv[ID::smoothingTimeSecond]->getFloat());
   SmootherCommon<float>::setBufferSize(float(length));
 
+  info.fdn.delay.updateBuffer();
+
   // When tempo-sync is off, use defaultTempo BPM.
   bool isTempoSyncing = pv[ID::lfoTempoSync]->getInt();
   info.synchronizer.prepare(
@@ -322,9 +369,21 @@ void DSPCore::process(const size_t length, float *out0, float *out1)
     for (size_t j = 0; j < upFold; ++j) {
       info.process();
 
+      // Voices after the last active one are skipped.
+      size_t nActive = 0;
+      info.fdn.input.fill(0);
       for (auto &note : notes) {
         if (note.state == NoteState::rest) continue;
-        auto sig = note.process(upRate, info);
+        note.processInput(upRate, info);
+        nActive = note.voice + 1;
+      }
+
+      if (info.fdnEnable) info.fdn.process(nActive);
+      const auto &fdnOut = info.fdnEnable ? info.fdn.output : info.fdn.input;
+
+      for (auto &note : notes) {
+        if (note.state == NoteState::rest) continue;
+        auto sig = note.processOutput(fdnOut[note.voice], info);
         halfIn[0][j] += sig[0];
         halfIn[1][j] += sig[1];
       }
@@ -387,20 +446,20 @@ void Note::noteOn(
   std::uniform_int_distribution<unsigned> seedDist{
     0, std::numeric_limits<unsigned>::max()};
 
-  fdn.randomOrthogonal(
-    seedDist(info.fdnRng), pv[ID::fdnMatrixIdentityAmount]->getFloat(),
+  info.fdn.randomizeMatrix(
+    voice, seedDist(info.fdnRng), pv[ID::fdnMatrixIdentityAmount]->getFloat(),
     pv[ID::fdnRandomizeRatio]->getFloat(), info.fdnMatrixRandomBase);
 
   // FDN delay.
-  fdn.delay.rate = pv[ID::fdnInterpRate]->getFloat();
+  info.fdn.delay.rate[voice] = pv[ID::fdnInterpRate]->getFloat();
   auto fdnInterpLowpassSecond = pv[ID::fdnInterpLowpassSecond]->getFloat();
-  fdn.delay.kp = fdnInterpLowpassSecond == 0
+  info.fdn.delay.kp[voice] = fdnInterpLowpassSecond == 0
     ? float(1)
     : float(EMAFilter<double>::cutoffToP(sampleRate, 1.0 / fdnInterpLowpassSecond));
 
   std::uniform_real_distribution<float> overtoneDist(-1.0, 1.0);
   for (size_t idx = 0; idx < fdnMatrixSize; ++idx) {
-    overtoneRandomness[idx]
+    info.fdn.overtoneRandomness[idx][voice]
       = overtoneDist(info.fdnRng) * pv[ID::fdnOvertoneRandomness]->getFloat();
   }
 
@@ -414,24 +473,9 @@ void Note::noteOn(
     osc.reset();
     lfoPhase.offset = pv[ID::lfoRetrigger]->getInt() ? -info.synchronizer.getPhase() : 0;
 
-    fdn.reset();
-
-    float overtone = 1.0f;
-    for (size_t idx = 0; idx < fdnMatrixSize; ++idx) {
-      fdn.delay.resetDelayTimeAt(
-        idx, sampleRate,
-        info.fdnOvertoneOffset.getValue()
-          + (float(1) + overtoneRandomness[idx]) * overtone,
-        fdnFreq);
-      auto ot
-        = overtone * info.fdnOvertoneMul.getValue() + info.fdnOvertoneAdd.getValue();
-      if (info.fdnOvertoneModulo.getValue() >= std::numeric_limits<float>::epsilon()) {
-        ot /= float(1) + info.fdnOvertoneModulo.getValue();
-        ot -= std::floor(ot);
-        ot *= float(1) + info.fdnOvertoneModulo.getValue();
-      }
-      overtone = ot;
-    }
+    info.fdn.reset(voice);
+    info.fdn.noteFreq[voice] = fdnFreq;
+    info.fdn.resetDelayTime(voice);
 
     SET_NOTE_FILTER_CUTOFF(reset);
   } else {
@@ -549,7 +593,7 @@ void DSPCore::fillTransitionBuffer(size_t noteIndex)
   if (trStop >= transitionBuffer.size()) trStop += transitionBuffer.size();
 
   for (size_t bufIdx = 0; bufIdx < transitionBuffer.size(); ++bufIdx) {
-    auto oscOut = note.process(upRate, info);
+    auto oscOut = note.process(upRate, info, bufIdx);
     auto idx = (trIndex + bufIdx) % transitionBuffer.size();
     auto interp = float(1) - float(bufIdx) / transitionBuffer.size();
 
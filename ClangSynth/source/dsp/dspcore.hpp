@@ -18,6 +18,7 @@
 #pragma once
 
 #include "../../../common/dsp/constants.hpp"
+#include "../../../common/dsp/eventring.hpp"
 #include "../../../common/dsp/multirate.hpp"
 #include "../../../common/dsp/smoother.hpp"
 #include "../../../lib/pcg-cpp/pcg_random.hpp"
@@ -107,6 +108,7 @@ struct NoteProcessInfo {
   uint32_t previousSeed = 0;
   std::vector<std::vector<float>> fdnMatrixRandomBase;
   Wavetable<float, oscOvertoneSize> wavetable;
+  VoiceFeedbackDelayNetwork<float, fdnMatrixSize, maximumVoice> fdn;
 
   TableLFO<float, nLfoWavetable, 1024, TableLFOType::lfo> lfo;
   TableLFO<float, nModEnvelopeWavetable + 1, 1024, TableLFOType::envelope> envelope;
@@ -163,6 +165,7 @@ struct NoteProcessInfo {
     lfoPhase = 0;
 
     NOTE_PROCESS_INFO_SMOOTHER(reset);
+    updateFdnParameters();
   }
 
   void setParameters(GlobalParameter &param)
@@ -207,6 +210,18 @@ struct NoteProcessInfo {
     modEnvelopeToOscPitch.process();
     modEnvelopeToFdnPitch.process();
     modEnvelopeToFdnOvertoneAdd.process();
+
+    updateFdnParameters();
+  }
+
+private:
+  void updateFdnParameters()
+  {
+    fdn.feedback = fdnFeedback.getValue();
+    fdn.overtoneOffset = fdnOvertoneOffset.getValue();
+    fdn.overtoneMul = fdnOvertoneMul.getValue();
+    fdn.overtoneAdd = fdnOvertoneAdd.getValue();
+    fdn.overtoneModulo = fdnOvertoneModulo.getValue();
   }
 };
 
@@ -214,6 +229,7 @@ class Note {
 public:
   NoteState state = NoteState::rest;
 
+  size_t voice = 0; // Lane index of `NoteProcessInfo::fdn`.
   int_fast32_t id = -1;
   float velocity = 0;
   float fdnPitch = 0;
@@ -230,12 +246,9 @@ public:
   LFOPhase<float> lfoPhase;
   EnvelopePhase<float> modEnvelopePhase;
   TableOsc<float, oscOvertoneSize> osc;
-  std::array<float, fdnMatrixSize> overtoneRandomness{};
-  FeedbackDelayNetwork<float, fdnMatrixSize> fdn;
   NoteGate<float> gate;
   DoubleEMAFilter<float> gateSmoother;
 
-  void setup(float sampleRate);
   void reset(float sampleRate, NoteProcessInfo &info, GlobalParameter &param);
   void setParameters(float sampleRate, NoteProcessInfo &info, GlobalParameter &param);
   void noteOn(
@@ -250,7 +263,14 @@ public:
   void rest();
   bool isAttacking();
   float getGain();
-  std::array<float, 2> process(float sampleRate, NoteProcessInfo &info);
+
+  // `processInput()` sets per voice parameters of `info.fdn` and returns the input to
+  // FDN. After `info.fdn.process()`, `processOutput()` takes the output of FDN.
+  float processInput(float sampleRate, NoteProcessInfo &info);
+  std::array<float, 2> processOutput(float sig, NoteProcessInfo &info);
+
+  // Renders only this note, `offset` samples ahead of the others.
+  std::array<float, 2> process(float sampleRate, NoteProcessInfo &info, size_t offset);
 };
 
 class DSPCore {
@@ -270,7 +290,7 @@ public:
   float tempo = 120.0f;
   double beatsElapsed = 0.0f;
 
-  std::vector<MidiNote> midiNotes;
+  MidiEventRing<MidiNote> midiNotes;
 
   DSPCore();
 
@@ -298,22 +318,17 @@ public:
     note.pitch = pitch;
     note.tuning = tuning;
     note.velocity = velocity;
-    midiNotes.push_back(note);
+    midiNotes.push(note);
   }
 
   void processMidiNote(size_t frame)
   {
-    while (true) {
-      auto it = std::find_if(midiNotes.begin(), midiNotes.end(), [&](const MidiNote &nt) {
-        return nt.frame == frame;
-      });
-      if (it == std::end(midiNotes)) return;
-      if (it->isNoteOn)
-        noteOn(it->id, it->pitch, it->tuning, it->velocity);
+    midiNotes.dispatch(frame, [&](MidiNote &note) {
+      if (note.isNoteOn)
+        noteOn(note.id, note.pitch, note.tuning, note.velocity);
       else
-        noteOff(it->id);
-      midiNotes.erase(it);
-    }
+        noteOff(note.id);
+    });
   }
 
 private:
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include "../../../common/dsp/bufferallocator.hpp"
 #include "../../../common/dsp/constants.hpp"
 #include "../../../common/dsp/smoother.hpp"
 #include "../../../lib/pcg-cpp/pcg_random.hpp"
@@ -24,8 +25,12 @@
 
 #include <algorithm>
 #include <array>
+#include <cstdint>
+#include <limits>
 #include <numeric>
 #include <random>
+#include <utility>
+#include <vector>
 
 namespace SomeDSP {
 
@@ -65,175 +70,578 @@ public:
   }
 };
 
-template<typename Sample, size_t length> class ParallelDelay {
+/**
+Returns the longest delay time in samples of each line, for notes at or above
+`lowestFreq`. The overtone of a line goes lower only by `fdnOvertoneRandomness`, and by
+`fdnOvertoneModulo` which wraps it to 0. Modulation adds positive value to the overtone.
+*/
+template<typename Sample, size_t nLine>
+std::array<Sample, nLine> longestDelayTime(
+  Sample sampleRate,
+  Sample lowestFreq,
+  Sample offset,
+  Sample mul,
+  Sample add,
+  Sample modulo,
+  Sample randomness)
+{
+  constexpr auto eps = std::numeric_limits<Sample>::epsilon();
+  lowestFreq = std::max(eps, lowestFreq);
+
+  std::array<Sample, nLine> timeInSample;
+  Sample overtone = Sample(1); // Lower bound.
+  for (size_t line = 0; line < nLine; ++line) {
+    auto ot = std::max(eps, offset + (Sample(1) - randomness) * overtone);
+    timeInSample[line] = sampleRate / ot / lowestFreq;
+    overtone = modulo >= eps ? Sample(0) : overtone * mul + add;
+  }
+  return timeInSample;
+}
+
+/**
+`nLine` delays for each of `nVoice` voices. Buffers are interleaved as
+`buffer[line][frame * nVoice + voice]`, and all voices share the write pointer of a
+line. So writing is a contiguous store, and reading is a gather.
+
+Each line is sized in `setup()` for the longest delay time that the parameters allow,
+plus `aheadFrames` for `process(voice, offset, input)`. Delay time longer than the
+buffer is clamped, and the line is grown by `updateBuffer()`. The larger buffer is
+allocated on a worker thread, and the history is moved to it in `process()` a few
+frames at a time. `maxTime` is the upper limit of growth.
+
+`reset()` doesn't clear buffers. Instead, samples older than the ones written after the
+last reset are read as 0. The output is same as clearing all buffers.
+*/
+template<typename Sample, size_t nLine, size_t nVoice> class VoiceParallelDelay {
 public:
-  std::array<Sample, length> targetTime{};
-  std::array<Sample, length> time{};
-  std::array<size_t, length> wptr{};
-  std::array<std::vector<Sample>, length> buffer;
+  using VoiceArray = std::array<Sample, nVoice>;
 
-  Sample rate = Sample(0.25);
-  Sample kp = Sample(1);
+  // Frames of history moved to the grown buffer for each processed frame.
+  static constexpr size_t growthRate = 4;
 
-  void setup(Sample sampleRate, Sample maxTime)
+  std::array<VoiceArray, nLine> targetTime{};
+  std::array<VoiceArray, nLine> time{};
+  std::array<int32_t, nVoice> nWritten{}; // 32 bit for vectorization.
+  std::array<size_t, nLine> wptr{};
+  std::array<size_t, nLine> size{}; // In frames.
+  std::array<size_t, nLine> wantSize{};
+  std::array<std::vector<Sample>, nLine> buffer;
+  size_t maxSize = 4;
+  size_t aheadFrames = 0;
+
+  VoiceArray rate{};
+  VoiceArray kp{};
+
+private:
+  BackgroundBufferAllocator<Sample, nLine> allocator;
+  std::array<std::vector<Sample>, nLine> next; // Grown buffers.
+  std::array<RingBufferGrowth, nLine> growth{};
+  size_t nGrowing = 0;
+
+public:
+  /**
+  `process(voice, offset, input)` writes up to `nAhead` frames ahead. The margin keeps
+  it from overwriting the history which the voice reads after that.
+  */
+  void setup(
+    Sample sampleRate,
+    Sample maxTime,
+    const std::array<Sample, nLine> &longest,
+    size_t nAhead)
   {
-    auto size = size_t(sampleRate * maxTime) + 2;
-    for (auto &bf : buffer) bf.resize(size < 4 ? 4 : size);
+    maxSize = std::max(size_t(4), size_t(sampleRate * maxTime) + 2);
+    aheadFrames = nAhead;
+
+    allocator.reset(next);
+    growth.fill({});
+    nGrowing = 0;
+    for (size_t line = 0; line < nLine; ++line) {
+      wantSize[line] = toSize(longest[line]);
+      size[line] = wantSize[line];
+      buffer[line] = std::vector<Sample>(size[line] * nVoice, Sample(0));
+    }
+    wptr.fill(0);
+    rate.fill(Sample(0.25));
+    kp.fill(Sample(1));
 
-    reset();
+    for (size_t voice = 0; voice < nVoice; ++voice) reset(voice);
   }
 
-  void reset(Sample timeInSample = 0)
+  void reset(size_t voice)
   {
-    targetTime.fill(timeInSample);
-    time.fill(timeInSample);
-    for (auto &bf : buffer) std::fill(bf.begin(), bf.end(), Sample(0));
+    for (size_t line = 0; line < nLine; ++line) {
+      targetTime[line][voice] = 0;
+      time[line][voice] = 0;
+    }
+    nWritten[voice] = 0;
   }
 
-  void setDelayTimeAt(size_t index, Sample sampleRate, Sample overtone, Sample noteFreq)
+  // Grows the line in `updateBuffer()` if it's shorter than `timeInSample`.
+  void reserve(size_t line, Sample timeInSample)
   {
-    targetTime[index] = std::clamp(
-      sampleRate / overtone / noteFreq, Sample(0), Sample(buffer[index].size() - 1));
+    wantSize[line] = std::max(wantSize[line], toSize(timeInSample));
   }
 
-  void resetDelayTimeAt(size_t index, Sample sampleRate, Sample overtone, Sample noteFreq)
+  // Called once per block from audio thread.
+  void updateBuffer()
   {
-    setDelayTimeAt(index, sampleRate, overtone, noteFreq);
-    time[index] = targetTime[index];
+    if (nGrowing > 0) return;
+
+    if (allocator.isIdle()) {
+      typename BackgroundBufferAllocator<Sample, nLine>::Sizes request{};
+      bool isShort = false;
+      for (size_t line = 0; line < nLine; ++line) {
+        if (wantSize[line] <= size[line]) continue;
+        request[line]
+          = nVoice * std::min(maxSize, std::max(wantSize[line], 2 * size[line]));
+        isShort = true;
+      }
+      if (isShort) allocator.request(request);
+    }
+
+    if (!allocator.receive(next)) return;
+    const auto nHistory = size_t(*std::max_element(nWritten.begin(), nWritten.end()));
+    for (size_t line = 0; line < nLine; ++line) {
+      if (next[line].size() <= buffer[line].size()) continue;
+      growth[line].start(size[line], wptr[line], nHistory);
+      ++nGrowing;
+      if (growth[line].isDone()) finishGrowth(line);
+    }
+    if (nGrowing == 0) allocator.release(next);
   }
 
-  void process(std::array<Sample, length> &input)
+  // Sets delay time of voices in `[0, nActive)`.
+  void setDelayTime(size_t line, const VoiceArray &timeInSample, size_t nActive)
   {
-    for (size_t idx = 0; idx < length; ++idx) {
-      // Interpolate delay time.
-      auto prevTime = time[idx];
-      time[idx] += kp * (targetTime[idx] - time[idx]);
-      auto diff = time[idx] - prevTime;
-      if (diff > rate) {
-        time[idx] = prevTime + rate;
-      } else if (diff < -rate) {
-        time[idx] = prevTime - rate;
-      }
+    const auto upper = Sample(size[line] - 1);
+    auto &target = targetTime[line];
+    Sample longest = 0;
+    for (size_t voice = 0; voice < nActive; ++voice) {
+      longest = std::max(longest, timeInSample[voice]);
+      target[voice] = std::clamp(timeInSample[voice], Sample(0), upper);
+    }
+    if (longest > upper) reserve(line, longest);
+  }
 
-      // Set delay time.
-      size_t timeInt = size_t(time[idx]);
-      Sample rFraction = time[idx] - Sample(timeInt);
+  void setDelayTime(size_t line, size_t voice, Sample timeInSample)
+  {
+    const auto upper = Sample(size[line] - 1);
+    if (timeInSample > upper) reserve(line, timeInSample);
+    targetTime[line][voice] = std::clamp(timeInSample, Sample(0), upper);
+  }
 
-      auto &buf = buffer[idx];
+  // Processes voices in `[0, nActive)`.
+  void process(std::array<VoiceArray, nLine> &input, size_t nActive)
+  {
+    std::array<int32_t, nVoice> index0;
+    std::array<int32_t, nVoice> index1;
+    VoiceArray fraction;
+    VoiceArray gain0;
+    VoiceArray gain1;
+    VoiceArray sample0;
+    VoiceArray sample1;
+
+    for (size_t voice = 0; voice < nActive; ++voice) {
+      if (size_t(nWritten[voice]) < maxSize) ++nWritten[voice];
+    }
+    // Skipped voices have a gap in their buffer, so nothing written before is valid.
+    for (size_t voice = nActive; voice < nVoice; ++voice) nWritten[voice] = 0;
 
-      size_t rptr0 = wptr[idx] - timeInt;
-      size_t rptr1 = rptr0 - 1;
-      if (rptr0 >= buf.size()) rptr0 += buf.size(); // Unsigned negative overflow case.
-      if (rptr1 >= buf.size()) rptr1 += buf.size(); // Unsigned negative overflow case.
+    for (size_t line = 0; line < nLine; ++line) {
+      auto &x = input[line];
+      auto &tm = time[line];
+      const auto &target = targetTime[line];
+      const auto sz = size[line];
+      const auto wp = wptr[line];
+      Sample *buf = buffer[line].data();
 
       // Write to buffer.
-      buf[wptr[idx]] = input[idx];
-      if (++wptr[idx] >= buf.size()) wptr[idx] -= buf.size();
+      Sample *dest = buf + wp * nVoice;
+      for (size_t voice = 0; voice < nActive; ++voice) dest[voice] = x[voice];
+
+      auto &gr = growth[line];
+      if (gr.isActive) {
+        Sample *nextBuf = next[line].data();
+        gr.copyHistory(buf, nextBuf, nVoice, growthRate);
+        Sample *nextDest = nextBuf + gr.nextWptr * nVoice;
+        for (size_t voice = 0; voice < nActive; ++voice) nextDest[voice] = x[voice];
+      }
+
+      // Interpolate delay time, and compute read indices.
+      const auto size32 = int32_t(sz);
+      const auto wp32 = int32_t(wp);
+      for (size_t voice = 0; voice < nActive; ++voice) {
+        tm[voice] = interpolateTime(tm[voice], target[voice], kp[voice], rate[voice]);
+
+        auto timeInt = int32_t(tm[voice]);
+        fraction[voice] = tm[voice] - Sample(timeInt);
+        int32_t rptr0 = wp32 - timeInt;
+        rptr0 += rptr0 < 0 ? size32 : 0;
+        int32_t rptr1 = rptr0 - 1;
+        rptr1 += rptr1 < 0 ? size32 : 0;
+        index0[voice] = rptr0 * int32_t(nVoice) + int32_t(voice);
+        index1[voice] = rptr1 * int32_t(nVoice) + int32_t(voice);
+
+        // Samples written before `reset()` are treated as 0.
+        gain0[voice] = timeInt < nWritten[voice] ? Sample(1) : Sample(0);
+        gain1[voice] = timeInt + 1 < nWritten[voice] ? Sample(1) : Sample(0);
+      }
+
+      // Indices are 32 bit and loads are unconditional, so this becomes gather.
+      for (size_t voice = 0; voice < nActive; ++voice) {
+        sample0[voice] = buf[index0[voice]];
+        sample1[voice] = buf[index1[voice]];
+      }
+
+      for (size_t voice = 0; voice < nActive; ++voice) {
+        auto s0 = gain0[voice] * sample0[voice];
+        auto s1 = gain1[voice] * sample1[voice];
+        x[voice] = s0 + fraction[voice] * (s1 - s0);
+      }
+
+      if (++wptr[line] >= sz) wptr[line] = 0;
 
-      // Read from buffer.
-      input[idx] = buf[rptr0] + rFraction * (buf[rptr1] - buf[rptr0]);
+      if (gr.isActive) {
+        gr.advance(next[line].size() / nVoice);
+        if (gr.isDone()) finishGrowth(line);
+        if (nGrowing == 0) allocator.release(next);
+      }
     }
   }
-};
 
-/**
-If `length` is too long, compiler might silently fail to allocate stack.
-*/
-template<typename Sample, size_t length> class FeedbackDelayNetwork {
-private:
-  std::array<std::array<Sample, length>, length> matrix{};
-  std::array<std::array<Sample, length>, 2> buf{};
-  size_t bufIndex = 0;
+  /**
+  Processes only `voice`, `offset` frames ahead of the other voices. Used to render a
+  stolen note ahead of time, so the voice must be reset afterward.
+  */
+  void process(size_t voice, size_t offset, std::array<Sample, nLine> &input)
+  {
+    if (size_t(nWritten[voice]) < maxSize) ++nWritten[voice];
 
-public:
-  ParallelDelay<Sample, length> delay;
-  ParallelSVF<Sample, length> lowpass;
-  ParallelSVF<Sample, length> highpass;
+    for (size_t line = 0; line < nLine; ++line) {
+      const auto sz = size[line];
+      const auto wp = (wptr[line] + offset) % sz;
+      Sample *buf = buffer[line].data();
 
-  /**
-  If `identityAmount` is close to 0, then the result becomes close to identity matrix.
+      buf[wp * nVoice + voice] = input[line];
 
-  This algorithm is ported from `scipy.stats.ortho_group` in SciPy v1.8.0.
-  */
-  void randomOrthogonal(
-    unsigned seed,
-    Sample identityAmount,
-    Sample ratio,
-    const std::vector<std::vector<Sample>> &randomBase)
+      auto &tm = time[line][voice];
+      tm = interpolateTime(tm, targetTime[line][voice], kp[voice], rate[voice]);
+      input[line] = read(buf, sz, wp, voice, tm, nWritten[voice]);
+    }
+  }
+
+private:
+  size_t toSize(Sample timeInSample)
   {
-    pcg64 rng{};
-    rng.seed(seed);
-    std::normal_distribution<Sample> dist{}; // mean 0, stddev 1.
+    // Negated to send NaN to `maxSize`.
+    const auto margin = aheadFrames + 2;
+    if (!(timeInSample + Sample(margin) < Sample(maxSize))) return maxSize;
+    return std::max(size_t(4), size_t(std::max(Sample(0), timeInSample)) + margin);
+  }
 
-    matrix.fill({});
-    for (size_t i = 0; i < length; ++i) matrix[i][i] = Sample(1);
+  void finishGrowth(size_t line)
+  {
+    std::swap(buffer[line], next[line]);
+    size[line] = buffer[line].size() / nVoice;
+    wptr[line] = growth[line].nextWptr;
+    growth[line].isActive = false;
+    --nGrowing;
+  }
 
-    std::array<Sample, length> x;
-    for (size_t n = 0; n < length; ++n) {
-      auto xRange = length - n;
+  static inline Sample interpolateTime(Sample time, Sample target, Sample kp, Sample rate)
+  {
+    auto next = time + kp * (target - time);
+    auto lower = time - rate;
+    auto upper = time + rate;
+    return std::min(std::max(next, lower), upper);
+  }
 
-      x[0] = Sample(1);
-      for (size_t i = 1; i < xRange; ++i) {
-        auto mix = randomBase[n][i] + ratio * (dist(rng) - randomBase[n][i]);
-        x[i] = identityAmount * mix;
-      }
+  // Same as the read in `process(input, nActive)`, for a single voice.
+  static inline Sample read(
+    const Sample *buf,
+    size_t sz,
+    size_t wp,
+    size_t voice,
+    Sample timeInSample,
+    int32_t written)
+  {
+    const auto size = int32_t(sz);
+    auto timeInt = int32_t(timeInSample);
+    Sample rFraction = timeInSample - Sample(timeInt);
+
+    int32_t rptr0 = int32_t(wp) - timeInt;
+    rptr0 += rptr0 < 0 ? size : 0;
+    int32_t rptr1 = rptr0 - 1;
+    rptr1 += rptr1 < 0 ? size : 0;
+
+    const auto nv = int32_t(nVoice);
+    const auto vc = int32_t(voice);
+    Sample s0 = buf[rptr0 * nv + vc];
+    Sample s1 = buf[rptr1 * nv + vc];
+    s0 = timeInt < written ? s0 : Sample(0);
+    s1 = timeInt + 1 < written ? s1 : Sample(0);
+    return s0 + rFraction * (s1 - s0);
+  }
+};
+
+/**
+If `identityAmount` is close to 0, then the result becomes close to identity matrix.
+
+This algorithm is ported from `scipy.stats.ortho_group` in SciPy v1.8.0.
+*/
+template<typename Sample, size_t length>
+void randomOrthogonal(
+  std::array<std::array<Sample, length>, length> &matrix,
+  unsigned seed,
+  Sample identityAmount,
+  Sample ratio,
+  const std::vector<std::vector<Sample>> &randomBase)
+{
+  pcg64 rng{};
+  rng.seed(seed);
+  std::normal_distribution<Sample> dist{}; // mean 0, stddev 1.
+
+  matrix.fill({});
+  for (size_t i = 0; i < length; ++i) matrix[i][i] = Sample(1);
+
+  std::array<Sample, length> x;
+  for (size_t n = 0; n < length; ++n) {
+    auto xRange = length - n;
+
+    x[0] = Sample(1);
+    for (size_t i = 1; i < xRange; ++i) {
+      auto mix = randomBase[n][i] + ratio * (dist(rng) - randomBase[n][i]);
+      x[i] = identityAmount * mix;
+    }
 
-      Sample norm2 = 0;
-      for (size_t i = 0; i < xRange; ++i) norm2 += x[i] * x[i];
+    Sample norm2 = 0;
+    for (size_t i = 0; i < xRange; ++i) norm2 += x[i] * x[i];
 
-      Sample x0 = x[0];
+    Sample x0 = x[0];
 
-      Sample D = x0 >= 0 ? Sample(1) : Sample(-1);
-      x[0] += D * std::sqrt(norm2);
+    Sample D = x0 >= 0 ? Sample(1) : Sample(-1);
+    x[0] += D * std::sqrt(norm2);
 
-      Sample denom = std::sqrt((norm2 - x0 * x0 + x[0] * x[0]) / Sample(2));
-      for (size_t i = 0; i < xRange; ++i) x[i] /= denom;
+    Sample denom = std::sqrt((norm2 - x0 * x0 + x[0] * x[0]) / Sample(2));
+    for (size_t i = 0; i < xRange; ++i) x[i] /= denom;
 
-      for (size_t row = 0; row < length; ++row) {
-        Sample dotH = 0;
-        for (size_t col = 0; col < xRange; ++col) dotH += matrix[col][row] * x[col];
-        for (size_t col = 0; col < xRange; ++col) {
-          matrix[col][row] = D * (matrix[col][row] - dotH * x[col]);
-        }
+    for (size_t row = 0; row < length; ++row) {
+      Sample dotH = 0;
+      for (size_t col = 0; col < xRange; ++col) dotH += matrix[col][row] * x[col];
+      for (size_t col = 0; col < xRange; ++col) {
+        matrix[col][row] = D * (matrix[col][row] - dotH * x[col]);
       }
     }
   }
+}
 
-  void setup(Sample sampleRate, Sample maxTime)
+/**
+Feedback delay networks of all voices in structure of arrays. Each voice has its own
+matrix, delay times and filter cutoffs. Arrays are indexed as `[line][voice]`, so the
+inner loops over voices are vectorized.
+
+Per voice inputs (`input`, `noteFreq`, `overtoneAddMod`, and filter cutoffs) are set by
+each note, then `process()` renders voices in `[0, nActive)` at once. Output is written
+to `output`.
+
+If `nLine * nLine * nVoice` is too large, compiler might silently fail to allocate
+stack.
+*/
+template<typename Sample, size_t nLine, size_t nVoice> class VoiceFeedbackDelayNetwork {
+public:
+  using VoiceArray = std::array<Sample, nVoice>;
+
+  // Filter cutoffs ramp to new target in this interval.
+  static constexpr Sample cutoffControlSeconds = Sample(0.00025);
+
+private:
+  std::array<std::array<VoiceArray, nLine>, nLine> matrix{}; // [row][column][voice].
+  std::array<std::array<VoiceArray, nLine>, 2> buf{};
+  size_t bufIndex = 0;
+  Sample sampleRate = Sample(44100);
+
+public:
+  // Shared by all voices. Set before `process()`.
+  Sample feedback = 0;
+  Sample overtoneOffset = 0;
+  Sample overtoneMul = Sample(1);
+  Sample overtoneAdd = Sample(1);
+  Sample overtoneModulo = 0;
+
+  // Per voice.
+  VoiceArray input{};
+  VoiceArray output{};
+  VoiceArray noteFreq{};
+  VoiceArray overtoneAddMod{};
+  std::array<VoiceArray, nLine> overtoneRandomness{};
+
+  VoiceParallelDelay<Sample, nLine, nVoice> delay;
+  VoiceParallelSVF<Sample, nLine, nVoice> lowpass;
+  VoiceParallelSVF<Sample, nLine, nVoice> highpass;
+
+  // See `VoiceParallelDelay::setup()`.
+  void setup(
+    Sample sampleRate,
+    Sample maxTime,
+    const std::array<Sample, nLine> &longest,
+    size_t nAhead)
   {
-    delay.setup(sampleRate, maxTime);
+    this->sampleRate = sampleRate;
+
+    delay.setup(sampleRate, maxTime, longest, nAhead);
+
+    auto interval = size_t(sampleRate * cutoffControlSeconds);
+    lowpass.setInterval(interval);
+    highpass.setInterval(interval);
 
     // Slightly below nyquist to prevent blow up.
     lowpass.setCutoff(Sample(0.499), Sample(0.5));
     highpass.setCutoff(Sample(5) / sampleRate, Sample(0.5));
 
-    reset();
+    // Lanes without note must not divide by 0.
+    noteFreq.fill(Sample(20));
+
+    for (size_t voice = 0; voice < nVoice; ++voice) reset(voice);
+  }
+
+  void reset(size_t voice)
+  {
+    for (auto &bf : buf) {
+      for (auto &line : bf) line[voice] = 0;
+    }
+    input[voice] = 0;
+    output[voice] = 0;
+    overtoneAddMod[voice] = 0;
+    delay.reset(voice);
+    lowpass.reset(voice);
+    highpass.reset(voice);
   }
 
-  void reset()
+  void randomizeMatrix(
+    size_t voice,
+    unsigned seed,
+    Sample identityAmount,
+    Sample ratio,
+    const std::vector<std::vector<Sample>> &randomBase)
   {
-    buf.fill({});
-    delay.reset();
-    lowpass.reset();
-    highpass.reset();
+    std::array<std::array<Sample, nLine>, nLine> mat;
+    randomOrthogonal(mat, seed, identityAmount, ratio, randomBase);
+    for (size_t row = 0; row < nLine; ++row) {
+      for (size_t col = 0; col < nLine; ++col) matrix[row][col][voice] = mat[row][col];
+    }
   }
 
-  Sample process(Sample input, Sample feedback)
+  // Jumps to the delay time of current `noteFreq` without interpolation.
+  void resetDelayTime(size_t voice)
   {
+    updateVoiceDelayTime(voice);
+    for (size_t line = 0; line < nLine; ++line) {
+      delay.time[line][voice] = delay.targetTime[line][voice];
+    }
+  }
+
+  void process(size_t nActive)
+  {
+    updateDelayTime(nActive);
+
     bufIndex ^= 1;
     auto &front = buf[bufIndex];
     auto &back = buf[bufIndex ^ 1];
-    front.fill(0);
-    for (size_t i = 0; i < length; ++i) {
-      for (size_t j = 0; j < length; ++j) front[i] += matrix[i][j] * back[j];
+    for (size_t row = 0; row < nLine; ++row) {
+      auto &fr = front[row];
+      for (size_t voice = 0; voice < nActive; ++voice) fr[voice] = 0;
+      for (size_t col = 0; col < nLine; ++col) {
+        const auto &mat = matrix[row][col];
+        const auto &bk = back[col];
+        for (size_t voice = 0; voice < nActive; ++voice) {
+          fr[voice] += mat[voice] * bk[voice];
+        }
+      }
+      for (size_t voice = 0; voice < nActive; ++voice) {
+        fr[voice] = input[voice] + feedback * fr[voice];
+      }
+    }
+
+    delay.process(front, nActive);
+    lowpass.updateCoefficient(0, nActive);
+    highpass.updateCoefficient(0, nActive);
+    lowpass.lowpass(front, nActive);
+    highpass.highpass(front, nActive);
+
+    for (size_t voice = 0; voice < nActive; ++voice) output[voice] = 0;
+    for (size_t line = 0; line < nLine; ++line) {
+      const auto &fr = front[line];
+      for (size_t voice = 0; voice < nActive; ++voice) output[voice] += fr[voice];
+    }
+  }
+
+  // Single voice version of `process()`. See `VoiceParallelDelay::process()`.
+  Sample process(size_t voice, size_t offset)
+  {
+    updateVoiceDelayTime(voice);
+
+    // `buf[bufIndex]` holds the latest output. It's overwritten in place, so the
+    // other voices stay in sync with `process(nActive)`.
+    auto &latest = buf[bufIndex];
+    std::array<Sample, nLine> front{};
+    for (size_t row = 0; row < nLine; ++row) {
+      for (size_t col = 0; col < nLine; ++col) {
+        front[row] += matrix[row][col][voice] * latest[col][voice];
+      }
+      front[row] = input[voice] + feedback * front[row];
     }
 
-    for (size_t idx = 0; idx < length; ++idx) front[idx] = input + feedback * front[idx];
-    delay.process(front);
-    lowpass.lowpass(front);
-    highpass.highpass(front);
+    delay.process(voice, offset, front);
+    lowpass.updateCoefficient(voice, voice + 1);
+    highpass.updateCoefficient(voice, voice + 1);
 
-    return std::accumulate(front.begin(), front.end(), Sample(0));
+    Sample sum = 0;
+    for (size_t line = 0; line < nLine; ++line) {
+      auto sig = lowpass.lowpass(line, voice, front[line]);
+      sig = highpass.highpass(line, voice, sig);
+      latest[line][voice] = sig;
+      sum += sig;
+    }
+    return sum;
+  }
+
+private:
+  inline Sample nextOvertone(Sample overtone, Sample addMod)
+  {
+    auto ot = overtone * overtoneMul + overtoneAdd + addMod;
+    if (overtoneModulo >= std::numeric_limits<Sample>::epsilon()) {
+      // Almost same operation as `std::fmod()`.
+      ot /= Sample(1) + overtoneModulo;
+      ot -= std::floor(ot);
+      ot *= Sample(1) + overtoneModulo;
+    }
+    return ot;
+  }
+
+  void updateDelayTime(size_t nActive)
+  {
+    VoiceArray overtone;
+    overtone.fill(Sample(1));
+    VoiceArray timeInSample;
+    for (size_t line = 0; line < nLine; ++line) {
+      const auto &randomness = overtoneRandomness[line];
+      for (size_t voice = 0; voice < nActive; ++voice) {
+        auto ot = overtoneOffset + (Sample(1) + randomness[voice]) * overtone[voice];
+        timeInSample[voice] = sampleRate / ot / noteFreq[voice];
+        overtone[voice] = nextOvertone(overtone[voice], overtoneAddMod[voice]);
+      }
+      delay.setDelayTime(line, timeInSample, nActive);
+    }
+  }
+
+  void updateVoiceDelayTime(size_t voice)
+  {
+    Sample overtone = Sample(1);
+    for (size_t line = 0; line < nLine; ++line) {
+      auto ot = overtoneOffset + (Sample(1) + overtoneRandomness[line][voice]) * overtone;
+      delay.setDelayTime(line, voice, sampleRate / ot / noteFreq[voice]);
+      overtone = nextOvertone(overtone, overtoneAddMod[voice]);
+    }
   }
 };
 
@@ -17,7 +17,10 @@
 
 #pragma once
 
+#include "../../../common/dsp/filtercoefficient.hpp"
 #include "../../../common/dsp/smoother.hpp"
+
+#include <array>
 #include <cmath>
 
 namespace SomeDSP {
@@ -92,48 +95,132 @@ public:
   }
 };
 
-template<typename Sample, size_t length> class ParallelSVF {
+/**
+`nLine` filters for each of `nVoice` voices. Arrays are indexed as `[line][voice]` so
+that the inner loops over voices are vectorized.
+
+Cutoffs are shared by all lines of a voice. They ramp to the targets set by
+`setCutoff(voice, ...)` at control rate. See `SVFCoefficientRamp`.
+*/
+template<typename Sample, size_t nLine, size_t nVoice> class VoiceParallelSVF {
 private:
-  std::array<Sample, length> ic1eq{};
-  std::array<Sample, length> ic2eq{};
+  std::array<std::array<Sample, nVoice>, nLine> ic1eq{};
+  std::array<std::array<Sample, nVoice>, nLine> ic2eq{};
 
-  Sample g = 0;
-  Sample k = 0;
-  Sample denom = Sample(1);
+  SVFCoefficientRamp<Sample, nVoice> coefficient;
+  std::array<Sample, nVoice> denom{};
 
 public:
+  VoiceParallelSVF() { denom.fill(Sample(1)); }
+
+  void setInterval(size_t samples) { coefficient.setInterval(samples); }
+
+  // Sets target. Coefficients are updated in `updateCoefficient()`.
+  void setCutoff(size_t voice, Sample normalizedFreq, Sample Q)
+  {
+    coefficient.setTarget(voice, normalizedFreq, Sample(1) / Q);
+  }
+
+  // Sets all voices without ramp.
   void setCutoff(Sample normalizedFreq, Sample Q)
   {
-    g = std::tan(normalizedFreq * Sample(pi));
-    k = Sample(1) / Q;
-    denom = Sample(1) / (Sample(1) + g * (g + k));
+    for (size_t voice = 0; voice < nVoice; ++voice) {
+      coefficient.reset(voice, normalizedFreq, Sample(1) / Q);
+    }
+    updateDenominator(0, nVoice);
+  }
+
+  // Advances coefficients of voices in `[begin, end)` by 1 sample.
+  void updateCoefficient(size_t begin, size_t end)
+  {
+    if (coefficient.process(begin, end)) updateDenominator(begin, end);
   }
 
   void reset()
   {
-    ic1eq.fill(0);
-    ic2eq.fill(0);
+    for (auto &ic : ic1eq) ic.fill(0);
+    for (auto &ic : ic2eq) ic.fill(0);
+  }
+
+  // Next `updateCoefficient()` jumps to the target of `voice`.
+  void reset(size_t voice)
+  {
+    for (size_t line = 0; line < nLine; ++line) {
+      ic1eq[line][voice] = 0;
+      ic2eq[line][voice] = 0;
+    }
+    coefficient.reset(voice);
+  }
+
+  // Processes voices in `[0, nActive)`.
+  void lowpass(std::array<std::array<Sample, nVoice>, nLine> &v0, size_t nActive)
+  {
+    const auto &g = coefficient.g;
+    for (size_t line = 0; line < nLine; ++line) {
+      auto &x = v0[line];
+      auto &ic1 = ic1eq[line];
+      auto &ic2 = ic2eq[line];
+      for (size_t n = 0; n < nActive; ++n) {
+        auto v1 = (ic1[n] + g[n] * (x[n] - ic2[n])) * denom[n];
+        auto v2 = ic2[n] + g[n] * v1;
+        ic1[n] = Sample(2) * v1 - ic1[n];
+        ic2[n] = Sample(2) * v2 - ic2[n];
+        x[n] = v2;
+      }
+    }
   }
 
-  void lowpass(std::array<Sample, length> &v0)
+  void highpass(std::array<std::array<Sample, nVoice>, nLine> &v0, size_t nActive)
   {
-    for (size_t n = 0; n < length; ++n) {
-      auto v1 = (ic1eq[n] + g * (v0[n] - ic2eq[n])) * denom;
-      auto v2 = ic2eq[n] + g * v1;
-      ic1eq[n] = Sample(2) * v1 - ic1eq[n];
-      ic2eq[n] = Sample(2) * v2 - ic2eq[n];
-      v0[n] = v2;
+    const auto &g = coefficient.g;
+    const auto &k = coefficient.k;
+    for (size_t line = 0; line < nLine; ++line) {
+      auto &x = v0[line];
+      auto &ic1 = ic1eq[line];
+      auto &ic2 = ic2eq[line];
+      for (size_t n = 0; n < nActive; ++n) {
+        auto v1 = (ic1[n] + g[n] * (x[n] - ic2[n])) * denom[n];
+        auto v2 = ic2[n] + g[n] * v1;
+        ic1[n] = Sample(2) * v1 - ic1[n];
+        ic2[n] = Sample(2) * v2 - ic2[n];
+        x[n] -= k[n] * v1 + v2;
+      }
     }
   }
 
-  void highpass(std::array<Sample, length> &v0)
+  // Single voice version of `lowpass()`.
+  Sample lowpass(size_t line, size_t voice, Sample x0)
+  {
+    auto &ic1 = ic1eq[line][voice];
+    auto &ic2 = ic2eq[line][voice];
+    auto g = coefficient.g[voice];
+    auto v1 = (ic1 + g * (x0 - ic2)) * denom[voice];
+    auto v2 = ic2 + g * v1;
+    ic1 = Sample(2) * v1 - ic1;
+    ic2 = Sample(2) * v2 - ic2;
+    return v2;
+  }
+
+  // Single voice version of `highpass()`.
+  Sample highpass(size_t line, size_t voice, Sample x0)
+  {
+    auto &ic1 = ic1eq[line][voice];
+    auto &ic2 = ic2eq[line][voice];
+    auto g = coefficient.g[voice];
+    auto v1 = (ic1 + g * (x0 - ic2)) * denom[voice];
+    auto v2 = ic2 + g * v1;
+    ic1 = Sample(2) * v1 - ic1;
+    ic2 = Sample(2) * v2 - ic2;
+    return x0 - coefficient.k[voice] * v1 - v2;
+  }
+
+private:
+  void updateDenominator(size_t begin, size_t end)
   {
-    for (size_t n = 0; n < length; ++n) {
-      auto v1 = (ic1eq[n] + g * (v0[n] - ic2eq[n])) * denom;
-      auto v2 = ic2eq[n] + g * v1;
-      ic1eq[n] = Sample(2) * v1 - ic1eq[n];
-      ic2eq[n] = Sample(2) * v2 - ic2eq[n];
-      v0[n] -= k * v1 + v2;
+    const auto &g = coefficient.g;
+    const auto &k = coefficient.k;
+    for (size_t n = begin; n < end; ++n) {
+      denom[n] = Sample(1) / (Sample(1) + g[n] * (g[n] + k[n]));
     }
   }
 };
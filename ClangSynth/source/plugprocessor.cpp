@@ -24,6 +24,8 @@
 #include "pluginterfaces/vst/ivstevents.h"
 #include "pluginterfaces/vst/ivstparameterchanges.h"
 
+#include "../../common/dsp/denormal.hpp"
+
 namespace Steinberg {
 namespace Synth {
 
@@ -77,6 +79,8 @@ tresult PLUGIN_API PlugProcessor::setActive(TBool state)
 
 tresult PLUGIN_API PlugProcessor::process(Vst::ProcessData &data)
 {
+  SomeDSP::ScopedNoDenormals noDenormals;
+
   // Read inputs parameter changes.
   if (data.inputParameterChanges) {
     int32 parameterCount = data.inputParameterChanges->getParameterCount();
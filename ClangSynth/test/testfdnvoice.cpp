@@ -0,0 +1,168 @@
+// (c) 2022 Takamitsu Endo
+//
+// This file is part of ClangSynth.
+//
+// ClangSynth is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// ClangSynth is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ClangSynth.  If not, see <https://www.gnu.org/licenses/>.
+
+// Compares each lane of `VoiceFeedbackDelayNetwork::process(nActive)` to a single voice
+// network. Lanes go to rest in the same way as `Note::processOutput()`, so resting lanes
+// below `nActive` are processed along with the active ones. The batched network starts
+// with short delay lines, and grows them while notes are playing.
+
+#include "../source/dsp/fdn.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+
+using namespace SomeDSP;
+
+constexpr size_t nLine = 4;
+constexpr size_t nVoice = 4;
+constexpr float sampleRate = 48000.0f;
+constexpr float maxDelayTime = 0.1f;
+
+using BatchFDN = VoiceFeedbackDelayNetwork<float, nLine, nVoice>;
+using SingleFDN = VoiceFeedbackDelayNetwork<float, nLine, 1>;
+
+struct Event {
+  size_t noteOn;
+  size_t rest;
+};
+
+template<typename FDN>
+void noteOn(
+  FDN &fdn,
+  size_t voice,
+  unsigned seed,
+  const std::vector<std::vector<float>> &randomBase)
+{
+  fdn.reset(voice);
+  fdn.randomizeMatrix(voice, seed, 0.5f, 0.5f, randomBase);
+  fdn.noteFreq[voice] = 200.0f + 50.0f * float(seed % 7);
+  fdn.overtoneAddMod[voice] = 0.1f * float(seed % 3);
+  for (size_t line = 0; line < nLine; ++line) {
+    fdn.overtoneRandomness[line][voice] = 0.01f * float(line);
+  }
+  fdn.lowpass.setCutoff(voice, 0.1f + 0.02f * float(seed % 5), 0.7f);
+  fdn.highpass.setCutoff(voice, 0.001f, 0.7f);
+  fdn.resetDelayTime(voice);
+}
+
+template<typename FDN> void setup(FDN &fdn, float longest)
+{
+  std::array<float, nLine> timeInSample;
+  timeInSample.fill(longest);
+  fdn.setup(sampleRate, maxDelayTime, timeInSample, 0);
+  fdn.feedback = 0.98f;
+}
+
+int main()
+{
+  constexpr size_t length = 16384;
+  constexpr float tolerance = 1e-4f;
+
+  std::vector<std::vector<float>> randomBase(nLine);
+  std::minstd_rand rng{0};
+  std::normal_distribution<float> normal{};
+  for (size_t i = 0; i < nLine; ++i) {
+    randomBase[i].resize(nLine - i);
+    for (auto &value : randomBase[i]) value = normal(rng);
+  }
+
+  // Voice 0 rests while voice 3 is active, so its lane is below `nActive`.
+  std::array<std::array<Event, 2>, nVoice> events{{
+    {{{0, 2000}, {9000, 15000}}},
+    {{{500, 4000}, {4100, 12000}}},
+    {{{1000, 7000}, {7500, 10000}}},
+    {{{1500, 12000}, {13000, length}}},
+  }};
+
+  // Long enough for the lowest `noteFreq` of 200 Hz.
+  auto batch = std::make_unique<BatchFDN>();
+  setup(*batch, 250.0f);
+
+  std::vector<std::unique_ptr<SingleFDN>> single(nVoice);
+  for (auto &fdn : single) {
+    fdn = std::make_unique<SingleFDN>();
+    setup(*fdn, sampleRate * maxDelayTime);
+  }
+
+  std::array<bool, nVoice> isActive{};
+  std::array<std::minstd_rand, nVoice> noise;
+  std::uniform_real_distribution<float> dist{-1.0f, 1.0f};
+
+  size_t nError = 0;
+  for (size_t frame = 0; frame < length; ++frame) {
+    if (frame == 5000) {
+      for (size_t line = 0; line < nLine; ++line) batch->delay.reserve(line, 1000.0f);
+    }
+    if (frame % 64 == 0) batch->delay.updateBuffer();
+
+    size_t nActive = 0;
+    for (size_t voice = 0; voice < nVoice; ++voice) {
+      for (size_t idx = 0; idx < events[voice].size(); ++idx) {
+        const auto &ev = events[voice][idx];
+        if (frame == ev.noteOn) {
+          unsigned seed = unsigned(voice * 2 + idx);
+          noteOn(*batch, voice, seed, randomBase);
+          noteOn(*single[voice], 0, seed, randomBase);
+          noise[voice].seed(seed + 1);
+          isActive[voice] = true;
+        } else if (frame == ev.rest) {
+          batch->reset(voice);
+          isActive[voice] = false;
+        }
+      }
+
+      if (!isActive[voice]) {
+        batch->input[voice] = 0;
+        continue;
+      }
+      auto sig = 0.1f * dist(noise[voice]);
+      batch->input[voice] = sig;
+      single[voice]->input[0] = sig;
+      nActive = voice + 1;
+    }
+
+    batch->process(nActive);
+    for (size_t voice = 0; voice < nVoice; ++voice) {
+      if (isActive[voice]) single[voice]->process(1);
+    }
+
+    for (size_t voice = 0; voice < nActive; ++voice) {
+      const float expected = isActive[voice] ? single[voice]->output[0] : 0.0f;
+      const float actual = batch->output[voice];
+      bool isFailed = isActive[voice]
+        ? std::fabs(actual - expected) > tolerance * std::max(std::fabs(expected), 1.0f)
+        : actual != 0.0f;
+      if (!isFailed) continue;
+
+      std::cerr << "Error: frame " << frame << ", voice " << voice << ": batched "
+                << actual << " and single " << expected << " are not equal.\n";
+      if (++nError >= 16) return EXIT_FAILURE;
+    }
+  }
+
+  for (size_t line = 0; line < nLine; ++line) {
+    if (batch->delay.size[line] > 1000) continue;
+    std::cerr << "Error: line " << line << " didn't grow.\n";
+    return EXIT_FAILURE;
+  }
+
+  if (nError == 0) std::cout << "All lanes matched the single voice network.\n";
+  return nError == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -15,7 +15,7 @@
 // You should have received a copy of the GNU General Public License
 // along with CubicPadSynth.  If not, see <https://www.gnu.org/licenses/>.
 
-#include "dspcore.hpp"
+#include "dspcoreimpl.hpp"
 
 #include "../../../lib/juce_FastMathApproximations.h"
 #include "../../../lib/vcl/vectormath_exp.h"
@@ -26,9 +26,32 @@
 
 #include <iostream>
 
-#define PROCESSING_UNIT_NAME ProcessingUnit_FixedInstruction
-#define NOTE_NAME Note_FixedInstruction
-#define DSPCORE_NAME DSPCore_FixedInstruction
+#if defined(__arm64__) || defined(__aarch64__)
+  #define PROCESSING_UNIT_NAME ProcessingUnit_FixedInstruction
+  #define NOTE_NAME Note_FixedInstruction
+  #define DSPCORE_NAME DSPCore_FixedInstruction
+  #define CREATE_DSPCORE_NAME createDSPCore_FixedInstruction
+#elif INSTRSET >= 10
+  #define PROCESSING_UNIT_NAME ProcessingUnit_AVX512
+  #define NOTE_NAME Note_AVX512
+  #define DSPCORE_NAME DSPCore_AVX512
+  #define CREATE_DSPCORE_NAME createDSPCore_AVX512
+#elif INSTRSET >= 8
+  #define PROCESSING_UNIT_NAME ProcessingUnit_AVX2
+  #define NOTE_NAME Note_AVX2
+  #define DSPCORE_NAME DSPCore_AVX2
+  #define CREATE_DSPCORE_NAME createDSPCore_AVX2
+#elif INSTRSET >= 7
+  #define PROCESSING_UNIT_NAME ProcessingUnit_AVX
+  #define NOTE_NAME Note_AVX
+  #define DSPCORE_NAME DSPCore_AVX
+  #define CREATE_DSPCORE_NAME createDSPCore_AVX
+#else
+  #error Unsupported instruction set
+#endif
+
+namespace SomeDSP {
+SOMEDSP_ISA_NAMESPACE_BEGIN
 
 inline float clamp(float value, float min, float max)
 {
@@ -132,8 +155,6 @@ DSPCORE_NAME::DSPCORE_NAME()
   noteIndices.reserve(maxVoice);
   voiceIndices.reserve(maxVoice);
 
-  midiNotes.reserve(maxVoice);
-
   for (int i = 0; i < notes.size(); ++i) {
     notes[i].vecIndex = i % 16;
     notes[i].arrayIndex = i / 16;
@@ -144,7 +165,7 @@ void DSPCORE_NAME::setup(double sampleRate)
 {
   this->sampleRate = float(sampleRate);
 
-  midiNotes.resize(0);
+  midiNotes.clear();
 
   SmootherCommon<float>::setSampleRate(this->sampleRate);
   SmootherCommon<float>::setTime(0.04f);
@@ -159,6 +180,9 @@ void DSPCORE_NAME::setup(double sampleRate)
   // 2 msec + 1 sample transition time.
   transitionBuffer.resize(1 + size_t(this->sampleRate * 0.01), {0.0f, 0.0f});
 
+  // 20 msec crossfade on wavetable swap.
+  tableFadeLength = 1 + size_t(this->sampleRate * 0.02);
+
   startup();
   prepareRefresh = true;
 }
@@ -201,6 +225,11 @@ void DSPCORE_NAME::reset()
   trIndex = 0;
   trStop = 0;
 
+  if (tableFadeCounter > 0) {
+    tableFadeCounter = 0;
+    wavetable.releaseBackTable();
+  }
+
   startup();
 }
 
@@ -283,27 +312,29 @@ std::array<float, 2> PROCESSING_UNIT_NAME::process(
   float sampleRate,
   WaveTable<tableSize, nOvertone> &wavetable,
   LfoWaveTable<lfoTableSize> &lfoWaveTable,
-  NoteProcessInfo &info)
+  const NoteProcessFrame &frm)
 {
-  lfo.setFrequency(sampleRate, info.lfoFrequency.getValue());
-  Vec16f lfoSig = info.lfoPitchAmount.getValue() * lfo.process(lfoWaveTable.table);
-  lfoSmoother.setP(info.lfoLowpass.getValue());
+  lfo.setFrequency(sampleRate, frm.lfoFrequency);
+  Vec16f lfoSig = frm.lfoPitchAmount * lfo.process(lfoWaveTable.table);
+  lfoSmoother.setP(frm.lfoLowpass);
   lfoSig = lfoSmoother.process(lfoSig);
 
-  pitch = lfoSig + notePitch + info.masterPitch.getValue()
-    + info.pitchEnvelopeAmount.getValue() * pitchEnvelope.process();
+  pitch = lfoSig + notePitch + frm.masterPitch
+    + frm.pitchEnvelopeAmount * pitchEnvelope.process();
   osc.setFrequency(
-    notePitchToFrequency(
-      pitch, info.equalTemperament.getValue(), info.pitchA4Hz.getValue()),
+    notePitchToFrequency(pitch, frm.equalTemperament, frm.pitchA4Hz),
     wavetable.tableBaseFreq);
 
-  float lpKey = info.tableLowpassKeyFollow.getValue();
-  float lpCutoff = info.tableLowpass.getValue();
+  float lpKey = frm.tableLowpassKeyFollow;
+  float lpCutoff = frm.tableLowpass;
   float lpPt = lpCutoff * 128.0f; // 128 comes from midi note number range + 1.
   lowpassPitch = (lpPt + lpKey * (lpCutoff * (float(nTable) - pitch) - lpPt))
-    - lowpassEnvelope.process() * info.tableLowpassEnvelopeAmount.getValue();
+    - lowpassEnvelope.process() * frm.tableLowpassEnvelopeAmount;
   lowpassPitch = select(lowpassPitch < 0.0f, 0.0f, lowpassPitch);
-  Vec16f sig = osc.processCubic(lowpassPitch + pitch, wavetable.table);
+  Vec16f sig = frm.tableFade <= 0
+    ? osc.processCubic(lowpassPitch + pitch, wavetable.table)
+    : osc.processCubic(
+      lowpassPitch + pitch, wavetable.table, wavetable.backTable, frm.tableFade);
 
   gain = velocity * gainEnvelope.process();
   isActive = horizontal_add(gain) != 0;
@@ -317,9 +348,27 @@ std::array<float, 2> PROCESSING_UNIT_NAME::process(
   return frame;
 }
 
+size_t PROCESSING_UNIT_NAME::processBlock(
+  float sampleRate,
+  WaveTable<tableSize, nOvertone> &wavetable,
+  LfoWaveTable<lfoTableSize> &lfoWaveTable,
+  const NoteProcessFrame *frm,
+  size_t length,
+  std::array<float, 2> *dest)
+{
+  // Stops at the same sample where serial `process()` starts to skip this unit.
+  for (size_t i = 0; i < length; ++i) {
+    dest[i] = process(sampleRate, wavetable, lfoWaveTable, frm[i]);
+    if (!isActive) return i + 1;
+  }
+  return length;
+}
+
 void DSPCORE_NAME::process(const size_t length, float *out0, float *out1)
 {
-  if (wavetable.isRefreshing) {
+  if (wavetable.swapTable()) tableFadeCounter = tableFadeLength;
+
+  if (!wavetable.hasTable) {
     for (int i = 0; i < length; ++i) {
       processMidiNote(i);
       out0[i] = 0;
@@ -330,30 +379,31 @@ void DSPCORE_NAME::process(const size_t length, float *out0, float *out1)
 
   SmootherCommon<float>::setBufferSize(float(length));
 
+  if (renderPool.size() > 1) {
+    processParallel(length, out0, out1);
+    return;
+  }
+
   std::array<float, 2> frame{};
   for (uint32_t i = 0; i < length; ++i) {
     processMidiNote(i);
 
-    info.masterPitch.process();
-    info.equalTemperament.process();
-    info.pitchA4Hz.process();
-    info.tableLowpass.process();
-    info.tableLowpassKeyFollow.process();
-    info.tableLowpassEnvelopeAmount.process();
-    info.pitchEnvelopeAmount.process();
-    info.lfoFrequency.process();
-    info.lfoPitchAmount.process();
-    info.lfoLowpass.process();
+    const auto frm = info.process(float(tableFadeCounter) / float(tableFadeLength));
 
     frame.fill(0.0f);
 
     for (auto &unit : units) {
       if (!unit.isActive) continue;
-      auto sig = unit.process(sampleRate, wavetable, lfoWavetable, info);
+      auto sig = unit.process(sampleRate, wavetable, lfoWavetable, frm);
       frame[0] += sig[0];
       frame[1] += sig[1];
     }
 
+    if (tableFadeCounter > 0) {
+      --tableFadeCounter;
+      if (tableFadeCounter == 0) wavetable.releaseBackTable();
+    }
+
     if (isTransitioning) {
       frame[0] += transitionBuffer[trIndex][0];
       frame[1] += transitionBuffer[trIndex][1];
@@ -368,6 +418,69 @@ void DSPCORE_NAME::process(const size_t length, float *out0, float *out1)
   }
 }
 
+/**
+Renders active units on `renderPool`. Block is split at note events and
+`renderBlockSize`, then each unit writes a segment to its own buffer. Summation order
+and arithmetic are the same as the serial loop in `process()`, so the output is
+identical.
+*/
+void DSPCORE_NAME::processParallel(const size_t length, float *out0, float *out1)
+{
+  size_t start = 0;
+  while (start < length) {
+    processMidiNote(uint32_t(start));
+
+    const size_t end = std::min({length, start + renderBlockSize, midiNotes.nextFrame()});
+    const size_t segLength = end - start;
+
+    bool releaseBackTable = false;
+    for (size_t i = 0; i < segLength; ++i) {
+      frameInfo[i] = info.process(float(tableFadeCounter) / float(tableFadeLength));
+      if (tableFadeCounter > 0) {
+        --tableFadeCounter;
+        if (tableFadeCounter == 0) releaseBackTable = true;
+      }
+    }
+
+    unitLength.fill(0);
+    auto renderUnit = [&](size_t idx) {
+      auto &unit = units[idx];
+      if (!unit.isActive) return;
+      unitLength[idx] = unit.processBlock(
+        sampleRate, wavetable, lfoWavetable, frameInfo.data(), segLength,
+        unitBuffer[idx].data());
+    };
+    renderPool.run(nUnit, renderUnit);
+
+    if (releaseBackTable) wavetable.releaseBackTable();
+
+    std::array<float, 2> frame{};
+    for (size_t i = 0; i < segLength; ++i) {
+      frame.fill(0.0f);
+
+      for (size_t idx = 0; idx < nUnit; ++idx) {
+        if (i >= unitLength[idx]) continue;
+        frame[0] += unitBuffer[idx][i][0];
+        frame[1] += unitBuffer[idx][i][1];
+      }
+
+      if (isTransitioning) {
+        frame[0] += transitionBuffer[trIndex][0];
+        frame[1] += transitionBuffer[trIndex][1];
+        transitionBuffer[trIndex].fill(0.0f);
+        trIndex = (trIndex + 1) % transitionBuffer.size();
+        if (trIndex == trStop) isTransitioning = false;
+      }
+
+      const auto masterGain = interpMasterGain.process();
+      out0[start + i] = masterGain * frame[0];
+      out1[start + i] = masterGain * frame[1];
+    }
+
+    start = end;
+  }
+}
+
 enum UnisonPanType {
   unisonPanAlternateLR,
   unisonPanAlternateMS,
@@ -548,6 +661,9 @@ void DSPCORE_NAME::noteOn(int32_t identifier, int16_t pitch, float tuning, float
 
 void DSPCORE_NAME::fillTransitionBuffer(size_t noteIndex)
 {
+  // `wavetable.table` is null until the first table is published.
+  if (!wavetable.hasTable) return;
+
   isTransitioning = true;
 
   // Beware the negative overflow. trStop is size_t.
@@ -589,33 +705,38 @@ void DSPCORE_NAME::refreshTable()
 {
   using ID = ParameterID::ID;
 
-  reset();
+  WaveTable<tableSize, nOvertone>::PadSynthParameter prm;
+
+  prm.sampleRate = sampleRate;
+  prm.tableBaseFreq = param.value[ID::tableBaseFrequency]->getFloat();
 
-  const float tableBaseFreq = param.value[ID::tableBaseFrequency]->getFloat();
   const float pitchMultiplier = param.value[ID::overtonePitchMultiply]->getFloat();
   const float pitchModulo = param.value[ID::overtonePitchModulo]->getFloat();
   const float gainPow = param.value[ID::overtoneGainPower]->getFloat();
   const float widthMul = param.value[ID::overtoneWidthMultiply]->getFloat();
 
   for (size_t idx = 0; idx < nOvertone; ++idx) {
-    otFrequency[idx] = (pitchMultiplier * idx + 1.0f) * tableBaseFreq
+    prm.frequency[idx] = (pitchMultiplier * idx + 1.0f) * prm.tableBaseFreq
       * param.value[ID::overtonePitch0 + idx]->getFloat();
     if (pitchModulo != 0)
-      otFrequency[idx]
-        = fmodf(otFrequency[idx], notePitchToFrequency(pitchModulo, 12.0f, 440.0f));
-    otGain[idx] = powf(param.value[ID::overtoneGain0 + idx]->getFloat(), gainPow);
-    otBandWidth[idx] = widthMul * param.value[ID::overtoneWidth0 + idx]->getFloat();
-    otPhase[idx] = param.value[ID::overtonePhase0 + idx]->getFloat();
+      prm.frequency[idx]
+        = fmodf(prm.frequency[idx], notePitchToFrequency(pitchModulo, 12.0f, 440.0f));
+    prm.gain[idx] = powf(param.value[ID::overtoneGain0 + idx]->getFloat(), gainPow);
+    prm.bandWidth[idx] = widthMul * param.value[ID::overtoneWidth0 + idx]->getFloat();
+    prm.phase[idx] = param.value[ID::overtonePhase0 + idx]->getFloat();
   }
 
-  wavetable.padsynth(
-    sampleRate, tableBaseFreq, otFrequency, otGain, otPhase, otBandWidth,
-    param.value[ID::padSynthSeed]->getInt(), param.value[ID::spectrumExpand]->getFloat(),
-    int32_t(param.value[ID::spectrumShift]->getInt()) - spectrumSize,
-    param.value[ID::profileComb]->getInt() + 1, param.value[ID::profileShape]->getFloat(),
-    param.value[ID::overtonePitchRandom]->getInt(),
-    param.value[ID::spectrumInvert]->getInt(),
-    param.value[ID::uniformPhaseProfile]->getInt());
+  prm.seed = param.value[ID::padSynthSeed]->getInt();
+  prm.expand = param.value[ID::spectrumExpand]->getFloat();
+  prm.shift = int32_t(param.value[ID::spectrumShift]->getInt()) - spectrumSize;
+  prm.profileSkip = param.value[ID::profileComb]->getInt() + 1;
+  prm.profileShape = param.value[ID::profileShape]->getFloat();
+  prm.randomPitch = param.value[ID::overtonePitchRandom]->getInt();
+  prm.invertSpectrum = param.value[ID::spectrumInvert]->getInt();
+  prm.uniformPhaseProfile = param.value[ID::uniformPhaseProfile]->getInt();
+
+  // Table is built on worker thread, and swapped in `process()` at block boundary.
+  wavetable.requestRefresh(prm);
 }
 
 void DSPCORE_NAME::refreshLfo()
@@ -630,3 +751,11 @@ void DSPCORE_NAME::refreshLfo()
 
   lfoWavetable.refreshTable(table, param.value[ID::lfoWavetableType]->getInt());
 }
+
+SOMEDSP_ISA_NAMESPACE_END
+} // namespace SomeDSP
+
+std::unique_ptr<DSPInterface> CREATE_DSPCORE_NAME()
+{
+  return std::make_unique<SomeDSP::DSPCORE_NAME>();
+}
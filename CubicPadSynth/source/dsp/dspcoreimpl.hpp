@@ -0,0 +1,308 @@
+// (c) 2020-2022 Takamitsu Endo
+//
+// This file is part of EnvelopedSine.
+//
+// EnvelopedSine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// EnvelopedSine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with EnvelopedSine.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "../../../common/dsp/constants.hpp"
+#include "../../../common/dsp/isanamespace.hpp"
+#include "../../../common/dsp/smoother.hpp"
+#include "../../../common/dsp/workerpool.hpp"
+#include "../../../lib/vcl.hpp"
+#include "../../../lib/vcl/vectormath_exp.h"
+#include "dspcore.hpp"
+#include "envelope.hpp"
+#include "noise.hpp"
+#include "oscillator.hpp"
+
+#include <array>
+#include <cmath>
+#include <random>
+
+namespace SomeDSP {
+SOMEDSP_ISA_NAMESPACE_BEGIN
+
+class EMAFilter16 {
+public:
+  void setP(float p) { kp = std::clamp<float>(p, float(0), float(1)); };
+  void setP(int index, float p) { kp.insert(index, p); };
+  void reset() { value = 0; }
+  Vec16f process(Vec16f input) { return value += kp * (input - value); }
+
+private:
+  Vec16f kp = 1; // In [0, 1].
+  Vec16f value = 0;
+};
+
+inline float calcMasterPitch(int32_t octave, int32_t semi, int32_t milli, float bend)
+{
+  return 12 * octave + semi + milli / 1000.0f + (bend - 0.5f) * 4.0f;
+}
+
+inline float getMasterPitch(GlobalParameter &param)
+{
+  using ID = ParameterID::ID;
+  return calcMasterPitch(
+    int32_t(param.value[ID::oscOctave]->getInt()) - 12,
+    param.value[ID::oscSemi]->getInt() - 120, param.value[ID::oscMilli]->getInt() - 1000,
+    param.value[ID::pitchBend]->getFloat());
+}
+
+constexpr size_t nUnit = 8;
+
+// Length of sub-block used to render units on worker threads.
+constexpr size_t renderBlockSize = 256;
+
+enum class NoteState { active, release, rest };
+
+// Values of `NoteProcessInfo` at a sample. Shared read-only by units.
+struct NoteProcessFrame {
+  float masterPitch;
+  float equalTemperament;
+  float pitchA4Hz;
+  float tableLowpass;
+  float tableLowpassKeyFollow;
+  float tableLowpassEnvelopeAmount;
+  float pitchEnvelopeAmount;
+  float lfoFrequency;
+  float lfoPitchAmount;
+  float lfoLowpass;
+  float tableFade;
+};
+
+struct NoteProcessInfo {
+  std::minstd_rand rng{0};
+
+  LinearSmoother<float> masterPitch;
+  LinearSmoother<float> equalTemperament;
+  LinearSmoother<float> pitchA4Hz;
+  LinearSmoother<float> tableLowpass;
+  LinearSmoother<float> tableLowpassKeyFollow;
+  LinearSmoother<float> tableLowpassEnvelopeAmount;
+  LinearSmoother<float> pitchEnvelopeAmount;
+  LinearSmoother<float> lfoFrequency;
+  LinearSmoother<float> lfoPitchAmount;
+  LinearSmoother<float> lfoLowpass;
+
+  void reset(GlobalParameter &param)
+  {
+    using ID = ParameterID::ID;
+
+    masterPitch.reset(getMasterPitch(param));
+    equalTemperament.reset(param.value[ID::equalTemperament]->getFloat() + 1);
+    pitchA4Hz.reset(param.value[ID::pitchA4Hz]->getFloat() + 100);
+    tableLowpass.reset(
+      float(Scales::tableLowpass.getMax()) - param.value[ID::tableLowpass]->getFloat());
+    tableLowpassKeyFollow.reset(param.value[ID::tableLowpassKeyFollow]->getFloat());
+    tableLowpassEnvelopeAmount.reset(
+      param.value[ID::tableLowpassEnvelopeAmount]->getFloat());
+    pitchEnvelopeAmount.reset(
+      param.value[ID::pitchEnvelopeAmount]->getFloat()
+      * (param.value[ID::pitchEnvelopeAmountNegative]->getInt() ? -1 : 1));
+
+    lfoFrequency.reset(0);
+    lfoPitchAmount.reset(param.value[ID::lfoPitchAmount]->getFloat());
+    lfoLowpass.reset(param.value[ID::lfoLowpass]->getFloat());
+  }
+
+  NoteProcessFrame process(float tableFade)
+  {
+    NoteProcessFrame frm;
+    frm.masterPitch = masterPitch.process();
+    frm.equalTemperament = equalTemperament.process();
+    frm.pitchA4Hz = pitchA4Hz.process();
+    frm.tableLowpass = tableLowpass.process();
+    frm.tableLowpassKeyFollow = tableLowpassKeyFollow.process();
+    frm.tableLowpassEnvelopeAmount = tableLowpassEnvelopeAmount.process();
+    frm.pitchEnvelopeAmount = pitchEnvelopeAmount.process();
+    frm.lfoFrequency = lfoFrequency.process();
+    frm.lfoPitchAmount = lfoPitchAmount.process();
+    frm.lfoLowpass = lfoLowpass.process();
+    frm.tableFade = tableFade;
+    return frm;
+  }
+};
+
+#define PROCESSING_UNIT_CLASS(INSTRSET)                                                  \
+  struct ProcessingUnit_##INSTRSET {                                                     \
+    TableOsc16<tableSize> osc;                                                           \
+    LfoTableOsc16<lfoTableSize> lfo;                                                     \
+    EMAFilter16 lfoSmoother;                                                             \
+    ExpADSREnvelope16 gainEnvelope;                                                      \
+    LinearADSREnvelope16 pitchEnvelope;                                                  \
+    LinearADSREnvelope16 lowpassEnvelope;                                                \
+                                                                                         \
+    Vec16f notePitch = 0;                                                                \
+    Vec16f pitch = 0;                                                                    \
+    Vec16f lowpassPitch = 0;                                                             \
+    Vec16f notePan = 0.5f;                                                               \
+    Vec16f frequency = 1;                                                                \
+    Vec16f gain = 0;                                                                     \
+    Vec16f gain0 = 0;                                                                    \
+    Vec16f gain1 = 0;                                                                    \
+    Vec16f velocity = 0;                                                                 \
+                                                                                         \
+    bool isActive = false;                                                               \
+                                                                                         \
+    void setParameters(float sampleRate, NoteProcessInfo &info, GlobalParameter &param); \
+    std::array<float, 2> process(                                                        \
+      float sampleRate,                                                                  \
+      WaveTable<tableSize, nOvertone> &wavetable,                                        \
+      LfoWaveTable<lfoTableSize> &lfoWaveTable,                                          \
+      const NoteProcessFrame &frm);                                                      \
+    size_t processBlock(                                                                 \
+      float sampleRate,                                                                  \
+      WaveTable<tableSize, nOvertone> &wavetable,                                        \
+      LfoWaveTable<lfoTableSize> &lfoWaveTable,                                          \
+      const NoteProcessFrame *frm,                                                       \
+      size_t length,                                                                     \
+      std::array<float, 2> *dest);                                                       \
+    void reset(GlobalParameter &param);                                                  \
+  };
+
+#define NOTE_CLASS(INSTRSET)                                                             \
+  class Note_##INSTRSET {                                                                \
+  public:                                                                                \
+    NoteState state = NoteState::rest;                                                   \
+                                                                                         \
+    float sampleRate = 44100;                                                            \
+                                                                                         \
+    int vecIndex = 0;                                                                    \
+    int arrayIndex = 0;                                                                  \
+    int32_t id = -1;                                                                     \
+                                                                                         \
+    void setup(float sampleRate);                                                        \
+    void noteOn(                                                                         \
+      int32_t noteId,                                                                    \
+      float notePitch,                                                                   \
+      float velocity,                                                                    \
+      float pan,                                                                         \
+      float phase,                                                                       \
+      NoteProcessInfo &info,                                                             \
+      std::array<ProcessingUnit_##INSTRSET, nUnit> &units,                               \
+      GlobalParameter &param);                                                           \
+    void release(std::array<ProcessingUnit_##INSTRSET, nUnit> &units);                   \
+    void release(std::array<ProcessingUnit_##INSTRSET, nUnit> &units, float seconds);    \
+    void rest();                                                                         \
+    bool isAttacking(std::array<ProcessingUnit_##INSTRSET, nUnit> &units);               \
+    float getGain(std::array<ProcessingUnit_##INSTRSET, nUnit> &units);                  \
+  };
+
+
+#define DSPCORE_CLASS(INSTRSET)                                                          \
+  class DSPCore_##INSTRSET final : public DSPInterface {                                 \
+  public:                                                                                \
+    DSPCore_##INSTRSET();                                                                \
+                                                                                         \
+    void setup(double sampleRate) override;                                              \
+    void reset() override;                                                               \
+    void startup() override;                                                             \
+    void setParameters(float tempo) override;                                            \
+    void process(const size_t length, float *out0, float *out1) override;                \
+    void noteOn(int32_t noteId, int16_t pitch, float tuning, float velocity) override;   \
+    void fillTransitionBuffer(size_t noteIndex);                                         \
+    void noteOff(int32_t noteId) override;                                               \
+    void refreshTable() override;                                                        \
+    void refreshLfo() override;                                                          \
+    void setRenderThreads(size_t nThread) override { renderPool.resize(nThread); }       \
+                                                                                         \
+    void pushMidiNote(                                                                   \
+      bool isNoteOn,                                                                     \
+      uint32_t frame,                                                                    \
+      int32_t noteId,                                                                    \
+      int16_t pitch,                                                                     \
+      float tuning,                                                                      \
+      float velocity) override                                                           \
+    {                                                                                    \
+      MidiNote note;                                                                     \
+      note.isNoteOn = isNoteOn;                                                          \
+      note.frame = frame;                                                                \
+      note.id = noteId;                                                                  \
+      note.pitch = pitch;                                                                \
+      note.tuning = tuning;                                                              \
+      note.velocity = velocity;                                                          \
+      midiNotes.push(note);                                                              \
+    }                                                                                    \
+                                                                                         \
+    void processMidiNote(uint32_t frame) override                                        \
+    {                                                                                    \
+      midiNotes.dispatch(frame, [&](MidiNote &note) {                                    \
+        if (note.isNoteOn)                                                               \
+          noteOn(note.id, note.pitch, note.tuning, note.velocity);                       \
+        else                                                                             \
+          noteOff(note.id);                                                              \
+      });                                                                                \
+    }                                                                                    \
+                                                                                         \
+  private:                                                                               \
+    void processParallel(const size_t length, float *out0, float *out1);                 \
+    void sortVoiceIndicesByGain();                                                       \
+    void terminateNotes(size_t nNote);                                                   \
+                                                                                         \
+    float sampleRate = 44100.0f;                                                         \
+                                                                                         \
+    bool prepareRefresh = true;                                                          \
+    bool isTableRefeshed = false;                                                        \
+    bool isLFORefreshed = false;                                                         \
+    WaveTable<tableSize, nOvertone> wavetable;                                           \
+    size_t tableFadeLength = 1;                                                          \
+    size_t tableFadeCounter = 0;                                                         \
+    LfoWaveTable<lfoTableSize> lfoWavetable;                                             \
+    std::array<ProcessingUnit_##INSTRSET, nUnit> units;                                  \
+                                                                                         \
+    size_t nVoice = 32;                                                                  \
+    int32_t panCounter = 0;                                                              \
+    std::vector<size_t> noteIndices;                                                     \
+    std::vector<size_t> voiceIndices;                                                    \
+    std::vector<float> unisonPan;                                                        \
+    std::array<Note_##INSTRSET, maxVoice> notes;                                         \
+                                                                                         \
+    NoteProcessInfo info;                                                                \
+    LinearSmoother<float> interpMasterGain;                                              \
+                                                                                         \
+    std::vector<std::array<float, 2>> transitionBuffer{};                                \
+    bool isTransitioning = false;                                                        \
+    size_t trIndex = 0;                                                                  \
+    size_t trStop = 0;                                                                   \
+    TableOsc<tableSize> trOsc;                                                           \
+                                                                                         \
+    SpinWorkerPool renderPool;                                                           \
+    std::array<NoteProcessFrame, renderBlockSize> frameInfo;                             \
+    std::array<size_t, nUnit> unitLength{};                                              \
+    std::array<std::array<std::array<float, 2>, renderBlockSize>, nUnit> unitBuffer{};   \
+  };
+
+#if defined(__arm64__) || defined(__aarch64__)
+PROCESSING_UNIT_CLASS(FixedInstruction)
+NOTE_CLASS(FixedInstruction)
+DSPCORE_CLASS(FixedInstruction)
+#elif INSTRSET >= 10
+PROCESSING_UNIT_CLASS(AVX512)
+NOTE_CLASS(AVX512)
+DSPCORE_CLASS(AVX512)
+#elif INSTRSET >= 8
+PROCESSING_UNIT_CLASS(AVX2)
+NOTE_CLASS(AVX2)
+DSPCORE_CLASS(AVX2)
+#elif INSTRSET >= 7
+PROCESSING_UNIT_CLASS(AVX)
+NOTE_CLASS(AVX)
+DSPCORE_CLASS(AVX)
+#endif
+
+SOMEDSP_ISA_NAMESPACE_END
+} // namespace SomeDSP
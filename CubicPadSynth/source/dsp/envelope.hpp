@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include "../../../common/dsp/isanamespace.hpp"
 #include "../../../common/dsp/smoother.hpp"
 #include "../../../lib/vcl.hpp"
 #include "../../../lib/vcl/vectormath_exp.h"
@@ -26,6 +27,7 @@
 #include <cmath>
 
 namespace SomeDSP {
+SOMEDSP_ISA_NAMESPACE_BEGIN
 
 class alignas(64) ExpADSREnvelope16 {
 public:
@@ -267,4 +269,5 @@ protected:
   Vec16f out = 0;
 };
 
+SOMEDSP_ISA_NAMESPACE_END
 } // namespace SomeDSP
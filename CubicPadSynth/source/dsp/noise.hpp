@@ -17,11 +17,13 @@
 
 #pragma once
 
+#include "../../../common/dsp/isanamespace.hpp"
 #include "../../../lib/vcl.hpp"
 
 #include <cstdint>
 
 namespace SomeDSP {
+SOMEDSP_ISA_NAMESPACE_BEGIN
 
 // Numerical Recipes In C p.284. Normalized to [0, 1).
 template<typename Sample> class Random {
@@ -58,4 +60,5 @@ struct alignas(64) White16 {
   }
 };
 
+SOMEDSP_ISA_NAMESPACE_END
 } // namespace SomeDSP
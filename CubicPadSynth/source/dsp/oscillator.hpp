@@ -18,17 +18,26 @@
 #pragma once
 
 #include "../../../common/dsp/constants.hpp"
+#include "../../../common/dsp/isanamespace.hpp"
+#include "../../../common/dsp/sharedcache.hpp"
+#include "../../../common/dsp/tablediskcache.hpp"
 #include "../../../lib/fftw3/fftw3.h"
 #include "../../../lib/vcl.hpp"
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstring>
 #include <deque>
+#include <memory>
 #include <mutex>
 #include <random>
+#include <thread>
 
 namespace SomeDSP {
+SOMEDSP_ISA_NAMESPACE_BEGIN
 
 constexpr size_t nTable = 136; // midi note nubmer 136 ~= 21096 Hz.
 constexpr size_t nTablePadded = nTable + 4;
@@ -74,59 +83,318 @@ table is 2d array which has extra padding for interpolation.
 - Padded last 2 columns has first and second element of original table.
 - Padded first row is copy of first row of original table.
 - Padded last 3 row is silence.
+
+Each row is stored as a mipmap level. Row `idx` is decimated by `2^shift`. Higher
+notes have less bins, so they can be stored in shorter rows. One more element is
+padded at the end of each row to guard against rounding in index scaling, so a row
+has `(tableSize >> shift) + 4` elements.
 */
+struct TableMipmap {
+  std::array<float *, nTablePadded> row{};
+
+  // `scale[idx] = 2^-shift`. Multiply to phase on full length table to get index on row.
+  std::array<float, nTablePadded> scale{};
+};
+
 template<size_t tableSize, size_t nPeak> struct WaveTable {
   // `fftwMutex` is used to lock FFTW3 calls except `fftw*_execute`.
   static std::mutex fftwMutex;
 
   static constexpr size_t spectrumSize = tableSize / 2 + 1;
-  static constexpr size_t paddedSize = tableSize + 3;
+
+  // Highest bin of a row is kept under `1 / mipmapOversample` of its Nyquist frequency,
+  // to keep the error of cubic interpolation small.
+  static constexpr size_t mipmapOversample = 32;
+  static constexpr size_t minRowLength = 1024;
+
+  using MipmapShift = std::array<uint32_t, nTablePadded>;
+
+  static constexpr size_t rowLength(uint32_t shift) { return (tableSize >> shift) + 4; }
+
+  struct PadSynthParameter {
+    float sampleRate = 44100.0f;
+    float tableBaseFreq = 20.0f;
+    std::array<float, nPeak> frequency{};
+    std::array<float, nPeak> gain{};
+    std::array<float, nPeak> phase{};
+    std::array<float, nPeak> bandWidth{};
+    uint32_t seed = 0;
+    float expand = 1.0f;
+    int32_t shift = 0;
+    uint32_t profileSkip = 1;
+    float profileShape = 1.0f;
+    bool randomPitch = false;
+    bool invertSpectrum = false;
+    bool uniformPhaseProfile = false;
+
+    bool operator==(const PadSynthParameter &rhs) const
+    {
+      return sampleRate == rhs.sampleRate && tableBaseFreq == rhs.tableBaseFreq
+        && frequency == rhs.frequency && gain == rhs.gain && phase == rhs.phase
+        && bandWidth == rhs.bandWidth && seed == rhs.seed && expand == rhs.expand
+        && shift == rhs.shift && profileSkip == rhs.profileSkip
+        && profileShape == rhs.profileShape && randomPitch == rhs.randomPitch
+        && invertSpectrum == rhs.invertSpectrum
+        && uniformPhaseProfile == rhs.uniformPhaseProfile;
+    }
+
+    template<typename Visitor> void visit(Visitor &visitor) const
+    {
+      visitor.add(sampleRate);
+      visitor.add(tableBaseFreq);
+      visitor.addArray(frequency);
+      visitor.addArray(gain);
+      visitor.addArray(phase);
+      visitor.addArray(bandWidth);
+      visitor.add(seed);
+      visitor.add(expand);
+      visitor.add(shift);
+      visitor.add(profileSkip);
+      visitor.add(profileShape);
+      visitor.add(uint8_t(randomPitch));
+      visitor.add(uint8_t(invertSpectrum));
+      visitor.add(uint8_t(uniformPhaseProfile));
+    }
+
+    using Hash = CacheKeyHash<PadSynthParameter>;
+  };
+
+  // A set of band limited tables. Shared between plugin instances through `Cache`, and
+  // read-only after built. All rows are placed in a single buffer, which is either
+  // allocated by `allocate()`, or mapped from disk.
+  struct TableSet {
+    TableMipmap table;
+    float *storage = nullptr;
+    size_t storageSize = 0;
+    std::unique_ptr<TableDiskCache::Entry> mapped;
+
+    TableSet() {}
+
+    ~TableSet()
+    {
+      if (storage == nullptr) return;
+
+      const std::lock_guard<std::mutex> fftwLock(fftwMutex);
+      fftwf_free(storage);
+    }
+
+    static size_t getStorageSize(const MipmapShift &shift)
+    {
+      size_t size = 0;
+      for (const auto &sft : shift) size += rowLength(sft);
+      return size;
+    }
+
+    void setLayout(const MipmapShift &shift, float *head)
+    {
+      for (size_t idx = 0; idx < nTablePadded; ++idx) {
+        table.row[idx] = head;
+        table.scale[idx] = 1.0f / float(size_t(1) << shift[idx]);
+        head += rowLength(shift[idx]);
+      }
+    }
+
+    void allocate(const MipmapShift &shift)
+    {
+      storageSize = getStorageSize(shift);
+      {
+        const std::lock_guard<std::mutex> fftwLock(fftwMutex);
+        storage = (float *)fftwf_malloc(sizeof(float) * storageSize);
+      }
+      std::memset(storage, 0, sizeof(float) * storageSize);
+      setLayout(shift, storage);
+    }
+
+    // Tables from disk are never written, so `const_cast` is safe here.
+    bool
+    load(TableDiskCache &disk, const PadSynthParameter &prm, const MipmapShift &shift)
+    {
+      storageSize = getStorageSize(shift);
+      mapped = disk.load(prm, 1, storageSize);
+      if (!mapped) return false;
+      setLayout(shift, const_cast<float *>(mapped->table(0)));
+      return true;
+    }
+
+    TableSet(const TableSet &) = delete;
+    TableSet &operator=(const TableSet &) = delete;
+  };
+
+  using Cache = SharedCache<PadSynthParameter, TableSet>;
+
+  // Increment `generatorVersion` when `padsynth()` is changed.
+  static TableDiskCache &diskCache()
+  {
+    static TableDiskCache cache("CubicPadSynth", 2);
+    return cache;
+  }
+
   fftwf_complex *spectrum;
   fftwf_complex *bandLimited;
   fftwf_complex *tmpSpec;
-  std::array<float *, nTablePadded> table;
-  std::array<fftwf_plan, nTablePadded> plan;
+  float *fullTable; // Output of inverse FFT, before decimated into mipmap.
+  fftwf_plan plan;
   std::array<float, nTablePadded> frequency; // Must be sorted by ascending order.
-  bool isRefreshing = true;
+
+  // `table` and `tableBaseFreq` are only touched from audio thread. `hasTable` is false
+  // until the first table is published. `table` points to `tableSet`.
+  TableMipmap table;
+  std::shared_ptr<const TableSet> tableSet;
   float tableBaseFreq = 20.0f;
+  bool hasTable = false;
+
+  // Back buffer. `worker` acquires a table set from `Cache` here, then audio thread
+  // swaps it with `table` in `swapTable()`. While crossfading, `backTable` holds the
+  // previous table and audio thread keeps reading it until `releaseBackTable()` is
+  // called. The previous set is dropped by `worker` on next acquisition, so that the
+  // table memory is never freed on audio thread.
+  TableMipmap backTable;
+  std::shared_ptr<const TableSet> backSet;
+  float backBaseFreq = 20.0f;
+  std::atomic<bool> isBackReady{false};
+  std::atomic<bool> isBackFree{true};
+
+  std::mutex requestMutex;
+  std::condition_variable requestCondition;
+  PadSynthParameter request;
+  bool isRequested = false;
+  bool isTerminating = false;
+  std::thread worker;
 
   WaveTable()
   {
-    const std::lock_guard<std::mutex> fftwLock(fftwMutex);
+    {
+      const std::lock_guard<std::mutex> fftwLock(fftwMutex);
 
-    spectrum = (fftwf_complex *)fftwf_malloc(sizeof(fftwf_complex) * spectrumSize);
-    bandLimited = (fftwf_complex *)fftwf_malloc(sizeof(fftwf_complex) * spectrumSize);
-    tmpSpec = (fftwf_complex *)fftwf_malloc(sizeof(fftwf_complex) * spectrumSize);
+      spectrum = (fftwf_complex *)fftwf_malloc(sizeof(fftwf_complex) * spectrumSize);
+      bandLimited = (fftwf_complex *)fftwf_malloc(sizeof(fftwf_complex) * spectrumSize);
+      tmpSpec = (fftwf_complex *)fftwf_malloc(sizeof(fftwf_complex) * spectrumSize);
 
-    for (size_t idx = 0; idx < nTablePadded; ++idx) {
-      table[idx] = (float *)fftwf_malloc(sizeof(float) * paddedSize);
-      table[idx][0] = 0;
-      table[idx][paddedSize - 1] = 0;
+      fullTable = (float *)fftwf_malloc(sizeof(float) * tableSize);
 
-      plan[idx]
-        = fftwf_plan_dft_c2r_1d(tableSize, bandLimited, table[idx] + 1, FFTW_ESTIMATE);
+      for (size_t idx = 0; idx < nTablePadded; ++idx) {
+        // TODO: Experiment with different frequency.
+        frequency[idx] = 440.0f * powf(2.0f, (idx - 69.0f) / 12.0f);
+      }
 
-      // TODO: Experiment with different frequency.
-      frequency[idx] = 440.0f * powf(2.0f, (idx - 69.0f) / 12.0f);
+      plan = fftwf_plan_dft_c2r_1d(tableSize, bandLimited, fullTable, FFTW_ESTIMATE);
     }
 
-    // Last 3 tables are slince.
-    for (size_t idx = nTablePadded - 3; idx < nTablePadded; ++idx) {
-      for (size_t i = 0; i < paddedSize; ++i) table[idx][i] = 0;
-    }
+#ifndef TEST_DSP
+    worker = std::thread(&WaveTable::workerLoop, this);
+#endif
   }
 
   ~WaveTable()
   {
+    {
+      std::lock_guard<std::mutex> lock(requestMutex);
+      isTerminating = true;
+    }
+    requestCondition.notify_one();
+    if (worker.joinable()) worker.join();
+
+    // Table sets lock `fftwMutex` on destruction.
+    tableSet.reset();
+    backSet.reset();
+
     const std::lock_guard<std::mutex> fftwLock(fftwMutex);
 
-    for (auto &pln : plan) fftwf_destroy_plan(pln);
-    for (auto &tbl : table) fftwf_free(tbl);
+    fftwf_destroy_plan(plan);
+    fftwf_free(fullTable);
     fftwf_free(tmpSpec);
     fftwf_free(bandLimited);
     fftwf_free(spectrum);
   }
 
+  // Called from any thread. If a refresh is already queued, it's overwritten by the
+  // newer one. In test build, the table is built immediately for deterministic output.
+  void requestRefresh(const PadSynthParameter &prm)
+  {
+#ifdef TEST_DSP
+    acquireBackSet(prm);
+    isBackReady.store(true, std::memory_order_release);
+#else
+    {
+      std::lock_guard<std::mutex> lock(requestMutex);
+      request = prm;
+      isRequested = true;
+    }
+    requestCondition.notify_one();
+#endif
+  }
+
+  // Called from audio thread at the start of a block. Returns true when the new table
+  // is published and the previous one is kept in `backTable` for crossfading.
+  bool swapTable()
+  {
+    if (!isBackReady.load(std::memory_order_acquire)) return false;
+
+    std::swap(table, backTable);
+    std::swap(tableSet, backSet);
+    std::swap(tableBaseFreq, backBaseFreq);
+
+    // `isBackFree` must be cleared before `isBackReady`. Otherwise `worker` may see both
+    // flags free and replace `backSet` while it's still read for crossfading.
+    const bool isFirst = !hasTable;
+    hasTable = true;
+    if (!isFirst) isBackFree.store(false, std::memory_order_release);
+    isBackReady.store(false, std::memory_order_release);
+    return !isFirst;
+  }
+
+  // Called from audio thread when crossfade is finished.
+  void releaseBackTable() { isBackFree.store(true, std::memory_order_release); }
+
+  // Called from `worker`. `isBackReady` must be loaded first. `swapTable()` clears
+  // `isBackFree` before `isBackReady`, so acquiring `isBackReady == false` guarantees
+  // that the following load doesn't see stale `isBackFree == true` while crossfading.
+  bool isBackWritable()
+  {
+    if (isBackReady.load(std::memory_order_acquire)) return false;
+    return isBackFree.load(std::memory_order_acquire);
+  }
+
+  void workerLoop()
+  {
+    while (true) {
+      PadSynthParameter prm;
+      {
+        std::unique_lock<std::mutex> lock(requestMutex);
+
+        // Audio thread doesn't notify when `backTable` is released, because notifying
+        // may lock. Polling with timeout is used instead.
+        while (!isTerminating && !(isRequested && isBackWritable())) {
+          requestCondition.wait_for(lock, std::chrono::milliseconds(10));
+        }
+        if (isTerminating) return;
+
+        prm = request;
+        isRequested = false;
+      }
+
+      acquireBackSet(prm);
+      isBackReady.store(true, std::memory_order_release);
+    }
+  }
+
+  // Called from `worker`, or from audio thread in test build. Replacing `backSet` may
+  // free the previous set if no other instance holds it.
+  void acquireBackSet(const PadSynthParameter &prm)
+  {
+    backSet = Cache::instance().acquire(
+      prm, [&](const PadSynthParameter &key, TableSet &dest) {
+        const auto shift = getMipmapShift(key.tableBaseFreq);
+        if (dest.load(diskCache(), key, shift)) return;
+        dest.allocate(shift);
+        padsynth(key, dest.table, shift);
+        const float *storage = dest.storage;
+        diskCache().store(key, &storage, 1, dest.storageSize);
+      });
+    backTable = backSet->table;
+    backBaseFreq = prm.tableBaseFreq;
+  }
+
   inline float profile(float fi, float bwi, float shape)
   {
     if (bwi < 1e-5f) bwi = 1e-5f;
@@ -134,21 +402,51 @@ template<size_t tableSize, size_t nPeak> struct WaveTable {
     return powf(expf(-x * x) / bwi, shape);
   }
 
-  void refreshTable()
+  size_t getBandIndex(float tableBaseFreq, size_t idx)
+  {
+    size_t bandIdx = size_t(spectrumSize * tableBaseFreq / frequency[idx]);
+    return std::clamp<size_t>(bandIdx, 1, spectrumSize);
+  }
+
+  MipmapShift getMipmapShift(float tableBaseFreq)
   {
-    isRefreshing = true;
+    MipmapShift shift{};
+    for (size_t idx = 2; idx < nTablePadded; ++idx) {
+      // Padded rows are silent. They take the same shift as the last row.
+      const size_t highestBin = getBandIndex(tableBaseFreq, std::min(idx, nTable)) - 1;
+      uint32_t sft = 0;
+      while ((tableSize >> (sft + 1)) >= minRowLength
+             && highestBin * mipmapOversample * 2 <= (tableSize >> (sft + 1)))
+      {
+        ++sft;
+      }
+      shift[idx] = sft;
+    }
+    return shift;
+  }
 
-    // table[0] and table[1] has full spectrum.
+  // Decimates `fullTable` into `row`. This is exact because the spectrum is already
+  // band limited under the Nyquist frequency of `row`.
+  void decimateTable(float *row, uint32_t shift)
+  {
+    const size_t length = tableSize >> shift;
+    for (size_t i = 0; i < length; ++i) row[i + 1] = fullTable[i << shift];
+  }
+
+  void
+  refreshTable(float tableBaseFreq, const TableMipmap &dest, const MipmapShift &shift)
+  {
+    // dest[0] and dest[1] has full spectrum.
     bandLimited[0][0] = 0;
     bandLimited[0][1] = 0;
     std::memcpy(
       bandLimited + 1, spectrum + 1, sizeof(fftwf_complex) * (spectrumSize - 1));
-    fftwf_execute(plan[0]);
-    std::memcpy(table[1], table[0], sizeof(float) * paddedSize);
+    fftwf_execute_dft_c2r(plan, bandLimited, fullTable);
+    decimateTable(dest.row[0], shift[0]);
+    decimateTable(dest.row[1], shift[1]);
 
     for (size_t idx = 2; idx <= nTable; ++idx) {
-      size_t bandIdx = size_t(spectrumSize * tableBaseFreq / frequency[idx]);
-      bandIdx = std::clamp<size_t>(bandIdx, 1, spectrumSize);
+      size_t bandIdx = getBandIndex(tableBaseFreq, idx);
 
       bandLimited[0][0] = 0;
       bandLimited[0][1] = 0;
@@ -156,61 +454,54 @@ template<size_t tableSize, size_t nPeak> struct WaveTable {
       std::memset(
         bandLimited + bandIdx, 0, sizeof(fftwf_complex) * (spectrumSize - bandIdx));
 
-      fftwf_execute(plan[idx]);
+      fftwf_execute_dft_c2r(plan, bandLimited, fullTable);
+      decimateTable(dest.row[idx], shift[idx]);
     }
 
     // Fill padded elements.
     for (size_t idx = 0; idx < nTablePadded - 1; ++idx) {
-      table[idx][0] = table[idx][tableSize];
-      table[idx][paddedSize - 2] = table[idx][1];
-      table[idx][paddedSize - 1] = table[idx][2];
+      const size_t length = tableSize >> shift[idx];
+      auto &row = dest.row[idx];
+      row[0] = row[length];
+      row[length + 1] = row[1];
+      row[length + 2] = row[2];
+      row[length + 3] = row[3];
     }
 
     // Normalize.
     float max = 0.0f;
     for (size_t i = 0; i < tableSize; ++i) {
-      auto value = fabsf(table[0][i]);
+      auto value = fabsf(dest.row[0][i]);
       if (max < value) max = value;
     }
     if (max != 0.0f) {
       for (size_t idx = 0; idx < nTablePadded - 1; ++idx) {
-        for (size_t i = 0; i < paddedSize; ++i) table[idx][i] /= max;
+        const size_t length = rowLength(shift[idx]);
+        for (size_t i = 0; i < length; ++i) dest.row[idx][i] /= max;
       }
     }
-
-    isRefreshing = false;
   }
 
   float sign(float x) { return float((0 < x) - (x < 0)); }
 
   void padsynth(
-    float sampleRate,
-    float tableBaseFreq,
-    std::array<float, nPeak> &frequency,
-    std::array<float, nPeak> &gain,
-    std::array<float, nPeak> &phase,
-    std::array<float, nPeak> &bandWidth,
-    uint32_t seed,
-    float expand,
-    int32_t shift,
-    uint32_t profileSkip,
-    float profileShape,
-    bool randomPitch,
-    bool invertSpectrum,
-    bool uniformPhaseProfile)
-  {
-    this->tableBaseFreq = tableBaseFreq;
+    const PadSynthParameter &prm, const TableMipmap &dest, const MipmapShift &level)
+  {
+    const float sampleRate = prm.sampleRate;
+    const float tableBaseFreq = prm.tableBaseFreq;
+    const float expand = prm.expand;
+    int32_t shift = prm.shift;
 
     for (int32_t bin = 0; bin < spectrumSize; ++bin) {
       spectrum[bin][0] = 0;
       spectrum[bin][1] = 0;
     }
 
-    std::mt19937 rng(seed);
+    std::mt19937 rng(prm.seed);
     std::uniform_real_distribution<float> distFreq(100.0f, 8000.0f);
     for (int32_t peak = 0; peak < nPeak; ++peak) {
-      float freq = randomPitch ? distFreq(rng) : frequency[peak];
-      float bandHz = (powf(2.0f, bandWidth[peak] / 1200.0f) - 1.0f) * freq;
+      float freq = prm.randomPitch ? distFreq(rng) : prm.frequency[peak];
+      float bandHz = (powf(2.0f, prm.bandWidth[peak] / 1200.0f) - 1.0f) * freq;
       float bandIdx = bandHz / (2.0f * sampleRate);
 
       float sigma = sqrtf(bandIdx * bandIdx / float(twopi));
@@ -222,19 +513,19 @@ template<size_t tableSize, size_t nPeak> struct WaveTable {
       int32_t start = std::max<int32_t>(center - profileHalf, 0);
       int32_t end = std::min<int32_t>(center + profileHalf, spectrumSize);
 
-      std::uniform_real_distribution<float> distPhase(0.0f, phase[peak]);
+      std::uniform_real_distribution<float> distPhase(0.0f, prm.phase[peak]);
       float phi = distPhase(rng);
-      for (int32_t bin = start; bin < end; bin += profileSkip) {
-        float radius = gain[peak]
+      for (int32_t bin = start; bin < end; bin += prm.profileSkip) {
+        float radius = prm.gain[peak]
           * profile(bin / float(spectrumSize) - freqIdx, bandIdx,
-                    std::floor(profileShape));
-        if (!uniformPhaseProfile) phi = distPhase(rng);
+                    std::floor(prm.profileShape));
+        if (!prm.uniformPhaseProfile) phi = distPhase(rng);
         spectrum[bin][0] += radius * cosf(phi);
         spectrum[bin][1] += radius * sinf(phi);
       }
     }
 
-    if (invertSpectrum) {
+    if (prm.invertSpectrum) {
       float reMax = 0;
       float imMax = 0;
       for (int32_t bin = 1; bin < spectrumSize; ++bin) {
@@ -288,7 +579,7 @@ template<size_t tableSize, size_t nPeak> struct WaveTable {
     spectrum[0][0] = 0.0f;
     spectrum[0][1] = 0.0f;
 
-    refreshTable();
+    refreshTable(tableBaseFreq, dest, level);
   }
 };
 
@@ -312,36 +603,30 @@ template<size_t tableSize> struct TableOsc {
     tick = 0;
   }
 
+  // Cubic interpolation on row `iy` at current phase.
+  inline float interpRow(const TableMipmap &table, size_t iy)
+  {
+    float x = (phase - 1.0f) * table.scale[iy] + 1.0f;
+    float frac = x - std::floor(x);
+    size_t x1 = size_t(x);
+    const float *row = table.row[iy];
+    return cubicInterp(row[x1 - 1], row[x1], row[x1 + 1], row[x1 + 2], frac);
+  }
+
   // notePitch is fractional note number. For example, notePitch = 60.12 means 60
   // semitones and 12 cents higher from midi note number 0.
-  float process(float notePitch, std::array<float *, nTablePadded> &table)
+  float process(float notePitch, const TableMipmap &table)
   {
     phase += tick;
     if (phase > paddedLast) phase -= tableSize;
 
     if (notePitch <= 0) {
-      float frac = phase - std::floor(phase);
-      size_t x1 = size_t(phase);
-      size_t x0 = x1 - 1;
-      size_t x2 = x1 + 1;
-      size_t x3 = x1 + 2;
-      return cubicInterp(table[0][x0], table[0][x1], table[0][x2], table[0][x3], frac);
+      return interpRow(table, 0);
     } else if (notePitch >= notePitchUpperBound) {
       return 0;
     }
     notePitch += 1.0f;
 
-    // // Bilinear interpolation.
-    // auto yFrac = notePitch - floor(notePitch);
-    // size_t south = size_t(notePitch);
-    // size_t north = south + 1;
-    // auto xFrac = phase - floor(phase);
-    // size_t L = size_t(phase);
-    // size_t R = L + 1;
-    // auto x0 = table[south][L] + xFrac * (table[south][R] - table[south][L]);
-    // auto x1 = table[north][L] + xFrac * (table[north][R] - table[north][L]);
-    // return x0 + yFrac * (x1 - x0);
-
     // Bicubic interpolation.
     auto yFrac = notePitch - std::floor(notePitch);
     size_t iy1 = size_t(notePitch);
@@ -349,20 +634,10 @@ template<size_t tableSize> struct TableOsc {
     size_t iy2 = iy1 + 1;
     size_t iy3 = iy1 + 2;
 
-    auto xFrac = phase - std::floor(phase);
-    size_t ix1 = size_t(phase);
-    size_t ix0 = ix1 - 1;
-    size_t ix2 = ix1 + 1;
-    size_t ix3 = ix1 + 2;
-
-    auto y0 = cubicInterp(
-      table[iy0][ix0], table[iy0][ix1], table[iy0][ix2], table[iy0][ix3], xFrac);
-    auto y1 = cubicInterp(
-      table[iy1][ix0], table[iy1][ix1], table[iy1][ix2], table[iy1][ix3], xFrac);
-    auto y2 = cubicInterp(
-      table[iy2][ix0], table[iy2][ix1], table[iy2][ix2], table[iy2][ix3], xFrac);
-    auto y3 = cubicInterp(
-      table[iy3][ix0], table[iy3][ix1], table[iy3][ix2], table[iy3][ix3], xFrac);
+    auto y0 = interpRow(table, iy0);
+    auto y1 = interpRow(table, iy1);
+    auto y2 = interpRow(table, iy2);
+    auto y3 = interpRow(table, iy3);
     return cubicInterp(y0, y1, y2, y3, yFrac);
   }
 };
@@ -398,22 +673,58 @@ template<size_t tableSize> struct alignas(64) TableOsc16 {
     tick = 0;
   }
 
-  inline Vec16f loadTable(Vec16i ix, Vec16i iy, std::array<float *, nTablePadded> &table)
+  inline Vec16f loadTable(Vec16i ix, Vec16i iy, const TableMipmap &table)
   {
+    const auto &row = table.row;
     return Vec16f(
-      table[iy.extract(0)][ix.extract(0)], table[iy.extract(1)][ix.extract(1)],
-      table[iy.extract(2)][ix.extract(2)], table[iy.extract(3)][ix.extract(3)],
-      table[iy.extract(4)][ix.extract(4)], table[iy.extract(5)][ix.extract(5)],
-      table[iy.extract(6)][ix.extract(6)], table[iy.extract(7)][ix.extract(7)],
-      table[iy.extract(8)][ix.extract(8)], table[iy.extract(9)][ix.extract(9)],
-      table[iy.extract(10)][ix.extract(10)], table[iy.extract(11)][ix.extract(11)],
-      table[iy.extract(12)][ix.extract(12)], table[iy.extract(13)][ix.extract(13)],
-      table[iy.extract(14)][ix.extract(14)], table[iy.extract(15)][ix.extract(15)]);
+      row[iy.extract(0)][ix.extract(0)], row[iy.extract(1)][ix.extract(1)],
+      row[iy.extract(2)][ix.extract(2)], row[iy.extract(3)][ix.extract(3)],
+      row[iy.extract(4)][ix.extract(4)], row[iy.extract(5)][ix.extract(5)],
+      row[iy.extract(6)][ix.extract(6)], row[iy.extract(7)][ix.extract(7)],
+      row[iy.extract(8)][ix.extract(8)], row[iy.extract(9)][ix.extract(9)],
+      row[iy.extract(10)][ix.extract(10)], row[iy.extract(11)][ix.extract(11)],
+      row[iy.extract(12)][ix.extract(12)], row[iy.extract(13)][ix.extract(13)],
+      row[iy.extract(14)][ix.extract(14)], row[iy.extract(15)][ix.extract(15)]);
+  }
+
+  // Index on row `iy` at current phase. Rows have different length in mipmap.
+  inline Vec16f rowIndex(Vec16i iy, const TableMipmap &table)
+  {
+    Vec16f scale = lookup<int(nTablePadded)>(iy, table.scale.data());
+    return (phase - float(1)) * scale + float(1);
+  }
+
+  inline Vec16f interpRowLinear(Vec16i iy, const TableMipmap &table)
+  {
+    Vec16f x = rowIndex(iy, table);
+    Vec16f xFrac = x - floor(x);
+    Vec16i ix0 = truncatei(x);
+    Vec16i ix1 = ix0 + 1;
+
+    Vec16f table0 = loadTable(ix0, iy, table);
+    Vec16f table1 = loadTable(ix1, iy, table);
+    return table0 + xFrac * (table1 - table0);
+  }
+
+  inline Vec16f interpRowCubic(Vec16i iy, const TableMipmap &table)
+  {
+    Vec16f x = rowIndex(iy, table);
+    Vec16f xFrac = x - floor(x);
+    Vec16i ix1 = truncatei(x);
+    Vec16i ix0 = ix1 - 1;
+    Vec16i ix2 = ix1 + 1;
+    Vec16i ix3 = ix1 + 2;
+
+    Vec16f table0 = loadTable(ix0, iy, table);
+    Vec16f table1 = loadTable(ix1, iy, table);
+    Vec16f table2 = loadTable(ix2, iy, table);
+    Vec16f table3 = loadTable(ix3, iy, table);
+    return cubicInterp(table0, table1, table2, table3, xFrac);
   }
 
   // notePitch is fractional note number. For example, notePitch = 60.12 means 60
   // semitones and 12 cents higher from midi note number 0.
-  Vec16f process(Vec16f notePitch, std::array<float *, nTablePadded> &table)
+  Vec16f process(Vec16f notePitch, const TableMipmap &table)
   {
     phase += tick;
     phase = select(phase >= paddedLast, phase - tableSize, phase);
@@ -427,27 +738,31 @@ template<size_t tableSize> struct alignas(64) TableOsc16 {
     Vec16i iy0 = truncatei(notePitch);
     Vec16i iy1 = iy0 + 1;
 
-    Vec16f xFrac = phase - floor(phase);
-    Vec16i ix0 = truncatei(phase);
-    Vec16i ix1 = ix0 + 1;
-
-    Vec16f table00 = loadTable(ix0, iy0, table);
-    Vec16f table01 = loadTable(ix1, iy0, table);
-    Vec16f y0 = table00 + xFrac * (table01 - table00);
-
-    Vec16f table10 = loadTable(ix0, iy1, table);
-    Vec16f table11 = loadTable(ix1, iy1, table);
-    Vec16f y1 = table10 + xFrac * (table11 - table10);
-
+    Vec16f y0 = interpRowLinear(iy0, table);
+    Vec16f y1 = interpRowLinear(iy1, table);
     return y0 + yFrac * (y1 - y0);
   }
 
   // Too slow.
-  Vec16f processCubic(Vec16f notePitch, std::array<float *, nTablePadded> &table)
+  Vec16f processCubic(Vec16f notePitch, const TableMipmap &table)
   {
     phase += tick;
     phase = select(phase >= paddedLast, phase - tableSize, phase);
+    return interpCubic(notePitch, table);
+  }
 
+  // Crossfades from `fadeTable` to `table`. `fade` is the gain of `fadeTable`.
+  Vec16f processCubic(
+    Vec16f notePitch, const TableMipmap &table, const TableMipmap &fadeTable, float fade)
+  {
+    phase += tick;
+    phase = select(phase >= paddedLast, phase - tableSize, phase);
+    Vec16f sig = interpCubic(notePitch, table);
+    return sig + fade * (interpCubic(notePitch, fadeTable) - sig);
+  }
+
+  Vec16f interpCubic(Vec16f notePitch, const TableMipmap &table)
+  {
     notePitch = select(notePitch <= 0, 0, notePitch);
     notePitch += float(1);
     notePitch = select(notePitch >= notePitchUpperBound, notePitchUpperBound, notePitch);
@@ -459,36 +774,10 @@ template<size_t tableSize> struct alignas(64) TableOsc16 {
     Vec16i iy2 = iy1 + 1;
     Vec16i iy3 = iy1 + 2;
 
-    Vec16f xFrac = phase - floor(phase);
-    Vec16i ix1 = truncatei(phase);
-    Vec16i ix0 = ix1 - 1;
-    Vec16i ix2 = ix1 + 1;
-    Vec16i ix3 = ix1 + 2;
-
-    Vec16f table00 = loadTable(ix0, iy0, table);
-    Vec16f table01 = loadTable(ix1, iy0, table);
-    Vec16f table02 = loadTable(ix2, iy0, table);
-    Vec16f table03 = loadTable(ix3, iy0, table);
-    Vec16f y0 = cubicInterp(table00, table01, table02, table03, xFrac);
-
-    Vec16f table10 = loadTable(ix0, iy1, table);
-    Vec16f table11 = loadTable(ix1, iy1, table);
-    Vec16f table12 = loadTable(ix2, iy1, table);
-    Vec16f table13 = loadTable(ix3, iy1, table);
-    Vec16f y1 = cubicInterp(table10, table11, table12, table13, xFrac);
-
-    Vec16f table20 = loadTable(ix0, iy2, table);
-    Vec16f table21 = loadTable(ix1, iy2, table);
-    Vec16f table22 = loadTable(ix2, iy2, table);
-    Vec16f table23 = loadTable(ix3, iy2, table);
-    Vec16f y2 = cubicInterp(table20, table21, table22, table23, xFrac);
-
-    Vec16f table30 = loadTable(ix0, iy3, table);
-    Vec16f table31 = loadTable(ix1, iy3, table);
-    Vec16f table32 = loadTable(ix2, iy3, table);
-    Vec16f table33 = loadTable(ix3, iy3, table);
-    Vec16f y3 = cubicInterp(table30, table31, table32, table33, xFrac);
-
+    Vec16f y0 = interpRowCubic(iy0, table);
+    Vec16f y1 = interpRowCubic(iy1, table);
+    Vec16f y2 = interpRowCubic(iy2, table);
+    Vec16f y3 = interpRowCubic(iy3, table);
     return cubicInterp(y0, y1, y2, y3, yFrac);
   }
 };
@@ -588,4 +877,5 @@ public:
   }
 };
 
+SOMEDSP_ISA_NAMESPACE_END
 } // namespace SomeDSP
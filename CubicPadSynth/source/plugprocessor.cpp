@@ -28,14 +28,34 @@
 #include "pluginterfaces/vst/ivstevents.h"
 #include "pluginterfaces/vst/ivstparameterchanges.h"
 
+#include "../../common/dsp/denormal.hpp"
+#include "../../lib/vcl.hpp"
+
 #include <cstring>
+#include <iostream>
 
 namespace Steinberg {
 namespace Synth {
 
 PlugProcessor::PlugProcessor()
 {
-  dsp = std::make_unique<DSPCore_FixedInstruction>();
+#if defined(__arm64__) || defined(__aarch64__)
+  dsp = createDSPCore_FixedInstruction();
+#else
+  auto iset = instrset_detect();
+  #ifdef __linux__
+  if (iset >= 10) {
+    dsp = createDSPCore_AVX512();
+  } else
+  #endif
+    if (iset >= 8) {
+    dsp = createDSPCore_AVX2();
+  } else if (iset >= 7) {
+    dsp = createDSPCore_AVX();
+  } else {
+    std::cerr << "\nError: Instruction set AVX or later not supported on this computer";
+  }
+#endif
 
   setControllerClass(ControllerUID);
 }
@@ -74,6 +94,11 @@ tresult PLUGIN_API PlugProcessor::setupProcessing(Vst::ProcessSetup &setup)
 {
   if (dsp == nullptr) return kNotInitialized;
   dsp->setup(processSetup.sampleRate);
+
+  // Units are rendered on multiple threads only for offline rendering. Thread count is
+  // clamped to the number of cores in `SpinWorkerPool::resize()`.
+  dsp->setRenderThreads(setup.processMode == Vst::kOffline ? nUnit : 1);
+
   return AudioEffect::setupProcessing(setup);
 }
 
@@ -91,6 +116,8 @@ tresult PLUGIN_API PlugProcessor::setActive(TBool state)
 
 tresult PLUGIN_API PlugProcessor::process(Vst::ProcessData &data)
 {
+  SomeDSP::ScopedNoDenormals noDenormals;
+
   if (dsp == nullptr) return kNotInitialized;
 
   // Read inputs parameter changes.
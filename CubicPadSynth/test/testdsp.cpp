@@ -17,8 +17,9 @@
 
 #define SET_PARAMETERS dsp->setParameters(tempo);
 
-#include "../../test/synthtester.hpp"
+#include "../../lib/vcl.hpp"
 #include "../source/dsp/dspcore.hpp"
+#include "../../test/synthtester.hpp"
 
 // CMake provides this macro, but just in case.
 #ifndef UHHYOU_PLUGIN_NAME
@@ -29,6 +30,8 @@
 
 int main()
 {
-  SynthTester<DSPCore_FixedInstruction> tester(UHHYOU_PLUGIN_NAME, OUT_DIR_PATH, 1);
+  SynthTesterSimdRuntimeDispatch<DSPInterface> tester(
+    UHHYOU_PLUGIN_NAME, OUT_DIR_PATH, 1);
+
   return tester.isFinished ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -0,0 +1,124 @@
+// (c) 2022 Takamitsu Endo
+//
+// This file is part of CubicPadSynth.
+//
+// CubicPadSynth is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// CubicPadSynth is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with CubicPadSynth.  If not, see <https://www.gnu.org/licenses/>.
+
+// Renders the same note sequence with `setRenderThreads(1)` and with parallel rendering,
+// then checks that both outputs are sample-identical. Notes start and stop inside of
+// blocks, so that the parallel path splits blocks at note events.
+
+#include "../../lib/vcl.hpp"
+#include "../source/dsp/dspcore.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+constexpr double sampleRate = 48000.0;
+constexpr float tempo = 120.0f;
+constexpr size_t blockSize = 512;
+constexpr size_t nBlock = 200;
+
+std::unique_ptr<DSPInterface> createDSPCore()
+{
+#if defined(__arm64__) || defined(__aarch64__)
+  return createDSPCore_FixedInstruction();
+#else
+  auto iset = instrset_detect();
+  #ifdef __linux__
+  if (iset >= 10) return createDSPCore_AVX512();
+  #endif
+  if (iset >= 8) return createDSPCore_AVX2();
+  if (iset >= 7) return createDSPCore_AVX();
+  return nullptr;
+#endif
+}
+
+std::vector<float> render(size_t nThread)
+{
+  using ID = ParameterID::ID;
+
+  auto dsp = createDSPCore();
+  if (!dsp) return {};
+
+  dsp->param.value[ID::nUnison]->setFromInt(3);
+  dsp->setup(sampleRate);
+  dsp->setParameters(tempo);
+  dsp->setRenderThreads(nThread);
+
+  std::vector<float> out(2 * blockSize * nBlock);
+  std::vector<float> out0(blockSize);
+  std::vector<float> out1(blockSize);
+  int32_t noteId = 0;
+  for (size_t block = 0; block < nBlock; ++block) {
+    // A chord of 3 notes every 10 blocks, released 6 blocks later.
+    if (block % 10 == 0 && block < nBlock / 2) {
+      for (int16_t pitch : {48, 55, 64}) {
+        auto frame = uint32_t((block * 37 + size_t(pitch) * 5) % blockSize);
+        auto notePitch = int16_t(pitch + block / 10);
+        dsp->pushMidiNote(true, frame, noteId + pitch, notePitch, 0, 0.8f);
+      }
+    } else if (block % 10 == 6 && block < nBlock / 2) {
+      for (int16_t pitch : {48, 55, 64}) {
+        auto frame = uint32_t((block * 91 + size_t(pitch) * 3) % blockSize);
+        dsp->pushMidiNote(false, frame, noteId + pitch, 0, 0, 0);
+      }
+      noteId += 100;
+    }
+
+    dsp->setParameters(tempo);
+    dsp->process(blockSize, out0.data(), out1.data());
+    for (size_t i = 0; i < blockSize; ++i) {
+      out[2 * (block * blockSize + i)] = out0[i];
+      out[2 * (block * blockSize + i) + 1] = out1[i];
+    }
+  }
+  return out;
+}
+
+int main()
+{
+  auto serial = render(1);
+  if (serial.empty()) {
+    std::cerr << "Error: This CPU doesn't support AVX.\n";
+    return EXIT_FAILURE;
+  }
+
+  bool isSilent = true;
+  for (const auto &value : serial) {
+    if (value == 0) continue;
+    isSilent = false;
+    break;
+  }
+  if (isSilent) {
+    std::cerr << "Error: Serial rendering output is silent.\n";
+    return EXIT_FAILURE;
+  }
+
+  for (size_t nThread : {2, 4, 8}) {
+    auto parallel = render(nThread);
+    for (size_t i = 0; i < serial.size(); ++i) {
+      if (serial[i] == parallel[i]) continue;
+      std::cerr << "Error: Output differs at sample " << i / 2 << ", channel " << i % 2
+                << " with " << nThread << " threads. serial: " << serial[i]
+                << ", parallel: " << parallel[i] << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::cout << "Serial and parallel rendering are identical.\n";
+  return EXIT_SUCCESS;
+}
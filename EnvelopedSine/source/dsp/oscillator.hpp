@@ -18,6 +18,7 @@
 #pragma once
 
 #include "../../../common/dsp/constants.hpp"
+#include "../../../common/dsp/isanamespace.hpp"
 #include "../../../lib/juce_FastMathApproximations.h"
 #include "../../../lib/vcl.hpp"
 #include "../../../lib/vcl/vectormath_exp.h"
@@ -26,6 +27,7 @@
 #include <array>
 
 namespace SomeDSP {
+SOMEDSP_ISA_NAMESPACE_BEGIN
 
 template<size_t size> struct alignas(64) QuadOscExpAD {
   std::array<Vec16f, size> frequency{};
@@ -132,4 +134,5 @@ template<size_t size> struct alignas(64) QuadOscExpAD {
   }
 };
 
+SOMEDSP_ISA_NAMESPACE_END
 } // namespace SomeDSP
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include "../../../common/dsp/isanamespace.hpp"
 #include "../../../lib/juce_FastMathApproximations.h"
 #include "../../../lib/vcl.hpp"
 
@@ -24,6 +25,7 @@
 #include <cmath>
 
 namespace SomeDSP {
+SOMEDSP_ISA_NAMESPACE_BEGIN
 
 // Order 2 Thiran all-pass filter.
 template<typename Sample> struct ThiranAllpass2 {
@@ -205,4 +207,5 @@ struct Thiran2Phaser16 {
   }
 };
 
+SOMEDSP_ISA_NAMESPACE_END
 } // namespace SomeDSP
@@ -0,0 +1,47 @@
+// (c) 2022 Takamitsu Endo
+//
+// This file is part of Uhhyou Plugins.
+//
+// Uhhyou Plugins is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Uhhyou Plugins is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Uhhyou Plugins.  If not, see <https://www.gnu.org/licenses/>.
+
+#define SET_PARAMETERS dsp->setParameters();
+
+#include "../../test/batchrender.hpp"
+#include "../../lib/vcl.hpp"
+#include "../source/dsp/dspcore.hpp"
+
+// CMake provides this macro, but just in case.
+#ifndef UHHYOU_PLUGIN_NAME
+  #define UHHYOU_PLUGIN_NAME "EnvelopedSine"
+#endif
+
+int main(int argc, char *argv[])
+{
+#if defined(__arm64__) || defined(__aarch64__)
+  BatchRenderer<DSPInterface> renderer(
+    UHHYOU_PLUGIN_NAME, argc, argv, createDSPCore_FixedInstruction);
+#else
+  BatchRenderer<DSPInterface> renderer(
+    UHHYOU_PLUGIN_NAME, argc, argv, []() -> std::unique_ptr<DSPInterface> {
+      auto iset = instrset_detect();
+  #ifdef __linux__
+      if (iset >= 10) return createDSPCore_AVX512();
+  #endif
+      if (iset >= 8) return createDSPCore_AVX2();
+      if (iset >= 7) return createDSPCore_AVX();
+      return nullptr;
+    });
+#endif
+  return renderer.isFinished ? EXIT_SUCCESS : EXIT_FAILURE;
+}
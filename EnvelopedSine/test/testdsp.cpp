@@ -17,8 +17,9 @@
 
 #define SET_PARAMETERS dsp->setParameters();
 
-#include "../../test/synthtester.hpp"
+#include "../../lib/vcl.hpp"
 #include "../source/dsp/dspcore.hpp"
+#include "../../test/synthtester.hpp"
 
 // CMake provides this macro, but just in case.
 #ifndef UHHYOU_PLUGIN_NAME
@@ -29,13 +30,7 @@
 
 int main()
 {
-#ifdef __linux__
-  SynthTesterSimdRuntimeDispatch<DSPInterface, DSPCore_AVX512, DSPCore_AVX2, DSPCore_AVX>
-    tester(UHHYOU_PLUGIN_NAME, OUT_DIR_PATH);
-#else
-  SynthTesterSimdRuntimeDispatch<DSPInterface, DSPCore_AVX2, DSPCore_AVX> tester(
-    UHHYOU_PLUGIN_NAME, OUT_DIR_PATH);
-#endif
+  SynthTesterSimdRuntimeDispatch<DSPInterface> tester(UHHYOU_PLUGIN_NAME, OUT_DIR_PATH);
 
   return tester.isFinished ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -15,14 +15,31 @@
 // You should have received a copy of the GNU General Public License
 // along with EsPhaser.  If not, see <https://www.gnu.org/licenses/>.
 
-#include "dspcore.hpp"
+#include "dspcoreimpl.hpp"
 
 #include "../../../lib/vcl/vectormath_exp.h"
 
 #include <algorithm>
 #include <numeric>
 
-#define DSPCORE_NAME DSPCore_FixedInstruction
+#if defined(__arm64__) || defined(__aarch64__)
+  #define DSPCORE_NAME DSPCore_FixedInstruction
+  #define CREATE_DSPCORE_NAME createDSPCore_FixedInstruction
+#elif INSTRSET >= 10
+  #define DSPCORE_NAME DSPCore_AVX512
+  #define CREATE_DSPCORE_NAME createDSPCore_AVX512
+#elif INSTRSET >= 8
+  #define DSPCORE_NAME DSPCore_AVX2
+  #define CREATE_DSPCORE_NAME createDSPCore_AVX2
+#elif INSTRSET >= 7
+  #define DSPCORE_NAME DSPCore_AVX
+  #define CREATE_DSPCORE_NAME createDSPCore_AVX
+#else
+  #error Unsupported instruction set
+#endif
+
+namespace SomeDSP {
+SOMEDSP_ISA_NAMESPACE_BEGIN
 
 void DSPCORE_NAME::setup(double sampleRate)
 {
@@ -113,3 +130,11 @@ void DSPCORE_NAME::process(
     out1[i] = in1[i] + mix * (phaser1 - in1[i]);
   }
 }
+
+SOMEDSP_ISA_NAMESPACE_END
+} // namespace SomeDSP
+
+std::unique_ptr<DSPInterface> CREATE_DSPCORE_NAME()
+{
+  return std::make_unique<SomeDSP::DSPCORE_NAME>();
+}
@@ -15,17 +15,13 @@
 // You should have received a copy of the GNU General Public License
 // along with EsPhaser.  If not, see <https://www.gnu.org/licenses/>.
 
+
 #pragma once
 
-#include "../../../common/dsp/constants.hpp"
-#include "../../../common/dsp/smoother.hpp"
 #include "../parameter.hpp"
-#include "phaser.hpp"
 
-#include <array>
-#include <cmath>
+#include <memory>
 
-using namespace SomeDSP;
 using namespace Steinberg::Synth;
 
 class DSPInterface {
@@ -44,34 +40,17 @@ public:
     = 0;
 };
 
-#define DSPCORE_CLASS(INSTRSET)                                                          \
-  class DSPCore_##INSTRSET final : public DSPInterface {                                 \
-  public:                                                                                \
-    void setup(double sampleRate) override;                                              \
-    void reset() override;                                                               \
-    void startup() override;                                                             \
-    void setParameters() override;                                                       \
-    void process(                                                                        \
-      const size_t length,                                                               \
-      const float *in0,                                                                  \
-      const float *in1,                                                                  \
-      float *out0,                                                                       \
-      float *out1) override;                                                             \
-                                                                                         \
-  private:                                                                               \
-    float sampleRate = 44100.0f;                                                         \
-                                                                                         \
-    std::array<Thiran2Phaser, 2> phaser;                                                 \
-                                                                                         \
-    LinearSmoother<float> interpMix;                                                     \
-    LinearSmoother<float> interpFrequency;                                               \
-    LinearSmoother<float> interpFreqSpread;                                              \
-    LinearSmoother<float> interpFeedback;                                                \
-    LinearSmoother<float> interpRange;                                                   \
-    LinearSmoother<float> interpMin;                                                     \
-    RotarySmoother<float> interpPhase;                                                   \
-    LinearSmoother<float> interpStereoOffset;                                            \
-    LinearSmoother<float> interpCascadeOffset;                                           \
-  };
-
-DSPCORE_CLASS(FixedInstruction)
+/**
+`dspcore.cpp` is built once for each instruction set, and each build defines one of these
+factories. DSP classes are declared in `dspcoreimpl.hpp`, which is only included from
+`dspcore.cpp`. So other sources don't see the classes built for other instruction sets.
+*/
+#if defined(__arm64__) || defined(__aarch64__)
+std::unique_ptr<DSPInterface> createDSPCore_FixedInstruction();
+#else
+  #ifdef __linux__
+std::unique_ptr<DSPInterface> createDSPCore_AVX512();
+  #endif
+std::unique_ptr<DSPInterface> createDSPCore_AVX2();
+std::unique_ptr<DSPInterface> createDSPCore_AVX();
+#endif
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include "../../../common/dsp/isanamespace.hpp"
 #include "../../../lib/vcl.hpp"
 #include "../../../lib/vcl/vectormath_trig.h"
 
@@ -27,6 +28,7 @@
 #include <iostream>
 
 namespace SomeDSP {
+SOMEDSP_ISA_NAMESPACE_BEGIN
 
 // Old implementation of LinearSmoother in `common/smoother.hpp`.
 // EsPhaser relies on buggy behavior of this old smoother.
@@ -82,6 +84,13 @@ protected:
   Sample epsilon = Sample(1e-5);
 };
 
+/**
+16 lanes of 2nd order Thiran allpass. Input is shifted by 1 lane on each step, and lane
+15 is the output to the next allpass.
+
+Coefficients only depend on `fraction`, so they are computed once by `coefficient()` and
+shared by all allpasses driven by the same LFO.
+*/
 struct alignas(64) ThiranAllpass2x16 {
   Vec16f x0 = 0.0f;
   Vec16f x1 = 0.0f;
@@ -89,8 +98,6 @@ struct alignas(64) ThiranAllpass2x16 {
   Vec16f y0 = 0.0f;
   Vec16f y1 = 0.0f;
   Vec16f y2 = 0.0f;
-  Vec16f a1 = 0.0f;
-  Vec16f a2 = 0.0f;
 
   void reset()
   {
@@ -103,21 +110,42 @@ struct alignas(64) ThiranAllpass2x16 {
   }
 
   // fraction > 0.01.
-  void step(float input, Vec16f fraction)
+  static void coefficient(Vec16f fraction, Vec16f &a1, Vec16f &a2)
   {
     auto delay = 2.0f - fraction;
     auto tmp = (delay - 2.0f) / (delay + 1.0f);
     a1 = -2.0f * tmp;
     a2 = (delay - 1.0f) / (delay + 2.0f) * tmp;
+  }
+
+  static inline Vec16f
+  output(Vec16f a1, Vec16f a2, Vec16f x0, Vec16f x1, Vec16f x2, Vec16f y1, Vec16f y2)
+  {
+    return a2 * x0 + a1 * x1 + x2 - a1 * y1 - a2 * y2;
+  }
+
+  static inline Vec16f shift(Vec16f x)
+  {
+    return permute16<V_DC, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14>(x);
+  }
+
+  // Returns lane 15 of `y0` after next `step()`. Lane 15 doesn't depend on the input of
+  // the step, so it can be computed before the input is known.
+  float peek(Vec16f a1, Vec16f a2) const
+  {
+    return output(a1, a2, shift(x0), x0, x1, y0, y1).extract(15);
+  }
 
+  void step(float input, Vec16f a1, Vec16f a2)
+  {
     x2 = x1;
     x1 = x0;
-    x0 = permute16<V_DC, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14>(x0);
+    x0 = shift(x0);
     x0.insert(0, input);
 
     y2 = y1;
     y1 = y0;
-    y0 = a2 * x0 + a1 * x1 + x2 - a1 * y1 - a2 * y2;
+    y0 = output(a1, a2, x0, x1, x2, y1, y2);
   }
 
   float get(int index) { return y0.extract(index); }
@@ -196,11 +224,17 @@ struct alignas(64) Thiran2Phaser {
 
     Vec16f lfo = lfoRange * sin(phase + offset) - lfoMin;
 
+    Vec16f a1;
+    Vec16f a2;
+    ThiranAllpass2x16::coefficient(lfo, a1, a2);
+
     buffer = juce::dsp::FastMathApproximations::tanh(input + feedback * buffer);
-    for (int i = 0; i <= arrayStop; ++i) {
-      allpass[i].step(buffer, lfo);
-      buffer = allpass[i].get(15);
-    }
+    const int nAllpass = arrayStop + 1;
+    int i = 0;
+    while (i + 8 <= nAllpass) i = cascade<8>(i, a1, a2);
+    if (i + 4 <= nAllpass) i = cascade<4>(i, a1, a2);
+    if (i + 2 <= nAllpass) i = cascade<2>(i, a1, a2);
+    if (i < nAllpass) cascade<1>(i, a1, a2);
 
     auto sig0 = allpass[index[0]].get(stage[0]);
     auto sig1 = allpass[index[1]].get(stage[1]);
@@ -208,6 +242,26 @@ struct alignas(64) Thiran2Phaser {
 
     return buffer;
   }
+
+private:
+  /**
+  Steps `allpass[start]` to `allpass[start + nAllpass - 1]`, and returns the next index.
+  Takes input from `buffer`, and writes the output of the last allpass to `buffer`.
+
+  Output of an allpass is the input of the next one. The outputs are first collected by
+  `peek()` which only reads past inputs, then all steps run without waiting for each
+  other. Each group stays in L1 cache between the 2 loops.
+  */
+  template<int nAllpass> inline int cascade(int start, Vec16f a1, Vec16f a2)
+  {
+    std::array<float, nAllpass + 1> sig;
+    sig[0] = buffer;
+    for (int i = 0; i < nAllpass; ++i) sig[i + 1] = allpass[start + i].peek(a1, a2);
+    for (int i = 0; i < nAllpass; ++i) allpass[start + i].step(sig[i], a1, a2);
+    buffer = sig[nAllpass];
+    return start + nAllpass;
+  }
 };
 
+SOMEDSP_ISA_NAMESPACE_END
 } // namespace SomeDSP
@@ -28,6 +28,9 @@
 #include "pluginterfaces/vst/ivstevents.h"
 #include "pluginterfaces/vst/ivstparameterchanges.h"
 
+#include "../../common/dsp/denormal.hpp"
+#include "../../lib/vcl.hpp"
+
 #include <iostream>
 
 namespace Steinberg {
@@ -35,7 +38,23 @@ namespace Synth {
 
 PlugProcessor::PlugProcessor()
 {
-  dsp = std::make_unique<DSPCore_FixedInstruction>();
+#if defined(__arm64__) || defined(__aarch64__)
+  dsp = createDSPCore_FixedInstruction();
+#else
+  auto iset = instrset_detect();
+  #ifdef __linux__
+  if (iset >= 10) {
+    dsp = createDSPCore_AVX512();
+  } else
+  #endif
+    if (iset >= 8) {
+    dsp = createDSPCore_AVX2();
+  } else if (iset >= 7) {
+    dsp = createDSPCore_AVX();
+  } else {
+    std::cerr << "\nError: Instruction set AVX or later not supported on this computer";
+  }
+#endif
 
   setControllerClass(ControllerUID);
 }
@@ -91,6 +110,8 @@ tresult PLUGIN_API PlugProcessor::setActive(TBool state)
 
 tresult PLUGIN_API PlugProcessor::process(Vst::ProcessData &data)
 {
+  SomeDSP::ScopedNoDenormals noDenormals;
+
   if (dsp == nullptr) return kNotInitialized;
 
   // Read inputs parameter changes.
@@ -0,0 +1,181 @@
+// (c) 2022 Takamitsu Endo
+//
+// This file is part of Uhhyou Plugins.
+//
+// Uhhyou Plugins is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Uhhyou Plugins is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Uhhyou Plugins.  If not, see <https://www.gnu.org/licenses/>.
+
+// Compares `Thiran2Phaser` against the previous cascade loop for each stage count. The
+// stage parameter is in [0, 4095], and `stage >> 4` + 1 allpasses of 16 lanes run.
+//
+// Results are nanoseconds per sample of one channel. `maxDiff` is the maximum absolute
+// difference between the outputs, which should be 0.
+
+#include "../source/dsp/phaser.hpp"
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace SomeDSP;
+
+constexpr float sampleRate = 48000.0f;
+constexpr size_t nFrame = 4800;
+
+// Previous implementation. Each allpass computes coefficients and waits for the output
+// of the previous one.
+struct alignas(64) LegacyThiranAllpass2x16 {
+  Vec16f x0 = 0.0f;
+  Vec16f x1 = 0.0f;
+  Vec16f x2 = 0.0f;
+  Vec16f y0 = 0.0f;
+  Vec16f y1 = 0.0f;
+  Vec16f y2 = 0.0f;
+  Vec16f a1 = 0.0f;
+  Vec16f a2 = 0.0f;
+
+  void step(float input, Vec16f fraction)
+  {
+    auto delay = 2.0f - fraction;
+    auto tmp = (delay - 2.0f) / (delay + 1.0f);
+    a1 = -2.0f * tmp;
+    a2 = (delay - 1.0f) / (delay + 2.0f) * tmp;
+
+    x2 = x1;
+    x1 = x0;
+    x0 = permute16<V_DC, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14>(x0);
+    x0.insert(0, input);
+
+    y2 = y1;
+    y1 = y0;
+    y0 = a2 * x0 + a1 * x1 + x2 - a1 * y1 - a2 * y2;
+  }
+
+  float get(int index) { return y0.extract(index); }
+};
+
+// Only the parts of `Thiran2Phaser` used here. `stage` is fixed.
+struct alignas(64) LegacyThiran2Phaser {
+  std::array<LegacyThiranAllpass2x16, 256> allpass;
+  Vec16f phase = 0;
+  float buffer = 0;
+  int stage = 15;
+  int index = 0;
+
+  void reset(int newStage)
+  {
+    stage = newStage & 15;
+    index = newStage >> 4;
+  }
+
+  float process(
+    float input,
+    float freqSpread,
+    float cascadeOffset,
+    float stereoOffset,
+    float tick,
+    float feedback,
+    float lfoRange,
+    float lfoMin)
+  {
+    Vec16f tck;
+    Vec16f offset;
+    for (int i = 0; i < 16; ++i) {
+      tck.insert(i, freqSpread * i);
+      offset.insert(i, stereoOffset + i * cascadeOffset);
+    }
+
+    phase += tick / (1.0f + tck);
+    phase = select(phase > float(pi), phase - float(twopi), phase);
+
+    Vec16f lfo = lfoRange * sin(phase + offset) - lfoMin;
+
+    buffer = juce::dsp::FastMathApproximations::tanh(input + feedback * buffer);
+    for (int i = 0; i <= index; ++i) {
+      allpass[i].step(buffer, lfo);
+      buffer = allpass[i].get(15);
+    }
+
+    return buffer = allpass[index].get(stage);
+  }
+};
+
+struct Result {
+  double legacyNs = 0;
+  double currentNs = 0;
+  float maxDiff = 0;
+};
+
+// Same arguments as `DSPCore::process()` with default parameters.
+template<typename Phaser> double render(Phaser &phaser, std::vector<float> &sig)
+{
+  const float lfoRange = 0.5f;
+  const float lfoMin = Thiran2Phaser::getLfoMin(lfoRange, 0.0f);
+  const float tick = 2.0f * float(twopi) / sampleRate;
+
+  auto start = std::chrono::steady_clock::now();
+  for (auto &value : sig) {
+    value = phaser.process(value, 0.0f, 0.0f, 0.0f, tick, 0.5f, lfoRange, lfoMin);
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() / nFrame;
+}
+
+Result run(int nStage, const std::vector<float> &input)
+{
+  // Both are too large for stack.
+  auto legacy = std::make_unique<LegacyThiran2Phaser>();
+  auto current = std::make_unique<Thiran2Phaser>();
+  legacy->reset(nStage);
+  current->setup(sampleRate);
+  current->reset(nStage);
+  current->arrayStop = nStage >> 4;
+
+  std::vector<float> outLegacy(input);
+  std::vector<float> outCurrent(input);
+
+  Result result;
+  result.legacyNs = render(*legacy, outLegacy);
+  result.currentNs = render(*current, outCurrent);
+  for (size_t i = 0; i < nFrame; ++i) {
+    result.maxDiff = std::max(result.maxDiff, std::abs(outLegacy[i] - outCurrent[i]));
+  }
+  return result;
+}
+
+int main()
+{
+  std::minstd_rand rng{0};
+  std::uniform_real_distribution<float> dist{-0.5f, 0.5f};
+  std::vector<float> input(nFrame);
+  for (auto &value : input) value = dist(rng);
+
+  std::cout << "stage, nAllpass, legacy [ns/sample], current [ns/sample], speedup, "
+               "maxDiff\n";
+  bool isSame = true;
+  for (int nStage : {15, 31, 63, 127, 255, 511, 1023, 1999, 2047, 4095}) {
+    auto result = run(nStage, input);
+    isSame &= result.maxDiff == 0;
+    std::cout << nStage << ", " << (nStage >> 4) + 1 << ", " << std::fixed
+              << std::setprecision(3) << result.legacyNs << ", " << result.currentNs
+              << ", " << result.legacyNs / result.currentNs << ", " << std::scientific
+              << result.maxDiff << "\n";
+  }
+  return isSame ? EXIT_SUCCESS : EXIT_FAILURE;
+}
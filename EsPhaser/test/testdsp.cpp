@@ -17,8 +17,9 @@
 
 #define SET_PARAMETERS dsp->setParameters(tempo);
 
-#include "../../test/fxtester.hpp"
+#include "../../lib/vcl.hpp"
 #include "../source/dsp/dspcore.hpp"
+#include "../../test/fxtester.hpp"
 
 // CMake provides this macro, but just in case.
 #ifndef UHHYOU_PLUGIN_NAME
@@ -29,13 +30,7 @@
 
 int main()
 {
-#ifdef __linux__
-  FxTesterSimdRuntimeDispatch<DSPInterface, DSPCore_AVX512, DSPCore_AVX2, DSPCore_AVX>
-    tester(UHHYOU_PLUGIN_NAME, OUT_DIR_PATH);
-#else
-  FxTesterSimdRuntimeDispatch<DSPInterface, DSPCore_AVX2, DSPCore_AVX> tester(
-    UHHYOU_PLUGIN_NAME, OUT_DIR_PATH);
-#endif
+  FxTesterSimdRuntimeDispatch<DSPInterface> tester(UHHYOU_PLUGIN_NAME, OUT_DIR_PATH);
 
   return tester.isFinished ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -43,10 +43,11 @@ void DSPCore::setup(double sampleRate)
 
   gate.setup(sampleRate, 0.001f);
 
-  for (auto &fdn : feedbackDelayNetwork) fdn.setup(sampleRate, 1.0f);
+  for (auto &fdn : feedbackDelayNetwork) fdn.setup(sampleRate, maxDelayTime);
 
   reset();
   startup();
+  updateTailSamples();
 }
 
 size_t DSPCore::getLatency() { return 0; }
@@ -101,6 +102,11 @@ void DSPCore::reset()
     lowpassLfoTime[1][idx].reset(timeLfoDist(rng));
   }
 
+  clearTail();
+}
+
+void DSPCore::clearTail()
+{
   ASSIGN_PARAMETER(reset);
 
   crossBuffer.fill(0);
@@ -141,6 +147,45 @@ void DSPCore::setParameters()
   }
   isMatrixRefeshed = pv[ID::refreshMatrix]->getInt();
   prepareRefresh = false;
+
+  updateTailSamples();
+}
+
+float DSPCore::getLongestDelaySeconds()
+{
+  using ID = ParameterID::ID;
+  const auto &pv = param.value;
+
+  auto timeMul = pv[ID::timeMultiplier]->getFloat() * notePitchMultiplier;
+  float time = 0;
+  for (size_t idx = 0; idx < nDelay; ++idx) {
+    time = std::max(
+      time,
+      timeMul * pv[ID::delayTime0 + idx]->getFloat()
+        + pv[ID::timeLfoAmount0 + idx]->getFloat());
+  }
+  return std::min(time, maxDelayTime);
+}
+
+void DSPCore::updateTailSamples()
+{
+  // Feedback matrix is orthogonal, and filters in the loop only attenuate. So the gain
+  // of a loop is at most `feedback`.
+  auto feedback = std::max(
+    float(param.value[ParameterID::ID::feedback]->getFloat()),
+    std::abs(interpFeedback.getValue()));
+  auto frames = TailDetector::feedbackTailFrames(
+    sampleRate, getLongestDelaySeconds(), feedback);
+  tailSamples.store(
+    uint32_t(std::min<size_t>(frames, std::numeric_limits<uint32_t>::max())),
+    std::memory_order_relaxed);
+}
+
+uint32_t DSPCore::getTailSamples() { return tailSamples.load(std::memory_order_relaxed); }
+
+size_t DSPCore::getLongestDelaySamples()
+{
+  return size_t(std::ceil(sampleRate * getLongestDelaySeconds()));
 }
 
 void DSPCore::process(
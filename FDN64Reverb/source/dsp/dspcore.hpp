@@ -18,15 +18,21 @@
 #pragma once
 
 #include "../../../common/dsp/constants.hpp"
+#include "../../../common/dsp/eventring.hpp"
 #include "../../../common/dsp/smoother.hpp"
+#include "../../../common/dsp/taildetector.hpp"
 #include "../parameter.hpp"
 #include "fdnreverb.hpp"
 
 #include <array>
+#include <atomic>
+#include <limits>
 
 using namespace SomeDSP;
 using namespace Steinberg::Synth;
 
+constexpr float maxDelayTime = 1.0f; // In seconds.
+
 class DSPCore {
 public:
   struct NoteInfo {
@@ -37,19 +43,27 @@ public:
     float velocity;
   };
 
-  DSPCore()
-  {
-    midiNotes.reserve(1024);
-    noteStack.reserve(1024);
-  }
+  DSPCore() { noteStack.reserve(1024); }
 
   GlobalParameter param;
 
   void setup(double sampleRate);
   void reset();
+  // Clears delay lines, filters and ramps after the tail decayed. Unlike `reset()`,
+  // notes are kept, so a key held across the silence keeps its pitch.
+  void clearTail();
   void startup();
   size_t getLatency();
   void setParameters();
+
+  // Frames until output decays under -150 dB after input stops, or `UINT32_MAX` when
+  // output doesn't decay. Computed on audio thread in `setParameters()`, so this can be
+  // called from any thread.
+  uint32_t getTailSamples();
+
+  // Longest delay from input to output. Used by `TailDetector`.
+  size_t getLongestDelaySamples();
+
   void process(
     const size_t length, const float *in0, const float *in1, float *out0, float *out1);
   void noteOn(NoteInfo &info);
@@ -69,28 +83,29 @@ public:
     note.id = noteId;
     note.pitch = pitch + tuning;
     note.velocity = velocity;
-    midiNotes.push_back(note);
+    midiNotes.push(note);
   }
 
+  // Dispatches all queued notes. Called when the block is skipped while idle, so that
+  // the notes don't pile up and fire at stale offsets in a later block.
+  void flushMidiNotes() { processMidiNote(std::numeric_limits<size_t>::max()); }
+
   void processMidiNote(size_t frame)
   {
-    while (true) {
-      auto it = std::find_if(midiNotes.begin(), midiNotes.end(), [&](const NoteInfo &nt) {
-        return nt.frame == frame;
-      });
-      if (it == std::end(midiNotes)) return;
-      if (it->isNoteOn)
-        noteOn(*it);
+    midiNotes.dispatch(frame, [&](NoteInfo &note) {
+      if (note.isNoteOn)
+        noteOn(note);
       else
-        noteOff(it->id);
-      midiNotes.erase(it);
-    }
+        noteOff(note.id);
+    });
   }
 
 private:
   void updateDelayTime();
+  float getLongestDelaySeconds();
+  void updateTailSamples();
 
-  std::vector<NoteInfo> midiNotes;
+  MidiEventRing<NoteInfo> midiNotes;
   std::vector<NoteInfo> noteStack;
   float notePitchMultiplier = float(1);
 
@@ -113,6 +128,7 @@ private:
   ExpSmoother<float> interpFeedback;
   ExpSmoother<float> interpDry;
   ExpSmoother<float> interpWet;
+  std::atomic<uint32_t> tailSamples{0};
 
   EasyGate<float> gate;
   std::array<FeedbackDelayNetwork<float, nDelay>, 2> feedbackDelayNetwork;
@@ -286,7 +286,22 @@ If `length` is too long, compiler might silently fail to allocate stack.
 */
 template<typename Sample, size_t length> class FeedbackDelayNetwork {
 private:
+  // Method to apply `matrix`. Selected in `randomizeMatrix()` from the structure of
+  // generated matrix.
+  enum class MatrixKernel {
+    dense,
+    hadamard,
+    rankOne,
+    upperTriangular,
+    lowerTriangular,
+    schroeder,
+    absorbent,
+  };
+
   std::array<std::array<Sample, length>, length> matrix{};
+  std::array<std::array<Sample, length>, length> matrixT{}; // Transposed `matrix`.
+  std::array<Sample, length> rankOneVector{};
+  MatrixKernel kernel = MatrixKernel::dense;
   std::array<std::array<Sample, length>, 2> buf{};
   std::array<Delay<Sample>, length> delay;
   std::array<DoubleEMAFilterKp<Sample>, length> lowpass;
@@ -719,6 +734,139 @@ public:
     } else { // matrixType == FeedbackMatrixType::orthogonal, or default.
       randomOrthogonal(seed, matrix);
     }
+
+    for (size_t row = 0; row < length; ++row) {
+      for (size_t col = 0; col < length; ++col) matrixT[col][row] = matrix[row][col];
+    }
+
+    switch (matrixType) {
+      case FeedbackMatrixType::circulantOrthogonal:
+      case FeedbackMatrixType::circulant4:
+      case FeedbackMatrixType::circulant8:
+      case FeedbackMatrixType::circulant16:
+      case FeedbackMatrixType::circulant32: {
+        // `matrix` is `u * u^T - I`, where `u[i]^2 = matrix[i][i] + 1`.
+        kernel = MatrixKernel::rankOne;
+        for (size_t i = 0; i < length; ++i) {
+          rankOneVector[i] = std::sqrt(std::max(Sample(0), matrix[i][i] + Sample(1)));
+        }
+      } break;
+      case FeedbackMatrixType::upperTriangularPositive:
+      case FeedbackMatrixType::upperTriangularNegative:
+        kernel = MatrixKernel::upperTriangular;
+        break;
+      case FeedbackMatrixType::lowerTriangularPositive:
+      case FeedbackMatrixType::lowerTriangularNegative:
+        kernel = MatrixKernel::lowerTriangular;
+        break;
+      case FeedbackMatrixType::schroederPositive:
+      case FeedbackMatrixType::schroederNegative:
+        kernel = MatrixKernel::schroeder;
+        break;
+      case FeedbackMatrixType::absorbentPositive:
+      case FeedbackMatrixType::absorbentNegative:
+        kernel = MatrixKernel::absorbent;
+        break;
+      case FeedbackMatrixType::hadamard:
+        kernel = MatrixKernel::hadamard;
+        break;
+      default:
+        kernel = MatrixKernel::dense;
+        break;
+    }
+  }
+
+  const std::array<std::array<Sample, length>, length> &getMatrix() { return matrix; }
+
+  /**
+  Computes `out = matrix * in`. Except for `hadamard` and `rankOne`, the order of
+  additions for each element is the same as naive dense product, so the result is
+  identical when ignoring the sign of zero.
+  */
+  void applyMatrix(const std::array<Sample, length> &in, std::array<Sample, length> &out)
+  {
+    switch (kernel) {
+      case MatrixKernel::hadamard: {
+        // Fast Walsh-Hadamard transform. Sylvester's construction is in natural order.
+        static_assert(
+          length && ((length & (length - 1)) == 0),
+          "FeedbackDelayNetwork::applyMatrix(): length must be power of 2.");
+
+        out = in;
+        for (size_t half = 1; half < length; half *= 2) {
+          for (size_t start = 0; start < length; start += 2 * half) {
+            for (size_t i = start; i < start + half; ++i) {
+              auto x0 = out[i];
+              auto x1 = out[i + half];
+              out[i] = x0 + x1;
+              out[i + half] = x0 - x1;
+            }
+          }
+        }
+        const auto scale = matrix[0][0];
+        for (auto &value : out) value *= scale;
+      } break;
+
+      case MatrixKernel::rankOne: {
+        Sample dot = 0;
+        for (size_t i = 0; i < length; ++i) dot += rankOneVector[i] * in[i];
+        for (size_t i = 0; i < length; ++i) out[i] = rankOneVector[i] * dot - in[i];
+      } break;
+
+      case MatrixKernel::upperTriangular: {
+        out.fill(0);
+        for (size_t col = 0; col < length; ++col) {
+          const auto &column = matrixT[col];
+          const auto x = in[col];
+          for (size_t row = 0; row <= col; ++row) out[row] += column[row] * x;
+        }
+      } break;
+
+      case MatrixKernel::lowerTriangular: {
+        out.fill(0);
+        for (size_t col = 0; col < length; ++col) {
+          const auto &column = matrixT[col];
+          const auto x = in[col];
+          for (size_t row = col; row < length; ++row) out[row] += column[row] * x;
+        }
+      } break;
+
+      case MatrixKernel::schroeder: {
+        // Diagonal except last 2 rows.
+        for (size_t i = 0; i < length - 2; ++i) out[i] = matrix[i][i] * in[i];
+        for (size_t row = length - 2; row < length; ++row) {
+          out[row] = 0;
+          for (size_t col = 0; col < length; ++col) out[row] += matrix[row][col] * in[col];
+        }
+      } break;
+
+      case MatrixKernel::absorbent: {
+        // Upper half is dense, and lower half has 2 diagonals.
+        constexpr size_t half = length / 2;
+        for (size_t row = 0; row < half; ++row) out[row] = 0;
+        for (size_t col = 0; col < length; ++col) {
+          const auto &column = matrixT[col];
+          const auto x = in[col];
+          for (size_t row = 0; row < half; ++row) out[row] += column[row] * x;
+        }
+        for (size_t row = half; row < length; ++row) {
+          out[row] = matrix[row][row - half] * in[row - half];
+          out[row] += matrix[row][row] * in[row];
+        }
+      } break;
+
+      case MatrixKernel::dense:
+      default: {
+        // Accumulating columns instead of dot products of rows, to allow vectorization
+        // without reordering additions.
+        out.fill(0);
+        for (size_t col = 0; col < length; ++col) {
+          const auto &column = matrixT[col];
+          const auto x = in[col];
+          for (size_t row = 0; row < length; ++row) out[row] += column[row] * x;
+        }
+      } break;
+    }
   }
 
   void setup(Sample sampleRate, Sample maxTime)
@@ -771,10 +919,7 @@ public:
     bufIndex ^= 1;
     auto &front = buf[bufIndex];
     auto &back = buf[bufIndex ^ 1];
-    front.fill(0);
-    for (size_t i = 0; i < length; ++i) {
-      for (size_t j = 0; j < length; ++j) front[i] += matrix[i][j] * back[j];
-    }
+    applyMatrix(back, front);
     return std::accumulate(front.begin(), front.end(), Sample(0));
   }
 
@@ -28,6 +28,8 @@
 #include "pluginterfaces/vst/ivstevents.h"
 #include "pluginterfaces/vst/ivstparameterchanges.h"
 
+#include "../../common/dsp/denormal.hpp"
+
 #ifdef USE_VECTORCLASS
   #include "../../lib/vcl/vectorclass.h"
 #endif
@@ -84,11 +86,20 @@ tresult PLUGIN_API PlugProcessor::setActive(TBool state)
     dsp.reset();
     lastState = 0;
   }
+  tailDetector.reset();
   return AudioEffect::setActive(state);
 }
 
+uint32 PLUGIN_API PlugProcessor::getTailSamples()
+{
+  auto tail = dsp.getTailSamples();
+  return tail >= Vst::kInfiniteTail ? Vst::kInfiniteTail : uint32(tail);
+}
+
 tresult PLUGIN_API PlugProcessor::process(Vst::ProcessData &data)
 {
+  SomeDSP::ScopedNoDenormals noDenormals;
+
   using ID = ParameterID::ID;
 
   // Read inputs parameter changes.
@@ -131,13 +142,26 @@ tresult PLUGIN_API PlugProcessor::process(Vst::ProcessData &data)
   auto isBypassing = dsp.param.value[ParameterID::bypass]->getInt();
   if (isBypassing) {
     if (!wasBypassing) dsp.reset();
+    tailDetector.reset();
     processBypass(data);
   } else {
+    const size_t length = size_t(data.numSamples);
     float *in0 = data.inputs[0].channelBuffers32[0];
     float *in1 = data.inputs[0].channelBuffers32[1];
     float *out0 = data.outputs[0].channelBuffers32[0];
     float *out1 = data.outputs[0].channelBuffers32[1];
-    dsp.process((size_t)data.numSamples, in0, in1, out0, out1);
+    auto isInputSilent
+      = tailDetector.isInputSilent(data.inputs[0].silenceFlags, in0, in1, length);
+    if (isInputSilent && tailDetector.isIdle()) {
+      dsp.flushMidiNotes();
+      processSilence(data);
+    } else {
+      dsp.process(length, in0, in1, out0, out1);
+      data.outputs[0].silenceFlags = 0;
+      auto holdFrames = dsp.getLongestDelaySamples();
+      if (tailDetector.update(isInputSilent, out0, out1, length, holdFrames))
+        dsp.clearTail();
+    }
   }
   wasBypassing = isBypassing;
 
@@ -162,6 +186,15 @@ void PlugProcessor::processBypass(Vst::ProcessData &data)
   }
 }
 
+void PlugProcessor::processSilence(Vst::ProcessData &data)
+{
+  float **out = data.outputs[0].channelBuffers32;
+  for (int32_t ch = 0; ch < data.outputs[0].numChannels; ch++) {
+    memset(out[ch], 0, data.numSamples * sizeof(float));
+  }
+  data.outputs[0].silenceFlags = (uint64(1) << data.outputs[0].numChannels) - 1;
+}
+
 void PlugProcessor::handleEvent(Vst::ProcessData &data)
 {
   for (int32 index = 0; index < data.inputEvents->getEventCount(); ++index) {
@@ -0,0 +1,109 @@
+// (c) 2022 Takamitsu Endo
+//
+// This file is part of Uhhyou Plugins.
+//
+// Uhhyou Plugins is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Uhhyou Plugins is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Uhhyou Plugins.  If not, see <https://www.gnu.org/licenses/>.
+
+// Measures the CPU time of reverb tail after the input stops. Noise is fed for the
+// first second, then silence follows. Without `ScopedNoDenormals`, time per sample
+// rises when the tail decays into subnormal range. With it, time stays flat.
+//
+// Results are nanoseconds per sample for each second of output. `peak` is the maximum
+// absolute value of the output without the guard, to show where the tail becomes
+// subnormal (less than about 1.2e-38).
+
+#include "../../common/dsp/denormal.hpp"
+#include "../source/dsp/dspcore.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <vector>
+
+constexpr double sampleRate = 48000.0;
+constexpr size_t blockSize = 512;
+constexpr size_t inputSeconds = 1;
+constexpr size_t totalSeconds = 20;
+
+struct Segment {
+  double nsPerSample = 0;
+  float peak = 0;
+};
+
+std::vector<Segment> run(bool flushDenormals)
+{
+  using ID = Steinberg::Synth::ParameterID::ID;
+
+  auto dsp = std::make_unique<DSPCore>();
+  // Short tail. Internal states become subnormal after about 12 seconds.
+  dsp->param.value[ID::feedback]->setFromNormalized(0.2);
+  dsp->setup(sampleRate);
+  dsp->setParameters();
+  dsp->reset();
+
+  const size_t framesPerSecond = size_t(sampleRate);
+  std::vector<float> in0(blockSize), in1(blockSize), out0(blockSize), out1(blockSize);
+
+  std::minstd_rand rng{0};
+  std::uniform_real_distribution<float> dist{-0.5f, 0.5f};
+
+  std::vector<Segment> segments(totalSeconds);
+  for (size_t second = 0; second < totalSeconds; ++second) {
+    double elapsed = 0;
+    float peak = 0;
+    for (size_t frame = 0; frame < framesPerSecond; frame += blockSize) {
+      const size_t length = std::min(blockSize, framesPerSecond - frame);
+      for (size_t i = 0; i < length; ++i) {
+        in0[i] = second < inputSeconds ? dist(rng) : 0.0f;
+        in1[i] = second < inputSeconds ? dist(rng) : 0.0f;
+      }
+
+      auto start = std::chrono::steady_clock::now();
+      {
+        std::optional<SomeDSP::ScopedNoDenormals> guard;
+        if (flushDenormals) guard.emplace();
+        dsp->setParameters();
+        dsp->process(length, in0.data(), in1.data(), out0.data(), out1.data());
+      }
+      auto end = std::chrono::steady_clock::now();
+      elapsed += std::chrono::duration<double, std::nano>(end - start).count();
+
+      for (size_t i = 0; i < length; ++i) peak = std::max(peak, std::abs(out0[i]));
+    }
+    segments[second].nsPerSample = elapsed / double(framesPerSecond);
+    segments[second].peak = peak;
+  }
+  return segments;
+}
+
+int main()
+{
+  auto withoutGuard = run(false);
+  auto withGuard = run(true);
+
+  std::cout << "second, peak, without guard [ns/sample], with guard [ns/sample]\n";
+  for (size_t idx = 0; idx < totalSeconds; ++idx) {
+    std::cout << idx << ", " << std::scientific << std::setprecision(3)
+              << withoutGuard[idx].peak << ", " << std::fixed
+              << withoutGuard[idx].nsPerSample << ", " << withGuard[idx].nsPerSample
+              << "\n";
+  }
+  return EXIT_SUCCESS;
+}
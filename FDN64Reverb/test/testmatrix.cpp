@@ -0,0 +1,97 @@
+// (c) 2022 Takamitsu Endo
+//
+// This file is part of FDN64Reverb.
+//
+// FDN64Reverb is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// FDN64Reverb is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with FDN64Reverb.  If not, see <https://www.gnu.org/licenses/>.
+
+// Compares `FeedbackDelayNetwork::applyMatrix()` to naive dense matrix-vector product.
+
+#include "../source/dsp/fdnreverb.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+
+using namespace SomeDSP;
+
+constexpr size_t nDelay = 64;
+using FDN = FeedbackDelayNetwork<float, nDelay>;
+
+// Kernels other than these keep the order of additions of dense product. The result may
+// still differ by FMA contraction.
+bool isReordered(unsigned matrixType)
+{
+  switch (matrixType) {
+    case FeedbackMatrixType::circulantOrthogonal:
+    case FeedbackMatrixType::circulant4:
+    case FeedbackMatrixType::circulant8:
+    case FeedbackMatrixType::circulant16:
+    case FeedbackMatrixType::circulant32:
+    case FeedbackMatrixType::hadamard:
+      return true;
+  }
+  return false;
+}
+
+int main()
+{
+  constexpr float toleranceExact = 1e-6f;
+  constexpr float toleranceReordered = 1e-5f;
+
+  auto fdn = std::make_unique<FDN>();
+  std::minstd_rand rng{0};
+  std::uniform_real_distribution<float> dist{-1.0f, 1.0f};
+
+  std::array<float, nDelay> input;
+  std::array<float, nDelay> fast;
+  std::array<float, nDelay> dense;
+
+  size_t nError = 0;
+  for (unsigned type = 0; type < FeedbackMatrixType::FeedbackMatrixType_ENUM_LENGTH;
+       ++type) {
+    for (unsigned seed = 0; seed < 16; ++seed) {
+      fdn->randomizeMatrix(type, seed);
+      const auto &matrix = fdn->getMatrix();
+
+      for (auto &value : input) value = dist(rng);
+
+      fdn->applyMatrix(input, fast);
+
+      dense.fill(0);
+      float norm = 0;
+      for (size_t i = 0; i < nDelay; ++i) {
+        for (size_t j = 0; j < nDelay; ++j) dense[i] += matrix[i][j] * input[j];
+        norm += dense[i] * dense[i];
+      }
+      norm = std::sqrt(norm);
+
+      for (size_t i = 0; i < nDelay; ++i) {
+        const float tolerance = isReordered(type) ? toleranceReordered : toleranceExact;
+        bool isFailed = std::fabs(fast[i] - dense[i]) > tolerance * std::max(norm, 1.0f);
+        if (!isFailed) continue;
+
+        std::cerr << "Error: matrixType " << type << ", seed " << seed << ", index " << i
+                  << ": fast " << fast[i] << " and dense " << dense[i]
+                  << " are not equal.\n";
+        ++nError;
+        break;
+      }
+    }
+  }
+
+  if (nError == 0) std::cout << "All matrix types passed.\n";
+  return nError == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
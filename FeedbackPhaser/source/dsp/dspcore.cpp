@@ -119,9 +119,8 @@ void DSPCore::reset()
   for (auto &x : feedbackHighpass) x.reset();
   for (auto &x : outputHighpass) x.reset();
 
-  for (auto &x : upSampler) x.reset();
-  for (auto &x : decimationLowpass) x.reset();
-  for (auto &x : halfbandIir) x.reset();
+  upSampler.reset();
+  downSampler.reset();
 
   startup();
 }
@@ -260,42 +259,32 @@ void DSPCore::process(
   for (size_t i = 0; i < length; ++i) {
     processMidiNote(i);
 
-    upSampler[0].process(in0[i]);
-    upSampler[1].process(in1[i]);
-    upSampler[2].process(side0[i]);
-    upSampler[3].process(side1[i]);
+    upSampler.process({in0[i], in1[i], side0[i], side1[i]});
+    const auto &up = upSampler.output;
+    auto &down = downSampler.inputBuffer;
 
     if (oversampling == 2) { // 8x.
       for (size_t j = 0; j < upFold; ++j) {
-        auto frame = processFrame(
-          {upSampler[0].output[j], upSampler[1].output[j]},
-          {upSampler[2].output[j], upSampler[3].output[j]});
-        decimationLowpass[0].push(frame[0]);
-        decimationLowpass[1].push(frame[1]);
-        upSampler[0].output[j] = decimationLowpass[0].output();
-        upSampler[1].output[j] = decimationLowpass[1].output();
+        auto frame = processFrame({up[0][j], up[1][j]}, {up[2][j], up[3][j]});
+        down[0][j] = frame[0];
+        down[1][j] = frame[1];
       }
-      out0[i] = halfbandIir[0].process(
-        {upSampler[0].output[0], upSampler[0].output[upFold / 2]});
-      out1[i] = halfbandIir[1].process(
-        {upSampler[1].output[0], upSampler[1].output[upFold / 2]});
+      auto frame = downSampler.processLeading();
+      out0[i] = frame[0];
+      out1[i] = frame[1];
     } else if (oversampling == 1) { // 2x.
       const size_t mid = upFold / 2;
-      for (size_t j = 0; j < upFold; j += mid) {
-        auto frame = processFrame(
-          {upSampler[0].output[j], upSampler[1].output[j]},
-          {upSampler[2].output[j], upSampler[3].output[j]});
-        upSampler[0].output[j] = frame[0];
-        upSampler[1].output[j] = frame[1];
+      for (size_t j = 0; j < 2; ++j) {
+        const size_t k = j * mid;
+        auto frame = processFrame({up[0][k], up[1][k]}, {up[2][k], up[3][k]});
+        down[0][j] = frame[0];
+        down[1][j] = frame[1];
       }
-      out0[i]
-        = halfbandIir[0].process({upSampler[0].output[0], upSampler[0].output[mid]});
-      out1[i]
-        = halfbandIir[1].process({upSampler[1].output[0], upSampler[1].output[mid]});
+      auto frame = downSampler.process2x();
+      out0[i] = frame[0];
+      out1[i] = frame[1];
     } else { // 1x.
-      auto frame = processFrame(
-        {upSampler[0].output[0], upSampler[1].output[0]},
-        {upSampler[2].output[0], upSampler[3].output[0]});
+      auto frame = processFrame({up[0][0], up[1][0]}, {up[2][0], up[3][0]});
       out0[i] = frame[0];
       out1[i] = frame[1];
     }
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "../../../common/dsp/constants.hpp"
+#include "../../../common/dsp/eventring.hpp"
 #include "../../../common/dsp/multirate.hpp"
 #include "../../../common/dsp/smoother.hpp"
 #include "../parameter.hpp"
@@ -36,11 +37,7 @@ public:
     float velocity;
   };
 
-  DSPCore()
-  {
-    midiNotes.reserve(1024);
-    noteStack.reserve(1024);
-  }
+  DSPCore() { noteStack.reserve(1024); }
 
   GlobalParameter param;
   bool isPlaying = false;
@@ -81,22 +78,17 @@ public:
     note.id = noteId;
     note.pitch = pitch + tuning;
     note.velocity = velocity;
-    midiNotes.push_back(note);
+    midiNotes.push(note);
   }
 
   void processMidiNote(size_t frame)
   {
-    while (true) {
-      auto it = std::find_if(midiNotes.begin(), midiNotes.end(), [&](const NoteInfo &nt) {
-        return nt.frame == frame;
-      });
-      if (it == std::end(midiNotes)) return;
-      if (it->isNoteOn)
-        noteOn(*it);
+    midiNotes.dispatch(frame, [&](NoteInfo &note) {
+      if (note.isNoteOn)
+        noteOn(note);
       else
-        noteOff(it->id);
-      midiNotes.erase(it);
-    }
+        noteOff(note.id);
+    });
   }
 
 private:
@@ -108,7 +100,7 @@ private:
   static constexpr size_t upFold = 8;
   static constexpr std::array<size_t, 3> fold{1, 2, upFold};
 
-  std::vector<NoteInfo> midiNotes;
+  MidiEventRing<NoteInfo> midiNotes;
   std::vector<NoteInfo> noteStack;
 
   double sampleRate = 44100;
@@ -146,7 +138,6 @@ private:
   std::array<SVF<double>, 2> feedbackHighpass{};
   std::array<SVF<double>, 2> outputHighpass{};
 
-  std::array<CubicUpSampler<double, upFold>, 4> upSampler;
-  std::array<DecimationLowpass<double, Sos8FoldFirstStage<double>>, 2> decimationLowpass;
-  std::array<HalfBandIIR<double, HalfBandCoefficient<double>>, 2> halfbandIir;
+  PolyphaseCubicUpSampler<double, 4, upFold> upSampler;
+  PolyphaseDownSampler<double, 2, Sos8FoldFirstStage<double>> downSampler;
 };
@@ -18,12 +18,15 @@
 #pragma once
 
 #include "../../../common/dsp/constants.hpp"
+#include "../../../common/dsp/isanamespace.hpp"
 #include "../../../common/dsp/smoother.hpp"
 
 #include <algorithm>
+#include <cstdint>
 #include <vector>
 
 namespace SomeDSP {
+SOMEDSP_ISA_NAMESPACE_BEGIN
 
 // 2x oversampled, linear interpolated delay.
 template<typename Sample> class Delay {
@@ -178,4 +181,5 @@ public:
   }
 };
 
+SOMEDSP_ISA_NAMESPACE_END
 } // namespace SomeDSP
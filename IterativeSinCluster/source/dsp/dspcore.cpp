@@ -15,12 +15,32 @@
 // You should have received a copy of the GNU General Public License
 // along with IterativeSinCluster.  If not, see <https://www.gnu.org/licenses/>.
 
-#include "dspcore.hpp"
+#include "dspcoreimpl.hpp"
 #include "../../../lib/juce_FastMathApproximations.h"
 #include "../../../lib/vcl.hpp"
 
-#define NOTE_NAME Note_FixedInstruction
-#define DSPCORE_NAME DSPCore_FixedInstruction
+#if defined(__arm64__) || defined(__aarch64__)
+  #define NOTE_NAME Note_FixedInstruction
+  #define DSPCORE_NAME DSPCore_FixedInstruction
+  #define CREATE_DSPCORE_NAME createDSPCore_FixedInstruction
+#elif INSTRSET >= 10
+  #define NOTE_NAME Note_AVX512
+  #define DSPCORE_NAME DSPCore_AVX512
+  #define CREATE_DSPCORE_NAME createDSPCore_AVX512
+#elif INSTRSET >= 8
+  #define NOTE_NAME Note_AVX2
+  #define DSPCORE_NAME DSPCore_AVX2
+  #define CREATE_DSPCORE_NAME createDSPCore_AVX2
+#elif INSTRSET >= 7
+  #define NOTE_NAME Note_AVX
+  #define DSPCORE_NAME DSPCore_AVX
+  #define CREATE_DSPCORE_NAME createDSPCore_AVX
+#else
+  #error Unsupported instruction set
+#endif
+
+namespace SomeDSP {
+SOMEDSP_ISA_NAMESPACE_BEGIN
 
 inline float clamp(float value, float min, float max)
 {
@@ -201,13 +221,11 @@ template<typename Sample> std::array<Sample, 2> NOTE_NAME<Sample>::process()
   return out;
 }
 
-DSPCORE_NAME::DSPCORE_NAME() { midiNotes.reserve(128); }
-
 void DSPCORE_NAME::setup(double sampleRate)
 {
   this->sampleRate = float(sampleRate);
 
-  midiNotes.resize(0);
+  midiNotes.clear();
 
   SmootherCommon<float>::setSampleRate(this->sampleRate);
   SmootherCommon<float>::setTime(0.04f);
@@ -401,3 +419,11 @@ void DSPCORE_NAME::noteOff(int32_t noteId)
 
   notes[i].release();
 }
+
+SOMEDSP_ISA_NAMESPACE_END
+} // namespace SomeDSP
+
+std::unique_ptr<DSPInterface> CREATE_DSPCORE_NAME()
+{
+  return std::make_unique<SomeDSP::DSPCORE_NAME>();
+}
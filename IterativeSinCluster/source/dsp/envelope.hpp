@@ -18,11 +18,13 @@
 #pragma once
 
 #include "../../../common/dsp/constants.hpp"
+#include "../../../common/dsp/isanamespace.hpp"
 #include "../../../common/dsp/smoother.hpp"
 
 #include <cmath>
 
 namespace SomeDSP {
+SOMEDSP_ISA_NAMESPACE_BEGIN
 
 // t in [0, 1].
 template<typename Sample> inline Sample cosinterp(Sample t)
@@ -265,4 +267,5 @@ protected:
   Sample sustain = 1;
 };
 
+SOMEDSP_ISA_NAMESPACE_END
 } // namespace SomeDSP
@@ -17,10 +17,13 @@
 
 #pragma once
 
+#include "../../../common/dsp/isanamespace.hpp"
+
 #include <cmath>
 #include <cstdint>
 
 namespace SomeDSP {
+SOMEDSP_ISA_NAMESPACE_BEGIN
 
 // Numerical Recipes In C p.284.
 template<typename Sample> class White {
@@ -68,4 +71,5 @@ private:
   Sample b6 = 0.0;
 };
 
+SOMEDSP_ISA_NAMESPACE_END
 } // namespace SomeDSP
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "../../../common/dsp/constants.hpp"
+#include "../../../common/dsp/isanamespace.hpp"
 #include "../../../lib/vcl.hpp"
 #include "../../../lib/vcl/vectormath_trig.h"
 
@@ -25,6 +26,7 @@
 #include <cmath>
 
 namespace SomeDSP {
+SOMEDSP_ISA_NAMESPACE_BEGIN
 
 template<size_t size> struct alignas(64) BiquadOsc {
 public:
@@ -57,4 +59,5 @@ public:
   }
 };
 
+SOMEDSP_ISA_NAMESPACE_END
 } // namespace SomeDSP
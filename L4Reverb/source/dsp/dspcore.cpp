@@ -131,12 +131,17 @@ template<typename T> inline T calcNotePitch(T note)
 
 void DSPCore::reset()
 {
-  using ID = ParameterID::ID;
-
   midiNotes.clear();
   noteStack.clear();
   notePitchMultiplier = float(1);
 
+  clearTail();
+}
+
+void DSPCore::clearTail()
+{
+  using ID = ParameterID::ID;
+
   startup();
 
   for (auto &dly : delay) dly.reset();
@@ -175,6 +180,20 @@ void DSPCore::setParameters()
   ASSIGN_ALLPASS_PARAMETER(push);
 }
 
+size_t DSPCore::getLongestDelaySamples()
+{
+  using ID = ParameterID::ID;
+
+  // Worst case is the path through all the innermost delays in series.
+  const float maxTime = float(Scales::time.getMax());
+  auto timeMul = param.value[ID::timeMultiply]->getFloat() * notePitchMultiplier;
+  double seconds = 0;
+  for (uint16_t idx = 0; idx < nDepth1; ++idx) {
+    seconds += std::min(param.value[ID::time0 + idx]->getFloat() * timeMul, maxTime);
+  }
+  return size_t(std::ceil(sampleRate * seconds));
+}
+
 void DSPCore::process(
   const size_t length, const float *in0, const float *in1, float *out0, float *out1)
 {
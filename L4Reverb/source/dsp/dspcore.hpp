@@ -18,12 +18,15 @@
 #pragma once
 
 #include "../../../common/dsp/constants.hpp"
+#include "../../../common/dsp/eventring.hpp"
 #include "../../../common/dsp/smoother.hpp"
+#include "../../../common/dsp/taildetector.hpp"
 #include "../parameter.hpp"
 
 #include "delay.hpp"
 
 #include <array>
+#include <limits>
 #include <random>
 
 using namespace SomeDSP;
@@ -39,18 +42,25 @@ public:
     float velocity;
   };
 
-  DSPCore()
-  {
-    midiNotes.reserve(1024);
-    noteStack.reserve(1024);
-  }
+  DSPCore() { noteStack.reserve(1024); }
 
   GlobalParameter param;
 
   void setup(double sampleRate);
   void reset();
+  // Clears delay lines, filters and ramps after the tail decayed. Unlike `reset()`,
+  // notes are kept, so a key held across the silence keeps its pitch.
+  void clearTail();
   void startup();
   void setParameters();
+
+  // Nested allpass doesn't have a closed form decay time. Always returns
+  // `TailDetector::infiniteTail`.
+  size_t getTailSamples() { return TailDetector::infiniteTail; }
+
+  // Longest delay from input to output. Used by `TailDetector`.
+  size_t getLongestDelaySamples();
+
   void process(
     const size_t length, const float *in0, const float *in1, float *out0, float *out1);
   void noteOn(NoteInfo &info);
@@ -70,29 +80,28 @@ public:
     note.id = noteId;
     note.pitch = pitch + tuning;
     note.velocity = velocity;
-    midiNotes.push_back(note);
+    midiNotes.push(note);
   }
 
+  // Dispatches all queued notes. Called when the block is skipped while idle, so that
+  // the notes don't pile up and fire at stale offsets in a later block.
+  void flushMidiNotes() { processMidiNote(std::numeric_limits<size_t>::max()); }
+
   void processMidiNote(size_t frame)
   {
-    while (true) {
-      auto it = std::find_if(midiNotes.begin(), midiNotes.end(), [&](const NoteInfo &nt) {
-        return nt.frame == frame;
-      });
-      if (it == std::end(midiNotes)) return;
-      if (it->isNoteOn)
-        noteOn(*it);
+    midiNotes.dispatch(frame, [&](NoteInfo &note) {
+      if (note.isNoteOn)
+        noteOn(note);
       else
-        noteOff(it->id);
-      midiNotes.erase(it);
-    }
+        noteOff(note.id);
+    });
   }
 
 private:
   void refreshSeed();
   void updateDelayTime();
 
-  std::vector<NoteInfo> midiNotes;
+  MidiEventRing<NoteInfo> midiNotes;
   std::vector<NoteInfo> noteStack;
   float notePitchMultiplier = float(1);
 
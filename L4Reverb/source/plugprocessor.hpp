@@ -47,12 +47,15 @@ public:
   tresult PLUGIN_API setState(IBStream *state) SMTG_OVERRIDE;
   tresult PLUGIN_API getState(IBStream *state) SMTG_OVERRIDE;
 
+  uint32 PLUGIN_API getTailSamples() SMTG_OVERRIDE;
+
   static FUnknown *createInstance(void *)
   {
     return (Vst::IAudioProcessor *)new PlugProcessor();
   }
 
   void processBypass(Vst::ProcessData &data);
+  void processSilence(Vst::ProcessData &data);
 
 protected:
   void handleEvent(Vst::ProcessData &data);
@@ -64,6 +67,7 @@ protected:
 
   uint64_t lastState = 0;
   uint32_t wasBypassing = 0;
+  SomeDSP::TailDetector tailDetector;
   DSPCore dsp;
 };
 
@@ -115,7 +115,7 @@ Note::process(float sampleRate, Wavetable &wavetable, NoteProcessInfo &info)
   gain = velocity * gainEnvelope.process();
   if (gainEnvelope.isTerminated()) state = NoteState::rest;
 
-  const auto oscOut = osc.process(wavetable.table, wavetable.tableSize);
+  const auto oscOut = osc.process(wavetable.table->table, wavetable.tableSize);
 
   const auto cutAmt = info.filterAmount.getValue();
   const auto cutoff = std::clamp(
@@ -143,15 +143,13 @@ DSPCore::DSPCore()
   voiceIndices.reserve(maxVoice);
 
   peakInfos.resize(nOvertone);
-
-  midiNotes.reserve(maxVoice);
 }
 
 void DSPCore::setup(double sampleRate)
 {
   this->sampleRate = float(sampleRate);
 
-  midiNotes.resize(0);
+  midiNotes.clear();
 
   SmootherCommon<float>::setSampleRate(this->sampleRate);
   SmootherCommon<float>::setTime(0.04f);
@@ -250,6 +248,17 @@ void DSPCore::setParameters(float tempo)
 
 void DSPCore::process(const size_t length, float *out0, float *out1)
 {
+  wavetable.swapTable();
+
+  if (!wavetable.table) {
+    for (size_t i = 0; i < length; ++i) {
+      processMidiNote(i);
+      out0[i] = 0;
+      out1[i] = 0;
+    }
+    return;
+  }
+
   SmootherCommon<float>::setBufferSize(float(length));
 
   std::array<float, 2> frame{};
@@ -450,6 +459,9 @@ void DSPCore::noteOn(int32_t identifier, int16_t pitch, float tuning, float velo
 
 void DSPCore::fillTransitionBuffer(size_t noteIndex)
 {
+  // `wavetable.table` is null until the first table is published.
+  if (!wavetable.table) return;
+
   isTransitioning = true;
 
   // Beware the negative overflow. trStop is size_t.
@@ -508,14 +520,21 @@ void DSPCore::refreshTable()
 
   size_t bufferSize = param.value[ID::tableBufferSize]->getInt();
   if (bufferSize >= 12) bufferSize = 11;
-  wavetable.resize(1024 << bufferSize);
-
-  wavetable.padsynth(
-    sampleRate, tableBaseFreq, peakInfos, param.value[ID::padSynthSeed]->getInt(),
-    param.value[ID::spectrumExpand]->getFloat(),
-    param.value[ID::spectrumRotate]->getFloat(),
-    param.value[ID::profileComb]->getInt() + 1, param.value[ID::profileShape]->getFloat(),
-    param.value[ID::uniformPhaseProfile]->getInt());
+
+  PadSynthParameter prm;
+  prm.sampleRate = sampleRate;
+  prm.tableBaseFreq = tableBaseFreq;
+  prm.tableSize = 1024 << bufferSize;
+  prm.peakInfos = peakInfos;
+  prm.seed = param.value[ID::padSynthSeed]->getInt();
+  prm.expand = param.value[ID::spectrumExpand]->getFloat();
+  prm.rotate = param.value[ID::spectrumRotate]->getFloat();
+  prm.profileSkip = param.value[ID::profileComb]->getInt() + 1;
+  prm.profileShape = param.value[ID::profileShape]->getFloat();
+  prm.uniformPhaseProfile = param.value[ID::uniformPhaseProfile]->getInt();
+
+  // Table is built on worker thread, and swapped in `process()` at block boundary.
+  wavetable.requestRefresh(prm);
 }
 
 void DSPCore::refreshLfo()
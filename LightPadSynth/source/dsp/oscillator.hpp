@@ -21,14 +21,22 @@
 #include "../../../lib/AudioFFT/AudioFFT.h"
 
 #include "../../../common/dsp/constants.hpp"
+#include "../../../common/dsp/sharedcache.hpp"
+#include "../../../common/dsp/tablediskcache.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <complex>
+#include <condition_variable>
 #include <cstring>
 #include <deque>
+#include <memory>
+#include <mutex>
 #include <numeric>
 #include <random>
+#include <thread>
 #include <vector>
 
 namespace SomeDSP {
@@ -49,11 +57,61 @@ template<typename Sample> struct PeakInfo {
   Sample gain = 0;
   Sample phase = 0;
   Sample bandWidth = 1;
+
+  bool operator==(const PeakInfo &rhs) const
+  {
+    return frequency == rhs.frequency && gain == rhs.gain && phase == rhs.phase
+      && bandWidth == rhs.bandWidth;
+  }
 };
 
 constexpr size_t initialTableSize = 262144;
 constexpr size_t maxMidiNoteNumber = 128;
 
+struct PadSynthParameter {
+  float sampleRate = 44100.0f;
+  float tableBaseFreq = 20.0f;
+  size_t tableSize = initialTableSize;
+  std::vector<PeakInfo<float>> peakInfos;
+  uint32_t seed = 0;
+  float expand = 1.0f;
+  float rotate = 0.0f;
+  uint32_t profileSkip = 1; // 1 or greater.
+  float profileShape = 1.0f;
+  bool uniformPhaseProfile = false;
+
+  bool operator==(const PadSynthParameter &rhs) const
+  {
+    return sampleRate == rhs.sampleRate && tableBaseFreq == rhs.tableBaseFreq
+      && tableSize == rhs.tableSize && peakInfos == rhs.peakInfos && seed == rhs.seed
+      && expand == rhs.expand && rotate == rhs.rotate && profileSkip == rhs.profileSkip
+      && profileShape == rhs.profileShape
+      && uniformPhaseProfile == rhs.uniformPhaseProfile;
+  }
+
+  template<typename Visitor> void visit(Visitor &visitor) const
+  {
+    visitor.add(sampleRate);
+    visitor.add(tableBaseFreq);
+    visitor.add(uint64_t(tableSize));
+    visitor.add(uint64_t(peakInfos.size()));
+    for (const auto &peak : peakInfos) {
+      visitor.add(peak.frequency);
+      visitor.add(peak.gain);
+      visitor.add(peak.phase);
+      visitor.add(peak.bandWidth);
+    }
+    visitor.add(seed);
+    visitor.add(expand);
+    visitor.add(rotate);
+    visitor.add(profileSkip);
+    visitor.add(profileShape);
+    visitor.add(uint8_t(uniformPhaseProfile));
+  }
+
+  using Hash = CacheKeyHash<PadSynthParameter>;
+};
+
 /**
 Last element of table is padded for linear interpolation.
 For example, consider following table:
@@ -68,30 +126,82 @@ which will be padded as following:
 tablePadded = [11, 22, 33, 44, 11].
                                ^ This element is padded.
 ```
+
+Tables are shared between plugin instances through `Cache`. Each instance only owns
+the buffers to compute spectrum. Tables are built on `worker` thread.
  */
 struct Wavetable {
+  // Tables are either computed into `owned`, or mapped from disk.
+  struct Table {
+    std::vector<std::vector<float>> owned;
+    std::unique_ptr<TableDiskCache::Entry> mapped;
+    std::vector<const float *> table;
+  };
+
+  using Cache = SharedCache<PadSynthParameter, Table>;
+
+  // Increment `generatorVersion` when `padsynth()` is changed.
+  static TableDiskCache &diskCache()
+  {
+    static TableDiskCache cache("LightPadSynth", 1);
+    return cache;
+  }
+
   std::vector<float> spectrumRe;
   std::vector<float> spectrumIm;
   std::vector<float> tmpSpecRe;
   std::vector<float> tmpSpecIm;
-  std::vector<std::vector<float>> table;
-  float tableBaseFreq = 20.0f;
   static const size_t tableSize = initialTableSize;
+  size_t fftSize = 0;
   audiofft::AudioFFT fft;
 
-  Wavetable() { resize(initialTableSize); }
+  // `table` and `tableBaseFreq` are only touched from audio thread. `table` is null
+  // until the first table is published.
+  std::shared_ptr<const Table> table;
+  float tableBaseFreq = 20.0f;
+
+  // Back buffer. `worker` acquires a table from `Cache` here, then audio thread swaps it
+  // with `table` in `swapTable()`. The previous table is dropped by `worker` on next
+  // acquisition, so that neither the cache lock nor freeing happens on audio thread.
+  std::shared_ptr<const Table> backTable;
+  float backBaseFreq = 20.0f;
+  std::atomic<bool> isBackReady{false};
+
+  std::mutex requestMutex;
+  std::condition_variable requestCondition;
+  PadSynthParameter request;
+  bool isRequested = false;
+  bool isTerminating = false;
+  std::thread worker;
+
+  Wavetable()
+  {
+#ifndef TEST_DSP
+    worker = std::thread(&Wavetable::workerLoop, this);
+#endif
+  }
+
+  ~Wavetable()
+  {
+    {
+      std::lock_guard<std::mutex> lock(requestMutex);
+      isTerminating = true;
+    }
+    requestCondition.notify_one();
+    if (worker.joinable()) worker.join();
+  }
 
   void resize(size_t tableSize)
   {
+    if (fftSize == tableSize) return;
+    fftSize = tableSize;
+
     size_t spectrumSize = tableSize / 2 + 1;
     spectrumRe.resize(spectrumSize);
     spectrumIm.resize(spectrumSize);
     tmpSpecRe.resize(spectrumSize);
     tmpSpecIm.resize(spectrumSize);
 
-    table.resize(maxMidiNoteNumber);
-    for (auto &tbl : table) tbl.resize(tableSize + 1);
-
     fft.init(tableSize);
   }
 
@@ -104,28 +214,102 @@ struct Wavetable {
     return powf(expf(-x * x) / bwi, shape);
   }
 
-  void padsynth(
-    float sampleRate,
-    float tableBaseFreq,
-    std::vector<PeakInfo<float>> &peakInfos,
-    uint32_t seed,
-    float expand,
-    float rotate,
-    uint32_t profileSkip, // 1 or greater.
-    float profileShape,
-    bool uniformPhaseProfile)
+  // Called from any thread. If a refresh is already queued, it's overwritten by the
+  // newer one. In test build, the table is built immediately for deterministic output.
+  void requestRefresh(const PadSynthParameter &prm)
+  {
+#ifdef TEST_DSP
+    acquireBackTable(prm);
+    isBackReady.store(true, std::memory_order_release);
+#else
+    {
+      std::lock_guard<std::mutex> lock(requestMutex);
+      request = prm;
+      isRequested = true;
+    }
+    requestCondition.notify_one();
+#endif
+  }
+
+  // Called from audio thread at the start of a block. Returns true when a new table is
+  // published.
+  bool swapTable()
   {
-    if (profileSkip < 1) profileSkip = 1;
+    if (!isBackReady.load(std::memory_order_acquire)) return false;
 
-    this->tableBaseFreq = tableBaseFreq;
+    std::swap(table, backTable);
+    std::swap(tableBaseFreq, backBaseFreq);
+    isBackReady.store(false, std::memory_order_release);
+    return true;
+  }
+
+  void workerLoop()
+  {
+    while (true) {
+      PadSynthParameter prm;
+      {
+        std::unique_lock<std::mutex> lock(requestMutex);
+
+        // Audio thread doesn't notify when it swaps the table, because notifying may
+        // lock. Polling with timeout is used instead.
+        while (!isTerminating
+               && !(isRequested && !isBackReady.load(std::memory_order_acquire)))
+        {
+          requestCondition.wait_for(lock, std::chrono::milliseconds(10));
+        }
+        if (isTerminating) return;
+
+        prm = request;
+        isRequested = false;
+      }
+
+      acquireBackTable(prm);
+      isBackReady.store(true, std::memory_order_release);
+    }
+  }
+
+  // Called from `worker`, or from audio thread in test build. The table is only
+  // computed when no other instance has the same parameters. Replacing `backTable` may
+  // free the previous table if no other instance holds it.
+  void acquireBackTable(const PadSynthParameter &prm)
+  {
+    auto build = [&](const PadSynthParameter &key, Table &dest) {
+      const size_t length = key.tableSize + 1;
+
+      dest.mapped = diskCache().load(key, maxMidiNoteNumber, length);
+      if (dest.mapped) {
+        for (size_t idx = 0; idx < maxMidiNoteNumber; ++idx)
+          dest.table.push_back(dest.mapped->table(idx));
+        return;
+      }
+
+      padsynth(key, dest.owned);
+      for (const auto &tbl : dest.owned) dest.table.push_back(tbl.data());
+      diskCache().store(key, dest.table.data(), maxMidiNoteNumber, length);
+    };
+    backTable = Cache::instance().acquire(prm, build);
+    backBaseFreq = prm.tableBaseFreq;
+  }
+
+  void padsynth(const PadSynthParameter &prm, std::vector<std::vector<float>> &dest)
+  {
+    resize(prm.tableSize);
+
+    dest.resize(maxMidiNoteNumber);
+    for (auto &tbl : dest) tbl.resize(prm.tableSize + 1);
+
+    const float sampleRate = prm.sampleRate;
+    const float expand = prm.expand;
+    const float rotate = prm.rotate;
+    const uint32_t profileSkip = std::max<uint32_t>(prm.profileSkip, 1);
 
     for (size_t bin = 1; bin < spectrumRe.size(); ++bin) {
       spectrumRe[bin] = 0.0f;
       spectrumIm[bin] = 0.0f;
     }
 
-    std::minstd_rand rng(seed);
-    for (const auto &peak : peakInfos) {
+    std::minstd_rand rng(prm.seed);
+    for (const auto &peak : prm.peakInfos) {
       float bandHz = (powf(2.0f, peak.bandWidth / 1200.0f) - 1.0f) * peak.frequency;
       float bandIdx = bandHz / (2.0f * sampleRate);
 
@@ -142,8 +326,8 @@ struct Wavetable {
       auto phase = distPhase(rng);
       for (int32_t bin = start; bin < end; bin += profileSkip) {
         auto radius = peak.gain
-          * profile(bin / float(spectrumRe.size()) - freqIdx, bandIdx, profileShape);
-        if (!uniformPhaseProfile) phase = distPhase(rng);
+          * profile(bin / float(spectrumRe.size()) - freqIdx, bandIdx, prm.profileShape);
+        if (!prm.uniformPhaseProfile) phase = distPhase(rng);
         spectrumRe[bin] += radius * cosf(phase);
         spectrumIm[bin] += radius * sinf(phase);
       }
@@ -190,7 +374,7 @@ struct Wavetable {
       sum += sqrtf(spectrumRe[i] * spectrumRe[i] + spectrumIm[i] * spectrumIm[i]);
 
     if (sum != 0) {
-      sum = 0.5f * sum / tableSize;
+      sum = 0.5f * sum / prm.tableSize;
       for (size_t i = 0; i < spectrumRe.size(); ++i) {
         auto value = std::complex<float>(spectrumRe[i], spectrumIm[i]) / sum;
         spectrumRe[i] = value.real();
@@ -198,11 +382,13 @@ struct Wavetable {
       }
     }
 
-    for (int i = 0; i < int(table.size()); ++i)
-      refreshTable(440.0f * std::pow(2.0f, (i - 69.0f) / 12.0f), table[i]);
+    for (int i = 0; i < int(dest.size()); ++i) {
+      refreshTable(
+        prm.tableBaseFreq, 440.0f * std::pow(2.0f, (i - 69.0f) / 12.0f), dest[i]);
+    }
   }
 
-  void refreshTable(float frequency, std::vector<float> &table)
+  void refreshTable(float tableBaseFreq, float frequency, std::vector<float> &table)
   {
     size_t bandIdx = size_t(spectrumRe.size() * tableBaseFreq / frequency);
     bandIdx = std::clamp<size_t>(bandIdx, 1, spectrumRe.size());
@@ -247,7 +433,7 @@ struct TableOsc {
     tableIndex = 0;
   }
 
-  float process(std::vector<std::vector<float>> &table, size_t tableSize)
+  float process(const std::vector<const float *> &table, size_t tableSize)
   {
     const auto &tbl = table[tableIndex];
 
@@ -23,6 +23,7 @@
 
 #include <algorithm>
 #include <array>
+#include <cstdint>
 #include <numeric>
 #include <random>
 
@@ -110,20 +111,22 @@ private:
   std::array<Sample, length> ic1eq{};
   std::array<Sample, length> ic2eq{};
 
-  std::array<ExpSmoother<Sample>, length> g;
-  std::array<ExpSmoother<Sample>, length> k;
+  ParallelExpSmoother<Sample, length> g;
+  ParallelExpSmoother<Sample, length> k;
 
 public:
   void pushCutoffAt(size_t index, Sample normalizedFreq, Sample Q)
   {
-    g[index].push(std::tan(std::clamp(normalizedFreq, minCutoff, nyquist) * Sample(pi)));
-    k[index].push(Sample(1) / Q);
+    auto freq = std::clamp(normalizedFreq, minCutoff, nyquist);
+    g.pushAt(index, std::tan(freq * Sample(pi)));
+    k.pushAt(index, Sample(1) / Q);
   }
 
   void resetCutoffAt(size_t index, Sample normalizedFreq, Sample Q)
   {
-    g[index].reset(std::tan(std::clamp(normalizedFreq, minCutoff, nyquist) * Sample(pi)));
-    k[index].reset(Sample(1) / Q);
+    auto freq = std::clamp(normalizedFreq, minCutoff, nyquist);
+    g.resetAt(index, std::tan(freq * Sample(pi)));
+    k.resetAt(index, Sample(1) / Q);
   }
 
   void reset()
@@ -134,9 +137,11 @@ public:
 
   void process(std::array<Sample, length> &v0)
   {
+    g.process();
+    k.process();
     for (size_t n = 0; n < length; ++n) {
-      auto gn = g[n].process();
-      auto kn = k[n].process();
+      auto gn = g.value[n];
+      auto kn = k.value[n];
       auto v1 = (ic1eq[n] + gn * (v0[n] - ic2eq[n])) / (Sample(1) + gn * (gn + kn));
       auto v2 = ic2eq[n] + gn * v1;
       ic1eq[n] = Sample(2) * v1 - ic1eq[n];
@@ -158,22 +163,22 @@ private:
   std::array<Sample, length> ic1eq{};
   std::array<Sample, length> ic2eq{};
 
-  std::array<ExpSmoother<Sample>, length> g;
-  std::array<ExpSmoother<Sample>, length> k;
+  ParallelExpSmoother<Sample, length> g;
+  ParallelExpSmoother<Sample, length> k;
 
 public:
   void pushCutoffAt(size_t index, Sample normalizedFreq, Sample Q)
   {
-    g[index].push(
-      A_sqrt * std::tan(std::clamp(normalizedFreq, minCutoff, nyquist) * Sample(pi)));
-    k[index].push(Sample(1) / Q);
+    auto freq = std::clamp(normalizedFreq, minCutoff, nyquist);
+    g.pushAt(index, A_sqrt * std::tan(freq * Sample(pi)));
+    k.pushAt(index, Sample(1) / Q);
   }
 
   void resetCutoffAt(size_t index, Sample normalizedFreq, Sample Q)
   {
-    g[index].reset(
-      A_sqrt * std::tan(std::clamp(normalizedFreq, minCutoff, nyquist) * Sample(pi)));
-    k[index].reset(Sample(1) / Q);
+    auto freq = std::clamp(normalizedFreq, minCutoff, nyquist);
+    g.resetAt(index, A_sqrt * std::tan(freq * Sample(pi)));
+    k.resetAt(index, Sample(1) / Q);
   }
 
   void reset()
@@ -184,9 +189,11 @@ public:
 
   void process(std::array<Sample, length> &v0)
   {
+    g.process();
+    k.process();
     for (size_t n = 0; n < length; ++n) {
-      auto gn = g[n].process();
-      auto kn = k[n].process();
+      auto gn = g.value[n];
+      auto kn = k.value[n];
       auto v1 = (ic1eq[n] + gn * (v0[n] - ic2eq[n])) / (Sample(1) + gn * (gn + kn));
       auto v2 = ic2eq[n] + gn * v1;
       ic1eq[n] = Sample(2) * v1 - ic1eq[n];
@@ -232,17 +239,23 @@ public:
   }
 };
 
+/**
+Delay lines of `length` channels sharing the same size. Buffer is interleaved as
+`[frame][line]` and all lines share a write pointer, so writing is a contiguous store.
+Read indices are 32 bit, so that reading can be vectorized as gather.
+*/
 template<typename Sample, size_t length> class ParallelDelay {
 public:
   std::array<Sample, length> neutralTime{};
   std::array<Sample, length> time{};
-  std::array<size_t, length> wptr{};
-  std::array<std::vector<Sample>, length> buffer;
+  size_t wptr = 0;
+  size_t size = 4; // In frames.
+  std::vector<Sample> buffer;
 
   void setup(Sample sampleRate, Sample maxTime)
   {
-    auto size = size_t(sampleRate * maxTime) + 2;
-    for (auto &bf : buffer) bf.resize(size < 4 ? 4 : size);
+    size = std::max(size_t(sampleRate * maxTime) + 2, size_t(4));
+    buffer.resize(size * length);
 
     reset();
   }
@@ -251,7 +264,7 @@ public:
   {
     neutralTime.fill(timeInSample);
     time.fill(timeInSample);
-    for (auto &bf : buffer) std::fill(bf.begin(), bf.end(), Sample(0));
+    std::fill(buffer.begin(), buffer.end(), Sample(0));
   }
 
   void setDelayTimeAt(size_t index, Sample sampleRate, Sample overtone, Sample noteFreq)
@@ -259,8 +272,8 @@ public:
     constexpr auto eps = std::numeric_limits<Sample>::epsilon();
     overtone = std::max(eps, overtone);
     noteFreq = std::max(eps, noteFreq);
-    neutralTime[index] = std::clamp(
-      sampleRate / (overtone * noteFreq), Sample(0), Sample(buffer[index].size() - 1));
+    neutralTime[index]
+      = std::clamp(sampleRate / (overtone * noteFreq), Sample(0), Sample(size - 1));
   }
 
   void resetDelayTimeAt(size_t index, Sample sampleRate, Sample overtone, Sample noteFreq)
@@ -275,43 +288,62 @@ public:
     Sample slewRate,
     Sample minModulation)
   {
+    std::array<Sample, length> timeMod;
+    std::array<Sample, length> up;
+    std::array<Sample, length> down;
+    std::array<Sample, length> fraction;
+    std::array<int32_t, length> index0;
+    std::array<int32_t, length> index1;
+
+    // Branches of rate limit are replaced by selects. Arithmetic before selects is in a
+    // separate loop, so that GCC vectorizes both loops.
     for (size_t idx = 0; idx < length; ++idx) {
-      // Rate limit delay time.
-      auto timeMod = Sample(1) - modulation * std::abs(input[idx]);
-      auto targetTime = neutralTime[idx] * std::max(minModulation, timeMod);
-      auto diff = targetTime - time[idx];
-      if (diff > slewRate) {
-        time[idx] += slewRate;
-      } else if (diff < -slewRate) {
-        time[idx] -= slewRate;
-      } else {
-        time[idx] = targetTime;
-      }
-
-      // Set delay time.
-      size_t timeInt = size_t(time[idx]);
-      Sample rFraction = time[idx] - Sample(timeInt);
-
-      auto &buf = buffer[idx];
+      timeMod[idx] = Sample(1) - modulation * std::abs(input[idx]);
+      up[idx] = time[idx] + slewRate;
+      down[idx] = time[idx] - slewRate;
+    }
 
-      size_t rptr0 = wptr[idx] - timeInt;
-      size_t rptr1 = rptr0 - 1;
-      if (rptr0 >= buf.size()) rptr0 += buf.size(); // Unsigned negative overflow case.
-      if (rptr1 >= buf.size()) rptr1 += buf.size(); // Unsigned negative overflow case.
+    // Rate limit delay time, and compute read indices.
+    const auto size32 = int32_t(size);
+    const auto wp32 = int32_t(wptr);
+    for (size_t idx = 0; idx < length; ++idx) {
+      auto tmod = timeMod[idx];
+      auto tu = up[idx];
+      auto td = down[idx];
+      auto target = neutralTime[idx] * std::max(minModulation, tmod);
+      auto diff = target - time[idx];
+      auto limited = diff < -slewRate ? td : target;
+      auto tm = diff > slewRate ? tu : limited;
+      time[idx] = tm;
+
+      auto timeInt = int32_t(tm);
+      fraction[idx] = tm - Sample(timeInt);
+      int32_t rptr0 = wp32 - timeInt;
+      rptr0 += rptr0 < 0 ? size32 : 0;
+      int32_t rptr1 = rptr0 - 1;
+      rptr1 += rptr1 < 0 ? size32 : 0;
+      index0[idx] = rptr0 * int32_t(length) + int32_t(idx);
+      index1[idx] = rptr1 * int32_t(length) + int32_t(idx);
+    }
 
-      // Write to buffer.
-      buf[wptr[idx]] = input[idx];
-      if (++wptr[idx] >= buf.size()) wptr[idx] -= buf.size();
+    // Write to buffer.
+    Sample *buf = buffer.data();
+    Sample *dest = buf + wptr * length;
+    for (size_t idx = 0; idx < length; ++idx) dest[idx] = input[idx];
+    if (++wptr >= size) wptr = 0;
 
-      // Read from buffer.
-      input[idx] = buf[rptr0] + rFraction * (buf[rptr1] - buf[rptr0]);
+    // Read from buffer.
+    for (size_t idx = 0; idx < length; ++idx) {
+      auto s0 = buf[index0[idx]];
+      auto s1 = buf[index1[idx]];
+      input[idx] = s0 + fraction[idx] * (s1 - s0);
     }
   }
 };
 
 template<typename Sample, size_t length> class SnaredFDN {
 private:
-  std::array<std::array<Sample, length>, length> matrix{};
+  std::array<std::array<Sample, length>, length> matrix{}; // [column][row].
   std::array<std::array<Sample, length>, 2> buf{};
   size_t bufIndex = 0;
 
@@ -364,9 +396,9 @@ public:
 
       for (size_t row = 0; row < length; ++row) {
         Sample dotH = 0;
-        for (size_t col = 0; col < xRange; ++col) dotH += matrix[col][row] * x[col];
+        for (size_t col = 0; col < xRange; ++col) dotH += matrix[row][col] * x[col];
         for (size_t col = 0; col < xRange; ++col) {
-          matrix[col][row] = D * (matrix[col][row] - dotH * x[col]);
+          matrix[row][col] = D * (matrix[row][col] - dotH * x[col]);
         }
       }
     }
@@ -402,14 +434,19 @@ public:
   {
     bufIndex ^= 1;
     auto &front = buf[bufIndex];
-    auto &back = buf[bufIndex ^ 1];
-    front.fill(0);
+    const auto &back = buf[bufIndex ^ 1];
+
+    // `matrix` is stored as [column][row], so the outer loop over rows is vectorized
+    // with contiguous loads. `sum` is local because `front` may alias `back` for GCC.
+    std::array<Sample, length> sum;
     for (size_t i = 0; i < length; ++i) {
-      for (size_t j = 0; j < length; ++j) front[i] += matrix[i][j] * back[j];
+      Sample acc = 0;
+      for (size_t j = 0; j < length; ++j) acc += matrix[j][i] * back[j];
+      sum[i] = acc;
     }
 
     for (size_t idx = 0; idx < length; ++idx) {
-      front[idx] = input * inputGain[idx] + feedback * front[idx];
+      front[idx] = input * inputGain[idx] + feedback * sum[idx];
     }
     delay.process(front, modulation, delayTimeSlewRate, minModulation);
     lowpass.process(front);
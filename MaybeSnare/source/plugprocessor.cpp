@@ -25,6 +25,8 @@
 #include "pluginterfaces/vst/ivstevents.h"
 #include "pluginterfaces/vst/ivstparameterchanges.h"
 
+#include "../../common/dsp/denormal.hpp"
+
 #ifdef USE_VECTORCLASS
   #include "../../lib/vcl/vectorclass.h"
 #endif
@@ -86,6 +88,8 @@ tresult PLUGIN_API PlugProcessor::setActive(TBool state)
 
 tresult PLUGIN_API PlugProcessor::process(Vst::ProcessData &data)
 {
+  SomeDSP::ScopedNoDenormals noDenormals;
+
   using ID = ParameterID::ID;
 
   // Read inputs parameter changes.
@@ -0,0 +1,421 @@
+// (c) 2022 Takamitsu Endo
+//
+// This file is part of Uhhyou Plugins.
+//
+// Uhhyou Plugins is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Uhhyou Plugins is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Uhhyou Plugins.  If not, see <https://www.gnu.org/licenses/>.
+
+// Compares `ModulatedFDN` against the previous implementation on a drum roll, which
+// retriggers the FDN at each hit as `DSPCore::noteOn()` does. MaybeSnare has the same FDN
+// as `SnaredFDN`.
+//
+// Results are nanoseconds per sample at 2x oversampled rate. `maxDiff` is the maximum
+// absolute difference between the outputs, which should be 0. With `-mfma`, GCC contracts
+// a few expressions of the 2 versions differently, and `maxDiff` becomes about 1e-15.
+
+#include "../../common/dsp/denormal.hpp"
+#include "../source/dsp/fdn.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace SomeDSP;
+
+constexpr size_t fdnSize = 16;
+constexpr double upRate = 2 * 48000.0;
+constexpr size_t nFrame = size_t(2 * upRate);
+constexpr size_t blockSize = 128;
+constexpr size_t nTrial = 5;
+
+// Previous implementation, from here to `LegacyModulatedFDN`.
+template<typename Sample, size_t length> class LegacySVFHighpass {
+private:
+  static constexpr Sample minCutoff = Sample(0.00001);
+  static constexpr Sample nyquist = Sample(0.49998);
+
+  std::array<Sample, length> ic1eq{};
+  std::array<Sample, length> ic2eq{};
+
+  std::array<ExpSmoother<Sample>, length> g;
+  std::array<ExpSmoother<Sample>, length> k;
+
+public:
+  void pushCutoffAt(size_t index, Sample normalizedFreq, Sample Q)
+  {
+    g[index].push(std::tan(std::clamp(normalizedFreq, minCutoff, nyquist) * Sample(pi)));
+    k[index].push(Sample(1) / Q);
+  }
+
+  void resetCutoffAt(size_t index, Sample normalizedFreq, Sample Q)
+  {
+    g[index].reset(std::tan(std::clamp(normalizedFreq, minCutoff, nyquist) * Sample(pi)));
+    k[index].reset(Sample(1) / Q);
+  }
+
+  void reset()
+  {
+    ic1eq.fill(0);
+    ic2eq.fill(0);
+  }
+
+  void process(std::array<Sample, length> &v0)
+  {
+    for (size_t n = 0; n < length; ++n) {
+      auto gn = g[n].process();
+      auto kn = k[n].process();
+      auto v1 = (ic1eq[n] + gn * (v0[n] - ic2eq[n])) / (Sample(1) + gn * (gn + kn));
+      auto v2 = ic2eq[n] + gn * v1;
+      ic1eq[n] = Sample(2) * v1 - ic1eq[n];
+      ic2eq[n] = Sample(2) * v2 - ic2eq[n];
+      v0[n] -= kn * v1 + v2;
+    }
+  }
+};
+
+template<typename Sample, size_t length> class LegacySVFHighshelf {
+private:
+  static constexpr Sample minCutoff = Sample(0.00001);
+  static constexpr Sample nyquist = Sample(0.49998);
+
+  // `A` is square root of shelving gain. The gain is fixed to 0.5 for this application.
+  static constexpr Sample A = Sample(halfSqrt2);                     // 0.5^(1/2).
+  static constexpr Sample A_sqrt = Sample(0.8408964152537145430311); // 0.5^(1/4).
+
+  std::array<Sample, length> ic1eq{};
+  std::array<Sample, length> ic2eq{};
+
+  std::array<ExpSmoother<Sample>, length> g;
+  std::array<ExpSmoother<Sample>, length> k;
+
+public:
+  void pushCutoffAt(size_t index, Sample normalizedFreq, Sample Q)
+  {
+    g[index].push(
+      A_sqrt * std::tan(std::clamp(normalizedFreq, minCutoff, nyquist) * Sample(pi)));
+    k[index].push(Sample(1) / Q);
+  }
+
+  void resetCutoffAt(size_t index, Sample normalizedFreq, Sample Q)
+  {
+    g[index].reset(
+      A_sqrt * std::tan(std::clamp(normalizedFreq, minCutoff, nyquist) * Sample(pi)));
+    k[index].reset(Sample(1) / Q);
+  }
+
+  void reset()
+  {
+    ic1eq.fill(0);
+    ic2eq.fill(0);
+  }
+
+  void process(std::array<Sample, length> &v0)
+  {
+    for (size_t n = 0; n < length; ++n) {
+      auto gn = g[n].process();
+      auto kn = k[n].process();
+      auto v1 = (ic1eq[n] + gn * (v0[n] - ic2eq[n])) / (Sample(1) + gn * (gn + kn));
+      auto v2 = ic2eq[n] + gn * v1;
+      ic1eq[n] = Sample(2) * v1 - ic1eq[n];
+      ic2eq[n] = Sample(2) * v2 - ic2eq[n];
+      v0[n] = A * A * (v0[n] - kn * v1 - v2) + A * kn * v1 + v2;
+    }
+  }
+};
+
+template<typename Sample, size_t length> class LegacyParallelDelay {
+public:
+  std::array<Sample, length> neutralTime{};
+  std::array<Sample, length> time{};
+  std::array<size_t, length> wptr{};
+  std::array<std::vector<Sample>, length> buffer;
+
+  void setup(Sample sampleRate, Sample maxTime)
+  {
+    auto size = size_t(sampleRate * maxTime) + 2;
+    for (auto &bf : buffer) bf.resize(size < 4 ? 4 : size);
+
+    reset();
+  }
+
+  void reset(Sample timeInSample = 0)
+  {
+    neutralTime.fill(timeInSample);
+    time.fill(timeInSample);
+    for (auto &bf : buffer) std::fill(bf.begin(), bf.end(), Sample(0));
+  }
+
+  void setDelayTimeAt(size_t index, Sample sampleRate, Sample overtone, Sample noteFreq)
+  {
+    constexpr auto eps = std::numeric_limits<Sample>::epsilon();
+    overtone = std::max(eps, overtone);
+    noteFreq = std::max(eps, noteFreq);
+    neutralTime[index] = std::clamp(
+      sampleRate / (overtone * noteFreq), Sample(0), Sample(buffer[index].size() - 1));
+  }
+
+  void resetDelayTimeAt(size_t index, Sample sampleRate, Sample overtone, Sample noteFreq)
+  {
+    setDelayTimeAt(index, sampleRate, overtone, noteFreq);
+    time[index] = neutralTime[index];
+  }
+
+  void process(
+    std::array<Sample, length> &input,
+    Sample modulation,
+    Sample slewRate,
+    Sample minModulation)
+  {
+    for (size_t idx = 0; idx < length; ++idx) {
+      // Rate limit delay time.
+      auto timeMod = Sample(1) - modulation * std::abs(input[idx]);
+      auto targetTime = neutralTime[idx] * std::max(minModulation, timeMod);
+      auto diff = targetTime - time[idx];
+      if (diff > slewRate) {
+        time[idx] += slewRate;
+      } else if (diff < -slewRate) {
+        time[idx] -= slewRate;
+      } else {
+        time[idx] = targetTime;
+      }
+
+      // Set delay time.
+      size_t timeInt = size_t(time[idx]);
+      Sample rFraction = time[idx] - Sample(timeInt);
+
+      auto &buf = buffer[idx];
+
+      size_t rptr0 = wptr[idx] - timeInt;
+      size_t rptr1 = rptr0 - 1;
+      if (rptr0 >= buf.size()) rptr0 += buf.size(); // Unsigned negative overflow case.
+      if (rptr1 >= buf.size()) rptr1 += buf.size(); // Unsigned negative overflow case.
+
+      // Write to buffer.
+      buf[wptr[idx]] = input[idx];
+      if (++wptr[idx] >= buf.size()) wptr[idx] -= buf.size();
+
+      // Read from buffer.
+      input[idx] = buf[rptr0] + rFraction * (buf[rptr1] - buf[rptr0]);
+    }
+  }
+};
+
+template<typename Sample, size_t length> class LegacyModulatedFDN {
+private:
+  std::array<std::array<Sample, length>, length> matrix{};
+  std::array<std::array<Sample, length>, 2> buf{};
+  size_t bufIndex = 0;
+
+public:
+  std::array<Sample, length> inputGain{};
+  LegacyParallelDelay<Sample, length> delay;
+  LegacySVFHighshelf<Sample, length> lowpass;
+  LegacySVFHighpass<Sample, length> highpass;
+
+  /**
+  If `identityAmount` is close to 0, then the result becomes close to identity matrix.
+
+  This algorithm is ported from `scipy.stats.ortho_group` in SciPy v1.8.0.
+  */
+  void randomOrthogonal(
+    unsigned seed,
+    Sample identityAmount,
+    Sample ratio,
+    const std::vector<std::vector<Sample>> &randomBase)
+  {
+    pcg64 rng{};
+    rng.seed(seed);
+    std::normal_distribution<Sample> dist{}; // mean 0, stddev 1.
+
+    matrix.fill({});
+    for (size_t i = 0; i < length; ++i) matrix[i][i] = Sample(1);
+
+    std::array<Sample, length> x;
+    for (size_t n = 0; n < length; ++n) {
+      auto xRange = length - n;
+
+      x[0] = Sample(1);
+      for (size_t i = 1; i < xRange; ++i) {
+        auto mix = randomBase[n][i] + ratio * (dist(rng) - randomBase[n][i]);
+        x[i] = identityAmount * mix;
+      }
+
+      Sample norm2 = 0;
+      for (size_t i = 0; i < xRange; ++i) norm2 += x[i] * x[i];
+
+      Sample x0 = x[0];
+
+      Sample D = x0 >= 0 ? Sample(1) : Sample(-1);
+      x[0] += D * std::sqrt(norm2);
+
+      Sample denom = std::sqrt((norm2 - x0 * x0 + x[0] * x[0]) / Sample(2));
+      for (size_t i = 0; i < xRange; ++i) x[i] /= denom;
+
+      for (size_t row = 0; row < length; ++row) {
+        Sample dotH = 0;
+        for (size_t col = 0; col < xRange; ++col) dotH += matrix[col][row] * x[col];
+        for (size_t col = 0; col < xRange; ++col) {
+          matrix[col][row] = D * (matrix[col][row] - dotH * x[col]);
+        }
+      }
+    }
+  }
+
+  void setup(Sample sampleRate, Sample maxTime)
+  {
+    delay.setup(sampleRate, maxTime);
+
+    // Lowpass cutoff is set slightly below Nyquist frequency to prevent blow up.
+    for (size_t idx = 0; idx < length; ++idx) {
+      lowpass.resetCutoffAt(idx, Sample(0.499), Sample(0.5));
+      highpass.resetCutoffAt(idx, Sample(5) / sampleRate, Sample(0.5));
+    }
+
+    reset();
+  }
+
+  void reset()
+  {
+    buf.fill({});
+    delay.reset();
+    lowpass.reset();
+    highpass.reset();
+  }
+
+  Sample process(
+    Sample input,
+    Sample feedback,
+    Sample modulation,
+    Sample delayTimeSlewRate,
+    Sample minModulation)
+  {
+    bufIndex ^= 1;
+    auto &front = buf[bufIndex];
+    auto &back = buf[bufIndex ^ 1];
+    front.fill(0);
+    for (size_t i = 0; i < length; ++i) {
+      for (size_t j = 0; j < length; ++j) front[i] += matrix[i][j] * back[j];
+    }
+
+    for (size_t idx = 0; idx < length; ++idx) {
+      front[idx] = input * inputGain[idx] + feedback * front[idx];
+    }
+    delay.process(front, modulation, delayTimeSlewRate, minModulation);
+    lowpass.process(front);
+    highpass.process(front);
+
+    return std::accumulate(front.begin(), front.end(), Sample(0));
+  }
+};
+
+struct Result {
+  double legacyNs = 0;
+  double currentNs = 0;
+  double maxDiff = 0;
+};
+
+// Same calls as `DSPCore` of MembraneSynth. `FDN` is reset at the first hit only.
+template<typename FDN>
+double render(FDN &fdn, double hitsPerSecond, std::vector<double> &output)
+{
+  std::vector<std::vector<double>> randomBase(fdnSize);
+  for (size_t i = 0; i < fdnSize; ++i) randomBase[i].assign(fdnSize - i, 0.0);
+
+  std::minstd_rand rng{0};
+  std::uniform_real_distribution<double> dist{0.0, 1.0};
+  const auto interval = size_t(upRate / hitsPerSecond);
+
+  fdn.setup(upRate, 1.0);
+  for (size_t idx = 0; idx < fdnSize; ++idx) {
+    fdn.lowpass.resetCutoffAt(idx, 8000.0 / upRate, 0.7);
+    fdn.highpass.resetCutoffAt(idx, 20.0 / upRate, 0.7);
+  }
+
+  PulseGenerator<double> pulse;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t frame = 0; frame < nFrame; ++frame) {
+    if (frame % interval == 0) {
+      pulse.noteOn(0.5, 0.002 * upRate);
+      fdn.randomOrthogonal(unsigned(rng()), 0.5, 0.5, randomBase);
+      for (size_t idx = 0; idx < fdnSize; ++idx) {
+        fdn.inputGain[idx] = 1.0 / double(fdnSize);
+        fdn.delay.resetDelayTimeAt(idx, upRate, 1.0 + idx * (1.0 + dist(rng)), 110.0);
+      }
+    }
+
+    // Sweeps cutoff once per block, as `DSPCore::setParameters()` does.
+    if (frame % blockSize == 0) {
+      auto cutoff = 2000.0 + 1000.0 * double(frame % interval) / double(interval);
+      for (size_t idx = 0; idx < fdnSize; ++idx) {
+        fdn.lowpass.pushCutoffAt(idx, cutoff * (idx + 1) / upRate, 0.7);
+      }
+    }
+
+    output[frame] = fdn.process(pulse.process(), 0.98, 0.5, 0.2, 0.5);
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() / nFrame;
+}
+
+Result run(double hitsPerSecond)
+{
+  // Both are too large for stack.
+  auto legacy = std::make_unique<LegacyModulatedFDN<double, fdnSize>>();
+  auto current = std::make_unique<ModulatedFDN<double, fdnSize>>();
+
+  std::vector<double> outLegacy(nFrame);
+  std::vector<double> outCurrent(nFrame);
+
+  // Minimum of `nTrial` runs.
+  Result result;
+  result.legacyNs = std::numeric_limits<double>::max();
+  result.currentNs = std::numeric_limits<double>::max();
+  for (size_t trial = 0; trial < nTrial; ++trial) {
+    auto ns = render(*legacy, hitsPerSecond, outLegacy);
+    result.legacyNs = std::min(result.legacyNs, ns);
+    ns = render(*current, hitsPerSecond, outCurrent);
+    result.currentNs = std::min(result.currentNs, ns);
+  }
+  for (size_t i = 0; i < nFrame; ++i) {
+    result.maxDiff = std::max(result.maxDiff, std::abs(outLegacy[i] - outCurrent[i]));
+  }
+  return result;
+}
+
+int main()
+{
+  // Same as `PlugProcessor::process()`.
+  ScopedNoDenormals noDenormals;
+
+  SmootherCommon<double>::setSampleRate(upRate);
+  SmootherCommon<double>::setTime(0.04);
+
+  std::cout << "hits/s, legacy [ns/sample], current [ns/sample], speedup, maxDiff\n";
+  bool isSame = true;
+  for (double hitsPerSecond : {1.0, 8.0, 16.0, 32.0}) {
+    auto result = run(hitsPerSecond);
+    isSame &= result.maxDiff == 0;
+    std::cout << hitsPerSecond << ", " << std::fixed << std::setprecision(3)
+              << result.legacyNs << ", " << result.currentNs << ", "
+              << result.legacyNs / result.currentNs << ", " << std::scientific
+              << result.maxDiff << "\n";
+    std::cout << std::defaultfloat;
+  }
+  return isSame ? EXIT_SUCCESS : EXIT_FAILURE;
+}
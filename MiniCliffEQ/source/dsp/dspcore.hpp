@@ -20,6 +20,7 @@
 #include "../../../common/dsp/constants.hpp"
 #include "../../../common/dsp/lightlimiter.hpp"
 #include "../../../common/dsp/smoother.hpp"
+#include "../../../common/dsp/taildetector.hpp"
 #include "../parameter.hpp"
 #include "fftconvolver.hpp"
 
@@ -42,6 +43,11 @@ public:
   void startup();
   size_t getLatency();
   void setParameters();
+
+  // FIR has finite length, so tail is the length of FIR.
+  size_t getTailSamples() { return size_t(1) << firLengthInPow2; }
+  size_t getLongestDelaySamples() { return size_t(1) << firLengthInPow2; }
+
   void process(
     const size_t length, const float *in0, const float *in1, float *out0, float *out1);
 
@@ -53,6 +59,8 @@ private:
   ExpSmoother<float> interpHighpassGain;
   ExpSmoother<float> interpLowpassGain;
 
-  std::array<SplitConvolver<nBlock, blockSizeInPow2>, 2> convolver;
+  // `SplitConvolver<nBlock, blockSizeInPow2>` is lighter on average, but the head
+  // `ImmediateConvolver` computes a large FFT on a single sample.
+  std::array<DistributedConvolver<firLengthInPow2, 10>, 2> convolver;
   std::array<FixedIntDelay<float, fftconvLatency>, 2> delay;
 };
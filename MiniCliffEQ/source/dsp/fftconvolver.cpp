@@ -21,6 +21,6 @@
 
 namespace SomeDSP {
 
-std::mutex OverlapSaveConvolver::fftwMutex;
+std::mutex fftwMutex;
 
 } // namespace SomeDSP
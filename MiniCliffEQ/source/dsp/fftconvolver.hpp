@@ -30,6 +30,10 @@
 
 namespace SomeDSP {
 
+// `fftwMutex` is used to lock FFTW3 calls except `fftw*_execute`. In other words, FFTW3
+// isn't thread safe except `fftw*_execute` call. All convolvers share this one mutex.
+extern std::mutex fftwMutex;
+
 inline std::vector<float>
 getNuttallFir(size_t nTap, float sampleRate, float cutoffHz, bool isHighpass)
 {
@@ -99,9 +103,6 @@ public:
 
 class OverlapSaveConvolver {
 private:
-  // `fftwMutex` is used to lock FFTW3 calls except `fftw*_execute`.
-  static std::mutex fftwMutex;
-
   static constexpr size_t nBuffer = 2;
 
   size_t half = 1;
@@ -301,6 +302,348 @@ public:
   }
 };
 
+/**
+Overlap-save convolver which distributes the computation over a block period.
+
+FFT of length `2 * half` is decomposed by four-step FFT into `n1` FFTs of length `n2` and
+`n2` FFTs of length `n1`. Those small tasks, and spectrum multiplication, are spread to
+the samples of next block period. This avoids the CPU load spike of
+`OverlapSaveConvolver`, in exchange of 1 block of latency and roughly 2 times more
+computation.
+
+Because of the latency, FIR segments given to `setFir()` must start at or after
+`2 * half`. Two consecutive segments of length `half` are processed by frequency domain
+delay line to share the forward FFT.
+
+`setFir()` transforms the new FIR in its own scratch buffers, so it doesn't disturb the
+tasks of the ongoing period. The new spectrum is swapped in at the next period boundary.
+*/
+class DistributedOverlapSaveConvolver {
+private:
+  static constexpr size_t nSegment = 2;
+
+  size_t half = 1;
+  size_t size = 2; // FFT length.
+  size_t n1 = 1;
+  size_t n2 = 2;
+  size_t nTask = 0;
+
+  float *inBuf; // Ring buffer of length `4 * half`.
+  size_t inMask = 3;
+  size_t wptr = 0;
+  size_t windowStart = 0;
+
+  std::complex<float> *twiddle;
+  std::complex<float> *tmp;
+  std::complex<float> *work;
+  std::array<std::complex<float> *, nSegment> spectrum;
+  std::array<std::complex<float> *, nSegment> fir;
+  std::array<float *, 2> outBuf;
+
+  // Scratch for `setFir()`.
+  std::complex<float> *firTmp;
+  std::complex<float> *firWork;
+  std::array<std::complex<float> *, nSegment> pendingFir;
+  bool isFirPending = false;
+
+  fftwf_plan forwardPlan1;
+  fftwf_plan forwardPlan2;
+  fftwf_plan inversePlan1;
+  fftwf_plan inversePlan2;
+
+  size_t current = 0; // Index of `spectrum` for the latest input block.
+  size_t writeIndex = 0;
+  size_t counter = 0;
+  size_t taskIndex = 0;
+
+  // In-place FFT on `buf`, which must be allocated by `fftwf_malloc()` to have the same
+  // alignment as `tmp`.
+  static void execute(fftwf_plan plan, std::complex<float> *buf)
+  {
+    auto ptr = reinterpret_cast<fftwf_complex *>(buf);
+    fftwf_execute_dft(plan, ptr, ptr);
+  }
+
+  // Column `col` of first step of forward FFT.
+  void forwardColumn(
+    const float *src,
+    size_t start,
+    size_t mask,
+    size_t col,
+    std::complex<float> *tmpBuf,
+    std::complex<float> *workBuf)
+  {
+    for (size_t row = 0; row < n1; ++row) {
+      tmpBuf[row] = std::complex<float>(src[(start + n2 * row + col) & mask], 0);
+    }
+    execute(forwardPlan1, tmpBuf);
+    for (size_t k1 = 0; k1 < n1; ++k1) {
+      workBuf[k1 * n2 + col] = tmpBuf[k1] * twiddle[(col * k1) % size];
+    }
+  }
+
+  // Row `k1` of second step of forward FFT. Output layout is `dest[k1 * n2 + k2]`, which
+  // corresponds to natural index `k1 + n1 * k2`.
+  void forwardRow(
+    size_t k1,
+    std::complex<float> *tmpBuf,
+    std::complex<float> *workBuf,
+    std::complex<float> *dest)
+  {
+    std::copy(workBuf + k1 * n2, workBuf + (k1 + 1) * n2, tmpBuf);
+    execute(forwardPlan2, tmpBuf);
+    std::copy(tmpBuf, tmpBuf + n2, dest + k1 * n2);
+  }
+
+  void multiplySpectrum(size_t k1)
+  {
+    const auto &cur = spectrum[current];
+    const auto &prev = spectrum[current ^ 1];
+    for (size_t idx = k1 * n2; idx < (k1 + 1) * n2; ++idx) {
+      work[idx] = cur[idx] * fir[0][idx] + prev[idx] * fir[1][idx];
+    }
+  }
+
+  void inverseRow(size_t k1)
+  {
+    std::copy(work + k1 * n2, work + (k1 + 1) * n2, tmp);
+    fftwf_execute(inversePlan2);
+    for (size_t col = 0; col < n2; ++col) {
+      work[k1 * n2 + col] = tmp[col] * std::conj(twiddle[(col * k1) % size]);
+    }
+  }
+
+  // Only writes the last half of the output, as required by overlap-save.
+  void inverseColumn(size_t col)
+  {
+    for (size_t k1 = 0; k1 < n1; ++k1) tmp[k1] = work[k1 * n2 + col];
+    fftwf_execute(inversePlan1);
+    auto &out = outBuf[writeIndex];
+    for (size_t row = n1 / 2; row < n1; ++row) out[n2 * row + col - half] = tmp[row].real();
+  }
+
+  void runTask(size_t task)
+  {
+    if (task < n2) return forwardColumn(inBuf, windowStart, inMask, task, tmp, work);
+    task -= n2;
+    if (task < n1) return forwardRow(task, tmp, work, spectrum[current]);
+    task -= n1;
+    if (task < n1) return multiplySpectrum(task);
+    task -= n1;
+    if (task < n1) return inverseRow(task);
+    task -= n1;
+    inverseColumn(task);
+  }
+
+public:
+  void init(size_t blockSize)
+  {
+    const std::lock_guard<std::mutex> fftwLock(fftwMutex);
+
+    half = blockSize;
+    size = 2 * half;
+    n1 = 2;
+    while (n1 * n1 < size) n1 *= 2;
+    n2 = size / n1;
+    nTask = 3 * n1 + 2 * n2;
+
+    inBuf = (float *)fftwf_malloc(sizeof(float) * 4 * half);
+    inMask = 4 * half - 1;
+
+    auto cmalloc = [](size_t length) {
+      return (std::complex<float> *)fftwf_malloc(sizeof(std::complex<float>) * length);
+    };
+    twiddle = cmalloc(size);
+    tmp = cmalloc(n1 > n2 ? n1 : n2);
+    work = cmalloc(size);
+    firTmp = cmalloc(n1 > n2 ? n1 : n2);
+    firWork = cmalloc(size);
+    for (auto &spc : spectrum) spc = cmalloc(size);
+    for (auto &fr : fir) {
+      fr = cmalloc(size);
+      std::fill(fr, fr + size, std::complex<float>(0, 0));
+    }
+    for (auto &fr : pendingFir) fr = cmalloc(size);
+    for (auto &ob : outBuf) ob = (float *)fftwf_malloc(sizeof(float) * half);
+
+    for (size_t idx = 0; idx < size; ++idx) {
+      twiddle[idx] = std::polar(1.0f, float(-twopi * double(idx) / double(size)));
+    }
+
+    auto fftwTmp = reinterpret_cast<fftwf_complex *>(tmp);
+    forwardPlan1
+      = fftwf_plan_dft_1d(int(n1), fftwTmp, fftwTmp, FFTW_FORWARD, FFTW_ESTIMATE);
+    forwardPlan2
+      = fftwf_plan_dft_1d(int(n2), fftwTmp, fftwTmp, FFTW_FORWARD, FFTW_ESTIMATE);
+    inversePlan1
+      = fftwf_plan_dft_1d(int(n1), fftwTmp, fftwTmp, FFTW_BACKWARD, FFTW_ESTIMATE);
+    inversePlan2
+      = fftwf_plan_dft_1d(int(n2), fftwTmp, fftwTmp, FFTW_BACKWARD, FFTW_ESTIMATE);
+
+    reset();
+  }
+
+  ~DistributedOverlapSaveConvolver()
+  {
+    const std::lock_guard<std::mutex> fftwLock(fftwMutex);
+
+    fftwf_destroy_plan(forwardPlan1);
+    fftwf_destroy_plan(forwardPlan2);
+    fftwf_destroy_plan(inversePlan1);
+    fftwf_destroy_plan(inversePlan2);
+
+    fftwf_free(inBuf);
+    fftwf_free(twiddle);
+    fftwf_free(tmp);
+    fftwf_free(work);
+    fftwf_free(firTmp);
+    fftwf_free(firWork);
+    for (auto &spc : spectrum) fftwf_free(spc);
+    for (auto &fr : fir) fftwf_free(fr);
+    for (auto &fr : pendingFir) fftwf_free(fr);
+    for (auto &ob : outBuf) fftwf_free(ob);
+  }
+
+  /**
+  Sets `source[start:start + nSegment * half]`. `start` is the offset in the whole FIR,
+  and it must be `start >= 2 * half`. Coefficients out of `source` are filled by 0.
+
+  The new FIR takes effect from the next period.
+  */
+  void setFir(std::vector<float> &source, size_t start)
+  {
+    std::vector<float> segment(size);
+    for (size_t idx = 0; idx < nSegment; ++idx) {
+      std::fill(segment.begin(), segment.end(), float(0));
+      for (size_t i = 0; i < half; ++i) {
+        auto src = start + idx * half + i;
+        if (src >= source.size()) break;
+        segment[i] = source[src] / float(size); // FFT scaling.
+      }
+
+      for (size_t col = 0; col < n2; ++col) {
+        forwardColumn(segment.data(), 0, size - 1, col, firTmp, firWork);
+      }
+      for (size_t k1 = 0; k1 < n1; ++k1) forwardRow(k1, firTmp, firWork, pendingFir[idx]);
+    }
+    isFirPending = true;
+  }
+
+  void reset()
+  {
+    if (isFirPending) {
+      std::swap(fir, pendingFir);
+      isFirPending = false;
+    }
+
+    std::fill(inBuf, inBuf + 4 * half, float(0));
+    std::fill(work, work + size, std::complex<float>(0, 0));
+    for (auto &spc : spectrum) std::fill(spc, spc + size, std::complex<float>(0, 0));
+    for (auto &ob : outBuf) std::fill(ob, ob + half, float(0));
+
+    wptr = 0;
+    windowStart = 0;
+    current = 0;
+    writeIndex = 0;
+    counter = 0;
+    taskIndex = nTask; // Nothing to compute until the first block is filled.
+  }
+
+  float process(float input)
+  {
+    // Spread tasks evenly, and finish all of them at the last sample of the period.
+    const size_t target = (counter + 1) * nTask / half;
+    while (taskIndex < target) runTask(taskIndex++);
+
+    inBuf[wptr] = input;
+    wptr = (wptr + 1) & inMask;
+
+    auto output = outBuf[writeIndex ^ 1][counter];
+
+    if (++counter >= half) {
+      if (isFirPending) {
+        std::swap(fir, pendingFir);
+        isFirPending = false;
+      }
+      counter = 0;
+      taskIndex = 0;
+      writeIndex ^= 1;
+      current ^= 1;
+      windowStart = (wptr - size) & inMask;
+    }
+    return output;
+  }
+};
+
+/**
+FFT convolver without latency, which distributes FFT of large partitions over the block
+period to avoid CPU load spikes.
+
+Head of FIR `[0, 2^headLengthInPow2)` is processed by `ImmediateConvolver`. The rest is
+processed by `DistributedOverlapSaveConvolver` with block sizes `2^(headLengthInPow2 - 1)`,
+`2^headLengthInPow2`, ..., `2^(lengthInPow2 - 2)`. Each block size `B` covers
+`[2B, 4B)`.
+
+Worst case CPU load is roughly bounded by the largest partition of `ImmediateConvolver`.
+Total computation is higher than `ImmediateConvolver`.
+*/
+template<size_t lengthInPow2, size_t headLengthInPow2 = 10, size_t minBlockSizeInPow2 = 4>
+class DistributedConvolver {
+private:
+  static constexpr size_t nTap = size_t(1) << lengthInPow2;
+  static constexpr size_t nDistributed = lengthInPow2 - headLengthInPow2;
+
+  ImmediateConvolver<headLengthInPow2, minBlockSizeInPow2> immediateConvolver;
+  std::array<DistributedOverlapSaveConvolver, nDistributed> fftConvolver;
+
+public:
+  DistributedConvolver()
+  {
+    static_assert(
+      lengthInPow2 > headLengthInPow2,
+      "DistributedConvolver: lengthInPow2 must be greater than headLengthInPow2.");
+
+    for (size_t idx = 0; idx < nDistributed; ++idx) {
+      fftConvolver[idx].init(size_t(1) << (headLengthInPow2 - 1 + idx));
+    }
+  }
+
+  inline size_t latency()
+  {
+    // Latency of FIR filter specific to `refreshFir()`.
+    return nTap / 2 - 1;
+  }
+
+  void refreshFir(float sampleRate, float cutoffHz, bool isHighpass)
+  {
+    auto coefficient = getNuttallFir(nTap, sampleRate, cutoffHz, isHighpass);
+    setFir(coefficient);
+  }
+
+  void setFir(std::vector<float> &source)
+  {
+    if (source.size() < nTap) source.resize(nTap);
+
+    immediateConvolver.setFir(source);
+    for (size_t idx = 0; idx < nDistributed; ++idx) {
+      fftConvolver[idx].setFir(source, size_t(1) << (headLengthInPow2 + idx));
+    }
+  }
+
+  void reset()
+  {
+    immediateConvolver.reset();
+    for (auto &conv : fftConvolver) conv.reset();
+  }
+
+  float process(float input)
+  {
+    float output = immediateConvolver.process(input);
+    for (auto &conv : fftConvolver) output += conv.process(input);
+    return output;
+  }
+};
+
 class FixedIntDelayVector {
 public:
   std::vector<float> buf{};
@@ -48,6 +48,7 @@ public:
   tresult PLUGIN_API getState(IBStream *state) SMTG_OVERRIDE;
 
   uint32 PLUGIN_API getLatencySamples() SMTG_OVERRIDE;
+  uint32 PLUGIN_API getTailSamples() SMTG_OVERRIDE;
 
   static FUnknown *createInstance(void *)
   {
@@ -55,6 +56,7 @@ public:
   }
 
   void processBypass(Vst::ProcessData &data);
+  void processSilence(Vst::ProcessData &data);
 
 protected:
   inline int32 toDiscrete(Vst::ParamValue normalized, int32 stepCount)
@@ -64,6 +66,7 @@ protected:
 
   uint64_t lastState = 0;
   uint32_t wasBypassing = 0;
+  SomeDSP::TailDetector tailDetector;
   DSPCore dsp;
 };
 
@@ -98,13 +98,12 @@ void DSPCore::reset()
   notePitch.reset(double(1));
 
   feedbackBuffer.fill({});
-  for (auto &x : upSampler) x.reset();
+  upSampler.reset();
   for (auto &x : feedbackHighpass) x.reset();
   for (auto &x : feedbackLowpass) x.reset();
   for (auto &x : frequencyShifter) x.reset();
   for (auto &x : pitchShifter) x.reset();
-  for (auto &x : decimationLowpass) x.reset();
-  for (auto &x : halfbandIir) x.reset();
+  downSampler.reset();
 
   startup();
 }
@@ -204,32 +203,30 @@ void DSPCore::process(
   for (size_t i = 0; i < length; ++i) {
     processMidiNote(i);
 
-    upSampler[0].process(in0[i]);
-    upSampler[1].process(in1[i]);
+    upSampler.process({in0[i], in1[i]});
+    const auto &up = upSampler.output;
+    auto &down = downSampler.inputBuffer;
 
+    std::array<double, 2> out;
     if (oversampling == 0) { // 1x.
-      auto frame = processFrame(upSampler[0].output[0], upSampler[1].output[0]);
-      out0[i] = frame[0];
-      out1[i] = frame[1];
+      out = processFrame(up[0][0], up[1][0]);
     } else if (oversampling == 1) { // 2x.
-      for (size_t j = 0; j < 8; j += 4) {
-        auto frame = processFrame(upSampler[0].output[j], upSampler[1].output[j]);
-        upSampler[0].output[j] = frame[0];
-        upSampler[1].output[j] = frame[1];
+      for (size_t j = 0; j < 2; ++j) {
+        auto frame = processFrame(up[0][4 * j], up[1][4 * j]);
+        down[0][j] = frame[0];
+        down[1][j] = frame[1];
       }
-      out0[i] = halfbandIir[0].process({upSampler[0].output[0], upSampler[0].output[4]});
-      out1[i] = halfbandIir[1].process({upSampler[1].output[0], upSampler[1].output[4]});
+      out = downSampler.process2x();
     } else { // `oversampling == 2`, or 8x.
       for (size_t j = 0; j < maxUpFold; ++j) {
-        auto frame = processFrame(upSampler[0].output[j], upSampler[1].output[j]);
-        decimationLowpass[0].push(frame[0]);
-        decimationLowpass[1].push(frame[1]);
-        upSampler[0].output[j] = decimationLowpass[0].output();
-        upSampler[1].output[j] = decimationLowpass[1].output();
+        auto frame = processFrame(up[0][j], up[1][j]);
+        down[0][j] = frame[0];
+        down[1][j] = frame[1];
       }
-      out0[i] = halfbandIir[0].process({upSampler[0].output[0], upSampler[0].output[4]});
-      out1[i] = halfbandIir[1].process({upSampler[1].output[0], upSampler[1].output[4]});
+      out = downSampler.processLeading();
     }
+    out0[i] = float(out[0]);
+    out1[i] = float(out[1]);
   }
 }
 
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "../../../common/dsp/constants.hpp"
+#include "../../../common/dsp/eventring.hpp"
 #include "../../../common/dsp/lfo.hpp"
 #include "../../../common/dsp/multirate.hpp"
 #include "../../../common/dsp/smoother.hpp"
@@ -37,11 +38,7 @@ public:
     float velocity;
   };
 
-  DSPCore()
-  {
-    midiNotes.reserve(1024);
-    noteStack.reserve(1024);
-  }
+  DSPCore() { noteStack.reserve(1024); }
 
   GlobalParameter param;
   bool isPlaying = false;
@@ -74,22 +71,17 @@ public:
     note.id = noteId;
     note.pitch = pitch + tuning;
     note.velocity = velocity;
-    midiNotes.push_back(note);
+    midiNotes.push(note);
   }
 
   void processMidiNote(size_t frame)
   {
-    while (true) {
-      auto it = std::find_if(midiNotes.begin(), midiNotes.end(), [&](const NoteInfo &nt) {
-        return nt.frame == frame;
-      });
-      if (it == std::end(midiNotes)) return;
-      if (it->isNoteOn)
-        noteOn(*it);
+    midiNotes.dispatch(frame, [&](NoteInfo &note) {
+      if (note.isNoteOn)
+        noteOn(note);
       else
-        noteOff(it->id);
-      midiNotes.erase(it);
-    }
+        noteOff(note.id);
+    });
   }
 
 private:
@@ -100,7 +92,7 @@ private:
 
   static constexpr size_t maxUpFold = 8;
 
-  std::vector<NoteInfo> midiNotes;
+  MidiEventRing<NoteInfo> midiNotes;
   std::vector<NoteInfo> noteStack;
 
   double sampleRate = 44100;
@@ -131,11 +123,10 @@ private:
   LinearTempoSynchronizer<double, 32768> synchronizer;
 
   std::array<double, 2> feedbackBuffer{};
-  std::array<CubicUpSampler<double, maxUpFold>, 2> upSampler;
+  PolyphaseCubicUpSampler<double, 2, maxUpFold> upSampler;
   std::array<SVF<double>, 2> feedbackHighpass;
   std::array<SVF<double>, 2> feedbackLowpass;
   std::array<AMFrequencyShifter<double>, 2> frequencyShifter;
   std::array<PitchShiftDelay<double>, 2> pitchShifter;
-  std::array<DecimationLowpass<double, Sos8FoldFirstStage<double>>, 2> decimationLowpass;
-  std::array<HalfBandIIR<double, HalfBandCoefficient<double>>, 2> halfbandIir;
+  PolyphaseDownSampler<double, 2, Sos8FoldFirstStage<double>> downSampler;
 };
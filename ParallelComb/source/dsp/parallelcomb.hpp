@@ -22,7 +22,9 @@
 
 #include <algorithm>
 #include <array>
+#include <cstdint>
 #include <numeric>
+#include <vector>
 
 namespace SomeDSP {
 
@@ -44,44 +46,62 @@ public:
   }
 };
 
+/**
+Rate limiter followed by EMA lowpass, for each tap. Values are stored as arrays, so the
+loop over taps is vectorized.
+*/
 template<typename Sample, size_t nValue> class ParallelCombSmoother {
 private:
-  std::array<RateLimiter<Sample>, nValue> limiter;
-  std::array<EMAFilter<Sample>, nValue> lowpass;
+  std::array<Sample, nValue> target{};
+  std::array<Sample, nValue> limited{};
+  std::array<Sample, nValue> value{};
 
 public:
   void resetAt(size_t index, Sample value = 0)
   {
-    limiter[index].reset(value);
-    lowpass[index].reset(value);
+    target[index] = value;
+    limited[index] = value;
+    this->value[index] = value;
   }
 
-  void pushAt(size_t index, Sample target) { limiter[index].push(target); }
-  Sample at(size_t index) { return lowpass[index].value; }
+  void pushAt(size_t index, Sample target) { this->target[index] = target; }
+  Sample at(size_t index) { return value[index]; }
+  const std::array<Sample, nValue> &values() const { return value; }
 
   void process(Sample rate, Sample kp)
   {
     for (size_t idx = 0; idx < nValue; ++idx) {
-      lowpass[idx].kp = kp;
-      lowpass[idx].process(limiter[idx].process(rate));
+      // Same as `RateLimiter::process()`. `rate` may be negative.
+      auto diff = target[idx] - limited[idx];
+      limited[idx] = diff > rate ? limited[idx] + rate
+        : diff < -rate           ? limited[idx] - rate
+                                 : target[idx];
+      value[idx] += kp * (limited[idx] - value[idx]);
     }
   }
 };
 
+/**
+Multi-tap delay. The ring buffer is mirrored: each sample is written at `wptr` and
+`wptr + size`. Reading from `wptr + size - time` never wraps around, so the tap loop has
+no branches and becomes a vectorized gather.
+*/
 template<typename Sample, size_t nTap> class ParallelComb {
 private:
+  size_t size = 4;
   size_t wptr = 0;
   std::vector<Sample> buf;
 
 public:
   ParallelCombSmoother<Sample, nTap> time;
 
-  ParallelComb() : buf(4) {}
+  ParallelComb() : buf(2 * size) {}
 
   void setup(Sample sampleRate, Sample maxTime)
   {
-    auto &&size = size_t(sampleRate * maxTime) + 1;
-    buf.resize(size < 4 ? 4 : size);
+    auto &&newSize = size_t(sampleRate * maxTime) + 1;
+    size = newSize < 4 ? 4 : newSize;
+    buf.resize(2 * size);
 
     reset();
   }
@@ -94,23 +114,30 @@ public:
 
   Sample process(Sample input, Sample rate, Sample kp)
   {
-    if (++wptr >= buf.size()) wptr -= buf.size();
+    if (++wptr >= size) wptr -= size;
     buf[wptr] = input;
+    buf[wptr + size] = input;
 
     time.process(rate, kp);
 
-    Sample output = Sample(0);
+    std::array<int32_t, nTap> index;
+    std::array<Sample, nTap> fraction;
+    const auto &tm = time.values();
+    const auto maxTime = Sample(size - 1);
+    const auto start = int32_t(wptr + size);
     for (size_t idx = 0; idx < nTap; ++idx) {
-      Sample clamped = std::clamp(time.at(idx), Sample(0), Sample(buf.size() - 1));
-      size_t timeInt = size_t(clamped);
-      Sample fraction = clamped - Sample(timeInt);
-
-      size_t rptr0 = wptr - timeInt;
-      size_t rptr1 = rptr0 - 1;
-      if (rptr0 >= buf.size()) rptr0 += buf.size(); // Unsigned negative overflow case.
-      if (rptr1 >= buf.size()) rptr1 += buf.size(); // Unsigned negative overflow case.
+      Sample clamped = std::min(std::max(tm[idx], Sample(0)), maxTime);
+      auto timeInt = int32_t(clamped);
+      fraction[idx] = clamped - Sample(timeInt);
+      index[idx] = start - timeInt;
+    }
 
-      output -= buf[rptr0] + fraction * (buf[rptr1] - buf[rptr0]);
+    Sample output = Sample(0);
+    const Sample *data = buf.data();
+    for (size_t idx = 0; idx < nTap; ++idx) {
+      auto s0 = data[index[idx]];
+      auto s1 = data[index[idx] - 1];
+      output -= s0 + fraction[idx] * (s1 - s0);
     }
     return output;
   }
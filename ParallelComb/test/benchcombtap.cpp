@@ -0,0 +1,158 @@
+// (c) 2022 Takamitsu Endo
+//
+// This file is part of Uhhyou Plugins.
+//
+// Uhhyou Plugins is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Uhhyou Plugins is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Uhhyou Plugins.  If not, see <https://www.gnu.org/licenses/>.
+
+// Compares the tap loop of `ParallelComb` against the previous scalar loop, for each
+// number of taps and oversampling fold. The plugin uses 4 taps, and 1 or 16 fold.
+//
+// Results are nanoseconds per output sample of one channel. `maxDiff` is the maximum
+// absolute difference between the outputs, which should be 0.
+
+#include "../source/dsp/parallelcomb.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+constexpr float baseRate = 48000.0f;
+constexpr float maxDelayTime = 0.2f;
+constexpr size_t nFrame = 48000;
+
+// Previous implementation. Wraps 2 read pointers for each tap.
+template<typename Sample, size_t nTap> class ScalarParallelComb {
+private:
+  size_t wptr = 0;
+  std::vector<Sample> buf;
+
+public:
+  std::array<SomeDSP::RateLimiter<Sample>, nTap> limiter;
+  std::array<SomeDSP::EMAFilter<Sample>, nTap> lowpass;
+
+  void setup(Sample sampleRate, Sample maxTime)
+  {
+    auto &&size = size_t(sampleRate * maxTime) + 1;
+    buf.assign(size < 4 ? 4 : size, Sample(0));
+    wptr = 0;
+  }
+
+  Sample process(Sample input, Sample rate, Sample kp)
+  {
+    if (++wptr >= buf.size()) wptr -= buf.size();
+    buf[wptr] = input;
+
+    for (size_t idx = 0; idx < nTap; ++idx) {
+      lowpass[idx].kp = kp;
+      lowpass[idx].process(limiter[idx].process(rate));
+    }
+
+    Sample output = Sample(0);
+    for (size_t idx = 0; idx < nTap; ++idx) {
+      Sample clamped
+        = std::clamp(lowpass[idx].value, Sample(0), Sample(buf.size() - 1));
+      size_t timeInt = size_t(clamped);
+      Sample fraction = clamped - Sample(timeInt);
+
+      size_t rptr0 = wptr - timeInt;
+      size_t rptr1 = rptr0 - 1;
+      if (rptr0 >= buf.size()) rptr0 += buf.size(); // Unsigned negative overflow case.
+      if (rptr1 >= buf.size()) rptr1 += buf.size(); // Unsigned negative overflow case.
+
+      output -= buf[rptr0] + fraction * (buf[rptr1] - buf[rptr0]);
+    }
+    return output;
+  }
+};
+
+struct Result {
+  double scalarNs = 0;
+  double simdNs = 0;
+  float maxDiff = 0;
+};
+
+template<size_t nTap> Result run(size_t fold)
+{
+  const float sampleRate = baseRate * float(fold);
+
+  ScalarParallelComb<float, nTap> scalar;
+  SomeDSP::ParallelComb<float, nTap> simd;
+  scalar.setup(sampleRate, maxDelayTime);
+  simd.setup(sampleRate, maxDelayTime);
+
+  // Tap times are spread over the buffer so that reads miss the cache as in real use.
+  std::minstd_rand rng{0};
+  std::uniform_real_distribution<float> timeDist{0.001f, maxDelayTime};
+  for (size_t idx = 0; idx < nTap; ++idx) {
+    auto time = sampleRate * timeDist(rng);
+    scalar.limiter[idx].reset(time);
+    scalar.lowpass[idx].reset(time);
+    simd.time.resetAt(idx, time);
+  }
+
+  const size_t length = nFrame * fold;
+  std::vector<float> input(length);
+  std::uniform_real_distribution<float> sigDist{-0.5f, 0.5f};
+  for (auto &value : input) value = sigDist(rng);
+  std::vector<float> outScalar(length);
+  std::vector<float> outSimd(length);
+
+  const float rate = 0.5f;
+  const float kp = 0.01f;
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < length; ++i) outScalar[i] = scalar.process(input[i], rate, kp);
+  auto mid = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < length; ++i) outSimd[i] = simd.process(input[i], rate, kp);
+  auto end = std::chrono::steady_clock::now();
+
+  Result result;
+  using Nano = std::chrono::duration<double, std::nano>;
+  result.scalarNs = Nano(mid - start).count() / nFrame;
+  result.simdNs = Nano(end - mid).count() / nFrame;
+  for (size_t i = 0; i < length; ++i) {
+    result.maxDiff = std::max(result.maxDiff, std::abs(outScalar[i] - outSimd[i]));
+  }
+  return result;
+}
+
+template<size_t nTap> bool print()
+{
+  bool isSame = true;
+  for (size_t fold : {size_t(1), size_t(16)}) {
+    auto result = run<nTap>(fold);
+    isSame &= result.maxDiff == 0;
+    std::cout << nTap << ", " << fold << ", " << std::fixed << std::setprecision(3)
+              << result.scalarNs << ", " << result.simdNs << ", "
+              << result.scalarNs / result.simdNs << ", " << std::scientific
+              << result.maxDiff << "\n";
+  }
+  return isSame;
+}
+
+int main()
+{
+  std::cout << "nTap, fold, scalar [ns/sample], simd [ns/sample], speedup, maxDiff\n";
+  bool isSame = true;
+  isSame &= print<4>();
+  isSame &= print<8>();
+  isSame &= print<16>();
+  isSame &= print<32>();
+  return isSame ? EXIT_SUCCESS : EXIT_FAILURE;
+}
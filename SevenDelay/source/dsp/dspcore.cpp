@@ -19,6 +19,9 @@
 
 constexpr size_t channel = 2;
 
+// Tone filter coefficients ramp to new target in this interval.
+constexpr double toneControlSeconds = 0.00025;
+
 template<typename T> inline std::array<T, 2> calcPan(T inL, T inR, T pan, T spread)
 {
   T balanceL = std::clamp<T>(spread, T(0), T(1));
@@ -47,12 +50,15 @@ template<typename T> inline T calcNotePitch(T note)
 
 void DSPCore::setup(double sampleRate)
 {
+  this->sampleRate = sampleRate;
+
   SmootherCommon<double>::setSampleRate(double(sampleRate));
 
   for (size_t i = 0; i < delay.size(); ++i)
     delay[i].setup(double(sampleRate), double(1), maxDelayTime);
 
   for (size_t i = 0; i < filter.size(); ++i) filter[i].setup(double(sampleRate));
+  toneCoefficient.setInterval(size_t(sampleRate * toneControlSeconds));
 
   for (size_t i = 0; i < dcKiller.size(); ++i) {
     dcKiller[i].setup(double(sampleRate), double(0.1));
@@ -61,6 +67,7 @@ void DSPCore::setup(double sampleRate)
   lfoPhaseTick = double(twopi) / sampleRate;
 
   startup();
+  updateTailSamples(param.snapshot.acquire());
 }
 
 void DSPCore::reset()
@@ -69,62 +76,105 @@ void DSPCore::reset()
   noteStack.clear();
   notePitchMultiplier = double(1);
 
+  clearTail();
+}
+
+void DSPCore::clearTail()
+{
   for (size_t i = 0; i < channel; ++i) {
     delay[i].reset();
     filter[i].reset();
     dcKiller[i].reset();
   }
+  toneCoefficient.reset(0);
   startup();
 }
 
 void DSPCore::startup()
 {
+  const auto &pv = param.snapshot.acquire();
   delayOut.fill({});
-  lfoPhase = param.value[ParameterID::lfoInitialPhase]->getDouble();
+  lfoPhase = pv.lfoInitialPhase;
 }
 
 void DSPCore::setParameters()
 {
-  SmootherCommon<double>::setTime(param.value[ParameterID::smoothness]->getDouble());
+  const auto &pv = param.snapshot.acquire();
+
+  SmootherCommon<double>::setTime(pv.smoothness);
 
   // This won't work if sync is on and tempo < 15. Up to 8 sec or 8/16 beat.
   // 15.0 comes from (60 sec per minute) * (4 beat) / (16 beat).
-  auto time = param.value[ParameterID::time]->getDouble() * notePitchMultiplier;
-  if (param.value[ParameterID::tempoSync]->getInt()) {
+  auto time = pv.time * notePitchMultiplier;
+  if (pv.tempoSync) {
     if (time < double(1))
       time *= double(15) / double(tempo);
     else
       time = std::floor(double(2) * time) * double(7.5) / double(tempo);
   }
 
-  auto offset = param.value[ParameterID::offset]->getDouble();
+  auto offset = pv.offset;
   interpTime[0].push(offset < double(0) ? time * (double(1) + offset) : time);
   interpTime[1].push(offset > double(0) ? time * (double(1) - offset) : time);
 
-  interpWetMix.push(param.value[ParameterID::wetMix]->getDouble());
-  interpDryMix.push(param.value[ParameterID::dryMix]->getDouble());
-  interpFeedback.push(
-    param.value[ParameterID::negativeFeedback]->getInt()
-      ? -param.value[ParameterID::feedback]->getDouble()
-      : param.value[ParameterID::feedback]->getDouble());
-  interpLfoTimeAmount.push(param.value[ParameterID::lfoTimeAmount]->getDouble());
-  interpLfoToneAmount.push(param.value[ParameterID::lfoToneAmount]->getDouble());
-  interpLfoFrequency.push(param.value[ParameterID::lfoFrequency]->getDouble());
-  interpLfoShape.push(param.value[ParameterID::lfoShape]->getDouble());
+  interpWetMix.push(pv.wetMix);
+  interpDryMix.push(pv.dryMix);
+  interpFeedback.push(pv.negativeFeedback ? -pv.feedback : pv.feedback);
+  interpLfoTimeAmount.push(pv.lfoTimeAmount);
+  interpLfoToneAmount.push(pv.lfoToneAmount);
+  interpLfoFrequency.push(pv.lfoFrequency);
+  interpLfoShape.push(pv.lfoShape);
+
+  interpPanIn.push(pv.inPan);
+  interpSpreadIn.push(pv.inSpread);
+  interpPanOut.push(pv.outPan);
+  interpSpreadOut.push(pv.outSpread);
 
-  interpPanIn.push(param.value[ParameterID::inPan]->getDouble());
-  interpSpreadIn.push(param.value[ParameterID::inSpread]->getDouble());
-  interpPanOut.push(param.value[ParameterID::outPan]->getDouble());
-  interpSpreadOut.push(param.value[ParameterID::outSpread]->getDouble());
+  interpToneCutoff.push(pv.toneCutoff);
+  interpToneQ.push(pv.toneQ);
+  interpToneMix.push(double(Scales::toneMix.map(pv.toneCutoffNormalized)));
 
-  interpToneCutoff.push(param.value[ParameterID::toneCutoff]->getDouble());
-  interpToneQ.push(param.value[ParameterID::toneQ]->getDouble());
-  interpToneMix.push(
-    double(Scales::toneMix.map(param.value[ParameterID::toneCutoff]->getNormalized())));
+  interpDCKill.push(pv.dckill);
+  interpDCKillMix.push(double(Scales::dckillMix.reverseMap(pv.dckillNormalized)));
 
-  interpDCKill.push(param.value[ParameterID::dckill]->getDouble());
-  interpDCKillMix.push(double(
-    Scales::dckillMix.reverseMap(param.value[ParameterID::dckill]->getNormalized())));
+  updateTailSamples(pv);
+}
+
+double DSPCore::getLongestDelaySeconds(const ParameterSnapshot &pv)
+{
+  auto time = pv.time * notePitchMultiplier;
+  if (pv.tempoSync) {
+    if (time < double(1))
+      time *= double(15) / double(tempo);
+    else
+      time = std::floor(double(2) * time) * double(7.5) / double(tempo);
+  }
+
+  // Smoothers may be still moving from previous value. LFO adds up to 2 times of
+  // `lfoTimeAmount`.
+  time = std::max({time, interpTime[0].getValue(), interpTime[1].getValue()});
+  return std::min(time + double(2) * pv.lfoTimeAmount, maxDelayTime);
+}
+
+void DSPCore::updateTailSamples(const ParameterSnapshot &pv)
+{
+  auto feedback = std::max(pv.feedback, std::abs(interpFeedback.getValue()));
+  auto frames = TailDetector::feedbackTailFrames(
+    sampleRate, getLongestDelaySeconds(pv), feedback);
+  tailSamples.store(
+    uint32_t(std::min<size_t>(frames, std::numeric_limits<uint32_t>::max())),
+    std::memory_order_relaxed);
+}
+
+uint32_t DSPCore::getTailSamples()
+{
+  return tailSamples.load(std::memory_order_relaxed);
+}
+
+size_t DSPCore::getLongestDelaySamples()
+{
+  const auto &pv = param.snapshot.acquire();
+  return size_t(std::ceil(sampleRate * getLongestDelaySeconds(pv)));
 }
 
 void DSPCore::process(
@@ -132,7 +182,7 @@ void DSPCore::process(
 {
   SmootherCommon<double>::setBufferSize(double(length));
 
-  const bool lfoHold = !param.value[ParameterID::lfoHold]->getInt();
+  const bool lfoHold = !param.snapshot.acquire().lfoHold;
   for (size_t i = 0; i < length; ++i) {
     processMidiNote(i);
 
@@ -154,9 +204,11 @@ void DSPCore::process(
       = interpLfoToneAmount.process() * (double(0.5) * lfo + double(0.5));
     auto toneCutoff = interpToneCutoff.process() * lfoTone * lfoTone;
     if (toneCutoff < double(20)) toneCutoff = double(20);
-    const auto toneQ = interpToneQ.process();
-    filter[0].setCutoffQ(toneCutoff, toneQ);
-    filter[1].setCutoffQ(toneCutoff, toneQ);
+    const auto toneQ = std::max(interpToneQ.process(), double(1e-5));
+    toneCoefficient.setTarget(0, toneCutoff / sampleRate, double(2) * toneQ);
+    toneCoefficient.process(0, 1);
+    filter[0].setCoefficient(toneCoefficient.g[0], toneCoefficient.k[0]);
+    filter[1].setCoefficient(toneCoefficient.g[0], toneCoefficient.k[0]);
     auto filterOutL = filter[0].process(delayOut[0]);
     auto filterOutR = filter[1].process(delayOut[1]);
     const auto toneMix = interpToneMix.process();
@@ -187,6 +239,145 @@ void DSPCore::process(
   }
 }
 
+void DSPCore::sortParameterEvents()
+{
+  std::sort(
+    parameterEvents.begin(), parameterEvents.end(),
+    [](const ParameterEvent &lhs, const ParameterEvent &rhs) {
+      return lhs.frame < rhs.frame || (lhs.frame == rhs.frame && lhs.order < rhs.order);
+    });
+}
+
+size_t DSPCore::nextParameterFrame()
+{
+  return parameterEventIndex < parameterEvents.size()
+    ? parameterEvents[parameterEventIndex].frame
+    : std::numeric_limits<size_t>::max();
+}
+
+void DSPCore::processBlock(
+  const size_t length, const float *in0, const float *in1, float *out0, float *out1)
+{
+  SmootherCommon<double>::setBufferSize(double(length));
+
+  sortParameterEvents();
+  parameterEventIndex = 0;
+
+  size_t start = 0;
+  while (start < length) {
+    processParameterEvent(start);
+    processMidiNote(start);
+    const size_t end = std::min(
+      {length, midiNotes.nextFrame(), nextParameterFrame(), start + maxSubBlock});
+    processSubBlock(end - start, in0 + start, in1 + start, out0 + start, out1 + start);
+    start = end;
+  }
+
+  // Events with out of range frame are applied at the end.
+  processParameterEvent(std::numeric_limits<size_t>::max());
+  parameterEvents.clear();
+  parameterEventIndex = 0;
+}
+
+void DSPCore::processSubBlock(
+  const size_t length, const float *in0, const float *in1, float *out0, float *out1)
+{
+  auto &b = buf;
+
+  interpTime[0].processBlock(b.time[0].data(), length);
+  interpTime[1].processBlock(b.time[1].data(), length);
+  interpWetMix.processBlock(b.wetMix.data(), length);
+  interpDryMix.processBlock(b.dryMix.data(), length);
+  interpFeedback.processBlock(b.feedback.data(), length);
+  interpLfoTimeAmount.processBlock(b.lfoTimeAmount.data(), length);
+  interpLfoToneAmount.processBlock(b.lfoToneAmount.data(), length);
+  interpLfoShape.processBlock(b.lfoShape.data(), length);
+  interpPanIn.processBlock(b.panIn.data(), length);
+  interpSpreadIn.processBlock(b.spreadIn.data(), length);
+  interpPanOut.processBlock(b.panOut.data(), length);
+  interpSpreadOut.processBlock(b.spreadOut.data(), length);
+  interpToneCutoff.processBlock(b.toneCutoff.data(), length);
+  interpToneQ.processBlock(b.toneQ.data(), length);
+  interpToneMix.processBlock(b.toneMix.data(), length);
+  interpDCKill.processBlock(b.dckill.data(), length);
+  interpDCKillMix.processBlock(b.dckillMix.data(), length);
+
+  // LFO.
+  const bool lfoHold = !param.snapshot.acquire().lfoHold;
+  if (lfoHold) {
+    interpLfoFrequency.processBlock(b.lfoFrequency.data(), length);
+    for (size_t i = 0; i < length; ++i) {
+      b.lfoPhase[i] = lfoPhase;
+      lfoPhase += b.lfoFrequency[i] * lfoPhaseTick;
+      if (lfoPhase > double(2) * pi) lfoPhase -= double(2) * pi;
+    }
+  } else {
+    std::fill(b.lfoPhase.begin(), b.lfoPhase.begin() + length, lfoPhase);
+  }
+
+  for (size_t i = 0; i < length; ++i) {
+    auto sign = (pi < b.lfoPhase[i]) - (b.lfoPhase[i] < pi);
+    b.lfo[i] = sign * std::pow(std::abs(std::sin(b.lfoPhase[i])), b.lfoShape[i]);
+  }
+
+  // Feed-forward stages.
+  for (size_t i = 0; i < length; ++i) {
+    const auto lfoTime = b.lfoTimeAmount[i] * (double(1) + b.lfo[i]);
+    b.time[0][i] += lfoTime;
+    b.time[1][i] += lfoTime;
+
+    const auto lfoTone = b.lfoToneAmount[i] * (double(0.5) * b.lfo[i] + double(0.5));
+    auto toneCutoff = b.toneCutoff[i] * lfoTone * lfoTone;
+    if (toneCutoff < double(20)) toneCutoff = double(20);
+    const auto toneQ = std::max(b.toneQ[i], double(1e-5));
+    toneCoefficient.setTarget(0, toneCutoff / sampleRate, double(2) * toneQ);
+    toneCoefficient.process(0, 1);
+    b.toneG[i] = toneCoefficient.g[0];
+    b.toneK[i] = toneCoefficient.k[0];
+
+    const auto inDelay
+      = calcPan(double(in0[i]), double(in1[i]), b.panIn[i], b.spreadIn[i]);
+    b.delayIn[0][i] = inDelay[0];
+    b.delayIn[1][i] = inDelay[1];
+  }
+
+  // Feedback loop. Everything after the delay is fed back, so it can't be split.
+  for (size_t i = 0; i < length; ++i) {
+    delay[0].setTime(b.time[0][i]);
+    delay[1].setTime(b.time[1][i]);
+
+    const auto feedback = b.feedback[i];
+    delayOut[0] = delay[0].process(b.delayIn[0][i] + feedback * delayOut[0]);
+    delayOut[1] = delay[1].process(b.delayIn[1][i] + feedback * delayOut[1]);
+
+    filter[0].setCoefficient(b.toneG[i], b.toneK[i]);
+    filter[1].setCoefficient(b.toneG[i], b.toneK[i]);
+    auto filterOutL = filter[0].process(delayOut[0]);
+    auto filterOutR = filter[1].process(delayOut[1]);
+    const auto toneMix = b.toneMix[i];
+    delayOut[0] = filterOutL + toneMix * (delayOut[0] - filterOutL);
+    delayOut[1] = filterOutR + toneMix * (delayOut[1] - filterOutR);
+
+    dcKiller[0].setCutoff(b.dckill[i]);
+    dcKiller[1].setCutoff(b.dckill[i]);
+    filterOutL = dcKiller[0].process(delayOut[0]);
+    filterOutR = dcKiller[1].process(delayOut[1]);
+    const auto dckillMix = b.dckillMix[i];
+    delayOut[0] = filterOutL + dckillMix * (delayOut[0] - filterOutL);
+    delayOut[1] = filterOutR + dckillMix * (delayOut[1] - filterOutR);
+    delayOut = calcPan(delayOut[0], delayOut[1], b.panOut[i], b.spreadOut[i]);
+
+    b.delayOut[0][i] = delayOut[0];
+    b.delayOut[1][i] = delayOut[1];
+  }
+
+  // Output.
+  for (size_t i = 0; i < length; ++i) {
+    out0[i] = float(b.dryMix[i] * in0[i] + b.wetMix[i] * b.delayOut[0][i]);
+    out1[i] = float(b.dryMix[i] * in1[i] + b.wetMix[i] * b.delayOut[1][i]);
+  }
+}
+
 void DSPCore::noteOn(NoteInfo &info)
 {
   notePitchMultiplier = calcNotePitch(info.pitch);
@@ -213,18 +404,17 @@ void DSPCore::noteOff(int_fast32_t noteId)
 
 void DSPCore::updateDelayTime()
 {
-  using ID = ParameterID::ID;
-  const auto &pv = param.value;
+  const auto &pv = param.snapshot.acquire();
 
-  auto time = param.value[ParameterID::time]->getFloat() * notePitchMultiplier;
-  if (param.value[ParameterID::tempoSync]->getInt()) {
+  auto time = float(pv.time) * notePitchMultiplier;
+  if (pv.tempoSync) {
     if (time < double(1))
       time *= double(15) / double(tempo);
     else
       time = std::floor(double(2) * time) * double(7.5) / double(tempo);
   }
 
-  auto offset = param.value[ParameterID::offset]->getFloat();
+  auto offset = float(pv.offset);
   interpTime[0].push(offset < double(0) ? time * (double(1) + offset) : time);
   interpTime[1].push(offset > double(0) ? time * (double(1) - offset) : time);
 }
@@ -17,12 +17,17 @@
 
 #pragma once
 
+#include "../../../common/dsp/eventring.hpp"
+#include "../../../common/dsp/filtercoefficient.hpp"
 #include "../../../common/dsp/smoother.hpp"
+#include "../../../common/dsp/taildetector.hpp"
 #include "../parameter.hpp"
 #include "delay.hpp"
 #include "iir.hpp"
 
 #include <array>
+#include <atomic>
+#include <limits>
 
 using namespace SomeDSP;
 using namespace Steinberg::Synth;
@@ -42,10 +47,17 @@ public:
     float velocity;
   };
 
+  struct ParameterEvent {
+    uint32_t frame;
+    uint32_t order; // Keeps the order of points at the same frame after sorting.
+    uint32_t id;
+    double normalized;
+  };
+
   DSPCore()
   {
-    midiNotes.reserve(1024);
     noteStack.reserve(1024);
+    parameterEvents.reserve(4096);
   }
 
   GlobalParameter param;
@@ -53,12 +65,28 @@ public:
 
   void setup(double sampleRate);
   void reset();   // Stop sounds.
+  // Clears delay lines, filters and ramps after the tail decayed. Unlike `reset()`,
+  // notes are kept, so a key held across the silence keeps its pitch.
+  void clearTail();
   void startup(); // Reset phase, random seed etc.
   void setParameters();
 
+  // Frames until output decays under -150 dB after input stops, or `UINT32_MAX` when
+  // output doesn't decay. Computed on audio thread in `setParameters()`, so this can be
+  // called from any thread.
+  uint32_t getTailSamples();
+
+  // Longest delay from input to output. Used by `TailDetector`.
+  size_t getLongestDelaySamples();
+
   void process(
     const size_t length, const float *in0, const float *in1, float *out0, float *out1);
 
+  // Same output as `process()`. Buffer is split at note events and at `maxSubBlock`, then
+  // smoothers and feed-forward stages are computed over arrays.
+  void processBlock(
+    const size_t length, const float *in0, const float *in1, float *out0, float *out1);
+
   void noteOn(NoteInfo &info);
   void noteOff(int_fast32_t noteId);
 
@@ -76,29 +104,100 @@ public:
     note.id = noteId;
     note.pitch = pitch + tuning;
     note.velocity = velocity;
-    midiNotes.push_back(note);
+    midiNotes.push(note);
+  }
+
+  // Parameter changes inside a buffer. Only consumed by `processBlock()`.
+  void pushParameterEvent(uint32_t frame, uint32_t id, double normalized)
+  {
+    if (id >= param.value.size()) return;
+    if (parameterEvents.size() >= parameterEvents.capacity()) return;
+    parameterEvents.push_back({frame, uint32_t(parameterEvents.size()), id, normalized});
   }
 
+  // Applies all events at or before `frame`.
+  void processParameterEvent(size_t frame)
+  {
+    bool isChanged = false;
+    while (parameterEventIndex < parameterEvents.size()) {
+      const auto &event = parameterEvents[parameterEventIndex];
+      if (event.frame > frame) break;
+      param.value[event.id]->setFromNormalized(event.normalized);
+      ++parameterEventIndex;
+      isChanged = true;
+    }
+    if (!isChanged) return;
+    param.publish();
+    setParameters();
+  }
+
+  // Applies remaining events without rendering. Used when processing is skipped.
+  void flushParameterEvents()
+  {
+    sortParameterEvents();
+    processParameterEvent(std::numeric_limits<size_t>::max());
+    parameterEvents.clear();
+    parameterEventIndex = 0;
+  }
+
+  // Dispatches all queued notes. Called when the block is skipped while idle, so that
+  // the notes don't pile up and fire at stale offsets in a later block.
+  void flushMidiNotes() { processMidiNote(std::numeric_limits<size_t>::max()); }
+
   void processMidiNote(size_t frame)
   {
-    while (true) {
-      auto it = std::find_if(midiNotes.begin(), midiNotes.end(), [&](const NoteInfo &nt) {
-        return nt.frame == frame;
-      });
-      if (it == std::end(midiNotes)) return;
-      if (it->isNoteOn)
-        noteOn(*it);
+    midiNotes.dispatch(frame, [&](NoteInfo &note) {
+      if (note.isNoteOn)
+        noteOn(note);
       else
-        noteOff(it->id);
-      midiNotes.erase(it);
-    }
+        noteOff(note.id);
+    });
   }
 
 protected:
+  static constexpr size_t maxSubBlock = 64;
+
+  struct SubBlockBuffer {
+    using Array = std::array<double, maxSubBlock>;
+
+    std::array<Array, 2> time;
+    Array wetMix;
+    Array dryMix;
+    Array feedback;
+    Array lfoTimeAmount;
+    Array lfoToneAmount;
+    Array lfoFrequency;
+    Array lfoShape;
+    Array panIn;
+    Array spreadIn;
+    Array panOut;
+    Array spreadOut;
+    Array toneCutoff;
+    Array toneQ;
+    Array toneG;
+    Array toneK;
+    Array toneMix;
+    Array dckill;
+    Array dckillMix;
+
+    Array lfoPhase;
+    Array lfo;
+    std::array<Array, 2> delayIn;
+    std::array<Array, 2> delayOut;
+  };
+
+  void sortParameterEvents();
+  size_t nextParameterFrame();
+  void processSubBlock(
+    const size_t length, const float *in0, const float *in1, float *out0, float *out1);
   void updateDelayTime();
+  double getLongestDelaySeconds(const ParameterSnapshot &pv);
+  void updateTailSamples(const ParameterSnapshot &pv);
 
-  std::vector<NoteInfo> midiNotes;
+  MidiEventRing<NoteInfo> midiNotes;
   std::vector<NoteInfo> noteStack;
+  std::vector<ParameterEvent> parameterEvents;
+  size_t parameterEventIndex = 0;
   double notePitchMultiplier = double(1);
 
   std::array<LinearSmoother<double>, 2> interpTime{};
@@ -119,10 +218,15 @@ protected:
   LinearSmoother<double> interpDCKill;
   LinearSmoother<double> interpDCKillMix;
 
+  double sampleRate = 44100.0;
   double lfoPhase;
   double lfoPhaseTick;
   std::array<double, 2> delayOut{};
   std::array<DelayTypeName, 2> delay;
+  SVFCoefficientRamp<double, 1> toneCoefficient;
+  std::atomic<uint32_t> tailSamples{0};
   std::array<FilterTypeName, 2> filter;
   std::array<DCKillerTypeName, 2> dcKiller;
+
+  SubBlockBuffer buf;
 };
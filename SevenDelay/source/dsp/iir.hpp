@@ -36,6 +36,16 @@ public:
     d = Sample(1.0) / (Sample(1.0) + Sample(2.0) * resonance + g * g);
   }
 
+  // `tanG = tan(pi * cutoff / sampleRate)`, and `k = 2 * q`. Same as `setCutoffQ()`
+  // for coefficients computed elsewhere, like `SVFCoefficientRamp`.
+  void setCoefficient(Sample tanG, Sample k)
+  {
+    g = tanG / (Sample(1.0) + tanG);
+    twoR = k;
+    g1 = twoR + g;
+    d = Sample(1.0) / (Sample(1.0) + twoR + g * g);
+  }
+
   // q in (0, 1].
   void setCutoffQ(Sample hz, Sample q)
   {
@@ -21,6 +21,7 @@
 #include <vector>
 
 #include "../../common/parameterInterface.hpp"
+#include "../../common/tripleBuffer.hpp"
 
 #ifdef TEST_DSP
 #include "../../test/value.hpp"
@@ -82,8 +83,38 @@ struct Scales {
   static SomeDSP::LogScale<double> dckillMix; // internal
 };
 
+// Plain copy of parameter values for DSP. Filled by `GlobalParameter::publish()`.
+struct ParameterSnapshot {
+  double time = 0;
+  double feedback = 0;
+  double offset = 0;
+  double wetMix = 0;
+  double dryMix = 0;
+  double lfoTimeAmount = 0;
+  double lfoFrequency = 0;
+  double lfoShape = 0;
+  double lfoInitialPhase = 0;
+  double smoothness = 0;
+  double inSpread = 0;
+  double inPan = 0;
+  double outSpread = 0;
+  double outPan = 0;
+  double toneCutoff = 0;
+  double toneCutoffNormalized = 0;
+  double dckill = 0;
+  double dckillNormalized = 0;
+  double lfoToneAmount = 0;
+  double toneQ = 0;
+
+  uint32_t bypass = 0;
+  uint32_t tempoSync = 0;
+  uint32_t negativeFeedback = 0;
+  uint32_t lfoHold = 0;
+};
+
 struct GlobalParameter : public ParameterInterface {
   std::vector<std::unique_ptr<ValueInterface>> value;
+  TripleBuffer<ParameterSnapshot> snapshot;
 
   GlobalParameter()
   {
@@ -141,6 +172,45 @@ struct GlobalParameter : public ParameterInterface {
       = std::make_unique<LogValue>(0.9, Scales::toneQ, "Allpass Q", Info::kCanAutomate);
 
     for (size_t id = 0; id < value.size(); ++id) value[id]->setId(Vst::ParamID(id));
+
+    publish();
+  }
+
+  // Call after changing `value`. Reader side is `snapshot.acquire()`.
+  void publish()
+  {
+    snapshot.write([&](ParameterSnapshot &ss) { fillSnapshot(ss); });
+  }
+
+  void fillSnapshot(ParameterSnapshot &ss)
+  {
+    using ID = ParameterID::ID;
+
+    ss.time = value[ID::time]->getDouble();
+    ss.feedback = value[ID::feedback]->getDouble();
+    ss.offset = value[ID::offset]->getDouble();
+    ss.wetMix = value[ID::wetMix]->getDouble();
+    ss.dryMix = value[ID::dryMix]->getDouble();
+    ss.lfoTimeAmount = value[ID::lfoTimeAmount]->getDouble();
+    ss.lfoFrequency = value[ID::lfoFrequency]->getDouble();
+    ss.lfoShape = value[ID::lfoShape]->getDouble();
+    ss.lfoInitialPhase = value[ID::lfoInitialPhase]->getDouble();
+    ss.smoothness = value[ID::smoothness]->getDouble();
+    ss.inSpread = value[ID::inSpread]->getDouble();
+    ss.inPan = value[ID::inPan]->getDouble();
+    ss.outSpread = value[ID::outSpread]->getDouble();
+    ss.outPan = value[ID::outPan]->getDouble();
+    ss.toneCutoff = value[ID::toneCutoff]->getDouble();
+    ss.toneCutoffNormalized = value[ID::toneCutoff]->getNormalized();
+    ss.dckill = value[ID::dckill]->getDouble();
+    ss.dckillNormalized = value[ID::dckill]->getNormalized();
+    ss.lfoToneAmount = value[ID::lfoToneAmount]->getDouble();
+    ss.toneQ = value[ID::toneQ]->getDouble();
+
+    ss.bypass = value[ID::bypass]->getInt();
+    ss.tempoSync = value[ID::tempoSync]->getInt();
+    ss.negativeFeedback = value[ID::negativeFeedback]->getInt();
+    ss.lfoHold = value[ID::lfoHold]->getInt();
   }
 
 #ifdef TEST_DSP
@@ -153,6 +223,7 @@ struct GlobalParameter : public ParameterInterface {
     IBStreamer streamer(stream, kLittleEndian);
     for (auto &val : value)
       if (val->setState(streamer)) return kResultFalse;
+    publish();
     return kResultOk;
   }
 
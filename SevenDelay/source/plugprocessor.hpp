@@ -47,18 +47,22 @@ public:
   tresult PLUGIN_API setState(IBStream *state) SMTG_OVERRIDE;
   tresult PLUGIN_API getState(IBStream *state) SMTG_OVERRIDE;
 
+  uint32 PLUGIN_API getTailSamples() SMTG_OVERRIDE;
+
   static FUnknown *createInstance(void *)
   {
     return (Vst::IAudioProcessor *)new PlugProcessor();
   }
 
   void processBypass(Vst::ProcessData &data);
+  void processSilence(Vst::ProcessData &data);
 
 protected:
   void handleEvent(Vst::ProcessData &data);
 
   uint32_t lastState = 0;
   uint32_t wasBypassing = 0;
+  SomeDSP::TailDetector tailDetector;
   float tempo = 120.0f;
   DSPCore dsp;
 };
@@ -0,0 +1,98 @@
+// (c) 2022 Takamitsu Endo
+//
+// This file is part of Uhhyou Plugins.
+//
+// Uhhyou Plugins is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Uhhyou Plugins is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Uhhyou Plugins.  If not, see <https://www.gnu.org/licenses/>.
+
+// Measures the cost of parameter access. "interface" reads values through
+// `ValueInterface` in the same way as `DSPCore::setParameters()` did before
+// `ParameterSnapshot` was added. "snapshot" reads the same values from
+// `GlobalParameter::snapshot`.
+
+#include "../source/dsp/dspcore.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+constexpr size_t nIteration = 1000000;
+
+volatile double sink = 0;
+
+template<typename Func> double measure(Func func)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < nIteration; ++i) func();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() / nIteration;
+}
+
+double readInterface(GlobalParameter &param)
+{
+  using ID = ParameterID::ID;
+  auto &pv = param.value;
+
+  double sum = pv[ID::smoothness]->getDouble() + pv[ID::time]->getDouble()
+    + pv[ID::tempoSync]->getInt() + pv[ID::offset]->getDouble()
+    + pv[ID::wetMix]->getDouble() + pv[ID::dryMix]->getDouble()
+    + pv[ID::negativeFeedback]->getInt() + pv[ID::feedback]->getDouble()
+    + pv[ID::lfoTimeAmount]->getDouble() + pv[ID::lfoToneAmount]->getDouble()
+    + pv[ID::lfoFrequency]->getDouble() + pv[ID::lfoShape]->getDouble()
+    + pv[ID::inPan]->getDouble() + pv[ID::inSpread]->getDouble()
+    + pv[ID::outPan]->getDouble() + pv[ID::outSpread]->getDouble()
+    + pv[ID::toneCutoff]->getDouble() + pv[ID::toneQ]->getDouble()
+    + pv[ID::toneCutoff]->getNormalized() + pv[ID::dckill]->getDouble()
+    + pv[ID::dckill]->getNormalized() + pv[ID::lfoHold]->getInt();
+  return sum;
+}
+
+double readSnapshot(GlobalParameter &param)
+{
+  const auto &pv = param.snapshot.acquire();
+
+  double sum = pv.smoothness + pv.time + pv.tempoSync + pv.offset + pv.wetMix + pv.dryMix
+    + pv.negativeFeedback + pv.feedback + pv.lfoTimeAmount + pv.lfoToneAmount
+    + pv.lfoFrequency + pv.lfoShape + pv.inPan + pv.inSpread + pv.outPan + pv.outSpread
+    + pv.toneCutoff + pv.toneQ + pv.toneCutoffNormalized + pv.dckill
+    + pv.dckillNormalized + pv.lfoHold;
+  return sum;
+}
+
+int main()
+{
+  auto dsp = std::make_unique<DSPCore>();
+  dsp->setup(48000);
+  dsp->param.publish();
+  dsp->setParameters();
+
+  if (readInterface(dsp->param) != readSnapshot(dsp->param)) {
+    std::cerr << "Error: Snapshot doesn't match parameter values.\n";
+    return EXIT_FAILURE;
+  }
+
+  auto &param = dsp->param;
+  auto nsInterface = measure([&]() { sink = sink + readInterface(param); });
+  auto nsSnapshot = measure([&]() { sink = sink + readSnapshot(param); });
+  auto nsPublish = measure([&]() { param.publish(); });
+  auto nsSetParameters = measure([&]() { dsp->setParameters(); });
+
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << "interface read     : " << nsInterface << " ns\n";
+  std::cout << "snapshot read      : " << nsSnapshot << " ns\n";
+  std::cout << "publish            : " << nsPublish << " ns\n";
+  std::cout << "setParameters total: " << nsSetParameters << " ns\n";
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,115 @@
+// (c) 2022 Takamitsu Endo
+//
+// This file is part of Uhhyou Plugins.
+//
+// Uhhyou Plugins is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Uhhyou Plugins is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Uhhyou Plugins.  If not, see <https://www.gnu.org/licenses/>.
+
+// Compares `DSPCore::processBlock()` to `DSPCore::process()`. Outputs must be identical,
+// and throughput is printed for several host buffer sizes.
+
+#include "../source/dsp/dspcore.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+constexpr double sampleRate = 48000;
+constexpr size_t nFrame = size_t(10 * sampleRate);
+
+using ProcessFunc
+  = void (DSPCore::*)(const size_t, const float *, const float *, float *, float *);
+
+std::unique_ptr<DSPCore> setupDSP(size_t bufferSize)
+{
+  // `SmootherCommon` is static. Resets it to make each run independent.
+  SmootherCommon<double>::setBufferSize(double(bufferSize));
+
+  auto dsp = std::make_unique<DSPCore>();
+  dsp->setup(sampleRate);
+  dsp->param.value[ParameterID::lfoTimeAmount]->setFromNormalized(0.3);
+  dsp->param.value[ParameterID::lfoToneAmount]->setFromNormalized(0.7);
+  dsp->param.publish();
+  dsp->setParameters();
+  dsp->reset();
+  return dsp;
+}
+
+// Returns elapsed time in seconds.
+double render(
+  ProcessFunc func,
+  size_t bufferSize,
+  const std::vector<std::vector<float>> &in,
+  std::vector<std::vector<float>> &out)
+{
+  auto dsp = setupDSP(bufferSize);
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < nFrame; i += bufferSize) {
+    const size_t length = std::min(bufferSize, nFrame - i);
+
+    // Moves a parameter to exercise smoothers.
+    dsp->param.value[ParameterID::toneCutoff]->setFromNormalized(
+      0.5 + 0.4 * std::sin(double(i) / sampleRate));
+    dsp->param.publish();
+    dsp->setParameters();
+
+    if (i % (bufferSize * 64) == 0) {
+      dsp->pushMidiNote(true, uint32_t(length / 2), 0, 60, 0, 1);
+    }
+
+    ((*dsp).*func)(
+      length, in[0].data() + i, in[1].data() + i, out[0].data() + i, out[1].data() + i);
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+int main()
+{
+  std::minstd_rand rng{0};
+  std::uniform_real_distribution<float> dist{-0.5f, 0.5f};
+
+  std::vector<std::vector<float>> input(2);
+  for (auto &channel : input) {
+    channel.resize(nFrame);
+    for (auto &value : channel) value = dist(rng);
+  }
+
+  std::vector<std::vector<float>> outSample(2, std::vector<float>(nFrame));
+  std::vector<std::vector<float>> outBlock(2, std::vector<float>(nFrame));
+
+  bool isFailed = false;
+  std::cout << std::setw(8) << "buffer" << std::setw(16) << "process [MS/s]"
+            << std::setw(16) << "block [MS/s]" << std::setw(10) << "ratio\n";
+  for (size_t bufferSize : {16, 64, 256, 1024, 4096}) {
+    auto secSample = render(&DSPCore::process, bufferSize, input, outSample);
+    auto secBlock = render(&DSPCore::processBlock, bufferSize, input, outBlock);
+
+    if (outSample != outBlock) {
+      std::cerr << "Error: Output mismatch at buffer size " << bufferSize << ".\n";
+      isFailed = true;
+    }
+
+    std::cout << std::setw(8) << bufferSize << std::setw(16)
+              << double(nFrame) / secSample * 1e-6 << std::setw(16)
+              << double(nFrame) / secBlock * 1e-6 << std::setw(9) << secSample / secBlock
+              << "\n";
+  }
+
+  return isFailed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
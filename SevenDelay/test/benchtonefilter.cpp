@@ -0,0 +1,150 @@
+// (c) 2022 Takamitsu Endo
+//
+// This file is part of SevenDelay.
+//
+// SevenDelay is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// SevenDelay is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with SevenDelay.  If not, see <https://www.gnu.org/licenses/>.
+
+// Checks the error bounds documented in `common/dsp/filtercoefficient.hpp`, then compares
+// the tone filter with per sample `SVF::setCutoffQ()` to `SVFCoefficientRamp` for each
+// control interval. The cutoff is swept by a sine LFO as `DSPCore` does.
+//
+// `maxDiff` is the maximum absolute difference of the filter outputs. It isn't 0 because
+// the ramp lags behind the sweep by up to the interval.
+
+#include "../../common/dsp/filtercoefficient.hpp"
+#include "../source/dsp/iir.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace SomeDSP;
+
+constexpr double sampleRate = 48000;
+constexpr size_t nFrame = size_t(10 * sampleRate);
+
+template<typename Sample> double maxTanPiError()
+{
+  double maxError = 0;
+  for (size_t i = 1; i < 500000; ++i) {
+    auto x = Sample(double(i) / 1000000);
+    auto exact = std::tan(pi * double(x));
+    maxError = std::max(maxError, std::abs(double(tanPiApprox(x)) / exact - 1));
+  }
+  return maxError;
+}
+
+template<typename Sample> double maxSinhError(double range)
+{
+  double maxError = 0;
+  for (size_t i = 1; i <= 1000000; ++i) {
+    auto x = Sample(range * double(i) / 1000000);
+    auto exact = std::sinh(double(x));
+    maxError = std::max(maxError, std::abs(double(sinhApprox(x)) / exact - 1));
+  }
+  return maxError;
+}
+
+bool checkBound(const char *name, double error, double bound)
+{
+  std::cout << std::setw(24) << name << std::setw(16) << std::scientific
+            << std::setprecision(3) << error << std::setw(14) << bound << "\n";
+  return error <= bound;
+}
+
+double cutoffAt(size_t frame)
+{
+  auto lfo = 0.5 + 0.5 * std::sin(twopi * 2.0 * double(frame) / sampleRate);
+  return 20.0 + 19980.0 * lfo * lfo;
+}
+
+// Returns elapsed time in seconds.
+double renderExact(const std::vector<double> &input, std::vector<double> &output)
+{
+  SVF<double> filter;
+  filter.setup(sampleRate);
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < nFrame; ++i) {
+    filter.setCutoffQ(cutoffAt(i), 0.3);
+    output[i] = filter.process(input[i]);
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+double renderRamp(
+  size_t interval, const std::vector<double> &input, std::vector<double> &output)
+{
+  SVF<double> filter;
+  filter.setup(sampleRate);
+  SVFCoefficientRamp<double, 1> ramp;
+  ramp.setInterval(interval);
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < nFrame; ++i) {
+    ramp.setTarget(0, cutoffAt(i) / sampleRate, 2.0 * 0.3);
+    ramp.process(0, 1);
+    filter.setCoefficient(ramp.g[0], ramp.k[0]);
+    output[i] = filter.process(input[i]);
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+int main()
+{
+  bool isFailed = false;
+  std::cout << std::setw(24) << "approximation" << std::setw(16) << "max rel. error"
+            << std::setw(14) << "bound\n";
+  isFailed |= !checkBound("tanPiApprox<double>", maxTanPiError<double>(), 1.4e-8);
+  isFailed |= !checkBound("tanPiApprox<float>", maxTanPiError<float>(), 2.9e-7);
+  isFailed |= !checkBound("sinhApprox<double> <= 8", maxSinhError<double>(8), 6.8e-8);
+  isFailed |= !checkBound("sinhApprox<float> <= 8", maxSinhError<float>(8), 1.4e-6);
+  isFailed |= !checkBound("sinhApprox<double> <= 16", maxSinhError<double>(16), 2.4e-5);
+  std::cout << "\n";
+
+  std::minstd_rand rng{0};
+  std::uniform_real_distribution<double> dist{-0.5, 0.5};
+  std::vector<double> input(nFrame);
+  for (auto &value : input) value = dist(rng);
+
+  std::vector<double> outExact(nFrame);
+  std::vector<double> outRamp(nFrame);
+  auto secExact = renderExact(input, outExact);
+
+  std::cout << std::setw(10) << "interval" << std::setw(16) << "exact [ns/spl]"
+            << std::setw(16) << "ramp [ns/spl]" << std::setw(10) << "speedup"
+            << std::setw(12) << "maxDiff\n";
+  for (size_t interval : {1, 4, 16, 64}) {
+    auto secRamp = renderRamp(interval, input, outRamp);
+
+    double maxDiff = 0;
+    for (size_t i = 0; i < nFrame; ++i) {
+      if (!std::isfinite(outRamp[i])) isFailed = true;
+      maxDiff = std::max(maxDiff, std::abs(outExact[i] - outRamp[i]));
+    }
+
+    std::cout << std::setw(10) << interval << std::fixed << std::setprecision(3)
+              << std::setw(16) << secExact / nFrame * 1e9 << std::setw(16)
+              << secRamp / nFrame * 1e9 << std::setw(10) << secExact / secRamp
+              << std::scientific << std::setw(12) << maxDiff << "\n";
+  }
+
+  return isFailed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -15,7 +15,13 @@
 // You should have received a copy of the GNU General Public License
 // along with Uhhyou Plugins.  If not, see <https://www.gnu.org/licenses/>.
 
-#define SET_PARAMETERS dsp->setParameters();
+template<typename DSP> void publishAndSetParameters(DSP &dsp)
+{
+  dsp.param.publish();
+  dsp.setParameters();
+}
+
+#define SET_PARAMETERS publishAndSetParameters(*dsp);
 
 #include "../../test/fxtester.hpp"
 #include "../source/dsp/dspcore.hpp"
@@ -39,249 +39,426 @@ inline float tuneFixedFreq(float value, float mod)
   return 2.0f * value * value * value * (1.0f + mod);
 }
 
-template<typename Sample>
-void Note<Sample>::setup(
+template<typename Sample, size_t nVoice>
+void NotePool<Sample, nVoice>::setup(Sample sampleRate)
+{
+  this->sampleRate = sampleRate;
+
+  saw1.assign(nVoice, PTRSyncSaw<Sample>(sampleRate, 0, 0));
+  saw2.assign(nVoice, PTRSyncSaw<Sample>(sampleRate, 0, 0));
+  gainEnvelope.assign(
+    nVoice,
+    ExpADSREnvelope<float>(
+      sampleRate, Sample(0.2), Sample(0.5), Sample(0.2), Sample(1)));
+  filterEnvelope.assign(
+    nVoice,
+    LinearEnvelope<float>(sampleRate, Sample(0.2), Sample(0.5), Sample(0.2), Sample(1)));
+  modEnvelope.assign(nVoice, PolyExpEnvelope<double>(sampleRate, 0, 1));
+
+  for (size_t voice = 0; voice < nVoice; ++voice) {
+    filter.reset(voice);
+    rest(voice);
+  }
+  outSaw1.fill(0);
+  outSaw2.fill(0);
+  nActive = 0;
+}
+
+template<typename Sample, size_t nVoice>
+void NotePool<Sample, nVoice>::setup(
+  size_t voice,
   int32_t noteId,
   Sample normalizedKey,
   Sample frequency,
   Sample velocity,
   Steinberg::Synth::GlobalParameter &param)
 {
-  state = NoteState::active;
-  id = noteId;
-  this->normalizedKey = normalizedKey;
-  this->frequency = frequency;
-  this->velocity = velocity;
+  state[voice] = NoteState::active;
+  id[voice] = noteId;
+  this->normalizedKey[voice] = normalizedKey;
+  this->frequency[voice] = frequency;
+  this->velocity[voice] = velocity;
 
   if (param.value[ParameterID::osc1PhaseLock]->getInt())
-    saw1.setPhase(param.value[ParameterID::osc1Phase]->getFloat());
+    saw1[voice].setPhase(param.value[ParameterID::osc1Phase]->getFloat());
   if (param.value[ParameterID::osc2PhaseLock]->getInt())
-    saw2.setPhase(param.value[ParameterID::osc2Phase]->getFloat());
+    saw2[voice].setPhase(param.value[ParameterID::osc2Phase]->getFloat());
 
   if (!param.value[ParameterID::filterDirty]->getInt()) {
-    oscBuffer.fill(0.0f);
-    filter.clear();
+    outSaw1[voice] = 0;
+    outSaw2[voice] = 0;
+    filter.clear(voice);
   }
 
-  bypassFilter = param.value[ParameterID::filterType]->getInt() == 4;
-  if (!bypassFilter) {
+  bypassFilter[voice] = param.value[ParameterID::filterType]->getInt() == 4;
+  if (!bypassFilter[voice]) {
     switch (param.value[ParameterID::filterType]->getInt()) {
       default:
       case 0:
-        filter.type = BiquadType::lowpass;
+        filter.type[voice] = BiquadType::lowpass;
         break;
 
       case 1:
-        filter.type = BiquadType::highpass;
+        filter.type[voice] = BiquadType::highpass;
         break;
 
       case 2:
-        filter.type = BiquadType::bandpass;
+        filter.type[voice] = BiquadType::bandpass;
         break;
 
       case 3:
-        filter.type = BiquadType::notch;
+        filter.type[voice] = BiquadType::notch;
         break;
     }
     switch (param.value[ParameterID::filterShaper]->getInt()) {
       default:
       case 0:
-        filter.shaper = ShaperType::hardclip;
+        filter.shaper[voice] = ShaperType::hardclip;
         break;
 
       case 1:
-        filter.shaper = ShaperType::tanh;
+        filter.shaper[voice] = ShaperType::tanh;
         break;
 
       case 2:
-        filter.shaper = ShaperType::sinRunge;
+        filter.shaper[voice] = ShaperType::sinRunge;
         break;
 
       case 3:
-        filter.shaper = ShaperType::cubicExpDecayAbs;
+        filter.shaper[voice] = ShaperType::cubicExpDecayAbs;
         break;
     }
   }
 
-  gainEnvelope.reset(
+  gainEnvelope[voice].reset(
     param.value[ParameterID::gainA]->getFloat(),
     param.value[ParameterID::gainD]->getFloat(),
     param.value[ParameterID::gainS]->getFloat(),
     param.value[ParameterID::gainR]->getFloat());
-  filterEnvelope.reset(
+  filterEnvelope[voice].reset(
     param.value[ParameterID::filterA]->getFloat(),
     param.value[ParameterID::filterD]->getFloat(),
     param.value[ParameterID::filterS]->getFloat(),
     param.value[ParameterID::filterR]->getFloat());
-  modEnvelope.reset(
+  modEnvelope[voice].reset(
     param.value[ParameterID::modEnvelopeA]->getFloat(),
     param.value[ParameterID::modEnvelopeCurve]->getFloat());
 }
 
-template<typename Sample> void Note<Sample>::release()
+template<typename Sample, size_t nVoice>
+void NotePool<Sample, nVoice>::release(size_t voice)
 {
-  if (state == NoteState::rest) return;
-  state = NoteState::release;
-  gainEnvelope.release();
-  filterEnvelope.release();
+  if (state[voice] == NoteState::rest) return;
+  state[voice] = NoteState::release;
+  gainEnvelope[voice].release();
+  filterEnvelope[voice].release();
 }
 
-template<typename Sample> void Note<Sample>::rest()
+template<typename Sample, size_t nVoice> void NotePool<Sample, nVoice>::rest(size_t voice)
 {
-  state = NoteState::rest;
-  id = -1;
-  normalizedKey = 0;
-  velocity = 0;
-  gain = 0;
-  frequency = 0;
-  bypassFilter = false;
+  state[voice] = NoteState::rest;
+  id[voice] = -1;
+  normalizedKey[voice] = 0;
+  velocity[voice] = 0;
+  gain[voice] = 0;
+  frequency[voice] = 0;
+  bypassFilter[voice] = false;
 }
 
-template<typename Sample> void Note<Sample>::reset()
+template<typename Sample, size_t nVoice>
+void NotePool<Sample, nVoice>::reset(size_t voice)
 {
-  saw1.reset();
-  saw2.reset();
-  oscBuffer.fill(0);
+  saw1[voice].reset();
+  saw2[voice].reset();
+  outSaw1[voice] = 0;
+  outSaw2[voice] = 0;
 
-  filter.reset();
+  filter.reset(voice);
 
-  gainEnvelope.terminate();
-  filterEnvelope.terminate();
-  modEnvelope.terminate();
+  gainEnvelope[voice].terminate();
+  filterEnvelope[voice].terminate();
+  modEnvelope[voice].terminate();
 
-  rest();
+  rest(voice);
 }
 
-template<typename Sample> Sample Note<Sample>::process(NoteProcessInfo<Sample> &info)
+template<typename Sample, size_t nVoice>
+void NotePool<Sample, nVoice>::updateKernel(NoteProcessInfo<Sample> &info)
 {
-  if (state == NoteState::rest) return 0;
+  osc1SyncType = info.osc1SyncType;
+  osc2SyncType = info.osc2SyncType;
+
+  nActive = 0;
+  hasFilter = false;
+  for (size_t idx = 0; idx < nVoice; ++idx) {
+    if (state[idx] == NoteState::rest) continue;
+    nActive = std::max(nActive, idx % nNote + 1);
+
+    if (bypassFilter[idx]) continue;
+    if (!hasFilter) {
+      filterType = filter.type[idx];
+      shaperType = filter.shaper[idx];
+      hasFilter = true;
+    }
+    if (filterType != filter.type[idx]) filterType = BiquadType::mixed;
+    if (shaperType != filter.shaper[idx]) shaperType = ShaperType::mixed;
+  }
+}
 
-  const float modEnv = float(modEnvelope.process());
+template<typename Sample, size_t nVoice>
+template<int32_t syncType>
+void NotePool<Sample, nVoice>::setOscFreq(
+  size_t begin,
+  size_t end,
+  std::array<Sample, nVoice> &oscFreq,
+  std::array<Sample, nVoice> &syncFreq,
+  Sample pitch,
+  Sample sync,
+  Sample envToFreq,
+  Sample envToSync,
+  Sample lfoToFreq,
+  Sample lfoToSync,
+  Sample lfo)
+{
+  if constexpr (syncType == 0) { // Off
+    for (size_t idx = begin; idx < end; ++idx) {
+      auto env = modEnv[idx];
+      oscFreq[idx]
+        = frequency[idx] * (1.0f + envToFreq * env * env + lfoToFreq * lfo) * pitch;
+      syncFreq[idx] = 0.0f;
+    }
+  } else if constexpr (syncType == 1) { // Ratio
+    for (size_t idx = begin; idx < end; ++idx) {
+      auto env = modEnv[idx];
+      oscFreq[idx] = frequency[idx] * (1.0f + envToSync * env * env + lfoToSync * lfo)
+        * pitch * sync;
+      syncFreq[idx]
+        = frequency[idx] * (1.0f + envToFreq * env * env + lfoToFreq * lfo) * pitch;
+    }
+  } else if constexpr (syncType == 2) { // Fixed-Master
+    const auto fixed = tuneFixedFreq(sync, envToSync + 0.5f + 0.5f * envToSync * lfo);
+    for (size_t idx = begin; idx < end; ++idx) {
+      auto env = modEnv[idx];
+      oscFreq[idx]
+        = frequency[idx] * (1.0f + envToFreq * env * env + lfoToFreq * lfo) * pitch;
+      syncFreq[idx] = fixed;
+    }
+  } else { // Fixed-Slave
+    const auto fixed = tuneFixedFreq(sync, envToFreq + 0.5f + 0.5f * envToFreq * lfo);
+    for (size_t idx = begin; idx < end; ++idx) {
+      auto env = modEnv[idx];
+      oscFreq[idx] = fixed;
+      syncFreq[idx]
+        = frequency[idx] * (1.0f + envToSync * env * env + lfoToSync * lfo) * pitch;
+    }
+  }
+}
 
-  saw1.setOrder(info.osc1PTROrder);
-  switch (info.osc1SyncType) {
+template<typename Sample, size_t nVoice>
+void NotePool<Sample, nVoice>::setOscFreq(
+  int32_t syncType,
+  size_t begin,
+  size_t end,
+  std::array<Sample, nVoice> &oscFreq,
+  std::array<Sample, nVoice> &syncFreq,
+  Sample pitch,
+  Sample sync,
+  Sample envToFreq,
+  Sample envToSync,
+  Sample lfoToFreq,
+  Sample lfoToSync,
+  Sample lfo)
+{
+  switch (syncType) {
     default:
-    case 0: // Off
-      saw1.setOscFreq(
-        frequency
-        * (1.0f + info.modEnvelopeToFreq1 * modEnv * modEnv + info.modLFOToFreq1 * info.modLFO)
-        * info.osc1Pitch);
-      saw1.setSyncFreq(0.0f);
+    case 0:
+      setOscFreq<0>(
+        begin, end, oscFreq, syncFreq, pitch, sync, envToFreq, envToSync, lfoToFreq,
+        lfoToSync, lfo);
       break;
-    case 1: { // Ratio
-      saw1.setOscFreq(
-        frequency
-        * (1.0f + info.modEnvelopeToSync1 * modEnv * modEnv + info.modLFOToSync1 * info.modLFO)
-        * info.osc1Pitch * info.osc1Sync);
-      saw1.setSyncFreq(
-        frequency
-        * (1.0f + info.modEnvelopeToFreq1 * modEnv * modEnv + info.modLFOToFreq1 * info.modLFO)
-        * info.osc1Pitch);
-    } break;
-    case 2: // Fixed-Master
-      saw1.setOscFreq(
-        frequency
-        * (1.0f + info.modEnvelopeToFreq1 * modEnv * modEnv + info.modLFOToFreq1 * info.modLFO)
-        * info.osc1Pitch);
-      saw1.setSyncFreq(tuneFixedFreq(
-        info.osc1Sync,
-        info.modEnvelopeToSync1 + 0.5f + 0.5f * info.modEnvelopeToSync1 * info.modLFO));
+    case 1:
+      setOscFreq<1>(
+        begin, end, oscFreq, syncFreq, pitch, sync, envToFreq, envToSync, lfoToFreq,
+        lfoToSync, lfo);
+      break;
+    case 2:
+      setOscFreq<2>(
+        begin, end, oscFreq, syncFreq, pitch, sync, envToFreq, envToSync, lfoToFreq,
+        lfoToSync, lfo);
       break;
-    case 3: // Fixed-Slave
-      saw1.setOscFreq(tuneFixedFreq(
-        info.osc1Sync,
-        info.modEnvelopeToFreq1 + 0.5f + 0.5f * info.modEnvelopeToFreq1 * info.modLFO));
-      saw1.setSyncFreq(
-        frequency
-        * (1.0f + info.modEnvelopeToSync1 * modEnv * modEnv + info.modLFOToSync1 * info.modLFO)
-        * info.osc1Pitch);
+    case 3:
+      setOscFreq<3>(
+        begin, end, oscFreq, syncFreq, pitch, sync, envToFreq, envToSync, lfoToFreq,
+        lfoToSync, lfo);
       break;
   }
+}
+
+template<typename Sample, size_t nVoice>
+void NotePool<Sample, nVoice>::processFilter(
+  size_t begin, size_t end, NoteProcessInfo<Sample> &info)
+{
+  for (size_t idx = begin; idx < end; ++idx) {
+    isFilterActive[idx] = isActive[idx] & !bypassFilter[idx];
+  }
 
-  saw2.setOrder(info.osc2PTROrder);
-  switch (info.osc2SyncType) {
+  for (size_t idx = begin; idx < end; ++idx) {
+    filterEnv[idx] = isFilterActive[idx] ? filterEnvelope[idx].process() : 0.0f;
+  }
+
+  for (size_t idx = begin; idx < end; ++idx) {
+    auto env = filterEnv[idx];
+    cutoff[idx] = 8.0f * info.filterCutoffAmount * env
+      + info.filterKeyToCutoff * normalizedKey[idx];
+    resonance[idx] = info.filterResonance + info.filterResonanceAmount * env * env;
+    filter.feedback[idx] = std::min(
+      std::max(
+        info.filterFeedback + 2.0f * info.filterKeyToFeedback * normalizedKey[idx], 0.0f),
+      1.0f);
+  }
+  for (size_t idx = begin; idx < end; ++idx) {
+    if (isFilterActive[idx]) cutoff[idx] = info.filterCutoff * powf(2.0f, cutoff[idx]);
+  }
+
+  switch (filterType) {
+    case BiquadType::lowpass:
+      filter.template setCutoffQ<BiquadType::lowpass>(
+        begin, end, isFilterActive, cutoff, resonance, sampleRate);
+      break;
+    case BiquadType::highpass:
+      filter.template setCutoffQ<BiquadType::highpass>(
+        begin, end, isFilterActive, cutoff, resonance, sampleRate);
+      break;
+    case BiquadType::bandpass:
+      filter.template setCutoffQ<BiquadType::bandpass>(
+        begin, end, isFilterActive, cutoff, resonance, sampleRate);
+      break;
+    case BiquadType::notch:
+      filter.template setCutoffQ<BiquadType::notch>(
+        begin, end, isFilterActive, cutoff, resonance, sampleRate);
+      break;
     default:
-    case 0: // Off
-      saw2.setOscFreq(
-        frequency
-        * (1.0f + info.modEnvelopeToFreq2 * modEnv * modEnv + info.modLFOToFreq2 * info.modLFO)
-        * info.osc2Pitch);
-      saw2.setSyncFreq(0.0f);
+      filter.template setCutoffQ<BiquadType::mixed>(
+        begin, end, isFilterActive, cutoff, resonance, sampleRate);
+      break;
+  }
+
+  switch (shaperType) {
+    case ShaperType::hardclip:
+      filter.template process<ShaperType::hardclip>(
+        begin, end, isFilterActive, oscMix, info.filterSaturation);
+      break;
+    case ShaperType::tanh:
+      filter.template process<ShaperType::tanh>(
+        begin, end, isFilterActive, oscMix, info.filterSaturation);
       break;
-    case 1: // Ratio
-      saw2.setOscFreq(
-        frequency
-        * (1.0f + info.modEnvelopeToSync2 * modEnv * modEnv + info.modLFOToSync2 * info.modLFO)
-        * info.osc2Pitch * info.osc2Sync);
-      saw2.setSyncFreq(
-        frequency
-        * (1.0f + info.modEnvelopeToFreq2 * modEnv * modEnv + info.modLFOToFreq2 * info.modLFO)
-        * info.osc2Pitch);
+    case ShaperType::sinRunge:
+      filter.template process<ShaperType::sinRunge>(
+        begin, end, isFilterActive, oscMix, info.filterSaturation);
       break;
-    case 2: // Fixed-Master
-      saw2.setOscFreq(
-        frequency
-        * (1.0f + info.modEnvelopeToFreq2 * modEnv * modEnv + info.modLFOToFreq2 * info.modLFO)
-        * info.osc2Pitch);
-      saw2.setSyncFreq(tuneFixedFreq(
-        info.osc2Sync,
-        info.modEnvelopeToSync2 + 0.5f + 0.5f * info.modEnvelopeToSync2 * info.modLFO));
+    case ShaperType::cubicExpDecayAbs:
+      filter.template process<ShaperType::cubicExpDecayAbs>(
+        begin, end, isFilterActive, oscMix, info.filterSaturation);
       break;
-    case 3: // Fixed-Slave
-      saw2.setOscFreq(tuneFixedFreq(
-        info.osc2Sync,
-        info.modEnvelopeToFreq2 + 0.5f + 0.5f * info.modEnvelopeToFreq2 * info.modLFO));
-      saw2.setSyncFreq(
-        frequency
-        * (1.0f + info.modEnvelopeToSync2 * modEnv * modEnv + info.modLFOToSync2 * info.modLFO)
-        * info.osc2Pitch);
+    default:
+      filter.template process<ShaperType::mixed>(
+        begin, end, isFilterActive, oscMix, info.filterSaturation);
       break;
   }
+}
 
-  auto toSync1 = info.fmOsc1ToSync1 * oscBuffer[0] + info.fmOsc2ToSync1 * oscBuffer[1];
-  auto outSaw1 = saw1.process(0.0f, toSync1);
-  auto toFreq2 = info.fmOsc1ToFreq2 * oscBuffer[0];
-  auto outSaw2 = saw2.process(toFreq2, 0.0f);
-  oscBuffer[0] = outSaw1;
-  oscBuffer[1] = outSaw2;
-
-  const auto gainEnv = gainEnvelope.process();
-  if (gainEnvelope.isTerminated()) rest();
-  gain = velocity
-    * (gainEnv
-       + info.gainEnvelopeCurve
-         * (juce::dsp::FastMathApproximations::tanh(3.0f * info.gainEnvelopeCurve * gainEnv) - gainEnv));
-
-  if (bypassFilter) return gain * (info.osc1Gain * outSaw1 + info.osc2Gain * outSaw2);
-
-  auto filterEnv = filterEnvelope.process();
-  filter.setCutoffQ(
-    info.filterCutoff
-      * powf(
-        2.0f,
-        8.0f * info.filterCutoffAmount * filterEnv
-          + info.filterKeyToCutoff * normalizedKey),
-    info.filterResonance + info.filterResonanceAmount * filterEnv * filterEnv);
-  filter.feedback = clamp(
-    info.filterFeedback + 2.0f * info.filterKeyToFeedback * normalizedKey, 0.0f, 1.0f);
-  filter.saturation = info.filterSaturation;
-  return gain * filter.process(info.osc1Gain * outSaw1 + info.osc2Gain * outSaw2);
+template<typename Sample, size_t nVoice>
+void NotePool<Sample, nVoice>::process(
+  size_t begin, size_t end, bool unison, NoteProcessInfo<Sample> &info)
+{
+  for (size_t idx = begin; idx < end; ++idx) {
+    isActive[idx] = state[idx] != NoteState::rest;
+  }
+  if (!unison) {
+    processVoice(begin, end, info);
+    return;
+  }
+
+  // Second unison voice is processed only if the first one is not resting.
+  for (size_t idx = begin; idx < end; ++idx) {
+    isActive[nNote + idx] = isActive[idx] && state[nNote + idx] != NoteState::rest;
+  }
+  processVoice(begin, end, info);
+  processVoice(nNote + begin, nNote + end, info);
 }
 
-DSPCore::DSPCore() { midiNotes.reserve(128); }
+template<typename Sample, size_t nVoice>
+void NotePool<Sample, nVoice>::processVoice(
+  size_t begin, size_t end, NoteProcessInfo<Sample> &info)
+{
+  for (size_t idx = begin; idx < end; ++idx) {
+    modEnv[idx] = isActive[idx] ? float(modEnvelope[idx].process()) : 0.0f;
+  }
+
+  setOscFreq(
+    osc1SyncType, begin, end, oscFreq1, syncFreq1, info.osc1Pitch, info.osc1Sync,
+    info.modEnvelopeToFreq1, info.modEnvelopeToSync1, info.modLFOToFreq1,
+    info.modLFOToSync1, info.modLFO);
+  setOscFreq(
+    osc2SyncType, begin, end, oscFreq2, syncFreq2, info.osc2Pitch, info.osc2Sync,
+    info.modEnvelopeToFreq2, info.modEnvelopeToSync2, info.modLFOToFreq2,
+    info.modLFOToSync2, info.modLFO);
+
+  for (size_t idx = begin; idx < end; ++idx) {
+    if (!isActive[idx]) continue;
+
+    saw1[idx].setOrder(info.osc1PTROrder);
+    saw1[idx].setOscFreq(oscFreq1[idx]);
+    saw1[idx].setSyncFreq(syncFreq1[idx]);
+    saw2[idx].setOrder(info.osc2PTROrder);
+    saw2[idx].setOscFreq(oscFreq2[idx]);
+    saw2[idx].setSyncFreq(syncFreq2[idx]);
+
+    auto toSync1 = info.fmOsc1ToSync1 * outSaw1[idx] + info.fmOsc2ToSync1 * outSaw2[idx];
+    auto toFreq2 = info.fmOsc1ToFreq2 * outSaw1[idx];
+    outSaw1[idx] = saw1[idx].process(0.0f, toSync1);
+    outSaw2[idx] = saw2[idx].process(toFreq2, 0.0f);
+  }
+
+  for (size_t idx = begin; idx < end; ++idx) {
+    if (!isActive[idx]) continue;
+    gainEnv[idx] = gainEnvelope[idx].process();
+    if (gainEnvelope[idx].isTerminated()) rest(idx);
+  }
+
+  // Gain of resting voices stays 0 because `rest()` sets velocity to 0.
+  const auto curve = info.gainEnvelopeCurve;
+  for (size_t idx = begin; idx < end; ++idx) {
+    using juce::dsp::FastMathApproximations;
+    auto env = gainEnv[idx];
+    auto shaped = FastMathApproximations::tanh(3.0f * curve * env);
+    gain[idx] = velocity[idx] * (env + curve * (shaped - env));
+    oscMix[idx] = info.osc1Gain * outSaw1[idx] + info.osc2Gain * outSaw2[idx];
+  }
+
+  if (hasFilter) processFilter(begin, end, info);
+
+  for (size_t idx = begin; idx < end; ++idx) {
+    auto mix = oscMix[idx];
+    auto filtered = filter.output[idx];
+    oscMix[idx] = gain[idx] * (bypassFilter[idx] ? mix : filtered);
+  }
+  for (size_t idx = begin; idx < end; ++idx) {
+    auto sig = oscMix[idx];
+    output[idx] = isActive[idx] ? sig : 0.0f;
+  }
+}
 
 void DSPCore::setup(double sampleRate)
 {
   this->sampleRate = float(sampleRate);
 
-  midiNotes.resize(0);
+  midiNotes.clear();
 
   SmootherCommon<float>::setSampleRate(this->sampleRate);
   SmootherCommon<float>::setTime(0.2f);
 
-  for (auto &note : notes) {
-    for (auto &nt : note) nt = std::make_unique<Note<float>>(this->sampleRate);
-  }
+  notes.setup(this->sampleRate);
 
   // 10 msec + 1 sample transition time.
   transitionBuffer.resize(1 + size_t(this->sampleRate * 0.01f), 0.0);
@@ -351,9 +528,8 @@ void DSPCore::reset()
 
   ASSIGN_PARAMETER(reset);
 
-  for (auto &note : notes) {
-    for (auto &nt : note) nt->reset();
-  }
+  for (size_t idx = 0; idx < notes.state.size(); ++idx) notes.reset(idx);
+  notes.nActive = 0;
 
   std::fill(transitionBuffer.begin(), transitionBuffer.end(), 0.0f);
   isTransitioning = false;
@@ -406,16 +582,16 @@ void DSPCore::process(const size_t length, float *out0, float *out1)
   SmootherCommon<float>::setBufferSize(float(length));
 
   bool unison = param.value[ParameterID::unison]->getFloat();
-  for (auto &note : notes) {
-    if (note[0]->state == NoteState::rest) continue;
-    note[0]->gainEnvelope.set(
+  for (size_t idx = 0; idx < maxVoice; ++idx) {
+    if (notes.state[idx] == NoteState::rest) continue;
+    notes.gainEnvelope[idx].set(
       param.value[ParameterID::gainA]->getFloat(),
       param.value[ParameterID::gainD]->getFloat(),
       param.value[ParameterID::gainS]->getFloat(),
       param.value[ParameterID::gainR]->getFloat());
     if (unison) {
-      if (note[1]->state == NoteState::rest) continue;
-      note[1]->gainEnvelope.set(
+      if (notes.state[maxVoice + idx] == NoteState::rest) continue;
+      notes.gainEnvelope[maxVoice + idx].set(
         param.value[ParameterID::gainA]->getFloat(),
         param.value[ParameterID::gainD]->getFloat(),
         param.value[ParameterID::gainS]->getFloat(),
@@ -427,6 +603,7 @@ void DSPCore::process(const size_t length, float *out0, float *out1)
   noteInfo.osc1PTROrder = param.value[ParameterID::osc1PTROrder]->getInt();
   noteInfo.osc2SyncType = param.value[ParameterID::osc2SyncType]->getInt();
   noteInfo.osc2PTROrder = param.value[ParameterID::osc2PTROrder]->getInt();
+  notes.updateKernel(noteInfo);
   for (size_t i = 0; i < length; ++i) {
     processMidiNote(i);
 
@@ -466,14 +643,11 @@ void DSPCore::process(const size_t length, float *out0, float *out1)
     noteInfo.filterKeyToCutoff = interpFilterKeyToCutoff.process();
     noteInfo.filterKeyToFeedback = interpFilterKeyToFeedback.process();
 
+    notes.process(0, notes.nActive, unison, noteInfo);
     float sample = 0.0f;
-    for (auto &note : notes) {
-      if (note[0]->state == NoteState::rest) continue;
-      sample += note[0]->process(noteInfo);
-      if (unison) {
-        if (note[1]->state == NoteState::rest) continue;
-        sample += note[1]->process(noteInfo);
-      }
+    for (size_t idx = 0; idx < notes.nActive; ++idx) {
+      sample += notes.output[idx];
+      if (unison) sample += notes.output[maxVoice + idx];
     }
 
     if (isTransitioning) {
@@ -495,14 +669,14 @@ void DSPCore::noteOn(int32_t noteId, int16_t pitch, float tuning, float velocity
   size_t mostSilent = 0;
   float gain = 1.0f;
   for (; i < nVoice; ++i) {
-    if (notes[i][0]->id == noteId) break;
-    if (notes[i][0]->state == NoteState::rest) break;
-    if (!notes[i][0]->gainEnvelope.isAttacking() && notes[i][0]->gain < gain) {
-      gain = notes[i][0]->gain;
+    if (notes.id[i] == noteId) break;
+    if (notes.state[i] == NoteState::rest) break;
+    if (!notes.gainEnvelope[i].isAttacking() && notes.gain[i] < gain) {
+      gain = notes.gain[i];
       mostSilent = i;
     }
   }
-  if (i >= nVoice && notes[i][0]->state != NoteState::rest) {
+  if (i >= nVoice && (i >= maxVoice || notes.state[i] != NoteState::rest)) {
     isTransitioning = true;
 
     i = mostSilent;
@@ -538,24 +712,23 @@ void DSPCore::noteOn(int32_t noteId, int16_t pitch, float tuning, float velocity
     noteInfo.filterResonanceAmount = interpFilterResonanceAmount.getValue();
     noteInfo.filterKeyToCutoff = interpFilterKeyToCutoff.getValue();
     noteInfo.filterKeyToFeedback = interpFilterKeyToFeedback.getValue();
+    notes.updateKernel(noteInfo);
 
     // Beware the negative overflow. trStop is size_t.
     trStop = trIndex - 1;
     if (trStop >= transitionBuffer.size()) trStop += transitionBuffer.size();
 
+    const bool unison = param.value[ParameterID::unison]->getFloat();
     for (size_t j = 0; j < transitionBuffer.size(); ++j) {
-      if (notes[i][0]->state == NoteState::rest) {
+      if (notes.state[i] == NoteState::rest) {
         trStop = trIndex + j;
         if (trStop >= transitionBuffer.size()) trStop -= transitionBuffer.size();
         break;
       }
 
-      float sample = notes[i][0]->process(noteInfo);
-      if (
-        param.value[ParameterID::unison]->getFloat()
-        && notes[i][1]->state != NoteState::rest) {
-        sample += notes[i][1]->process(noteInfo);
-      }
+      notes.process(i, i + 1, unison, noteInfo);
+      float sample = notes.output[i];
+      if (unison) sample += notes.output[maxVoice + i];
       transitionBuffer[(trIndex + j) % transitionBuffer.size()] += sample
         * (0.5f + 0.5f * std::cos(float(pi) * float(j) / transitionBuffer.size()));
     }
@@ -563,24 +736,25 @@ void DSPCore::noteOn(int32_t noteId, int16_t pitch, float tuning, float velocity
 
   auto normalizedKey = float(pitch) / 127.0f;
   auto frequency = midiNoteToFrequency(pitch, tuning);
-  notes[i][0]->setup(noteId, normalizedKey, frequency, velocity, param);
+  notes.setup(i, noteId, normalizedKey, frequency, velocity, param);
   if (param.value[ParameterID::unison]->getFloat()) {
-    notes[i][1]->setup(noteId, normalizedKey, frequency, velocity, param);
-    notes[i][1]->saw1.addPhase(0.1777f);
-    notes[i][1]->saw2.addPhase(0.6883f);
+    notes.setup(maxVoice + i, noteId, normalizedKey, frequency, velocity, param);
+    notes.saw1[maxVoice + i].addPhase(0.1777f);
+    notes.saw2[maxVoice + i].addPhase(0.6883f);
   } else {
-    notes[i][1]->release();
+    notes.release(maxVoice + i);
   }
+  notes.updateKernel(noteInfo);
 }
 
 void DSPCore::noteOff(int32_t noteId)
 {
   size_t i = 0;
-  for (; i < notes.size(); ++i) {
-    if (notes[i][0]->id == noteId) break;
+  for (; i < maxVoice; ++i) {
+    if (notes.id[i] == noteId) break;
   }
-  if (i >= notes.size()) return;
+  if (i >= maxVoice) return;
 
-  notes[i][0]->release();
-  notes[i][1]->release();
+  notes.release(i);
+  notes.release(maxVoice + i);
 }
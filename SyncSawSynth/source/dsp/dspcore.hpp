@@ -18,6 +18,7 @@
 #pragma once
 
 #include "../../../common/dsp/constants.hpp"
+#include "../../../common/dsp/eventring.hpp"
 #include "../../../common/dsp/smoother.hpp"
 #include "../parameter.hpp"
 #include "envelope.hpp"
@@ -27,7 +28,6 @@
 
 #include <array>
 #include <cmath>
-#include <memory>
 #include <vector>
 
 using namespace SomeDSP;
@@ -74,53 +74,123 @@ template<typename Sample> struct NoteProcessInfo {
 
 enum class NoteState { active, release, rest };
 
-template<typename Sample> class Note {
+/**
+Notes stored as structure of arrays. Index `i` is the voice of `i`-th note, and
+`nVoice / 2 + i` is its unison voice. Unison voices are only processed when unison is
+on.
+
+Parts with per voice branches, like envelopes and oscillators, are processed voice by
+voice. Other parts are processed over a range of voices at once in `process()`, so
+that they are vectorized. Oscillator sync and filter kernels are selected in
+`updateKernel()`, instead of switching for each voice.
+*/
+template<typename Sample, size_t nVoice> class NotePool {
 public:
-  NoteState state = NoteState::rest;
-
-  int32_t id = -1;
-  Sample normalizedKey = 0;
-  Sample velocity = 0;
-  Sample gain = 0;
-  Sample frequency = 0;
-  bool bypassFilter = false;
-
-  PTRSyncSaw<Sample> saw1;
-  PTRSyncSaw<Sample> saw2;
-  std::array<float, 2> oscBuffer = {0, 0};
-
-  SerialFilter4<Sample> filter;
-
-  ExpADSREnvelope<float> gainEnvelope;
-  LinearEnvelope<float> filterEnvelope;
-  PolyExpEnvelope<double> modEnvelope;
-
-  Note(Sample sampleRate)
-    : saw1(sampleRate, 0, 0)
-    , saw2(sampleRate, 0, 0)
-    , filter(sampleRate, Sample(20000), Sample(0.5))
-    , gainEnvelope(sampleRate, Sample(0.2), Sample(0.5), Sample(0.2), Sample(1))
-    , filterEnvelope(sampleRate, Sample(0.2), Sample(0.5), Sample(0.2), Sample(1))
-    , modEnvelope(sampleRate, 0, 1)
+  std::array<NoteState, nVoice> state;
+  std::array<int32_t, nVoice> id;
+  std::array<Sample, nVoice> normalizedKey{};
+  std::array<Sample, nVoice> velocity{};
+  std::array<Sample, nVoice> gain{};
+  std::array<Sample, nVoice> frequency{};
+  std::array<int32_t, nVoice> bypassFilter{};
+
+  std::vector<PTRSyncSaw<Sample>> saw1;
+  std::vector<PTRSyncSaw<Sample>> saw2;
+  std::array<Sample, nVoice> outSaw1{};
+  std::array<Sample, nVoice> outSaw2{};
+
+  VoiceSerialFilter4<Sample, nVoice> filter;
+
+  std::vector<ExpADSREnvelope<float>> gainEnvelope;
+  std::vector<LinearEnvelope<float>> filterEnvelope;
+  std::vector<PolyExpEnvelope<double>> modEnvelope;
+
+  static constexpr size_t nNote = nVoice / 2;
+
+  // Number of notes to process. Notes at and above `nActive` are resting.
+  size_t nActive = 0;
+
+  // Output of `process()`. 0 for resting voices.
+  std::array<Sample, nVoice> output{};
+
+  NotePool()
   {
+    state.fill(NoteState::rest);
+    id.fill(-1);
   }
 
+  void setup(Sample sampleRate);
   void setup(
+    size_t voice,
     int32_t noteId,
     Sample normalizedKey,
     Sample frequency,
     Sample velocity,
     GlobalParameter &param);
-  void release();
-  void rest();
-  void reset();
-  Sample process(NoteProcessInfo<Sample> &info);
+  void release(size_t voice);
+  void rest(size_t voice);
+  void reset(size_t voice);
+
+  // Call this when notes are added or when `info` changes oscillator settings.
+  void updateKernel(NoteProcessInfo<Sample> &info);
+
+  // Processes notes in [begin, end), and their unison voices if `unison` is true.
+  void process(size_t begin, size_t end, bool unison, NoteProcessInfo<Sample> &info);
+
+private:
+  Sample sampleRate = 44100;
+
+  int32_t osc1SyncType = 0;
+  int32_t osc2SyncType = 0;
+  bool hasFilter = false;
+  BiquadType filterType = BiquadType::mixed;
+  ShaperType shaperType = ShaperType::mixed;
+
+  std::array<int32_t, nVoice> isActive{};
+  std::array<int32_t, nVoice> isFilterActive{};
+  std::array<Sample, nVoice> modEnv{};
+  std::array<Sample, nVoice> gainEnv{};
+  std::array<Sample, nVoice> filterEnv{};
+  std::array<Sample, nVoice> oscFreq1{};
+  std::array<Sample, nVoice> syncFreq1{};
+  std::array<Sample, nVoice> oscFreq2{};
+  std::array<Sample, nVoice> syncFreq2{};
+  std::array<Sample, nVoice> oscMix{};
+  std::array<Sample, nVoice> cutoff{};
+  std::array<Sample, nVoice> resonance{};
+
+  template<int32_t syncType>
+  void setOscFreq(
+    size_t begin,
+    size_t end,
+    std::array<Sample, nVoice> &oscFreq,
+    std::array<Sample, nVoice> &syncFreq,
+    Sample pitch,
+    Sample sync,
+    Sample envToFreq,
+    Sample envToSync,
+    Sample lfoToFreq,
+    Sample lfoToSync,
+    Sample lfo);
+  void setOscFreq(
+    int32_t syncType,
+    size_t begin,
+    size_t end,
+    std::array<Sample, nVoice> &oscFreq,
+    std::array<Sample, nVoice> &syncFreq,
+    Sample pitch,
+    Sample sync,
+    Sample envToFreq,
+    Sample envToSync,
+    Sample lfoToFreq,
+    Sample lfoToSync,
+    Sample lfo);
+  void processFilter(size_t begin, size_t end, NoteProcessInfo<Sample> &info);
+  void processVoice(size_t begin, size_t end, NoteProcessInfo<Sample> &info);
 };
 
 class DSPCore {
 public:
-  DSPCore();
-
   static const size_t maxVoice = 32;
   GlobalParameter param;
 
@@ -142,7 +212,7 @@ public:
     float velocity;
   };
 
-  std::vector<MidiNote> midiNotes;
+  MidiEventRing<MidiNote> midiNotes;
 
   void pushMidiNote(
     bool isNoteOn,
@@ -159,22 +229,17 @@ public:
     note.pitch = pitch;
     note.tuning = tuning;
     note.velocity = velocity;
-    midiNotes.push_back(note);
+    midiNotes.push(note);
   }
 
   void processMidiNote(size_t frame)
   {
-    while (true) {
-      auto it = std::find_if(midiNotes.begin(), midiNotes.end(), [&](const MidiNote &nt) {
-        return nt.frame == frame;
-      });
-      if (it == std::end(midiNotes)) return;
-      if (it->isNoteOn)
-        noteOn(it->id, it->pitch, it->tuning, it->velocity);
+    midiNotes.dispatch(frame, [&](MidiNote &note) {
+      if (note.isNoteOn)
+        noteOn(note.id, note.pitch, note.tuning, note.velocity);
       else
-        noteOff(it->id);
-      midiNotes.erase(it);
-    }
+        noteOff(note.id);
+    });
   }
 
 private:
@@ -217,7 +282,7 @@ private:
   ExpSmoother<float> interpFilterKeyToFeedback;
 
   size_t nVoice = 32;
-  std::array<std::array<std::unique_ptr<Note<float>>, 2>, maxVoice> notes;
+  NotePool<float, 2 * maxVoice> notes;
 
   // Transition happens when synth is playing all notes and user send a new note on.
   // transitionBuffer is used to store release of a note to reduce pop noise.
@@ -18,11 +18,13 @@
 #pragma once
 
 #include "../../../common/dsp/constants.hpp"
+#include "../../../common/dsp/filtercoefficient.hpp"
 #include "../../../lib/juce_FastMathApproximations.h"
 
-#include <cmath>
-
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <cstdint>
 
 namespace SomeDSP {
 
@@ -31,147 +33,290 @@ enum class BiquadType {
   highpass,
   bandpass,
   notch,
+  mixed, // Only used to select `VoiceSerialFilter4` kernels.
 };
 
-enum class ShaperType { hardclip, tanh, sinRunge, cubicExpDecayAbs };
+enum class ShaperType { hardclip, tanh, sinRunge, cubicExpDecayAbs, mixed };
+
+/**
+4 serial biquads for each voice. State and coefficients are stored as arrays indexed by
+voice, so the loops over voices are vectorized.
 
-template<typename Sample> class SerialFilter4 {
+`setCutoffQ()` and `process()` are specialized by filter type and shaper. Pass
+`BiquadType::mixed` or `ShaperType::mixed` when active voices have different types.
+`process()` leaves the state of voices with `isActive[voice] == 0` untouched.
+
+Masked updates are split into 2 loops: one computes new values and another selects.
+The select loop loads all values and selects into locals before storing. Otherwise GCC
+turns selects into branches, which are not vectorized.
+*/
+template<typename Sample, size_t nVoice> class VoiceSerialFilter4 {
 public:
-  BiquadType type = BiquadType::lowpass;
-  Sample fs;
-  Sample f0;
-  Sample q;
-
-  Sample b0 = 0;
-  Sample b1 = 0;
-  Sample b2 = 0;
-  Sample a0 = 0;
-  Sample a1 = 0;
-  Sample a2 = 0;
-
-  Sample w0 = 0;
-  Sample cos_w0 = 0;
-  Sample sin_w0 = 0;
-  Sample alpha = 0;
-
-  std::array<Sample, 4> x0{};
-  std::array<Sample, 4> x1{};
-  std::array<Sample, 4> x2{};
-  std::array<Sample, 4> y0{};
-  std::array<Sample, 4> y1{};
-  std::array<Sample, 4> y2{};
-
-  Sample feedback = 0;
-  Sample saturation = 1;
-  ShaperType shaper = ShaperType::sinRunge;
-
-  SerialFilter4(Sample sampleRate, Sample cutoff, Sample resonance)
-    : fs(sampleRate), f0(cutoff), q(resonance)
+  std::array<BiquadType, nVoice> type{};
+  std::array<ShaperType, nVoice> shaper{};
+  std::array<Sample, nVoice> feedback{};
+
+  std::array<Sample, nVoice> b0{};
+  std::array<Sample, nVoice> b1{};
+  std::array<Sample, nVoice> b2{};
+  std::array<Sample, nVoice> a0{};
+  std::array<Sample, nVoice> a1{};
+  std::array<Sample, nVoice> a2{};
+
+  std::array<std::array<Sample, nVoice>, 4> x1{};
+  std::array<std::array<Sample, nVoice>, 4> x2{};
+  std::array<std::array<Sample, nVoice>, 4> y1{};
+  std::array<std::array<Sample, nVoice>, 4> y2{};
+
+  std::array<Sample, nVoice> output{};
+
+  void reset(size_t voice)
   {
+    b0[voice] = b1[voice] = b2[voice] = 0;
+    a0[voice] = a1[voice] = a2[voice] = 0;
+    clear(voice);
   }
 
-  void reset()
+  void clear(size_t voice)
   {
-    b0 = b1 = b2 = 0;
-    a0 = a1 = a2 = 0;
-    clear();
+    feedback[voice] = 0;
+    for (size_t idx = 0; idx < 4; ++idx) {
+      x1[idx][voice] = 0;
+      x2[idx][voice] = 0;
+      y1[idx][voice] = 0;
+      y2[idx][voice] = 0;
+    }
   }
 
-  void clear()
+  template<BiquadType filterType>
+  void setCutoffQ(
+    size_t begin,
+    size_t end,
+    const std::array<int32_t, nVoice> &isActive,
+    const std::array<Sample, nVoice> &hz,
+    const std::array<Sample, nVoice> &q,
+    Sample sampleRate)
   {
-    feedback = 0;
-    x0.fill(0);
-    x1.fill(0);
-    x2.fill(0);
-    y0.fill(0);
-    y1.fill(0);
-    y2.fill(0);
+    std::array<Sample, nVoice> w0;
+    std::array<Sample, nVoice> cos_w0;
+    std::array<Sample, nVoice> sin_w0;
+    std::array<Sample, nVoice> qc;
+    for (size_t idx = begin; idx < end; ++idx) {
+      w0[idx] = std::min(std::max(hz[idx], Sample(20.0)), Sample(20000.0));
+      qc[idx] = std::min(std::max(q[idx], Sample(1e-5)), Sample(1.0));
+    }
+    for (size_t idx = begin; idx < end; ++idx) {
+      w0[idx] = Sample(twopi) * w0[idx] / sampleRate;
+      cos_w0[idx] = juce::dsp::FastMathApproximations::cos<Sample>(w0[idx]);
+      sin_w0[idx] = juce::dsp::FastMathApproximations::sin<Sample>(w0[idx]);
+    }
+
+    if constexpr (filterType == BiquadType::mixed) {
+      for (size_t idx = begin; idx < end; ++idx) {
+        if (!isActive[idx]) continue;
+        switch (type[idx]) {
+          default:
+          case BiquadType::lowpass:
+            setLowpass(idx, cos_w0[idx], sin_w0[idx], qc[idx]);
+            break;
+
+          case BiquadType::highpass:
+            setHighpass(idx, cos_w0[idx], sin_w0[idx], qc[idx]);
+            break;
+
+          case BiquadType::bandpass:
+            setBandpass(idx, w0[idx], cos_w0[idx], sin_w0[idx], qc[idx]);
+            break;
+
+          case BiquadType::notch:
+            setNotch(idx, w0[idx], cos_w0[idx], sin_w0[idx], qc[idx]);
+            break;
+        }
+      }
+    } else if constexpr (
+      filterType == BiquadType::lowpass || filterType == BiquadType::highpass) {
+      for (size_t idx = begin; idx < end; ++idx) {
+        auto alpha = sin_w0[idx] / (Sample(2.0) * qc[idx]);
+        auto c0 = filterType == BiquadType::lowpass ? Sample(1.0) - cos_w0[idx]
+                                                    : Sample(1.0) + cos_w0[idx];
+        b0[idx] = c0 / Sample(2.0);
+        b1[idx] = filterType == BiquadType::lowpass ? c0 : -c0;
+        b2[idx] = c0 / Sample(2.0);
+        a0[idx] = Sample(1.0) + alpha;
+        a1[idx] = -Sample(2.0) * cos_w0[idx];
+        a2[idx] = Sample(1.0) - alpha;
+      }
+    } else {
+      std::array<Sample, nVoice> alpha;
+      for (size_t idx = begin; idx < end; ++idx) {
+        alpha[idx] = bandAlpha(w0[idx], sin_w0[idx], qc[idx]);
+      }
+      for (size_t idx = begin; idx < end; ++idx) {
+        if constexpr (filterType == BiquadType::bandpass) {
+          b0[idx] = alpha[idx];
+          b1[idx] = Sample(0.0);
+          b2[idx] = -alpha[idx];
+        } else {
+          b0[idx] = Sample(1.0);
+          b1[idx] = -Sample(2.0) * cos_w0[idx];
+          b2[idx] = Sample(1.0);
+        }
+        a0[idx] = Sample(1.0) + alpha[idx];
+        a1[idx] = -Sample(2.0) * cos_w0[idx];
+        a2[idx] = Sample(1.0) - alpha[idx];
+      }
+    }
   }
 
-  Sample clamp(Sample value, Sample min, Sample max)
+  template<ShaperType shaperType>
+  void process(
+    size_t begin,
+    size_t end,
+    const std::array<int32_t, nVoice> &isActive,
+    const std::array<Sample, nVoice> &input,
+    Sample saturation)
   {
-    return value < min ? min : value > max ? max : value;
+    std::array<Sample, nVoice> x0;
+    for (size_t idx = begin; idx < end; ++idx) {
+      x0[idx] = saturation * (input[idx] - feedback[idx] * y1[3][idx]);
+    }
+    if constexpr (shaperType == ShaperType::mixed) {
+      for (size_t idx = begin; idx < end; ++idx) {
+        switch (shaper[idx]) {
+          default:
+          case ShaperType::hardclip:
+            x0[idx] = shaperHardclip(x0[idx]);
+            break;
+
+          case ShaperType::tanh:
+            x0[idx] = juce::dsp::FastMathApproximations::tanh<Sample>(x0[idx]);
+            break;
+
+          case ShaperType::sinRunge:
+            x0[idx] = shaperSinRunge(x0[idx]);
+            break;
+
+          case ShaperType::cubicExpDecayAbs:
+            x0[idx] = shaperCubicExpDecayAbs(x0[idx]);
+            break;
+        }
+      }
+    } else if constexpr (shaperType == ShaperType::hardclip) {
+      for (size_t idx = begin; idx < end; ++idx) x0[idx] = shaperHardclip(x0[idx]);
+    } else if constexpr (shaperType == ShaperType::tanh) {
+      // x0[idx] = std::tanh(x0[idx]);
+      for (size_t idx = begin; idx < end; ++idx) {
+        x0[idx] = juce::dsp::FastMathApproximations::tanh<Sample>(x0[idx]);
+      }
+    } else if constexpr (shaperType == ShaperType::sinRunge) {
+      for (size_t idx = begin; idx < end; ++idx) {
+        if (isActive[idx]) x0[idx] = shaperSinRunge(x0[idx]);
+      }
+    } else {
+      for (size_t idx = begin; idx < end; ++idx) {
+        if (isActive[idx]) x0[idx] = shaperCubicExpDecayAbs(x0[idx]);
+      }
+    }
+
+    std::array<Sample, nVoice> y0;
+    for (size_t stage = 0; stage < 4; ++stage) {
+      auto &xs1 = x1[stage];
+      auto &xs2 = x2[stage];
+      auto &ys1 = y1[stage];
+      auto &ys2 = y2[stage];
+      for (size_t idx = begin; idx < end; ++idx) {
+        y0[idx] = (b0[idx] * x0[idx] + b1[idx] * xs1[idx] + b2[idx] * xs2[idx]
+                   - a1[idx] * ys1[idx] - a2[idx] * ys2[idx])
+          / a0[idx];
+      }
+      for (size_t idx = begin; idx < end; ++idx) {
+        auto x = x0[idx];
+        auto vx1 = xs1[idx];
+        auto vx2 = xs2[idx];
+        auto vy1 = ys1[idx];
+        auto vy2 = ys2[idx];
+        auto vy0 = y0[idx];
+        bool active = isActive[idx] != 0;
+        auto nx2 = active ? vx1 : vx2;
+        auto nx1 = active ? x : vx1;
+        auto ny2 = active ? vy1 : vy2;
+        auto ny1 = active ? vy0 : vy1;
+        xs2[idx] = nx2;
+        xs1[idx] = nx1;
+        ys2[idx] = ny2;
+        ys1[idx] = ny1;
+        x0[idx] = vy1; // Input of next stage is the previous output of this stage.
+      }
+    }
+
+    for (size_t idx = begin; idx < end; ++idx) {
+      if (!isActive[idx]) continue;
+      if (std::isfinite(y1[3][idx])) {
+        output[idx] = y1[3][idx];
+      } else {
+        clear(idx);
+        output[idx] = 0;
+      }
+    }
   }
 
-  void setLowpass()
+private:
+  static Sample bandAlpha(Sample w0, Sample sin_w0, Sample q)
   {
-    alpha = sin_w0 / (Sample(2.0) * q);
-    b0 = (Sample(1.0) - cos_w0) / Sample(2.0);
-    b1 = Sample(1.0) - cos_w0;
-    b2 = (Sample(1.0) - cos_w0) / Sample(2.0);
-    a0 = Sample(1.0) + alpha;
-    a1 = -Sample(2.0) * cos_w0;
-    a2 = Sample(1.0) - alpha;
+    // 0.34657359027997264 = log(2) / 2.
+    return sin_w0 * sinhApprox(Sample(0.34657359027997264) * q * w0 / sin_w0);
   }
 
-  void setHighpass()
+  void setLowpass(size_t voice, Sample cos_w0, Sample sin_w0, Sample q)
   {
-    alpha = sin_w0 / (Sample(2.0) * q);
-    b0 = (Sample(1.0) + cos_w0) / Sample(2.0);
-    b1 = -(Sample(1.0) + cos_w0);
-    b2 = (Sample(1.0) + cos_w0) / Sample(2.0);
-    a0 = Sample(1.0) + alpha;
-    a1 = -Sample(2.0) * cos_w0;
-    a2 = Sample(1.0) - alpha;
+    auto alpha = sin_w0 / (Sample(2.0) * q);
+    b0[voice] = (Sample(1.0) - cos_w0) / Sample(2.0);
+    b1[voice] = Sample(1.0) - cos_w0;
+    b2[voice] = (Sample(1.0) - cos_w0) / Sample(2.0);
+    a0[voice] = Sample(1.0) + alpha;
+    a1[voice] = -Sample(2.0) * cos_w0;
+    a2[voice] = Sample(1.0) - alpha;
   }
 
-  void setBandpass()
+  void setHighpass(size_t voice, Sample cos_w0, Sample sin_w0, Sample q)
   {
-    // 0.34657359027997264 = log(2) / 2.
-    alpha = sin_w0 * std::sinh(Sample(0.34657359027997264) * q * w0 / sin_w0);
-    b0 = alpha;
-    b1 = 0.0;
-    b2 = -alpha;
-    a0 = Sample(1.0) + alpha;
-    a1 = -Sample(2.0) * cos_w0;
-    a2 = Sample(1.0) - alpha;
+    auto alpha = sin_w0 / (Sample(2.0) * q);
+    b0[voice] = (Sample(1.0) + cos_w0) / Sample(2.0);
+    b1[voice] = -(Sample(1.0) + cos_w0);
+    b2[voice] = (Sample(1.0) + cos_w0) / Sample(2.0);
+    a0[voice] = Sample(1.0) + alpha;
+    a1[voice] = -Sample(2.0) * cos_w0;
+    a2[voice] = Sample(1.0) - alpha;
   }
 
-  void setNotch()
+  void setBandpass(size_t voice, Sample w0, Sample cos_w0, Sample sin_w0, Sample q)
   {
-    alpha = sin_w0 * std::sinh(Sample(0.34657359027997264) * q * w0 / sin_w0);
-    b0 = Sample(1.0);
-    b1 = -Sample(2.0) * cos_w0;
-    b2 = Sample(1.0);
-    a0 = Sample(1.0) + alpha;
-    a1 = -Sample(2.0) * cos_w0;
-    a2 = Sample(1.0) - alpha;
+    auto alpha = bandAlpha(w0, sin_w0, q);
+    b0[voice] = alpha;
+    b1[voice] = 0.0;
+    b2[voice] = -alpha;
+    a0[voice] = Sample(1.0) + alpha;
+    a1[voice] = -Sample(2.0) * cos_w0;
+    a2[voice] = Sample(1.0) - alpha;
   }
 
-  void setCutoffQ(Sample hz, Sample q)
+  void setNotch(size_t voice, Sample w0, Sample cos_w0, Sample sin_w0, Sample q)
   {
-    f0 = clamp(hz, Sample(20.0), Sample(20000.0));
-    this->q = clamp(q, Sample(1e-5), Sample(1.0));
-
-    w0 = Sample(twopi) * f0 / fs;
-    cos_w0 = juce::dsp::FastMathApproximations::cos<Sample>(w0);
-    sin_w0 = juce::dsp::FastMathApproximations::sin<Sample>(w0);
-    switch (type) {
-      default:
-      case BiquadType::lowpass:
-        setLowpass();
-        break;
-
-      case BiquadType::highpass:
-        setHighpass();
-        break;
-
-      case BiquadType::bandpass:
-        setBandpass();
-        break;
-
-      case BiquadType::notch:
-        setNotch();
-        break;
-    }
+    auto alpha = bandAlpha(w0, sin_w0, q);
+    b0[voice] = Sample(1.0);
+    b1[voice] = -Sample(2.0) * cos_w0;
+    b2[voice] = Sample(1.0);
+    a0[voice] = Sample(1.0) + alpha;
+    a1[voice] = -Sample(2.0) * cos_w0;
+    a2[voice] = Sample(1.0) - alpha;
   }
 
-  Sample shaperSinRunge(Sample x)
+  static Sample shaperSinRunge(Sample x)
   {
     return std::sin(Sample(2.0 * pi) * x) / (Sample(1.0) + Sample(10.0) * x * x);
   }
 
-  Sample shaperCubicExpDecayAbs(Sample x)
+  static Sample shaperCubicExpDecayAbs(Sample x)
   {
     // Solve x for: diff(x^3*exp(-x), x) = 0,
     // then we get: x = 0, 27 * math.exp(-3).
@@ -179,52 +324,9 @@ public:
     return Sample(0.7439087749328765) * x * x * x * std::exp(-std::fabs(x));
   }
 
-  Sample shaperHardclip(Sample x)
+  static Sample shaperHardclip(Sample x)
   {
-    return x < Sample(-1.0) ? Sample(-1.0) : x > Sample(1.0) ? Sample(1.0) : x;
-  }
-
-  Sample process(Sample input)
-  {
-    input = saturation * (input - feedback * y0[3]);
-    switch (shaper) {
-      default:
-      case ShaperType::hardclip:
-        input = shaperHardclip(input);
-        break;
-
-      case ShaperType::tanh:
-        // input = std::tanh(input);
-        input = juce::dsp::FastMathApproximations::tanh<Sample>(input);
-        break;
-
-      case ShaperType::sinRunge:
-        input = shaperSinRunge(input);
-        break;
-
-      case ShaperType::cubicExpDecayAbs:
-        input = shaperCubicExpDecayAbs(input);
-        break;
-    }
-
-    x0[0] = input;
-    x0[1] = y0[0];
-    x0[2] = y0[1];
-    x0[3] = y0[2];
-
-    y0[0] = (b0 * x0[0] + b1 * x1[0] + b2 * x2[0] - a1 * y1[0] - a2 * y2[0]) / a0;
-    y0[1] = (b0 * x0[1] + b1 * x1[1] + b2 * x2[1] - a1 * y1[1] - a2 * y2[1]) / a0;
-    y0[2] = (b0 * x0[2] + b1 * x1[2] + b2 * x2[2] - a1 * y1[2] - a2 * y2[2]) / a0;
-    y0[3] = (b0 * x0[3] + b1 * x1[3] + b2 * x2[3] - a1 * y1[3] - a2 * y2[3]) / a0;
-
-    x2 = x1;
-    x1 = x0;
-    y2 = y1;
-    y1 = y0;
-
-    if (std::isfinite(y0[3])) return y0[3];
-    clear();
-    return 0.0;
+    return std::min(std::max(x, Sample(-1.0)), Sample(1.0));
   }
 };
 
@@ -0,0 +1,170 @@
+// (c) 2022 Takamitsu Endo
+//
+// This file is part of SyncSawSynth.
+//
+// SyncSawSynth is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// SyncSawSynth is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with SyncSawSynth.  If not, see <https://www.gnu.org/licenses/>.
+
+// Stress test of MIDI event dispatch with 1000+ events per block.
+//
+// "vector" is the previous implementation which searched `std::vector` on each sample
+// and erased the found event. "ring" is `MidiEventRing`. Events are pushed in order of
+// frame ("sorted"), or in random order ("shuffled") which is the worst case of
+// `MidiEventRing::push()`. "DSPCore" runs the whole synth with `MidiEventRing`.
+//
+// Results are the worst and the mean time of a block in microseconds.
+
+#include "../source/dsp/dspcore.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+constexpr size_t blockSize = 512;
+constexpr size_t nBlock = 200;
+
+using Event = DSPCore::MidiNote;
+
+volatile int64_t sink = 0;
+
+std::vector<std::vector<Event>> makeEvents(size_t nEvent, bool shuffle)
+{
+  std::minstd_rand rng{0};
+  std::uniform_int_distribution<uint32_t> frameDist(0, blockSize - 1);
+  std::uniform_int_distribution<int16_t> pitchDist(0, 127);
+
+  std::vector<std::vector<Event>> blocks(nBlock);
+  for (auto &events : blocks) {
+    events.resize(nEvent);
+    for (size_t i = 0; i < nEvent; ++i) {
+      auto &ev = events[i];
+      ev.isNoteOn = i % 2 == 0;
+      ev.frame = frameDist(rng);
+      ev.id = int32_t(i / 2);
+      ev.pitch = pitchDist(rng);
+      ev.tuning = 0;
+      ev.velocity = 0.5f;
+    }
+    if (shuffle) {
+      std::shuffle(events.begin(), events.end(), rng);
+    } else {
+      std::stable_sort(events.begin(), events.end(), [](const Event &a, const Event &b) {
+        return a.frame < b.frame;
+      });
+    }
+  }
+  return blocks;
+}
+
+struct Result {
+  double worst = 0;
+  double mean = 0;
+};
+
+template<typename Func> Result measure(Func func)
+{
+  Result result;
+  for (size_t block = 0; block < nBlock; ++block) {
+    auto start = std::chrono::steady_clock::now();
+    func(block);
+    auto end = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double, std::micro>(end - start).count();
+    result.worst = std::max(result.worst, elapsed);
+    result.mean += elapsed;
+  }
+  result.mean /= double(nBlock);
+  return result;
+}
+
+Result runVector(const std::vector<std::vector<Event>> &blocks)
+{
+  std::vector<Event> midiNotes;
+  midiNotes.reserve(128);
+
+  return measure([&](size_t block) {
+    for (const auto &ev : blocks[block]) midiNotes.push_back(ev);
+    for (size_t frame = 0; frame < blockSize; ++frame) {
+      while (true) {
+        auto it = std::find_if(midiNotes.begin(), midiNotes.end(), [&](const Event &nt) {
+          return nt.frame == frame;
+        });
+        if (it == std::end(midiNotes)) break;
+        sink += it->isNoteOn ? it->pitch : -it->id;
+        midiNotes.erase(it);
+      }
+    }
+  });
+}
+
+Result runRing(const std::vector<std::vector<Event>> &blocks)
+{
+  auto midiNotes = std::make_unique<MidiEventRing<Event>>();
+
+  return measure([&](size_t block) {
+    for (const auto &ev : blocks[block]) midiNotes->push(ev);
+    for (size_t frame = 0; frame < blockSize; ++frame) {
+      midiNotes->dispatch(frame, [&](Event &note) {
+        sink += note.isNoteOn ? note.pitch : -note.id;
+      });
+    }
+  });
+}
+
+Result runDSPCore(const std::vector<std::vector<Event>> &blocks)
+{
+  auto dsp = std::make_unique<DSPCore>();
+  dsp->setup(48000);
+  dsp->reset();
+
+  std::vector<float> out0(blockSize);
+  std::vector<float> out1(blockSize);
+
+  return measure([&](size_t block) {
+    for (const auto &ev : blocks[block]) {
+      dsp->pushMidiNote(ev.isNoteOn, ev.frame, ev.id, ev.pitch, ev.tuning, ev.velocity);
+    }
+    dsp->process(blockSize, out0.data(), out1.data());
+  });
+}
+
+void print(const std::string &name, size_t nEvent, const Result &result)
+{
+  std::cout << std::setw(18) << name << std::setw(8) << nEvent << std::setw(12)
+            << result.worst << std::setw(12) << result.mean << "\n";
+}
+
+int main()
+{
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << std::setw(18) << "method" << std::setw(8) << "events" << std::setw(12)
+            << "worst[us]" << std::setw(12) << "mean[us]" << "\n";
+
+  for (size_t nEvent : {1024, 2048, 4096}) {
+    auto sorted = makeEvents(nEvent, false);
+    auto shuffled = makeEvents(nEvent, true);
+
+    print("vector sorted", nEvent, runVector(sorted));
+    print("ring sorted", nEvent, runRing(sorted));
+    print("vector shuffled", nEvent, runVector(shuffled));
+    print("ring shuffled", nEvent, runRing(shuffled));
+    print("DSPCore", nEvent, runDSPCore(sorted));
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -344,13 +344,11 @@ template<typename Sample> Sample TpzMono<Sample>::getOsc2Pitch(GlobalParameter &
            param.value[ParameterID::pitchBend]->getFloat());
 }
 
-DSPCore::DSPCore() { midiNotes.reserve(128); }
-
 void DSPCore::setup(double sampleRate)
 {
   this->sampleRate = float(sampleRate);
 
-  midiNotes.resize(0);
+  midiNotes.clear();
 
   SmootherCommon<float>::setSampleRate(this->sampleRate);
   SmootherCommon<float>::setTime(0.01f);
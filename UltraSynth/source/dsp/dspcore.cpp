@@ -46,9 +46,11 @@ void DSPCore::setup(double sampleRate)
   constexpr auto smoothingTimeSecond = 0.2;
 
   baseRateKp = EMAFilter<double>::secondToP(sampleRate, smoothingTimeSecond);
+  lfoStep.set(double(0.1), upFold);
 
   SmootherCommon<double>::setSampleRate(upRate);
   SmootherCommon<double>::setTime(smoothingTimeSecond);
+  controlStep.set(SmootherCommon<double>::kp, upFold);
 
   reset();
   startup();
@@ -58,8 +60,9 @@ void DSPCore::setup(double sampleRate)
   using ID = ParameterID::ID;                                                            \
   const auto &pv = param.value;                                                          \
                                                                                          \
-  pitchSmoothingKp                                                                       \
-    = EMAFilter<double>::secondToP(upRate, pv[ID::noteSlideTimeSecond]->getDouble());    \
+  pitchStep.set(                                                                         \
+    EMAFilter<double>::secondToP(upRate, pv[ID::noteSlideTimeSecond]->getDouble()),      \
+    upFold);                                                                             \
   lowpassCutoffDecayKp = EMAFilter<double>::secondToP(                                   \
     upRate, pv[ID::lowpassCutoffDecaySecond]->getDouble());                              \
   auto notePitch = calcNotePitch(noteNumber);                                            \
@@ -74,10 +77,11 @@ void DSPCore::setup(double sampleRate)
   interpLfoToOsc1WaveShape.METHOD(pv[ID::lfoToOsc1WaveShape]->getDouble());              \
   interpLfoToOsc2WaveShape.METHOD(pv[ID::lfoToOsc2WaveShape]->getDouble());              \
                                                                                          \
-  gainAttackKp                                                                           \
-    = EMAFilter<double>::secondToP(upRate, pv[ID::gainAttackSecond]->getDouble());       \
-  gainDecayKp                                                                            \
-    = EMAFilter<double>::secondToP(upRate, pv[ID::gainDecaySecond]->getDouble());        \
+  gainAttackStep.set(                                                                    \
+    EMAFilter<double>::secondToP(upRate, pv[ID::gainAttackSecond]->getDouble()),         \
+    upFold);                                                                             \
+  gainDecayStep.set(                                                                     \
+    EMAFilter<double>::secondToP(upRate, pv[ID::gainDecaySecond]->getDouble()), upFold); \
                                                                                          \
   auto pitchBend                                                                         \
     = calcPitch(pv[ID::pitchBendRange]->getDouble() * pv[ID::pitchBend]->getDouble());   \
@@ -110,6 +114,7 @@ void DSPCore::setup(double sampleRate)
   interpSustain.METHOD(pv[ID::gainSustainAmplitude]->getDouble());                       \
                                                                                          \
   releaseEnvelope.prepare(upRate, pv[ID::gainReleaseSecond]->getDouble());               \
+  gainReleaseStep.set(releaseEnvelope.getKp(), upFold);                                  \
   svf.setSmootherSecond(upRate, pv[ID::lowpassCutoffAttackSecond]->getDouble());
 
 void DSPCore::reset()
@@ -128,9 +133,9 @@ void DSPCore::reset()
 
   svf.reset(interpSvfG.getValue(), interpSvfK.getValue());
 
-  firstStageLowpass.reset();
-  halfBandInput.fill({});
-  halfbandIir.reset();
+  downSampler.reset();
+
+  resetRamp();
 
   startup();
 }
@@ -145,11 +150,15 @@ void DSPCore::startup()
 
 void DSPCore::setParameters() { ASSIGN_PARAMETER(push); }
 
-template<typename Sample> inline Sample processOsc(Sample phase, Sample shape, Sample mix)
+// `invShape = 1 / shape` and `invShapeNeg = 1 / (1 - shape)`. The reciprocals are
+// computed on each sub-sample from the ramped wave shape, but they are moved out of the
+// feedback path between oscillators, so the divisions can overlap with it.
+template<typename Sample>
+inline Sample processOsc(Sample phase, Sample invShape, Sample invShapeNeg, Sample mix)
 {
   return Sample(-0.5)
-    + (phase < 0 ? lerp(-phase / (Sample(1) - shape), Sample(0), mix)
-                 : lerp(phase / shape, Sample(1), mix));
+    + (phase < 0 ? lerp(-phase * invShapeNeg, Sample(0), mix)
+                 : lerp(phase * invShape, Sample(1), mix));
 }
 
 void DSPCore::process(const size_t length, float *out0, float *out1)
@@ -159,6 +168,8 @@ void DSPCore::process(const size_t length, float *out0, float *out1)
 
   SmootherCommon<double>::setBufferSize(double(length));
   SmootherCommon<double>::setSampleRate(upRate);
+  controlStep.set(SmootherCommon<double>::kp, upFold);
+  const auto controlKp = controlStep.getKp();
 
   // When tempo-sync is off, use defaultTempo BPM.
   bool isTempoSyncing = pv[ID::lfoTempoSync]->getInt();
@@ -191,76 +202,91 @@ void DSPCore::process(const size_t length, float *out0, float *out1)
     auto lfoToOsc1WaveShape = interpLfoToOsc1WaveShape.process(baseRateKp);
     auto lfoToOsc2WaveShape = interpLfoToOsc2WaveShape.process(baseRateKp);
 
+    // Control rate. Values are evaluated at the end of current base rate sample.
+    auto lfoB = lfoSmootherB.processStep(lfoBipolar, lfoStep);
+    auto lfoP = lfoSmootherP.processStep(lfoPositive, lfoStep);
+
+    auto pitch = (double(1) + lfoToPitch * lfoB) * interpPitch.process(pitchStep.getKp());
+    auto freq = interpFrequencyHz.process(controlKp);
+    rampOsc1Delta.push(
+      freq * pitch * interpOsc1FrequencyOffsetPitch.process(controlKp) / upRate);
+    rampOsc2Delta.push(
+      freq * pitch * interpOsc2FrequencyOffsetPitch.process(controlKp) / upRate);
+
+    rampOsc1WaveShape.push(std::clamp<double>(
+      interpOsc1WaveShape.process(controlKp) + lfoToOsc1WaveShape * lfoB, eps, 1 - eps));
+    rampOsc2WaveShape.push(std::clamp<double>(
+      interpOsc2WaveShape.process(controlKp) + lfoToOsc2WaveShape * lfoB, eps, 1 - eps));
+
+    auto spMix1 = interpOsc1SawPulse.process(controlKp);
+    auto spMix2 = interpOsc2SawPulse.process(controlKp);
+    auto pmLpToO1 = interpPhaseModFromLowpassToOsc1.process(controlKp);
+    auto pmP1ToP2 = interpPmPhase1ToPhase2.process(controlKp);
+    auto pmP2ToP1 = interpPmPhase2ToPhase1.process(controlKp);
+    auto pmO1ToP2 = interpPmOsc1ToPhase2.process(controlKp);
+    auto pmO2ToP1 = interpPmOsc2ToPhase1.process(controlKp);
+    auto kTarget = interpSvfK.process(controlKp);
+    auto rectMix = interpRectificationMix.process(controlKp);
+    auto satMix = interpSaturationMix.process(controlKp);
+
+    rampOscMix.push(std::clamp(
+      interpOscMix.process(controlKp) + lfoToOscMix * lfoB, double(0), double(1)));
+    rampPreSaturation.push(lerp<double>(1.0, lfoB, lfoToPreSaturation));
+    rampSvfG.push(std::clamp<double>(
+      interpSvfG.process(controlKp) + lfoToCutoff * lfoP, SVFTool::minCutoff,
+      SVFTool::nyquist));
+
+    auto sustain = interpSustain.process(controlKp);
+    rampGain.push(attackEnvelope.processStep(
+      decayEnvelope.processStep(velocity * sustain, gainDecayStep)
+        * releaseEnvelope.processStep(gainReleaseStep),
+      gainAttackStep));
+
+    // Audio rate.
     for (size_t j = 0; j < 2; ++j) {                // Halfband downsampler.
       for (size_t k = 0; k < firstStateFold; ++k) { // Stage 1 downsampler.
-        auto lfoB = lfoSmootherB.processKp(lfoBipolar, 0.1);
-        auto lfoP = lfoSmootherP.processKp(lfoPositive, 0.1);
-
-        auto pitch
-          = (double(1) + lfoToPitch * lfoB) * interpPitch.process(pitchSmoothingKp);
-        auto freq = interpFrequencyHz.process();
-        auto osc1Freq = freq * pitch * interpOsc1FrequencyOffsetPitch.process();
-        auto osc2Freq = freq * pitch * interpOsc2FrequencyOffsetPitch.process();
-
-        auto ws1 = std::clamp<double>(
-          interpOsc1WaveShape.process() + lfoToOsc1WaveShape * lfoB, eps, 1 - eps);
-        auto ws2 = std::clamp<double>(
-          interpOsc2WaveShape.process() + lfoToOsc2WaveShape * lfoB, eps, 1 - eps);
-
-        auto spMix1 = interpOsc1SawPulse.process();
-        auto spMix2 = interpOsc2SawPulse.process();
-        auto pmLpToO1 = interpPhaseModFromLowpassToOsc1.process();
-        auto pmP1ToP2 = interpPmPhase1ToPhase2.process();
-        auto pmP2ToP1 = interpPmPhase2ToPhase1.process();
-        auto pmO1ToP2 = interpPmOsc1ToPhase2.process();
-        auto pmO2ToP1 = interpPmOsc2ToPhase1.process();
-        auto oscMix = interpOscMix.process();
-        auto gTarget = interpSvfG.process();
-        auto kTarget = interpSvfK.process();
-        auto rectMix = interpRectificationMix.process();
-        auto satMix = interpSaturationMix.process();
-        auto sustain = interpSustain.process();
+        // Reciprocals are not ramped. `ws` can be close to eps, and a linear ramp of
+        // `1 / ws` would overshoot far above `1 / ws` in between.
+        auto ws1 = rampOsc1WaveShape.process();
+        auto ws2 = rampOsc2WaveShape.process();
+        auto inv1 = double(1) / ws1;
+        auto invNeg1 = double(1) / (double(1) - ws1);
+        auto inv2 = double(1) / ws2;
+        auto invNeg2 = double(1) / (double(1) - ws2);
 
         // Osc1.
-        phase1
-          += osc1Freq / upRate + pmLpToO1 * feedback + pmP1ToP2 * phase2 + pmO1ToP2 * o2;
+        phase1 += rampOsc1Delta.process() + pmLpToO1 * feedback + pmP1ToP2 * phase2
+          + pmO1ToP2 * o2;
         phase1 -= std::floor(phase1);
-        o1 = processOsc<double>(ws1 - phase1, ws1, spMix1);
+        o1 = processOsc<double>(ws1 - phase1, inv1, invNeg1, spMix1);
 
         // Osc2.
-        phase2 += osc2Freq / upRate + pmP2ToP1 * phase1 + pmO2ToP1 * o1;
+        phase2 += rampOsc2Delta.process() + pmP2ToP1 * phase1 + pmO2ToP1 * o1;
         phase2 -= std::floor(phase2);
-        o2 = processOsc<double>(ws2 - phase2, ws2, spMix2);
+        o2 = processOsc<double>(ws2 - phase2, inv2, invNeg2, spMix2);
 
         // Saturation.
-        oscMix = std::clamp(oscMix + lfoToOscMix * double(lfoB), double(0), double(1));
-        auto sig = o1 + oscMix * (o2 - o1);
-        sig *= lerp<double>(1.0, lfoB, lfoToPreSaturation);
+        auto sig = o1 + rampOscMix.process() * (o2 - o1);
+        sig *= rampPreSaturation.process();
         sig = lerp<double>(sig, std::abs(sig), rectMix);
         auto sat = sig < 0 ? -std::sqrt(-sig) : std::sqrt(sig);
         sig = lerp<double>(sig, sat, satMix);
 
         // Filter.
-        gTarget = std::clamp<double>(
-          gTarget + lfoToCutoff * lfoP, SVFTool::minCutoff, SVFTool::nyquist);
-        sig = svf.lowpass(sig, gTarget, kTarget, lowpassCutoffDecayKp);
+        sig = svf.lowpass(sig, rampSvfG.process(), kTarget, lowpassCutoffDecayKp);
 
         // Gain.
-        sig *= attackEnvelope.processKp(
-          decayEnvelope.processKp(velocity * sustain, gainDecayKp)
-            * releaseEnvelope.process(),
-          gainAttackKp);
+        sig *= rampGain.process();
 
         feedback = sig;
         feedback -= std::floor(sig);
 
-        firstStageLowpass.push(sig);
+        downSampler.inputBuffer[0][j * firstStateFold + k] = sig;
       }
-      halfBandInput[j] = firstStageLowpass.output();
     }
 
     auto out
-      = float(interpOutputGain.process(baseRateKp) * halfbandIir.process(halfBandInput));
+      = float(interpOutputGain.process(baseRateKp) * downSampler.process()[0]);
     out0[i] = out;
     out1[i] = out;
   }
@@ -339,6 +365,24 @@ double DSPCore::getTempoSyncInterval()
     : (4 * upper) / (lower * lfoRate);
 }
 
+void DSPCore::resetRamp()
+{
+  constexpr auto eps = std::numeric_limits<double>::epsilon();
+
+  auto freq = interpFrequencyHz.getValue() * interpPitch.getValue() / upRate;
+  rampOsc1Delta.reset(freq * interpOsc1FrequencyOffsetPitch.getValue());
+  rampOsc2Delta.reset(freq * interpOsc2FrequencyOffsetPitch.getValue());
+  rampOsc1WaveShape.reset(
+    std::clamp<double>(interpOsc1WaveShape.getValue(), eps, 1 - eps));
+  rampOsc2WaveShape.reset(
+    std::clamp<double>(interpOsc2WaveShape.getValue(), eps, 1 - eps));
+  rampOscMix.reset(std::clamp(interpOscMix.getValue(), double(0), double(1)));
+  rampPreSaturation.reset(lerp<double>(1.0, 0.0, interpLfoToPreSaturation.getValue()));
+  rampSvfG.reset(std::clamp<double>(
+    interpSvfG.getValue(), SVFTool::minCutoff, SVFTool::nyquist));
+  rampGain.reset(0);
+}
+
 void DSPCore::resetBuffer()
 {
   feedback = 0;
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "../../../common/dsp/constants.hpp"
+#include "../../../common/dsp/eventring.hpp"
 #include "../../../common/dsp/lfo.hpp"
 #include "../../../common/dsp/multirate.hpp"
 #include "../../../common/dsp/smoother.hpp"
@@ -39,11 +40,7 @@ public:
     float velocity;
   };
 
-  DSPCore()
-  {
-    midiNotes.reserve(1024);
-    noteStack.reserve(1024);
-  }
+  DSPCore() { noteStack.reserve(1024); }
 
   GlobalParameter param;
   bool isPlaying = false;
@@ -74,29 +71,24 @@ public:
     note.id = noteId;
     note.noteNumber = noteNumber + tuning;
     note.velocity = velocity;
-    midiNotes.push_back(note);
+    midiNotes.push(note);
   }
 
   void processMidiNote(size_t frame)
   {
-    while (true) {
-      auto it = std::find_if(midiNotes.begin(), midiNotes.end(), [&](const NoteInfo &nt) {
-        return nt.frame == frame;
-      });
-      if (it == std::end(midiNotes)) return;
-      if (it->isNoteOn)
-        noteOn(*it);
+    midiNotes.dispatch(frame, [&](NoteInfo &note) {
+      if (note.isNoteOn)
+        noteOn(note);
       else
-        noteOff(it->id);
-      midiNotes.erase(it);
-    }
+        noteOff(note.id);
+    });
   }
 
 private:
   static constexpr size_t upFold = 64;
   static constexpr size_t firstStateFold = Sos64FoldFirstStage<float>::fold;
 
-  std::vector<NoteInfo> midiNotes;
+  MidiEventRing<NoteInfo> midiNotes;
   std::vector<NoteInfo> noteStack;
 
   DecibelScale<double> velocityMap{-36, 0, true};
@@ -106,7 +98,6 @@ private:
   double upRate = upFold * 44100.0;
 
   double noteNumber = 69.0;
-  double pitchSmoothingKp = 1.0;
   double lowpassCutoffDecayKp = 1.0;
   ExpSmootherLocal<double> interpPitch;
 
@@ -125,24 +116,64 @@ private:
   DoubleEMAFilter<double> lfoSmootherB;
   DoubleEMAFilter<double> lfoSmootherP;
 
-  ExpSmoother<double> interpFrequencyHz;
-  ExpSmoother<double> interpOsc1FrequencyOffsetPitch;
-  ExpSmoother<double> interpOsc2FrequencyOffsetPitch;
-  ExpSmoother<double> interpOsc1WaveShape;
-  ExpSmoother<double> interpOsc2WaveShape;
-  ExpSmoother<double> interpOsc1SawPulse;
-  ExpSmoother<double> interpOsc2SawPulse;
-  ExpSmoother<double> interpPhaseModFromLowpassToOsc1;
-  ExpSmoother<double> interpPmPhase1ToPhase2;
-  ExpSmoother<double> interpPmPhase2ToPhase1;
-  ExpSmoother<double> interpPmOsc1ToPhase2;
-  ExpSmoother<double> interpPmOsc2ToPhase1;
-  ExpSmoother<double> interpOscMix;
-  ExpSmoother<double> interpSvfG;
-  ExpSmoother<double> interpSvfK;
-  ExpSmoother<double> interpRectificationMix;
-  ExpSmoother<double> interpSaturationMix;
-  ExpSmoother<double> interpSustain;
+  // Smoothers below are processed once per base rate sample. Steps advance them by
+  // `upFold` samples at `upRate`.
+  EMAStep<double> controlStep;
+  EMAStep<double> lfoStep;
+  EMAStep<double> pitchStep;
+  ExpSmootherLocal<double> interpFrequencyHz;
+  ExpSmootherLocal<double> interpOsc1FrequencyOffsetPitch;
+  ExpSmootherLocal<double> interpOsc2FrequencyOffsetPitch;
+  ExpSmootherLocal<double> interpOsc1WaveShape;
+  ExpSmootherLocal<double> interpOsc2WaveShape;
+  ExpSmootherLocal<double> interpOsc1SawPulse;
+  ExpSmootherLocal<double> interpOsc2SawPulse;
+  ExpSmootherLocal<double> interpPhaseModFromLowpassToOsc1;
+  ExpSmootherLocal<double> interpPmPhase1ToPhase2;
+  ExpSmootherLocal<double> interpPmPhase2ToPhase1;
+  ExpSmootherLocal<double> interpPmOsc1ToPhase2;
+  ExpSmootherLocal<double> interpPmOsc2ToPhase1;
+  ExpSmootherLocal<double> interpOscMix;
+  ExpSmootherLocal<double> interpSvfG;
+  ExpSmootherLocal<double> interpSvfK;
+  ExpSmootherLocal<double> interpRectificationMix;
+  ExpSmootherLocal<double> interpSaturationMix;
+  ExpSmootherLocal<double> interpSustain;
+
+  /**
+  Linear interpolation of a control rate value across the `upFold` samples of the
+  inner loop. `push()` sets a new target at each base rate sample.
+  */
+  struct ControlRamp {
+    double value = 0;
+    double target = 0;
+    double delta = 0;
+
+    void reset(double x)
+    {
+      value = x;
+      target = x;
+      delta = 0;
+    }
+
+    void push(double x)
+    {
+      value = target;
+      target = x;
+      delta = (target - value) / double(upFold);
+    }
+
+    double process() { return value += delta; }
+  };
+
+  ControlRamp rampOsc1Delta;
+  ControlRamp rampOsc2Delta;
+  ControlRamp rampOsc1WaveShape;
+  ControlRamp rampOsc2WaveShape;
+  ControlRamp rampOscMix;
+  ControlRamp rampPreSaturation;
+  ControlRamp rampSvfG;
+  ControlRamp rampGain;
 
   double feedback = 0;
   double phase1 = 0;
@@ -150,19 +181,19 @@ private:
   double o1 = 0;
   double o2 = 0;
 
-  double gainAttackKp = 1.0;
-  double gainDecayKp = 1.0;
+  EMAStep<double> gainAttackStep;
+  EMAStep<double> gainDecayStep;
+  EMAStep<double> gainReleaseStep;
   DoubleEMAFilter<double> attackEnvelope;
   DoubleEMAFilter<double> decayEnvelope;
   NoteGate<double> releaseEnvelope;
 
   SerialSVF<double> svf;
 
-  DecimationLowpass<double, Sos64FoldFirstStage<double>> firstStageLowpass;
-  std::array<double, 2> halfBandInput;
-  HalfBandIIR<double, HalfBandCoefficient<double>> halfbandIir;
+  PolyphaseDownSampler<double, 1, Sos64FoldFirstStage<double>> downSampler;
 
   double calcNotePitch(double note);
   double getTempoSyncInterval();
   void resetBuffer();
+  void resetRamp();
 };
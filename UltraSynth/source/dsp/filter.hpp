@@ -77,7 +77,8 @@ public:
     auto kp = kSmoother.processKp(k.processKp(kTarget, decayKp), smootherKp);
 
     auto v0 = input;
-    auto v1 = (ic1eq + gp * (v0 - ic2eq)) / (Sample(1) + gp * (gp + kp));
+    auto d = Sample(1) / (Sample(1) + gp * (gp + kp));
+    auto v1 = (ic1eq + gp * (v0 - ic2eq)) * d;
     auto v2 = ic2eq + gp * v1;
     ic1eq = Sample(2) * v1 - ic1eq;
     ic2eq = Sample(2) * v2 - ic2eq;
@@ -131,7 +132,12 @@ public:
 
   void release() { signal = Sample(0); }
 
+  Sample getKp() const { return filter.kp; }
   Sample process() { return filter.process(signal); }
+  Sample processStep(const EMAStep<Sample> &step)
+  {
+    return filter.processStep(signal, step);
+  }
 };
 
 } // namespace SomeDSP
@@ -0,0 +1,77 @@
+// (c) 2022 Takamitsu Endo
+//
+// This file is part of Uhhyou Plugins.
+//
+// Uhhyou Plugins is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Uhhyou Plugins is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Uhhyou Plugins.  If not, see <https://www.gnu.org/licenses/>.
+
+// Measures `DSPCore::process` with a held note and LFO modulation. Results are
+// nanoseconds per base rate sample. A checksum is printed to compare outputs between
+// builds.
+
+#include "../source/dsp/dspcore.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+constexpr size_t blockSize = 512;
+constexpr double renderSeconds = 2.0;
+
+double run(double sampleRate, double &checksum)
+{
+  using ID = Steinberg::Synth::ParameterID::ID;
+
+  auto dsp = std::make_unique<DSPCore>();
+  auto &pv = dsp->param.value;
+  pv[ID::lfoToPitch]->setFromNormalized(0.5);
+  pv[ID::lfoToCutoff]->setFromNormalized(0.5);
+  pv[ID::lfoToOscMix]->setFromNormalized(0.5);
+  pv[ID::lfoToOsc1WaveShape]->setFromNormalized(0.5);
+
+  dsp->setup(sampleRate);
+  dsp->setParameters();
+  dsp->pushMidiNote(true, 0, 0, 60, 0, 1.0f);
+
+  const size_t nFrame = size_t(sampleRate * renderSeconds);
+  std::vector<float> out0(blockSize);
+  std::vector<float> out1(blockSize);
+
+  checksum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t frame = 0; frame < nFrame; frame += blockSize) {
+    dsp->setParameters();
+    dsp->process(blockSize, out0.data(), out1.data());
+    for (size_t i = 0; i < blockSize; ++i) checksum += std::abs(out0[i]);
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  if (!std::isfinite(checksum)) std::cerr << "Error: Non-finite output.\n";
+  return std::chrono::duration<double, std::nano>(end - start).count() / double(nFrame);
+}
+
+int main()
+{
+  std::cout << std::fixed << std::setprecision(3);
+  for (double sampleRate : {48000.0, 96000.0}) {
+    double checksum = 0;
+    double ns = run(sampleRate, checksum);
+    std::cout << sampleRate << " Hz: " << ns << " ns/sample, checksum " << checksum
+              << "\n";
+  }
+  return EXIT_SUCCESS;
+}
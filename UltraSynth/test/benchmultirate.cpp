@@ -0,0 +1,170 @@
+// (c) 2022 Takamitsu Endo
+//
+// This file is part of Uhhyou Plugins.
+//
+// Uhhyou Plugins is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Uhhyou Plugins is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Uhhyou Plugins.  If not, see <https://www.gnu.org/licenses/>.
+
+// Compares scalar up/down samplers in `common/dsp/multirate.hpp` to lane parallel
+// ones. Each round trip is upsampling, copying to decimator input, then decimation.
+// Results are nanoseconds per base rate sample per channel.
+
+#include "../../common/dsp/multirate.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace SomeDSP;
+
+constexpr size_t nFrame = 1 << 17;
+constexpr size_t nChannel = 2;
+
+template<typename Sample> std::vector<Sample> makeInput()
+{
+  std::minstd_rand rng{0};
+  std::uniform_real_distribution<Sample> dist(Sample(-1), Sample(1));
+  std::vector<Sample> input(nChannel * nFrame);
+  for (auto &x : input) x = dist(rng);
+  return input;
+}
+
+template<typename Func> double measure(Func func)
+{
+  auto start = std::chrono::steady_clock::now();
+  double sum = func();
+  auto end = std::chrono::steady_clock::now();
+  if (!std::isfinite(sum)) std::cerr << "Error: Non-finite output.\n";
+  return std::chrono::duration<double, std::nano>(end - start).count()
+    / double(nFrame * nChannel);
+}
+
+// `Sos` is `void` for 2x which only uses half-band filter.
+template<typename Sample, size_t fold, typename Sos> double runScalar()
+{
+  auto input = makeInput<Sample>();
+
+  std::array<CubicUpSampler<Sample, fold>, nChannel> upSampler;
+  std::array<DownSampler<Sample, Sos>, nChannel> downSampler;
+
+  return measure([&]() {
+    double sum = 0;
+    for (size_t i = 0; i < nFrame; ++i) {
+      for (size_t c = 0; c < nChannel; ++c) {
+        upSampler[c].process(input[nChannel * i + c]);
+        downSampler[c].inputBuffer = upSampler[c].output;
+        sum += downSampler[c].process();
+      }
+    }
+    return sum;
+  });
+}
+
+template<typename Sample, size_t fold, typename Sos> double runParallel()
+{
+  auto input = makeInput<Sample>();
+
+  PolyphaseCubicUpSampler<Sample, nChannel, fold> upSampler;
+  PolyphaseDownSampler<Sample, nChannel, Sos> downSampler;
+
+  return measure([&]() {
+    double sum = 0;
+    std::array<Sample, nChannel> frame;
+    for (size_t i = 0; i < nFrame; ++i) {
+      for (size_t c = 0; c < nChannel; ++c) frame[c] = input[nChannel * i + c];
+      upSampler.process(frame);
+      downSampler.inputBuffer = upSampler.output;
+      frame = downSampler.process();
+      for (size_t c = 0; c < nChannel; ++c) sum += frame[c];
+    }
+    return sum;
+  });
+}
+
+template<typename Sample> double runScalar2x()
+{
+  auto input = makeInput<Sample>();
+
+  std::array<CubicUpSampler<Sample, 2>, nChannel> upSampler;
+  std::array<HalfBandIIR<Sample, HalfBandCoefficient<Sample>>, nChannel> halfband;
+
+  return measure([&]() {
+    double sum = 0;
+    for (size_t i = 0; i < nFrame; ++i) {
+      for (size_t c = 0; c < nChannel; ++c) {
+        upSampler[c].process(input[nChannel * i + c]);
+        sum += halfband[c].process(upSampler[c].output);
+      }
+    }
+    return sum;
+  });
+}
+
+template<typename Sample> double runParallel2x()
+{
+  auto input = makeInput<Sample>();
+
+  PolyphaseCubicUpSampler<Sample, nChannel, 2> upSampler;
+  PolyphaseDownSampler<Sample, nChannel, Sos8FoldFirstStage<Sample>> downSampler;
+
+  return measure([&]() {
+    double sum = 0;
+    std::array<Sample, nChannel> frame;
+    for (size_t i = 0; i < nFrame; ++i) {
+      for (size_t c = 0; c < nChannel; ++c) frame[c] = input[nChannel * i + c];
+      upSampler.process(frame);
+      for (size_t c = 0; c < nChannel; ++c) {
+        downSampler.inputBuffer[c][0] = upSampler.output[c][0];
+        downSampler.inputBuffer[c][1] = upSampler.output[c][1];
+      }
+      frame = downSampler.process2x();
+      for (size_t c = 0; c < nChannel; ++c) sum += frame[c];
+    }
+    return sum;
+  });
+}
+
+void print(const std::string &name, double scalar, double parallel)
+{
+  std::cout << std::setw(12) << name << std::setw(12) << scalar << std::setw(12)
+            << parallel << std::setw(10) << scalar / parallel << "\n";
+}
+
+template<typename Sample> void runAll(const std::string &type)
+{
+  print(type + " 2x", runScalar2x<Sample>(), runParallel2x<Sample>());
+  print(
+    type + " 8x", runScalar<Sample, 8, Sos8FoldFirstStage<Sample>>(),
+    runParallel<Sample, 8, Sos8FoldFirstStage<Sample>>());
+  print(
+    type + " 16x", runScalar<Sample, 16, Sos16FoldFirstStage<Sample>>(),
+    runParallel<Sample, 16, Sos16FoldFirstStage<Sample>>());
+  print(
+    type + " 64x", runScalar<Sample, 64, Sos64FoldFirstStage<Sample>>(),
+    runParallel<Sample, 64, Sos64FoldFirstStage<Sample>>());
+}
+
+int main()
+{
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << std::setw(12) << "fold" << std::setw(12) << "scalar[ns]" << std::setw(12)
+            << "parallel" << std::setw(10) << "speedup" << "\n";
+  runAll<float>("float");
+  runAll<double>("double");
+  return EXIT_SUCCESS;
+}
@@ -51,13 +51,11 @@ void DSPCore::setSystem()
     param.value[ParameterID::randomAmount]->getFloat());
 }
 
-DSPCore::DSPCore() { midiNotes.reserve(128); }
-
 void DSPCore::setup(double sampleRate)
 {
   this->sampleRate = float(sampleRate);
 
-  midiNotes.resize(0);
+  midiNotes.clear();
 
   SmootherCommon<float>::setSampleRate(this->sampleRate);
   SmootherCommon<float>::setTime(param.value[ParameterID::smoothness]->getFloat());
@@ -22,6 +22,7 @@
 #include "delay.hpp"
 #include "wave.hpp"
 
+#include <algorithm>
 #include <array>
 #include <cmath>
 
@@ -92,7 +93,10 @@ public:
     this->decay
       = frequency < Sample(1e-5) ? Sample(1.0) : std::pow(Sample(0.5), decay / frequency);
 
-    interpDelayTime.push(Sample(1.0) / frequency);
+    // Frequency may be 0 when randomization is at maximum. Infinite delay time makes
+    // `interpDelayTime` NaN on the next push if the ramp is active, that is when block
+    // size is shorter than the smoothing time.
+    interpDelayTime.push(Sample(1.0) / std::max(frequency, Sample(10)));
   }
 
   void reset()
@@ -26,6 +26,29 @@ function(build_test additional_sources)
     SndFile::sndfile
     ${src}
     fftw3)
+
+  # Offline renderer. Only for plugins which take MIDI notes.
+  if(EXISTS "${CMAKE_CURRENT_SOURCE_DIR}/test/batchrender.cpp")
+    set(render "batchrender_${PLUGIN_NAME}")
+    add_executable(${render} test/batchrender.cpp)
+    target_compile_definitions(${render} PRIVATE
+      UHHYOU_PLUGIN_NAME="${PLUGIN_NAME}")
+    target_link_libraries(${render} PRIVATE
+      SndFile::sndfile
+      ${src}
+      fftw3)
+  endif()
+
+  # CPU regression benchmark over presets, sample rates and block sizes.
+  if(EXISTS "${CMAKE_CURRENT_SOURCE_DIR}/test/benchpreset.cpp")
+    set(bench "benchpreset_${PLUGIN_NAME}")
+    add_executable(${bench} test/benchpreset.cpp)
+    target_compile_definitions(${bench} PRIVATE
+      UHHYOU_PLUGIN_NAME="${PLUGIN_NAME}")
+    target_link_libraries(${bench} PRIVATE
+      ${src}
+      fftw3)
+  endif()
 endfunction()
 
 function(build_vst3 plug_sources)
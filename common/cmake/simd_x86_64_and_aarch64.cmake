@@ -5,6 +5,51 @@ function(get_plugin_name NAME_VAR)
   set(${NAME_VAR} ${PLUGIN_NAME} PARENT_SCOPE)
 endfunction()
 
+# Compiles `source/dsp/dspcore.cpp` once for each instruction set, and adds them to
+# `target`. `dspcore.cpp` selects the class name from `INSTRSET` defined in VCL, and
+# `PlugProcessor` picks one of the factories by `instrset_detect()` at runtime.
+#
+# Each build puts VCL and the DSP code into namespaces of the instruction set. See
+# `common/dsp/isanamespace.hpp`.
+#
+# AVX-512 is only built on Linux. On aarch64, only `FixedInstruction` is built.
+function(add_dspcore_instruction_sets target)
+  if(NOT CMAKE_SYSTEM_PROCESSOR MATCHES "^(x86_64|AMD64)$")
+    target_sources(${target} PRIVATE source/dsp/dspcore.cpp)
+    return()
+  endif()
+
+  if(MSVC)
+    set(flags_avx /arch:AVX)
+    set(flags_avx2 /arch:AVX2)
+    set(instruction_sets avx avx2)
+  else()
+    set(flags_avx -mavx)
+    set(flags_avx2 -mavx2 -mfma)
+    set(flags_avx512 -mavx512f -mavx512bw -mavx512dq -mavx512vl -mfma)
+    if(UNIX AND NOT APPLE)
+      set(instruction_sets avx avx2 avx512)
+    else()
+      set(instruction_sets avx avx2)
+    endif()
+  endif()
+
+  foreach(iset ${instruction_sets})
+    set(lib "${target}_dspcore_${iset}")
+    add_library(${lib} OBJECT source/dsp/dspcore.cpp)
+    set_target_properties(${lib} PROPERTIES POSITION_INDEPENDENT_CODE ON)
+    target_compile_options(${lib} PRIVATE ${flags_${iset}})
+    target_compile_definitions(${lib} PRIVATE
+      VCL_NAMESPACE=vcl_${iset}
+      SOMEDSP_ISA_NAMESPACE=isa_${iset})
+    target_link_libraries(${lib} PRIVATE ${ARGN})
+    if(APPLE)
+      target_compile_options(${lib} PRIVATE -fno-aligned-allocation)
+    endif()
+    target_link_libraries(${target} PRIVATE ${lib})
+  endforeach()
+endfunction()
+
 function(build_test)
   find_package(SndFile CONFIG REQUIRED)
 
@@ -19,12 +64,35 @@ function(build_test)
   set(src "${target}_source")
   add_fftw3()
   add_library(${src}
-    source/parameter.cpp
-    source/dsp/dspcore.cpp)
+    source/parameter.cpp)
+  add_dspcore_instruction_sets(${src})
   target_link_libraries(${target} PRIVATE
     SndFile::sndfile
     ${src}
     fftw3)
+
+  # Offline renderer. Only for plugins which take MIDI notes.
+  if(EXISTS "${CMAKE_CURRENT_SOURCE_DIR}/test/batchrender.cpp")
+    set(render "batchrender_${PLUGIN_NAME}")
+    add_executable(${render} test/batchrender.cpp)
+    target_compile_definitions(${render} PRIVATE
+      UHHYOU_PLUGIN_NAME="${PLUGIN_NAME}")
+    target_link_libraries(${render} PRIVATE
+      SndFile::sndfile
+      ${src}
+      fftw3)
+  endif()
+
+  # CPU regression benchmark over presets, sample rates and block sizes.
+  if(EXISTS "${CMAKE_CURRENT_SOURCE_DIR}/test/benchpreset.cpp")
+    set(bench "benchpreset_${PLUGIN_NAME}")
+    add_executable(${bench} test/benchpreset.cpp)
+    target_compile_definitions(${bench} PRIVATE
+      UHHYOU_PLUGIN_NAME="${PLUGIN_NAME}")
+    target_link_libraries(${bench} PRIVATE
+      ${src}
+      fftw3)
+  endif()
 endfunction()
 
 function(build_vst3 plug_sources)
@@ -32,8 +100,8 @@ function(build_vst3 plug_sources)
   set(target ${PLUGIN_NAME})
 
   smtg_add_vst3plugin(${target}
-    source/dsp/dspcore.cpp
     ${plug_sources})
+  add_dspcore_instruction_sets(${target} base sdk)
   if(MSVC)
     ## Too many warnings are emitted from VST 3 SDK.
     target_compile_options(${target} PRIVATE /arch:AVX)
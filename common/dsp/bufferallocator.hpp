@@ -0,0 +1,215 @@
+// (c) 2022 Takamitsu Endo
+//
+// This file is part of Uhhyou Plugins.
+//
+// Uhhyou Plugins is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Uhhyou Plugins is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Uhhyou Plugins.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "isanamespace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace SomeDSP {
+SOMEDSP_ISA_NAMESPACE_BEGIN
+
+/**
+Allocates and frees `nBuffer` buffers on a worker thread, so that audio thread can grow
+its buffers without calling `new` or `delete`.
+
+Audio thread calls `request()`, `receive()` and `release()`. These don't lock, and the
+worker polls the state. Notifying condition variable from audio thread may lock, so
+it's avoided. One request is handled at a time:
+
+1. `request()` when `isIdle()`.
+2. `receive()` returns true after the worker allocated the buffers.
+3. `release()` hands the buffers back to the worker, which frees them.
+
+In test build, there's no worker. Buffers are allocated in `request()` and freed in
+`release()`, so the output doesn't depend on thread scheduling.
+*/
+template<typename Sample, size_t nBuffer> class BackgroundBufferAllocator {
+public:
+  using Buffers = std::array<std::vector<Sample>, nBuffer>;
+  using Sizes = std::array<size_t, nBuffer>;
+
+  BackgroundBufferAllocator()
+  {
+#ifndef TEST_DSP
+    worker = std::thread(&BackgroundBufferAllocator::workerLoop, this);
+#endif
+  }
+
+  ~BackgroundBufferAllocator()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      isTerminating = true;
+    }
+    condition.notify_one();
+    if (worker.joinable()) worker.join();
+  }
+
+  bool isIdle() const { return state.load(std::memory_order_acquire) == State::idle; }
+
+  // Called from audio thread. Buffers of size 0 are left empty.
+  void request(const Sizes &sizes)
+  {
+    if (!isIdle()) return;
+    requestSize = sizes;
+    state.store(State::requested, std::memory_order_release);
+#ifdef TEST_DSP
+    work();
+#endif
+  }
+
+  // Called from audio thread. Swaps the allocated buffers into empty `dest`.
+  bool receive(Buffers &dest)
+  {
+    if (state.load(std::memory_order_acquire) != State::prepared) return false;
+    for (size_t idx = 0; idx < nBuffer; ++idx) std::swap(prepared[idx], dest[idx]);
+    state.store(State::received, std::memory_order_release);
+    return true;
+  }
+
+  // Called from audio thread after `receive()`. `buffers` becomes empty.
+  void release(Buffers &buffers)
+  {
+    if (state.load(std::memory_order_acquire) != State::received) return;
+    for (size_t idx = 0; idx < nBuffer; ++idx) std::swap(released[idx], buffers[idx]);
+    state.store(State::released, std::memory_order_release);
+#ifdef TEST_DSP
+    work();
+#endif
+  }
+
+  /**
+  Cancels the ongoing request, and frees all buffers held by this and `buffers`. Waits
+  for the worker to finish allocation. Don't call it from audio thread.
+  */
+  void reset(Buffers &buffers)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &buf : prepared) buf = std::vector<Sample>();
+    for (auto &buf : released) buf = std::vector<Sample>();
+    for (auto &buf : buffers) buf = std::vector<Sample>();
+    state.store(State::idle, std::memory_order_release);
+  }
+
+private:
+  enum class State { idle, requested, prepared, received, released };
+
+  std::atomic<State> state{State::idle};
+  Sizes requestSize{};
+  Buffers prepared;
+  Buffers released;
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  bool isTerminating = false;
+  std::thread worker;
+
+  void work()
+  {
+    auto current = state.load(std::memory_order_acquire);
+    if (current == State::requested) {
+      for (size_t idx = 0; idx < nBuffer; ++idx) {
+        prepared[idx].assign(requestSize[idx], Sample(0));
+      }
+      state.store(State::prepared, std::memory_order_release);
+    } else if (current == State::released) {
+      for (auto &buf : released) buf = std::vector<Sample>();
+      state.store(State::idle, std::memory_order_release);
+    }
+  }
+
+  void workerLoop()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!isTerminating) {
+      condition.wait_for(lock, std::chrono::milliseconds(10));
+      work();
+    }
+  }
+};
+
+/**
+Moves the history of a ring buffer into a larger one, while the ring buffer is in use.
+
+A frame is `frameSize` contiguous samples. History is copied `rate` frames at a time
+from the youngest, before each write. Meanwhile, the caller writes the input to both
+buffers, and keeps reading from the old buffer. The copy ends before the old buffer
+overwrites the frames not yet copied, so no history is lost. Only `nHistory` frames
+written after the last reset are copied, so an empty buffer can be swapped at once.
+
+The youngest frame at `start()` is placed right before `nextWptr`, so `oldSize` frames
+of history fit in the new buffer without wrapping around.
+*/
+struct RingBufferGrowth {
+  bool isActive = false;
+  size_t oldSize = 0;
+  size_t startWptr = 0;
+  size_t nextWptr = 0; // Write position of the new buffer.
+  size_t nHistory = 0;
+  size_t nCopied = 0;
+  size_t nElapsed = 0;
+
+  void start(size_t size, size_t wptr, size_t nWritten)
+  {
+    isActive = true;
+    oldSize = size;
+    startWptr = wptr;
+    nextWptr = size;
+    nHistory = std::min(size, nWritten);
+    nCopied = 0;
+    nElapsed = 0;
+  }
+
+  // Frames older than `oldSize - nElapsed` are already overwritten.
+  bool isDone() const { return nCopied >= std::min(nHistory, oldSize - nElapsed); }
+
+  // Called before writing a frame.
+  template<typename Sample>
+  void copyHistory(const Sample *src, Sample *dest, size_t frameSize, size_t rate)
+  {
+    const auto end = std::min(nCopied + rate, std::min(nHistory, oldSize - nElapsed));
+    for (; nCopied < end; ++nCopied) {
+      const auto age = nCopied + 1;
+      const auto from = startWptr >= age ? startWptr - age : startWptr + oldSize - age;
+      const auto to = oldSize - age;
+      for (size_t idx = 0; idx < frameSize; ++idx) {
+        dest[to * frameSize + idx] = src[from * frameSize + idx];
+      }
+    }
+  }
+
+  // Called after writing a frame.
+  void advance(size_t newSize)
+  {
+    if (++nextWptr >= newSize) nextWptr = 0;
+    ++nElapsed;
+  }
+};
+
+SOMEDSP_ISA_NAMESPACE_END
+} // namespace SomeDSP
@@ -0,0 +1,87 @@
+// (c) 2022 Takamitsu Endo
+//
+// This file is part of Uhhyou Plugins.
+//
+// Uhhyou Plugins is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Uhhyou Plugins is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Uhhyou Plugins.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+
+#if defined(__arm64__) || defined(__aarch64__)
+#elif defined(_MSC_VER)
+  #include <intrin.h>
+#else
+  #include <immintrin.h>
+#endif
+
+namespace SomeDSP {
+
+/**
+Sets flush-to-zero (FTZ) and denormals-are-zero (DAZ) on the current thread while the
+object is alive, and restores the previous state on destruction.
+
+Exponentially decaying feedback, like reverb tail or one-pole filter on silence, falls
+into subnormal range. On x86_64, arithmetic on subnormal numbers is much slower than
+normal numbers. Place this at the top of `PlugProcessor::process()`, and at the start
+of each worker thread.
+
+- x86_64: Sets FTZ and DAZ bits in MXCSR. Only affects SSE/AVX, not x87.
+- aarch64: Sets FZ bit in FPCR. There's no separate DAZ bit; FZ flushes both inputs
+  and outputs.
+- Others: No-op.
+*/
+class ScopedNoDenormals {
+#if defined(__arm64__) || defined(__aarch64__)
+  static constexpr uint64_t flushToZero = uint64_t(1) << 24;
+  uint64_t previous = 0;
+
+  static uint64_t getState()
+  {
+    uint64_t state;
+    asm volatile("mrs %0, fpcr" : "=r"(state));
+    return state;
+  }
+
+  static void setState(uint64_t state) { asm volatile("msr fpcr, %0" : : "r"(state)); }
+#elif defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+  static constexpr uint32_t flushToZero = 0x8040; // FTZ (bit 15) and DAZ (bit 6).
+  uint32_t previous = 0;
+
+  static uint32_t getState() { return _mm_getcsr(); }
+  static void setState(uint32_t state) { _mm_setcsr(state); }
+#else
+  static constexpr uint32_t flushToZero = 0;
+  uint32_t previous = 0;
+
+  static uint32_t getState() { return 0; }
+  static void setState(uint32_t) {}
+#endif
+
+public:
+  ScopedNoDenormals() : previous(getState())
+  {
+    if ((previous & flushToZero) != flushToZero) setState(previous | flushToZero);
+  }
+
+  ~ScopedNoDenormals()
+  {
+    if ((previous & flushToZero) != flushToZero) setState(previous);
+  }
+
+  ScopedNoDenormals(const ScopedNoDenormals &) = delete;
+  ScopedNoDenormals &operator=(const ScopedNoDenormals &) = delete;
+};
+
+} // namespace SomeDSP
@@ -0,0 +1,117 @@
+// (c) 2022 Takamitsu Endo
+//
+// This file is part of Uhhyou Plugins.
+//
+// Uhhyou Plugins is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Uhhyou Plugins is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Uhhyou Plugins.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace SomeDSP {
+
+/**
+Fixed capacity ring buffer of MIDI events sorted by `Event::frame`.
+
+`push()` appends to the back in O(1). Hosts usually send events in order. If not, the
+ring is sorted once with `std::sort` before the next read. Events of the same frame
+are kept in the order of arrival. When the ring is full, new events are dropped.
+
+`dispatch(frame, func)` consumes all events up to `frame` from the front. When called
+on each sample, the cost is a single comparison on the frames without event.
+
+No allocation happens after construction. All methods are meant to be called from
+the audio thread.
+*/
+template<typename Event, size_t capacity = 4096> class MidiEventRing {
+  static_assert(
+    capacity > 0 && (capacity & (capacity - 1)) == 0,
+    "MidiEventRing: capacity must be a power of 2.");
+
+  static constexpr size_t mask = capacity - 1;
+
+  struct Slot {
+    Event event;
+    uint32_t order; // Order of arrival.
+  };
+
+  std::array<Slot, capacity> buffer{};
+  size_t head = 0;
+  size_t count = 0;
+  uint32_t nPushed = 0;
+  bool isSorted = true;
+
+  void sort()
+  {
+    if (isSorted) return;
+    isSorted = true;
+
+    std::rotate(buffer.begin(), buffer.begin() + head, buffer.end());
+    head = 0;
+    std::sort(buffer.begin(), buffer.begin() + count, [](const Slot &a, const Slot &b) {
+      return a.event.frame < b.event.frame
+        || (a.event.frame == b.event.frame && a.order - b.order > (uint32_t(1) << 31));
+    });
+  }
+
+public:
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+
+  void clear()
+  {
+    head = 0;
+    count = 0;
+    isSorted = true;
+  }
+
+  // Returns false if the ring is full and `event` is dropped.
+  bool push(const Event &event)
+  {
+    if (count >= capacity) return false;
+
+    if (count > 0 && buffer[(head + count - 1) & mask].event.frame > event.frame) {
+      isSorted = false;
+    }
+    buffer[(head + count) & mask] = {event, nPushed++};
+    ++count;
+    return true;
+  }
+
+  // Frame of the earliest event. Returns max value of `size_t` when empty.
+  size_t nextFrame()
+  {
+    if (count == 0) return std::numeric_limits<size_t>::max();
+    sort();
+    return size_t(buffer[head].event.frame);
+  }
+
+  template<typename Func> void dispatch(size_t frame, Func func)
+  {
+    if (count == 0) return;
+    sort();
+    while (count > 0 && size_t(buffer[head].event.frame) <= frame) {
+      auto &event = buffer[head].event;
+      head = (head + 1) & mask;
+      --count;
+      func(event);
+    }
+  }
+};
+
+} // namespace SomeDSP
@@ -0,0 +1,245 @@
+// (c) 2022 Takamitsu Endo
+//
+// This file is part of Uhhyou Plugins.
+//
+// Uhhyou Plugins is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Uhhyou Plugins is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Uhhyou Plugins.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "constants.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace SomeDSP {
+
+/**
+Approximation of `tan(pi * x)`. `x` is normalized frequency in [0, 0.5).
+
+[5/4] Padé approximant of tan on [0, pi/4], and `tan(pi * x) = 1 / tan(pi * (0.5 - x))`
+on [0.25, 0.5). Maximum relative error is 1.4e-8 for double, and 2.9e-7 for float which
+is mostly rounding. There's no branch, so loops over arrays are vectorized.
+*/
+template<typename Sample> inline Sample tanPiApprox(Sample x)
+{
+  auto z = Sample(pi) * std::min(x, Sample(0.5) - x);
+  auto z2 = z * z;
+  auto num = z * (Sample(945) + z2 * (Sample(-105) + z2));
+  auto den = Sample(945) + z2 * (Sample(-420) + Sample(15) * z2);
+  bool isUpper = x > Sample(0.25);
+  return (isUpper ? den : num) / (isUpper ? num : den);
+}
+
+/**
+Approximation of `sinh(x)`.
+
+Evaluates Taylor series of sinh and cosh at `x / 16`, then doubles the argument 4 times
+with `sinh(2y) = 2 sinh(y) cosh(y)` and `cosh(2y) = 1 + 2 sinh(y)^2`. Maximum relative
+error for |x| <= 8 is 6.8e-8 for double, and 1.4e-6 for float. The error grows outside
+of the range, and reaches 2.4e-5 at |x| = 16. There's no branch.
+*/
+template<typename Sample> inline Sample sinhApprox(Sample x)
+{
+  auto y = x * Sample(1.0 / 16.0);
+  auto y2 = y * y;
+  auto s = y
+    * (Sample(1)
+       + y2
+         * (Sample(1.0 / 6.0)
+            + y2 * (Sample(1.0 / 120.0) + y2 * Sample(1.0 / 5040.0))));
+  auto c = Sample(1)
+    + y2
+      * (Sample(1.0 / 2.0)
+         + y2
+           * (Sample(1.0 / 24.0)
+              + y2 * (Sample(1.0 / 720.0) + y2 * Sample(1.0 / 40320.0))));
+  for (int i = 0; i < 4; ++i) {
+    auto s2 = Sample(2) * s * c;
+    c = Sample(1) + Sample(2) * s * s;
+    s = s2;
+  }
+  return s;
+}
+
+/**
+Coefficients of `nLane` TPT SVF, `g = tan(pi * normalizedFreq)` and `k`, updated at
+control rate. `k` is `1 / Q` for the usual form, and it's interpolated as is.
+
+`setTarget()` is cheap, so it can be called on every sample. `process()` recomputes `g`
+with `tanPiApprox()` only on lanes where the last ramp has ended and the target has
+changed since the last computation. Then `g` and `k` linearly ramp to the new values in
+`interval` samples. Both stay between 2 stable values during the ramp, so the filter
+stays stable while sweeping.
+
+Masked updates are split into loops of arithmetic and loops of selects, so that GCC
+vectorizes all of them.
+
+```
+ramp.setTarget(lane, cutoffHz / sampleRate, 1 / Q); // For each lane.
+if (ramp.process(0, nActive)) {
+  // Updates filters with `ramp.g` and `ramp.k`.
+}
+```
+*/
+template<typename Sample, size_t nLane> class SVFCoefficientRamp {
+public:
+  std::array<Sample, nLane> g{};
+  std::array<Sample, nLane> k{};
+
+  SVFCoefficientRamp() { isFresh.fill(1); }
+
+  void setInterval(size_t samples)
+  {
+    interval = std::max(samples, size_t(1));
+    invInterval = Sample(1) / Sample(interval);
+  }
+
+  // Next `process()` jumps to the target without ramp.
+  void reset(size_t lane)
+  {
+    counter[lane] = 0;
+    isFresh[lane] = 1;
+  }
+
+  // Jumps to the value immediately.
+  void reset(size_t lane, Sample normalizedFreq, Sample kValue)
+  {
+    freqIn[lane] = freqEnd[lane] = normalizedFreq;
+    kIn[lane] = kEnd[lane] = kValue;
+    g[lane] = gEnd[lane] = tanPiApprox(normalizedFreq);
+    k[lane] = kValue;
+    counter[lane] = 0;
+    isFresh[lane] = 0;
+  }
+
+  // `normalizedFreq` is in [0, 0.5).
+  void setTarget(size_t lane, Sample normalizedFreq, Sample kValue)
+  {
+    freqIn[lane] = normalizedFreq;
+    kIn[lane] = kValue;
+  }
+
+  // Advances lanes in `[begin, end)` by 1 sample. Returns true when `g` or `k` changed.
+  bool process(size_t begin, size_t end)
+  {
+    int32_t isUpdating = 0;
+    for (size_t idx = begin; idx < end; ++idx) {
+      int32_t isChanged = int32_t(freqIn[idx] != freqEnd[idx])
+        | int32_t(kIn[idx] != kEnd[idx]) | isFresh[idx];
+      needUpdate[idx] = int32_t(counter[idx] == 0) & isChanged;
+      isUpdating |= needUpdate[idx];
+    }
+    if (isUpdating) update(begin, end);
+
+    std::array<Sample, nLane> gNext;
+    std::array<Sample, nLane> kNext;
+    for (size_t idx = begin; idx < end; ++idx) {
+      gNext[idx] = g[idx] + dg[idx];
+      kNext[idx] = k[idx] + dk[idx];
+    }
+
+    int32_t isRamping = 0;
+    for (size_t idx = begin; idx < end; ++idx) {
+      auto cnt = counter[idx];
+      auto vg = g[idx];
+      auto vk = k[idx];
+      auto ng = gNext[idx];
+      auto nk = kNext[idx];
+      auto gt = gEnd[idx];
+      auto kt = kEnd[idx];
+      bool isLast = cnt == 1;
+      bool isActive = cnt > 0;
+      ng = isLast ? gt : ng;
+      nk = isLast ? kt : nk;
+      g[idx] = isActive ? ng : vg;
+      k[idx] = isActive ? nk : vk;
+      counter[idx] = isActive ? cnt - 1 : cnt;
+      isRamping |= int32_t(isActive);
+    }
+    return isUpdating | isRamping;
+  }
+
+private:
+  void update(size_t begin, size_t end)
+  {
+    std::array<Sample, nLane> gNew;
+    for (size_t idx = begin; idx < end; ++idx) gNew[idx] = tanPiApprox(freqIn[idx]);
+
+    for (size_t idx = begin; idx < end; ++idx) {
+      auto gn = gNew[idx];
+      auto kn = kIn[idx];
+      auto fn = freqIn[idx];
+      auto gt = gEnd[idx];
+      auto kt = kEnd[idx];
+      auto fq = freqEnd[idx];
+      bool isUpdate = needUpdate[idx] != 0;
+      gEnd[idx] = isUpdate ? gn : gt;
+      kEnd[idx] = isUpdate ? kn : kt;
+      freqEnd[idx] = isUpdate ? fn : fq;
+    }
+    for (size_t idx = begin; idx < end; ++idx) {
+      auto gt = gEnd[idx];
+      auto kt = kEnd[idx];
+      auto vg = g[idx];
+      auto vk = k[idx];
+      bool isJump = (needUpdate[idx] & isFresh[idx]) != 0;
+      g[idx] = isJump ? gt : vg;
+      k[idx] = isJump ? kt : vk;
+    }
+
+    const int32_t length = int32_t(interval);
+    for (size_t idx = begin; idx < end; ++idx) {
+      auto update = needUpdate[idx];
+      auto fresh = isFresh[idx];
+      counter[idx] = (update & ~fresh) != 0 ? length : counter[idx];
+      isFresh[idx] = fresh & ~update;
+    }
+
+    // Lanes still ramping keep their slope. Otherwise they end up off the target and
+    // snap at the last sample.
+    std::array<Sample, nLane> dgNew;
+    std::array<Sample, nLane> dkNew;
+    for (size_t idx = begin; idx < end; ++idx) {
+      dgNew[idx] = (gEnd[idx] - g[idx]) * invInterval;
+      dkNew[idx] = (kEnd[idx] - k[idx]) * invInterval;
+    }
+    for (size_t idx = begin; idx < end; ++idx) {
+      auto dgn = dgNew[idx];
+      auto dkn = dkNew[idx];
+      auto dgv = dg[idx];
+      auto dkv = dk[idx];
+      bool isUpdate = needUpdate[idx] != 0;
+      dg[idx] = isUpdate ? dgn : dgv;
+      dk[idx] = isUpdate ? dkn : dkv;
+    }
+  }
+
+  size_t interval = 1;
+  Sample invInterval = Sample(1);
+
+  std::array<Sample, nLane> freqIn{};
+  std::array<Sample, nLane> kIn{};
+  std::array<Sample, nLane> freqEnd{};
+  std::array<Sample, nLane> kEnd{};
+  std::array<Sample, nLane> gEnd{};
+  std::array<Sample, nLane> dg{};
+  std::array<Sample, nLane> dk{};
+  std::array<int32_t, nLane> counter{};
+  std::array<int32_t, nLane> needUpdate{};
+  std::array<int32_t, nLane> isFresh{};
+};
+
+} // namespace SomeDSP
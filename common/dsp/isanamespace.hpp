@@ -0,0 +1,37 @@
+// (c) 2022 Takamitsu Endo
+//
+// This file is part of Uhhyou Plugins.
+//
+// Uhhyou Plugins is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Uhhyou Plugins is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Uhhyou Plugins.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+/**
+`add_dspcore_instruction_sets()` in `common/cmake/simd_x86_64_and_aarch64.cmake` builds
+`dspcore.cpp` once for each instruction set. Each build defines `SOMEDSP_ISA_NAMESPACE`,
+and `VCL_NAMESPACE` for VCL.
+
+Code built in `dspcore.cpp` is put into the inline namespace `SOMEDSP_ISA_NAMESPACE`.
+Otherwise, inline functions of the same name are merged by the linker, and a copy built
+for an instruction set which the CPU doesn't support may be called.
+
+Other builds don't define `SOMEDSP_ISA_NAMESPACE`, and these macros expand to nothing.
+*/
+#ifdef SOMEDSP_ISA_NAMESPACE
+  #define SOMEDSP_ISA_NAMESPACE_BEGIN inline namespace SOMEDSP_ISA_NAMESPACE {
+  #define SOMEDSP_ISA_NAMESPACE_END }
+#else
+  #define SOMEDSP_ISA_NAMESPACE_BEGIN
+  #define SOMEDSP_ISA_NAMESPACE_END
+#endif
@@ -258,4 +258,268 @@ template<typename Sample, typename FirstStageSosCoefficient> struct DownSampler
   Sample process2x() { return halfbandIir.process({inputBuffer[0], inputBuffer[1]}); }
 };
 
+/*
+Lane parallel multirate classes below process `nChannel` channels at once. States are
+laid out so that the innermost loops run over sub-samples, filter sections or channels
+without dependency between iterations. They compile to SIMD without intrinsics, and
+work for both float and double.
+
+Arithmetic is the same as the scalar classes above, except `PolyphaseCubicUpSampler`
+which uses precomputed weights.
+*/
+
+template<typename Sample, size_t upSample>
+constexpr std::array<std::array<Sample, upSample>, 4> makeCubicUpSamplerWeight()
+{
+  // Weights of `CubicUpSampler::cubicInterp`. Computed by feeding unit impulses.
+  std::array<std::array<Sample, upSample>, 4> weight{};
+  for (size_t k = 0; k < 4; ++k) {
+    double y[4]{};
+    y[k] = 1;
+    for (size_t i = 0; i < upSample; ++i) {
+      auto u = 1 + double(i) / double(upSample);
+      auto d0 = y[0] - y[1];
+      auto d1 = d0 - (y[1] - y[2]);
+      auto d2 = d1 - ((y[1] - y[2]) - (y[2] - y[3]));
+      weight[k][i] = Sample(y[0] - ((d2 * (2 - u) / 3 + d1) * (1 - u) / 2 + d0) * u);
+    }
+  }
+  return weight;
+}
+
+/**
+3rd order Lagrange upsampler as 4 tap polyphase FIR. `output[channel][phase]`.
+`output[channel][0]` is exactly the input delayed by 2 samples.
+*/
+template<typename Sample, size_t nChannel, size_t upSample>
+class PolyphaseCubicUpSampler {
+  static constexpr std::array<std::array<Sample, upSample>, 4> weight
+    = makeCubicUpSamplerWeight<Sample, upSample>();
+
+  std::array<std::array<Sample, 4>, nChannel> buf{};
+
+public:
+  std::array<std::array<Sample, upSample>, nChannel> output{};
+
+  void reset()
+  {
+    buf.fill({});
+    output.fill({});
+  }
+
+  void process(const std::array<Sample, nChannel> &input)
+  {
+    for (size_t c = 0; c < nChannel; ++c) {
+      auto &b = buf[c];
+      b[0] = b[1];
+      b[1] = b[2];
+      b[2] = b[3];
+      b[3] = input[c];
+
+      auto &out = output[c];
+      for (size_t i = 0; i < upSample; ++i) {
+        out[i] = weight[0][i] * b[0] + weight[1][i] * b[1] + weight[2][i] * b[2]
+          + weight[3][i] * b[3];
+      }
+    }
+  }
+};
+
+/**
+Multi-channel version of `DecimationLowpass`. Sections are pipelined in the same way,
+so all `Sos::co.size() * nChannel` lanes are updated in a single loop. Lane index is
+`section * nChannel + channel`.
+*/
+template<typename Sample, size_t nChannel, typename Sos> class ParallelDecimationLowpass {
+  static constexpr size_t nLane = Sos::co.size() * nChannel;
+
+  static constexpr std::array<std::array<Sample, nLane>, 5> makeCoefficient()
+  {
+    std::array<std::array<Sample, nLane>, 5> laneCo{};
+    for (size_t k = 0; k < 5; ++k) {
+      for (size_t i = 0; i < nLane; ++i) laneCo[k][i] = Sos::co[i / nChannel][k];
+    }
+    return laneCo;
+  }
+
+  std::array<Sample, nLane> x0{};
+  std::array<Sample, nLane> x1{};
+  std::array<Sample, nLane> x2{};
+  std::array<Sample, nLane> y0{};
+  std::array<Sample, nLane> y1{};
+  std::array<Sample, nLane> y2{};
+
+public:
+  void reset()
+  {
+    x0.fill(0);
+    x1.fill(0);
+    x2.fill(0);
+    y0.fill(0);
+    y1.fill(0);
+    y2.fill(0);
+  }
+
+  void push(const std::array<Sample, nChannel> &input) noexcept
+  {
+    static constexpr auto co = makeCoefficient();
+
+    std::copy(input.begin(), input.end(), x0.begin());
+    std::copy(y0.begin(), y0.end() - nChannel, x0.begin() + nChannel);
+
+    for (size_t i = 0; i < nLane; ++i) {
+      y0[i]                //
+        = co[0][i] * x0[i] //
+        + co[1][i] * x1[i] //
+        + co[2][i] * x2[i] //
+        - co[3][i] * y1[i] //
+        - co[4][i] * y2[i];
+    }
+
+    x2 = x1;
+    x1 = x0;
+    y2 = y1;
+    y1 = y0;
+  }
+
+  inline Sample output(size_t channel) { return y0[nLane - nChannel + channel]; }
+};
+
+/**
+Multi-channel version of `HalfBandIIR`. Both allpass branches of all channels are
+processed side by side. Lane index is `branch * nChannel + channel`.
+*/
+template<typename Sample, size_t nChannel, typename Coefficient>
+class ParallelHalfBandIIR {
+  static constexpr size_t nLane = 2 * nChannel;
+  static constexpr size_t nCommon
+    = std::min(Coefficient::h0_a.size(), Coefficient::h1_a.size());
+  static constexpr size_t nStage
+    = std::max(Coefficient::h0_a.size(), Coefficient::h1_a.size());
+
+  static constexpr std::array<std::array<Sample, nLane>, nStage> makeCoefficient()
+  {
+    std::array<std::array<Sample, nLane>, nStage> laneCo{};
+    for (size_t s = 0; s < nStage; ++s) {
+      for (size_t c = 0; c < nChannel; ++c) {
+        if (s < Coefficient::h0_a.size()) laneCo[s][c] = Coefficient::h0_a[s];
+        if (s < Coefficient::h1_a.size()) laneCo[s][nChannel + c] = Coefficient::h1_a[s];
+      }
+    }
+    return laneCo;
+  }
+
+  std::array<std::array<Sample, nLane>, nStage> x1{};
+  std::array<std::array<Sample, nLane>, nStage> y1{};
+
+public:
+  void reset()
+  {
+    x1.fill({});
+    y1.fill({});
+  }
+
+  // input0 must be earlier sample.
+  std::array<Sample, nChannel> process(
+    const std::array<Sample, nChannel> &input0,
+    const std::array<Sample, nChannel> &input1)
+  {
+    static constexpr auto co = makeCoefficient();
+
+    std::array<Sample, nLane> sig;
+    std::copy(input0.begin(), input0.end(), sig.begin());
+    std::copy(input1.begin(), input1.end(), sig.begin() + nChannel);
+
+    for (size_t s = 0; s < nCommon; ++s) {
+      for (size_t i = 0; i < nLane; ++i) {
+        y1[s][i] = co[s][i] * (sig[i] - y1[s][i]) + x1[s][i];
+        x1[s][i] = sig[i];
+        sig[i] = y1[s][i];
+      }
+    }
+
+    // Remaining stages of the longer branch.
+    constexpr size_t first = Coefficient::h0_a.size() > nCommon ? 0 : nChannel;
+    for (size_t s = nCommon; s < nStage; ++s) {
+      for (size_t i = first; i < first + nChannel; ++i) {
+        y1[s][i] = co[s][i] * (sig[i] - y1[s][i]) + x1[s][i];
+        x1[s][i] = sig[i];
+        sig[i] = y1[s][i];
+      }
+    }
+
+    std::array<Sample, nChannel> output;
+    for (size_t c = 0; c < nChannel; ++c) {
+      output[c] = Sample(0.5) * (sig[c] + sig[nChannel + c]);
+    }
+    return output;
+  }
+};
+
+/**
+Block oriented multi-channel version of `DownSampler`. Fill `inputBuffer[channel][i]`,
+then call `process()` or `processLeading()` for `fold` times decimation, or
+`process2x()` which only reads `inputBuffer[channel][0]` and `inputBuffer[channel][1]`.
+*/
+template<typename Sample, size_t nChannel, typename FirstStageSosCoefficient>
+struct PolyphaseDownSampler {
+  static constexpr size_t fold = 2 * FirstStageSosCoefficient::fold;
+
+  std::array<std::array<Sample, fold>, nChannel> inputBuffer{};
+  ParallelDecimationLowpass<Sample, nChannel, FirstStageSosCoefficient> lowpass;
+  ParallelHalfBandIIR<Sample, nChannel, HalfBandCoefficient<Sample>> halfbandIir;
+
+  void reset()
+  {
+    inputBuffer.fill({});
+    lowpass.reset();
+    halfbandIir.reset();
+  }
+
+  std::array<Sample, nChannel> process()
+  {
+    std::array<std::array<Sample, nChannel>, 2> halfBandInput;
+    for (size_t half = 0; half < 2; ++half) {
+      for (size_t i = half * fold / 2; i < (half + 1) * fold / 2; ++i) {
+        std::array<Sample, nChannel> frame;
+        for (size_t c = 0; c < nChannel; ++c) frame[c] = inputBuffer[c][i];
+        lowpass.push(frame);
+      }
+      for (size_t c = 0; c < nChannel; ++c) halfBandInput[half][c] = lowpass.output(c);
+    }
+    return halfbandIir.process(halfBandInput[0], halfBandInput[1]);
+  }
+
+  /**
+  Same as `process()`, except that the half-band filter reads the lowpass output right
+  after the first sub-sample of each half, instead of the last. FeedbackPhaser and
+  NarrowingDelay decimate in this phase.
+  */
+  std::array<Sample, nChannel> processLeading()
+  {
+    std::array<std::array<Sample, nChannel>, 2> halfBandInput;
+    for (size_t half = 0; half < 2; ++half) {
+      for (size_t i = half * fold / 2; i < (half + 1) * fold / 2; ++i) {
+        std::array<Sample, nChannel> frame;
+        for (size_t c = 0; c < nChannel; ++c) frame[c] = inputBuffer[c][i];
+        lowpass.push(frame);
+        if (i != half * fold / 2) continue;
+        for (size_t c = 0; c < nChannel; ++c) halfBandInput[half][c] = lowpass.output(c);
+      }
+    }
+    return halfbandIir.process(halfBandInput[0], halfBandInput[1]);
+  }
+
+  std::array<Sample, nChannel> process2x()
+  {
+    std::array<Sample, nChannel> input0;
+    std::array<Sample, nChannel> input1;
+    for (size_t c = 0; c < nChannel; ++c) {
+      input0[c] = inputBuffer[c][0];
+      input1[c] = inputBuffer[c][1];
+    }
+    return halfbandIir.process(input0, input1);
+  }
+};
+
 } // namespace SomeDSP
@@ -0,0 +1,173 @@
+// (c) 2022 Takamitsu Endo
+//
+// This file is part of Uhhyou Plugins.
+//
+// Uhhyou Plugins is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Uhhyou Plugins is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Uhhyou Plugins.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "isanamespace.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace SomeDSP {
+SOMEDSP_ISA_NAMESPACE_BEGIN
+
+/**
+Visits the fields of a cache key. `Key` provides `visit(visitor)` which calls `add()`
+on each field, and `Derived` implements `bytes()`. Floats are visited by bit pattern,
+except that -0 is folded into +0 to be consistent with `operator==`.
+*/
+template<typename Derived> struct CacheKeyVisitor {
+  template<typename T> void add(T x)
+  {
+    static_assert(std::is_arithmetic<T>::value, "CacheKeyVisitor: T must be a number.");
+    static_cast<Derived *>(this)->bytes(&x, sizeof(T));
+  }
+
+  void add(float x)
+  {
+    if (x == 0) x = 0;
+    static_cast<Derived *>(this)->bytes(&x, sizeof(float));
+  }
+
+  template<typename Array> void addArray(const Array &array)
+  {
+    add(uint64_t(array.size()));
+    for (const auto &x : array) add(x);
+  }
+};
+
+// FNV-1a hash.
+struct CacheHasher : public CacheKeyVisitor<CacheHasher> {
+  uint64_t value = 14695981039346656037ull;
+
+  void bytes(const void *data, size_t size)
+  {
+    auto ptr = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; ++i) {
+      value ^= ptr[i];
+      value *= 1099511628211ull;
+    }
+  }
+};
+
+// Serialized key. Used to detect hash collision on persistent storage.
+struct CacheKeySerializer : public CacheKeyVisitor<CacheKeySerializer> {
+  std::vector<uint8_t> data;
+
+  void bytes(const void *src, size_t size)
+  {
+    auto ptr = static_cast<const uint8_t *>(src);
+    data.insert(data.end(), ptr, ptr + size);
+  }
+};
+
+template<typename Key> struct CacheKeyHash {
+  size_t operator()(const Key &key) const
+  {
+    CacheHasher hasher;
+    key.visit(hasher);
+    return size_t(hasher.value);
+  }
+};
+
+/**
+Process-wide cache of read-only data shared by plugin instances. Intended for large
+tables such as PADsynth wavetables, so that memory grows with the number of distinct
+sounds rather than the number of instances.
+
+`acquire()` returns a reference counted pointer. The entry is freed when the last
+owner drops it, on the thread that drops it. The map only holds weak references.
+
+`Key` must provide `operator==` and `Key::Hash`, which is usually `CacheKeyHash`.
+`Value` must be default constructible. Building is done outside of the map lock, so
+instances requesting different keys don't block each other. Instances requesting the
+same key wait for the first builder.
+*/
+template<typename Key, typename Value> class SharedCache {
+  struct Entry {
+    std::mutex buildMutex;
+    bool isBuilt = false;
+    Value value;
+  };
+
+  std::mutex mapMutex;
+  std::unordered_map<Key, std::weak_ptr<Entry>, typename Key::Hash> map;
+
+  SharedCache() {}
+
+public:
+  SharedCache(const SharedCache &) = delete;
+  SharedCache &operator=(const SharedCache &) = delete;
+
+  static SharedCache &instance()
+  {
+    static SharedCache cache;
+    return cache;
+  }
+
+  // `build(const Key &, Value &)` is called only when `key` is not in the cache.
+  template<typename Build>
+  std::shared_ptr<const Value> acquire(const Key &key, Build build)
+  {
+    std::shared_ptr<Entry> entry;
+    {
+      std::lock_guard<std::mutex> lock(mapMutex);
+
+      for (auto it = map.begin(); it != map.end();) {
+        if (it->second.expired())
+          it = map.erase(it);
+        else
+          ++it;
+      }
+
+      auto &slot = map[key];
+      entry = slot.lock();
+      if (!entry) {
+        entry = std::make_shared<Entry>();
+        slot = entry;
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(entry->buildMutex);
+      if (!entry->isBuilt) {
+        build(key, entry->value);
+        entry->isBuilt = true;
+      }
+    }
+
+    // Aliasing constructor. Shares ownership of `entry`.
+    return std::shared_ptr<const Value>(entry, &entry->value);
+  }
+
+  size_t size()
+  {
+    std::lock_guard<std::mutex> lock(mapMutex);
+    size_t count = 0;
+    for (const auto &it : map) count += !it.second.expired();
+    return count;
+  }
+};
+
+SOMEDSP_ISA_NAMESPACE_END
+} // namespace SomeDSP
@@ -18,13 +18,24 @@
 #pragma once
 
 #include "constants.hpp"
+#include "isanamespace.hpp"
 
 #include <algorithm>
 #include <array>
 #include <cmath>
 #include <limits>
 
+// Test builds render several `DSPCore` in parallel, each on its own thread, so the
+// state of `SmootherCommon` is per thread. Plugin hosts may call `setup()` and
+// `process()` from different threads, so plugins keep a single shared state.
+#ifdef TEST_DSP
+  #define SOMEDSP_SMOOTHER_STORAGE thread_local
+#else
+  #define SOMEDSP_SMOOTHER_STORAGE
+#endif
+
 namespace SomeDSP {
+SOMEDSP_ISA_NAMESPACE_BEGIN
 
 // Exponential moving average filter.
 template<typename Sample> class EMAFilter {
@@ -57,6 +68,26 @@ public:
   Sample processKp(Sample input, Sample k) { return value += k * (input - value); }
 };
 
+/**
+Coefficients to advance an EMA filter by `n` steps at once with constant input. Used
+to run smoothers at control rate in oversampled loops.
+
+For `ExpSmootherLocal` and `EMAFilter`, pass `getKp()` as kp. For `DoubleEMAFilter`,
+use `processStep()`.
+*/
+template<typename Sample> struct EMAStep {
+  Sample decay = 0; // (1 - kp)^n.
+  Sample slope = 0; // n * kp.
+
+  void set(Sample kp, size_t n)
+  {
+    decay = Sample(std::pow(double(1) - double(kp), double(n)));
+    slope = Sample(n) * kp;
+  }
+
+  Sample getKp() const { return Sample(1) - decay; }
+};
+
 template<typename Sample> class DoubleEMAFilter {
 public:
   Sample kp = Sample(1);
@@ -97,6 +128,16 @@ public:
     v2 += kp * (v1 - v2);
     return v2;
   }
+
+  // Same as calling `processKp(input, kp)` for `n` times. `step` is set by (kp, n).
+  Sample processStep(Sample input, const EMAStep<Sample> &step)
+  {
+    auto d1 = v1 - input;
+    auto d2 = v2 - input;
+    v1 = input + step.decay * d1;
+    v2 = input + step.decay * (d2 + step.slope * d1);
+    return v2;
+  }
 };
 
 template<typename Sample> class SmootherCommon {
@@ -115,16 +156,20 @@ public:
   }
   static void setBufferSize(Sample _bufferSize) { bufferSize = _bufferSize; }
 
-  static Sample sampleRate;
-  static Sample timeInSamples;
-  static Sample kp;
-  static Sample bufferSize;
+  static SOMEDSP_SMOOTHER_STORAGE Sample sampleRate;
+  static SOMEDSP_SMOOTHER_STORAGE Sample timeInSamples;
+  static SOMEDSP_SMOOTHER_STORAGE Sample kp;
+  static SOMEDSP_SMOOTHER_STORAGE Sample bufferSize;
 };
 
-template<typename Sample> Sample SmootherCommon<Sample>::sampleRate = 44100.0;
-template<typename Sample> Sample SmootherCommon<Sample>::timeInSamples = 0.0;
-template<typename Sample> Sample SmootherCommon<Sample>::kp = 1.0;
-template<typename Sample> Sample SmootherCommon<Sample>::bufferSize = 44100.0;
+template<typename Sample>
+SOMEDSP_SMOOTHER_STORAGE Sample SmootherCommon<Sample>::sampleRate = 44100.0;
+template<typename Sample>
+SOMEDSP_SMOOTHER_STORAGE Sample SmootherCommon<Sample>::timeInSamples = 0.0;
+template<typename Sample>
+SOMEDSP_SMOOTHER_STORAGE Sample SmootherCommon<Sample>::kp = 1.0;
+template<typename Sample>
+SOMEDSP_SMOOTHER_STORAGE Sample SmootherCommon<Sample>::bufferSize = 44100.0;
 
 template<typename Sample> class ExpSmoother {
 public:
@@ -141,6 +186,13 @@ public:
 
   void push(Sample newTarget) { target = newTarget; }
   Sample process() { return value += SmootherCommon<Sample>::kp * (target - value); }
+
+  // Same as calling `process()` for `length` times.
+  void processBlock(Sample *dest, size_t length)
+  {
+    const auto kp = SmootherCommon<Sample>::kp;
+    for (size_t i = 0; i < length; ++i) dest[i] = value += kp * (target - value);
+  }
 };
 
 template<typename Sample> class ExpSmootherLocal {
@@ -224,6 +276,15 @@ public:
     return value;
   }
 
+  // Same as calling `process()` for `length` times. Constant part is filled without
+  // the snapping branch.
+  void processBlock(Sample *dest, size_t length)
+  {
+    size_t i = 0;
+    for (; i < length && (value != target || ramp != 0); ++i) dest[i] = process();
+    std::fill(dest + i, dest + length, value);
+  }
+
 protected:
   Sample value = 1.0;
   Sample target = 1.0;
@@ -363,4 +424,5 @@ public:
   }
 };
 
+SOMEDSP_ISA_NAMESPACE_END
 } // namespace SomeDSP
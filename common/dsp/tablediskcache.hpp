@@ -0,0 +1,381 @@
+// (c) 2022 Takamitsu Endo
+//
+// This file is part of Uhhyou Plugins.
+//
+// Uhhyou Plugins is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Uhhyou Plugins is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Uhhyou Plugins.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "../../lib/ghc/fs_std.hpp"
+#include "isanamespace.hpp"
+#include "sharedcache.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace SomeDSP {
+SOMEDSP_ISA_NAMESPACE_BEGIN
+
+// Read-only memory mapping of a whole file.
+class MappedFile {
+#ifdef _WIN32
+  HANDLE file = INVALID_HANDLE_VALUE;
+  HANDLE mapping = nullptr;
+#endif
+  const uint8_t *ptr = nullptr;
+  size_t length = 0;
+
+public:
+  MappedFile(const fs::path &path)
+  {
+#ifdef _WIN32
+    file = CreateFileW(
+      path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0) return;
+
+    mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) return;
+
+    ptr = static_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (ptr != nullptr) length = size_t(fileSize.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+      void *addr = ::mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+      if (addr != MAP_FAILED) {
+        ptr = static_cast<const uint8_t *>(addr);
+        length = size_t(st.st_size);
+      }
+    }
+    ::close(fd); // Mapping stays valid after close.
+#endif
+  }
+
+  ~MappedFile()
+  {
+#ifdef _WIN32
+    if (ptr != nullptr) UnmapViewOfFile(ptr);
+    if (mapping != nullptr) CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+    if (ptr != nullptr) ::munmap(const_cast<uint8_t *>(ptr), length);
+#endif
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  bool isValid() const { return ptr != nullptr; }
+  const uint8_t *data() const { return ptr; }
+  size_t size() const { return length; }
+};
+
+/**
+Optional on-disk cache of generated tables. Each entry is a file which holds a set of
+`nTable` float tables of the same length, memory-mapped read-only on load. Loading
+becomes page faults instead of recomputation.
+
+The cache is only enabled when `UhhyouPlugins/wavetable` directory exists in the user
+cache directory. A sub directory is created for each plugin:
+
+- Linux: `$XDG_CACHE_HOME/UhhyouPlugins/wavetable/<plugin>`, or
+  `$HOME/.cache/...` when `$XDG_CACHE_HOME` is empty.
+- macOS: `$HOME/Library/Caches/UhhyouPlugins/wavetable/<plugin>`.
+- Windows: `%LocalAppData%\UhhyouPlugins\wavetable\<plugin>`.
+
+When the total size of a plugin directory exceeds `sizeLimit`, least recently used
+files are removed. A file is "used" when it's written or loaded.
+
+File format is native endian:
+
+```
+Header
+Key     // `keySize` bytes from `CacheKeySerializer`.
+Padding // Up to `dataOffset`, 64 bytes aligned.
+Data    // `nTable * tableLength` floats.
+```
+
+Files are written to a temporary name then renamed, so that other processes never see
+a partial file. All errors are treated as cache miss.
+*/
+class TableDiskCache {
+public:
+  static constexpr uint32_t formatVersion = 1;
+  static constexpr uint64_t defaultSizeLimit = uint64_t(4) << 30; // 4 GiB.
+
+  struct Header {
+    char magic[8];
+    uint32_t byteOrder;
+    uint32_t formatVersion;
+    uint32_t generatorVersion;
+    uint32_t reserved;
+    uint64_t keySize;
+    uint64_t nTable;
+    uint64_t tableLength;
+    uint64_t dataOffset;
+  };
+
+  // Loaded entry. `table(index)` is valid while this object is alive.
+  class Entry {
+    MappedFile file;
+    const float *head = nullptr;
+    size_t tableLength = 0;
+
+  public:
+    Entry(const fs::path &path) : file(path) {}
+
+    friend class TableDiskCache;
+
+    const float *table(size_t index) const { return head + index * tableLength; }
+  };
+
+  /**
+  `generatorVersion` must be incremented when the algorithm to generate tables is
+  changed. Otherwise stale tables are loaded.
+  */
+  TableDiskCache(
+    const std::string &pluginName,
+    uint32_t generatorVersion,
+    uint64_t sizeLimit = defaultSizeLimit)
+    : generatorVersion(generatorVersion), sizeLimit(sizeLimit)
+  {
+    std::error_code err;
+    auto root = getCacheHome() / "UhhyouPlugins" / "wavetable";
+    if (root.empty() || !fs::is_directory(root, err)) return;
+
+    directory = root / pluginName;
+    fs::create_directories(directory, err);
+    isEnabled = fs::is_directory(directory, err);
+  }
+
+  bool enabled() const { return isEnabled; }
+
+  // Returns nullptr on cache miss.
+  template<typename Key>
+  std::unique_ptr<Entry> load(const Key &key, size_t nTable, size_t tableLength)
+  {
+    if (!isEnabled) return nullptr;
+
+    CacheKeySerializer serialized;
+    key.visit(serialized);
+    auto path = getPath(serialized);
+
+    std::error_code err;
+    if (!fs::is_regular_file(path, err)) return nullptr;
+
+    auto entry = std::make_unique<Entry>(path);
+    if (!entry->file.isValid()) return nullptr;
+
+    const auto *data = entry->file.data();
+    const size_t size = entry->file.size();
+    if (size < sizeof(Header)) return nullptr;
+
+    Header header;
+    std::memcpy(&header, data, sizeof(Header));
+    Header expected = makeHeader(serialized.data.size(), nTable, tableLength);
+    if (
+      std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0
+      || header.byteOrder != expected.byteOrder
+      || header.formatVersion != expected.formatVersion
+      || header.generatorVersion != expected.generatorVersion
+      || header.keySize != expected.keySize || header.nTable != expected.nTable
+      || header.tableLength != expected.tableLength
+      || header.dataOffset != expected.dataOffset
+      || size < header.dataOffset + sizeof(float) * nTable * tableLength)
+    {
+      return nullptr;
+    }
+
+    // Hash collision check.
+    if (
+      std::memcmp(data + sizeof(Header), serialized.data.data(), serialized.data.size())
+      != 0)
+    {
+      return nullptr;
+    }
+
+    entry->head = reinterpret_cast<const float *>(data + header.dataOffset);
+    entry->tableLength = tableLength;
+
+    fs::last_write_time(path, fs::file_time_type::clock::now(), err);
+    return entry;
+  }
+
+  /**
+  `tables` is an array of `nTable` pointers to `tableLength` floats. Called after
+  `load` is missed. Old files are evicted afterward.
+  */
+  template<typename Key>
+  void
+  store(const Key &key, const float *const *tables, size_t nTable, size_t tableLength)
+  {
+    if (!isEnabled) return;
+
+    CacheKeySerializer serialized;
+    key.visit(serialized);
+    auto path = getPath(serialized);
+
+    Header header = makeHeader(serialized.data.size(), nTable, tableLength);
+
+    auto tmpPath = path;
+    tmpPath += ".tmp" + std::to_string(std::random_device{}());
+
+    {
+      std::ofstream ofs(tmpPath, std::ios::binary | std::ios::trunc);
+      if (!ofs.is_open()) return;
+
+      ofs.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+      ofs.write(
+        reinterpret_cast<const char *>(serialized.data.data()), serialized.data.size());
+
+      std::vector<char> padding(
+        header.dataOffset - sizeof(Header) - serialized.data.size(), 0);
+      ofs.write(padding.data(), padding.size());
+
+      for (size_t idx = 0; idx < nTable; ++idx) {
+        ofs.write(
+          reinterpret_cast<const char *>(tables[idx]), sizeof(float) * tableLength);
+      }
+
+      if (!ofs.good()) {
+        ofs.close();
+        std::error_code err;
+        fs::remove(tmpPath, err);
+        return;
+      }
+    }
+
+    std::error_code err;
+    fs::rename(tmpPath, path, err);
+    if (err) fs::remove(tmpPath, err);
+
+    evict();
+  }
+
+  // Removes least recently used files until the total size is under `sizeLimit`.
+  void evict()
+  {
+    if (!isEnabled) return;
+
+    struct Item {
+      fs::path path;
+      uint64_t size;
+      fs::file_time_type time;
+    };
+    std::vector<Item> items;
+    uint64_t total = 0;
+
+    std::error_code err;
+    for (const auto &file : fs::directory_iterator(directory, err)) {
+      if (!file.is_regular_file(err) || file.path().extension() != ".tbl") continue;
+      auto size = uint64_t(file.file_size(err));
+      if (err) continue;
+      items.push_back({file.path(), size, file.last_write_time(err)});
+      total += size;
+    }
+    if (total <= sizeLimit) return;
+
+    std::sort(items.begin(), items.end(), [](const Item &a, const Item &b) {
+      return a.time < b.time;
+    });
+    for (const auto &item : items) {
+      if (total <= sizeLimit) break;
+
+      // On Windows, removing a mapped file fails. It's left for next time.
+      if (fs::remove(item.path, err)) total -= item.size;
+    }
+  }
+
+private:
+  uint32_t generatorVersion;
+  uint64_t sizeLimit;
+  bool isEnabled = false;
+  fs::path directory;
+
+  Header makeHeader(size_t keySize, size_t nTable, size_t tableLength)
+  {
+    Header header;
+    std::memcpy(header.magic, "UHYTABLE", sizeof(header.magic));
+    header.byteOrder = 0x01020304;
+    header.formatVersion = formatVersion;
+    header.generatorVersion = generatorVersion;
+    header.reserved = 0;
+    header.keySize = keySize;
+    header.nTable = nTable;
+    header.tableLength = tableLength;
+    header.dataOffset = (sizeof(Header) + keySize + 63) & ~uint64_t(63);
+    return header;
+  }
+
+  fs::path getPath(const CacheKeySerializer &serialized)
+  {
+    CacheHasher hasher;
+    hasher.bytes(serialized.data.data(), serialized.data.size());
+
+    char name[32];
+    std::snprintf(
+      name, sizeof(name), "%016llx.tbl", static_cast<unsigned long long>(hasher.value));
+    return directory / name;
+  }
+
+  static fs::path getCacheHome()
+  {
+#ifdef _WIN32
+    const char *localAppData = std::getenv("LocalAppData");
+    if (localAppData != nullptr) return fs::path(localAppData);
+#elif __APPLE__
+    const char *home = std::getenv("HOME");
+    if (home != nullptr) return fs::path(home) / "Library/Caches";
+#else
+    const char *cacheDir = std::getenv("XDG_CACHE_HOME");
+    if (cacheDir != nullptr && cacheDir[0] != '\0') return fs::path(cacheDir);
+
+    const char *home = std::getenv("HOME");
+    if (home != nullptr) return fs::path(home) / ".cache";
+#endif
+    return fs::path("");
+  }
+};
+
+SOMEDSP_ISA_NAMESPACE_END
+} // namespace SomeDSP
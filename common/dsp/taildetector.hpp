@@ -0,0 +1,126 @@
+// (c) 2022 Takamitsu Endo
+//
+// This file is part of Uhhyou Plugins.
+//
+// Uhhyou Plugins is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Uhhyou Plugins is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Uhhyou Plugins.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace SomeDSP {
+
+/**
+Detects the end of the tail of an effect, to skip processing on silence.
+
+Input is silent when the host sets silence flags, or all samples are under `threshold`
+(-150 dB). After input becomes silent, the effect becomes idle when output also stays
+under `threshold` for `holdFrames` in a row. `holdFrames` is the longest delay from
+input to output, so that no sound is left in the delays.
+
+When `update()` returns true, caller resets the DSP to clear the residue under
+`threshold`. While idle, caller fills output with 0 instead of processing, until
+input becomes non-silent.
+
+```
+auto isInputSilent = detector.isInputSilent(silenceFlags, in0, in1, length);
+if (isInputSilent && detector.isIdle()) {
+  // Fill output with 0.
+} else {
+  dsp.process(length, in0, in1, out0, out1);
+  if (detector.update(isInputSilent, out0, out1, length, dsp.getLongestDelaySamples()))
+    dsp.reset();
+}
+```
+*/
+class TailDetector {
+public:
+  static constexpr size_t infiniteTail = std::numeric_limits<size_t>::max();
+  static constexpr float defaultThreshold = float(3.1622776601683795e-08); // -150 dB.
+
+  float threshold = defaultThreshold;
+
+  void reset()
+  {
+    silentFrames = 0;
+    idle = false;
+  }
+
+  bool isIdle() const { return idle; }
+
+  bool isSilent(const float *buf, size_t length) const
+  {
+    for (size_t i = 0; i < length; ++i) {
+      if (!(std::fabs(buf[i]) < threshold)) return false;
+    }
+    return true;
+  }
+
+  // `silenceFlags` is a bit field from host. Bit 0 and 1 are for channel 0 and 1.
+  bool isInputSilent(
+    uint64_t silenceFlags, const float *in0, const float *in1, size_t length) const
+  {
+    if ((silenceFlags & 0b11) == 0b11) return true;
+    return isSilent(in0, length) && isSilent(in1, length);
+  }
+
+  // Called after processing a block. Returns true when it becomes idle.
+  bool update(
+    bool isInputSilent,
+    const float *out0,
+    const float *out1,
+    size_t length,
+    size_t holdFrames)
+  {
+    idle = false;
+    if (!isInputSilent || !isSilent(out0, length) || !isSilent(out1, length)) {
+      silentFrames = 0;
+      return false;
+    }
+
+    silentFrames += length;
+    if (silentFrames < holdFrames) return false;
+    idle = true;
+    return true;
+  }
+
+  /**
+  Frames until output decays under `threshold` after the input stops. `loopSeconds` is
+  the delay time of a feedback loop, and `gain` is the gain of the loop. Returns
+  `infiniteTail` when it doesn't decay.
+  */
+  static size_t feedbackTailFrames(
+    double sampleRate,
+    double loopSeconds,
+    double gain,
+    double threshold = defaultThreshold)
+  {
+    gain = std::fabs(gain);
+    if (!(gain < 1.0)) return infiniteTail;
+
+    double nLoop = gain <= 0 ? 0 : std::ceil(std::log(threshold) / std::log(gain));
+    double frames = std::ceil(sampleRate * loopSeconds * (nLoop + 1.0));
+    if (!(frames < double(std::numeric_limits<uint32_t>::max()))) return infiniteTail;
+    return size_t(frames);
+  }
+
+private:
+  size_t silentFrames = 0;
+  bool idle = false;
+};
+
+} // namespace SomeDSP
@@ -0,0 +1,196 @@
+// (c) 2022 Takamitsu Endo
+//
+// This file is part of Uhhyou Plugins.
+//
+// Uhhyou Plugins is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Uhhyou Plugins is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Uhhyou Plugins.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "denormal.hpp"
+#include "isanamespace.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__arm64__) || defined(__aarch64__)
+#elif defined(_MSC_VER)
+  #include <intrin.h>
+#else
+  #include <immintrin.h>
+#endif
+
+namespace SomeDSP {
+SOMEDSP_ISA_NAMESPACE_BEGIN
+
+inline void cpuRelax()
+{
+#if defined(__arm64__) || defined(__aarch64__)
+  asm volatile("yield");
+#else
+  _mm_pause();
+#endif
+}
+
+/**
+Pool of spin-waiting worker threads to split a block of audio processing.
+
+`run()` is called from one thread (usually audio thread), and that thread also takes
+tasks. It returns after all tasks are finished and all workers are out of the task loop.
+Task to thread assignment is not deterministic, so each task must write to its own
+buffer.
+
+Workers spin for a while after each run, then fall back to sleep on a condition
+variable. Workers are not pinned to CPU cores. Fixed pinning puts workers of every
+plugin instance on the same cores, and one of them may be the core running the audio
+thread. Scheduling is left to the OS. Denormals are flushed to zero on workers, same as
+the audio thread.
+
+`resize()` creates and joins threads. Don't call it from audio thread.
+*/
+class SpinWorkerPool {
+public:
+  using TaskFunc = void (*)(void *context, size_t index);
+
+  ~SpinWorkerPool() { resize(1); }
+
+  // Number of threads including the caller of `run()`.
+  size_t size() const { return workers.size() + 1; }
+
+  // `nThread` is clamped to the number of CPU cores, because spinning threads more than
+  // cores only steal time from each other.
+  void resize(size_t nThread)
+  {
+    const size_t nCore = std::thread::hardware_concurrency();
+    if (nCore > 0 && nThread > nCore) nThread = nCore;
+    if (nThread < 1) nThread = 1;
+    if (nThread == size()) return;
+
+    if (!workers.empty()) {
+      isTerminating.store(true);
+      generation.fetch_add(1);
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+      }
+      condition.notify_all();
+      for (auto &worker : workers) worker.join();
+      workers.clear();
+      isTerminating.store(false);
+    }
+
+    const auto gen = generation.load();
+    for (size_t idx = 1; idx < nThread; ++idx) {
+      workers.emplace_back(&SpinWorkerPool::workerLoop, this, gen);
+    }
+  }
+
+  template<typename Func> void run(size_t nTask, Func &func)
+  {
+    run(
+      nTask, [](void *context, size_t index) { (*static_cast<Func *>(context))(index); },
+      static_cast<void *>(&func));
+  }
+
+  void run(size_t nTask, TaskFunc func, void *context)
+  {
+    if (workers.empty()) {
+      for (size_t idx = 0; idx < nTask; ++idx) func(context, idx);
+      return;
+    }
+
+    taskFunc = func;
+    taskContext = context;
+    taskCount = nTask;
+    nextTask.store(0, std::memory_order_relaxed);
+    nAcknowledged.store(0, std::memory_order_relaxed);
+    generation.fetch_add(1); // seq_cst. Pairs with `nSleeping` in `workerLoop()`.
+
+    if (nSleeping.load() > 0) {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+      }
+      condition.notify_all();
+    }
+
+    work();
+
+    size_t spin = 0;
+    while (nAcknowledged.load(std::memory_order_acquire) < workers.size()) {
+      if (++spin < spinLimit) {
+        cpuRelax();
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+private:
+  static constexpr size_t spinLimit = size_t(1) << 16;
+
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable condition;
+
+  std::atomic<uint64_t> generation{0};
+  std::atomic<size_t> nextTask{0};
+  std::atomic<size_t> nAcknowledged{0};
+  std::atomic<size_t> nSleeping{0};
+  std::atomic<bool> isTerminating{false};
+
+  TaskFunc taskFunc = nullptr;
+  void *taskContext = nullptr;
+  size_t taskCount = 0;
+
+  void work()
+  {
+    while (true) {
+      const size_t index = nextTask.fetch_add(1, std::memory_order_relaxed);
+      if (index >= taskCount) return;
+      taskFunc(taskContext, index);
+    }
+  }
+
+  void workerLoop(uint64_t seen)
+  {
+    ScopedNoDenormals noDenormals;
+
+    while (true) {
+      size_t spin = 0;
+      while (generation.load(std::memory_order_acquire) == seen) {
+        if (++spin < spinLimit) {
+          cpuRelax();
+          continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        nSleeping.fetch_add(1);
+        condition.wait(lock, [&]() { return generation.load() != seen; });
+        nSleeping.fetch_sub(1);
+      }
+      seen = generation.load(std::memory_order_acquire);
+
+      if (isTerminating.load(std::memory_order_acquire)) return;
+
+      work();
+      nAcknowledged.fetch_add(1, std::memory_order_release);
+    }
+  }
+};
+
+SOMEDSP_ISA_NAMESPACE_END
+} // namespace SomeDSP
@@ -0,0 +1,76 @@
+// (c) 2022 Takamitsu Endo
+//
+// This file is part of Uhhyou Plugins.
+//
+// Uhhyou Plugins is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Uhhyou Plugins is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Uhhyou Plugins.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+Lock-free triple buffer with multiple writers and single reader.
+
+Writer calls `write(fill)`, where `fill(T &)` fills the back buffer. Reader calls
+`acquire()` to get the latest published value. Neither side blocks.
+
+Additional writers (e.g. `setState()` on the UI thread) are allowed. When a writer finds
+another writer publishing, it only marks the buffer dirty and returns. The writer holding
+the lock sees the flag and fills again, so the latest values are always published.
+*/
+template<typename T> class TripleBuffer {
+private:
+  static constexpr uint8_t indexMask = 0b011;
+  static constexpr uint8_t newFlag = 0b100;
+
+  std::array<T, 3> buffer{};
+  uint8_t backIndex = 0;
+  uint8_t frontIndex = 1;
+  std::atomic<uint8_t> middle{2};
+  std::atomic<bool> isDirty{false};
+  std::atomic_flag writeLock = ATOMIC_FLAG_INIT;
+
+public:
+  // Writer side. `fill` must read the current values, as it may run on behalf of another
+  // writer.
+  //
+  // `isDirty` and `writeLock` are seq_cst. One writer stores `isDirty` then tests
+  // `writeLock`, and the other clears `writeLock` then loads `isDirty`. With weaker
+  // orders, each store may be reordered after the following load, and both writers
+  // return without publishing.
+  template<typename Fill> void write(Fill fill)
+  {
+    isDirty.store(true, std::memory_order_seq_cst);
+    while (isDirty.load(std::memory_order_seq_cst)) {
+      if (writeLock.test_and_set(std::memory_order_seq_cst)) return;
+      if (isDirty.exchange(false, std::memory_order_acq_rel)) {
+        fill(buffer[backIndex]);
+        backIndex
+          = middle.exchange(backIndex | newFlag, std::memory_order_acq_rel) & indexMask;
+      }
+      writeLock.clear(std::memory_order_seq_cst);
+    }
+  }
+
+  // Reader side.
+  const T &acquire()
+  {
+    if (middle.load(std::memory_order_relaxed) & newFlag) {
+      frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & indexMask;
+    }
+    return buffer[frontIndex];
+  }
+};
@@ -18,10 +18,13 @@
 */
 
 #pragma once
+#include "../common/dsp/isanamespace.hpp"
+
 #include <stddef.h>
 
 namespace juce {
 namespace dsp {
+SOMEDSP_ISA_NAMESPACE_BEGIN
 
 /**
     This class contains various fast mathematical function approximations.
@@ -231,5 +234,6 @@ struct FastMathApproximations {
   }
 };
 
+SOMEDSP_ISA_NAMESPACE_END
 } // namespace dsp
 } // namespace juce
@@ -26,3 +26,8 @@
 #endif
 
 #include "vcl/vectorclass.h"
+
+// Set for each instruction set build of `dspcore.cpp`. See `common/dsp/isanamespace.hpp`.
+#ifdef VCL_NAMESPACE
+using namespace VCL_NAMESPACE;
+#endif
@@ -0,0 +1,433 @@
+// (c) 2022 Takamitsu Endo
+//
+// This file is part of Uhhyou Plugins.
+//
+// Uhhyou Plugins is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Uhhyou Plugins is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Uhhyou Plugins.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "midifile.hpp"
+#include "presetutil.hpp"
+#include "testutil.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <functional>
+
+/**
+Parameter automation read from JSON. Values are normalized in [0, 1], and linearly
+interpolated between points. Before the first point and after the last point, the
+value is held. `parameter` is a name in `*.preset.json`, or an index.
+
+```json
+[
+  {"parameter": "lowpassCutoffHz", "points": [[0.0, 0.2], [4.0, 0.9]]},
+  {"parameter": 12, "points": [[1.5, 1.0]]}
+]
+```
+
+Like a host, the value is applied once at the start of each block.
+*/
+struct AutomationCurve {
+  struct Lane {
+    std::string name;
+    size_t index = 0;
+    std::vector<std::pair<double, double>> points; // (seconds, normalized value).
+  };
+
+  std::vector<Lane> lanes;
+  std::string error;
+
+  bool load(const fs::path &path)
+  {
+    std::ifstream ifs(path);
+    if (!ifs.is_open()) {
+      error = "Failed to open file.";
+      return false;
+    }
+
+    auto data = nlohmann::json::parse(ifs, nullptr, false);
+    if (data.is_discarded() || !data.is_array()) {
+      error = "Top level must be an array.";
+      return false;
+    }
+
+    for (const auto &item : data) {
+      Lane lane;
+      const auto &parameter = item["parameter"];
+      if (parameter.is_string()) {
+        lane.name = parameter.get<std::string>();
+      } else if (parameter.is_number_unsigned()) {
+        lane.index = parameter.get<size_t>();
+      } else {
+        error = "`parameter` must be a name or an index.";
+        return false;
+      }
+
+      for (const auto &point : item["points"]) {
+        if (!point.is_array() || point.size() != 2) {
+          error = "Each point must be [seconds, value].";
+          return false;
+        }
+        lane.points.emplace_back(
+          point[0].get<double>(), std::clamp(point[1].get<double>(), 0.0, 1.0));
+      }
+      if (lane.points.empty()) continue;
+
+      std::stable_sort(
+        lane.points.begin(), lane.points.end(),
+        [](const auto &a, const auto &b) { return a.first < b.first; });
+      lanes.push_back(std::move(lane));
+    }
+    return true;
+  }
+
+  // Returns lanes with indices resolved from `parameters` in `*.preset.json`.
+  std::vector<Lane> resolve(const nlohmann::json &parameters, std::string &message) const
+  {
+    std::vector<Lane> resolved = lanes;
+    for (auto &lane : resolved) {
+      if (lane.name.empty()) {
+        if (lane.index < parameters.size()) continue;
+        message = "Parameter index " + std::to_string(lane.index) + " is out of range.";
+        return {};
+      }
+
+      auto it = std::find_if(parameters.begin(), parameters.end(), [&](const auto &p) {
+        return p["name"] == lane.name;
+      });
+      if (it == parameters.end()) {
+        message = "Parameter \"" + lane.name + "\" is not found.";
+        return {};
+      }
+      lane.index = size_t(std::distance(parameters.begin(), it));
+    }
+    return resolved;
+  }
+
+  static double valueAt(const Lane &lane, double seconds)
+  {
+    const auto &pts = lane.points;
+    if (seconds <= pts.front().first) return pts.front().second;
+    if (seconds >= pts.back().first) return pts.back().second;
+
+    auto it = std::upper_bound(
+      pts.begin(), pts.end(), seconds,
+      [](double s, const auto &point) { return s < point.first; });
+    const auto &p1 = *it;
+    const auto &p0 = *std::prev(it);
+    auto span = p1.first - p0.first;
+    if (span <= 0) return p1.second;
+    return p0.second + (seconds - p0.first) / span * (p1.second - p0.second);
+  }
+};
+
+struct BatchRenderOption {
+  std::vector<std::string> midiPath;
+  std::string automationPath;
+  std::vector<std::string> presetName; // Empty means all presets.
+  std::string presetJsonPath;
+  std::string outDir;
+  double sampleRate = 48000;
+  size_t blockSize = 512;
+  double tailSeconds = 2;
+  size_t nThread = std::thread::hardware_concurrency();
+
+  static void printUsage(const std::string &pluginName)
+  {
+    std::cout << "Usage: batchrender_" << pluginName << R"( [options] --midi FILE...
+
+Renders each preset with each MIDI file to `OUT/<preset>_<midi>.wav`.
+
+Options:
+  --midi FILE         Standard MIDI File. Can be specified multiple times.
+  --automation FILE   Parameter automation JSON. Applied to all jobs.
+  --preset NAME       Preset to render. Can be specified multiple times.
+                      Default is all presets.
+  --preset-json FILE  Default is `../../presets/json/)"
+              << pluginName << R"(.preset.json`.
+  --out DIR           Output directory. Default is `render/)"
+              << pluginName << R"(`.
+  --sample-rate HZ    Default is 48000.
+  --block-size N      Number of frames passed to each process call. Default is 512.
+  --tail SECONDS      Rendered after the last MIDI event. Default is 2.
+  --threads N         Number of jobs rendered in parallel. Default is number of cores.
+)";
+  }
+
+  bool parse(const std::string &pluginName, int argc, char *argv[])
+  {
+    presetJsonPath = "../../presets/json/" + pluginName + ".preset.json";
+    outDir = "render/" + pluginName;
+
+    auto handle = [&](const std::string &arg, const std::string &value) -> std::string {
+      if (arg == "--midi") {
+        midiPath.push_back(value);
+      } else if (arg == "--automation") {
+        automationPath = value;
+      } else if (arg == "--preset") {
+        presetName.push_back(value);
+      } else if (arg == "--preset-json") {
+        presetJsonPath = value;
+      } else if (arg == "--out") {
+        outDir = value;
+      } else if (arg == "--sample-rate") {
+        sampleRate = std::stod(value);
+      } else if (arg == "--block-size") {
+        blockSize = std::stoul(value);
+      } else if (arg == "--tail") {
+        tailSeconds = std::stod(value);
+      } else if (arg == "--threads") {
+        nThread = std::stoul(value);
+      } else {
+        return "Unknown option " + arg;
+      }
+      return "";
+    };
+    if (!parseOptionPairs(argc, argv, handle)) return false;
+
+    if (midiPath.empty()) {
+      std::cerr << "Error: No MIDI file is specified.\n";
+      return false;
+    }
+    if (!(sampleRate > 0) || blockSize == 0 || !(tailSeconds >= 0)) {
+      std::cerr << "Error: Sample rate, block size and tail must be positive.\n";
+      return false;
+    }
+    nThread = std::max(nThread, size_t(1));
+    return true;
+  }
+};
+
+/**
+Offline renderer of synthesizer `DSPCore`. Jobs are the combinations of presets and
+MIDI files, and rendered in parallel.
+
+Unlike `SynthTester`, notes are sent through `pushMidiNote()` with the offset in the
+block, and `SET_PARAMETERS` is called on each block. This is the same as
+`PlugProcessor::process()`.
+
+Each job runs `setup()` and `process()` on one thread. `SmootherCommon` is
+`thread_local` in `TEST_DSP` builds, and FFTW3 planning is locked by `fftwMutex` of each
+plugin, so jobs don't share mutable state.
+*/
+template<typename DSP_CLASS> class BatchRenderer {
+public:
+  using Factory = std::function<std::unique_ptr<DSP_CLASS>()>;
+
+  bool isFinished = false;
+
+  BatchRenderer(
+    std::string pluginName,
+    int argc,
+    char *argv[],
+    Factory factory = []() { return std::make_unique<DSP_CLASS>(); })
+    : factory(factory)
+  {
+    if (!option.parse(pluginName, argc, argv)) {
+      BatchRenderOption::printUsage(pluginName);
+      return;
+    }
+
+    if (!loadInputs()) return;
+
+    std::error_code err;
+    fs::create_directories(option.outDir, err);
+    if (!fs::is_directory(option.outDir, err)) {
+      std::cerr << "Error: Failed to create " << option.outDir << "\n";
+      return;
+    }
+
+    for (size_t preset = 0; preset < presets.size(); ++preset) {
+      for (size_t midi = 0; midi < midiFiles.size(); ++midi) {
+        jobs.push_back({preset, midi});
+      }
+    }
+
+    auto nThread = std::min(option.nThread, jobs.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < nThread; ++i) {
+      threads.emplace_back(&BatchRenderer<DSP_CLASS>::worker, this);
+    }
+    for (auto &th : threads) th.join();
+
+    isFinished = nFailed == 0;
+  }
+
+private:
+  struct Job {
+    size_t preset;
+    size_t midi;
+  };
+
+  BatchRenderOption option;
+  Factory factory;
+  std::vector<nlohmann::json> presets;
+  std::vector<MidiFile> midiFiles;
+  std::vector<std::string> midiName; // Used for output file name.
+  AutomationCurve automation;
+
+  std::vector<Job> jobs;
+  std::atomic<size_t> nextJob{0};
+  std::atomic<size_t> nFailed{0};
+  std::mutex mtx;
+
+  bool loadInputs()
+  {
+    if (!loadPresetJson(option.presetJsonPath, option.presetName, presets)) return false;
+
+    midiFiles.resize(option.midiPath.size());
+    midiName.resize(option.midiPath.size());
+    for (size_t i = 0; i < midiFiles.size(); ++i) {
+      midiName[i] = fs::path(option.midiPath[i]).stem().string();
+      auto count = std::count(midiName.begin(), midiName.begin() + i, midiName[i]);
+      if (count > 0) midiName[i] += "_" + std::to_string(count);
+
+      if (!midiFiles[i].load(option.midiPath[i])) {
+        std::cerr << "Error " << option.midiPath[i] << ": " << midiFiles[i].error
+                  << "\n";
+        return false;
+      }
+    }
+
+    if (!option.automationPath.empty() && !automation.load(option.automationPath)) {
+      std::cerr << "Error " << option.automationPath << ": " << automation.error << "\n";
+      return false;
+    }
+    return true;
+  }
+
+  void worker()
+  {
+    while (true) {
+      size_t index = nextJob.fetch_add(1);
+      if (index >= jobs.size()) return;
+
+      // A new thread for each job starts `thread_local` state like `SmootherCommon` from
+      // the initial value. Otherwise a job sees the state left by the previous job on
+      // the same thread, and the output depends on `--threads`.
+      std::string error;
+      std::string path;
+      std::thread([&]() { path = render(jobs[index], error); }).join();
+
+      std::lock_guard<std::mutex> lock(mtx);
+      if (error.empty()) {
+        std::cout << "Rendered " << path << "\n";
+      } else {
+        std::cerr << "Error " << path << ": " << error << "\n";
+        ++nFailed;
+      }
+    }
+  }
+
+  void processDsp(
+    size_t length,
+    size_t currentFrame,
+    std::vector<std::vector<float>> &wav,
+    std::unique_ptr<DSP_CLASS> &dsp)
+  {
+#ifdef HAS_INPUT
+    std::vector<float> silence(length, 0.0f);
+    dsp->process(
+      length, silence.data(), silence.data(), wav[0].data() + currentFrame,
+      wav[1].data() + currentFrame);
+#else
+    dsp->process(length, wav[0].data() + currentFrame, wav[1].data() + currentFrame);
+#endif
+  }
+
+  std::string render(const Job &job, std::string &error)
+  {
+    const auto &preset = presets[job.preset];
+    const auto &midi = midiFiles[job.midi];
+    const auto sampleRate = option.sampleRate;
+
+    std::string name = preset["name"];
+    name += "_" + midiName[job.midi];
+    std::replace_if(
+      name.begin(), name.end(), [](char c) { return c == '/' || c == '\\'; }, '_');
+    auto path = (fs::path(option.outDir) / (name + ".wav")).string();
+
+    const auto &parameters = preset["parameter"];
+    auto lanes = automation.resolve(parameters, error);
+    if (!error.empty()) return path;
+
+    auto dsp = factory();
+    if (!dsp) {
+      error = "Failed to create DSP. Instruction set may not be supported.";
+      return path;
+    }
+    dsp->setup(sampleRate);
+
+    applyPresetParameters(*dsp, parameters);
+    for (const auto &lane : lanes) {
+      dsp->param.value[lane.index]->setFromNormalized(AutomationCurve::valueAt(lane, 0));
+    }
+
+    double tempo = midi.tempo(0);
+    setTransport(*dsp, tempo, 0);
+    SET_PARAMETERS;
+    dsp->reset();
+
+    const size_t nFrame
+      = size_t(std::ceil((midi.lastNoteSeconds() + option.tailSeconds) * sampleRate));
+    std::vector<std::vector<float>> wav(2);
+    for (auto &channel : wav) channel.resize(nFrame);
+
+    const auto &notes = midi.notes;
+    size_t noteIndex = 0;
+    for (size_t frame = 0; frame < nFrame; frame += option.blockSize) {
+      const size_t length = std::min(option.blockSize, nFrame - frame);
+      const double seconds = double(frame) / sampleRate;
+
+      for (const auto &lane : lanes) {
+        dsp->param.value[lane.index]->setFromNormalized(
+          AutomationCurve::valueAt(lane, seconds));
+      }
+      tempo = midi.tempo(seconds);
+      setTransport(*dsp, tempo, midi.beats(seconds));
+      SET_PARAMETERS;
+
+      for (; noteIndex < notes.size(); ++noteIndex) {
+        const auto &note = notes[noteIndex];
+        auto noteFrame = size_t(std::llround(note.seconds * sampleRate));
+        if (noteFrame >= frame + length) break;
+        dsp->pushMidiNote(
+          note.isNoteOn, uint32_t(noteFrame - std::min(noteFrame, frame)), note.id,
+          note.pitch, 0.0f, note.velocity);
+      }
+
+      processDsp(length, frame, wav, dsp);
+    }
+
+    SndFileResult result;
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      result = writeWave(path, wav, int(sampleRate));
+    }
+    if (result != SndFileResult::success) error = "Failed to write file.";
+
+    for (size_t ch = 0; ch < wav.size(); ++ch) {
+      for (size_t fr = 0; fr < nFrame; ++fr) {
+        if (std::isfinite(wav[ch][fr])) continue;
+        std::stringstream stream;
+        stream << "Non-finite value " << wav[ch][fr] << " at channel " << ch
+               << ", frame " << fr << ".";
+        error = stream.str();
+        return path;
+      }
+    }
+    return path;
+  }
+};
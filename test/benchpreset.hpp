@@ -0,0 +1,374 @@
+// (c) 2022 Takamitsu Endo
+//
+// This file is part of Uhhyou Plugins.
+//
+// Uhhyou Plugins is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Uhhyou Plugins is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Uhhyou Plugins.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "presetutil.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#ifndef HAS_SIDECHAIN
+  #define HAS_SIDECHAIN 0
+#endif
+
+/**
+Block size setting of a benchmark run. `size == 0` means variable block size. In that
+case, the size of each block is drawn from a fixed seed RNG in `[1, maxVariableSize]`.
+It mimics hosts like FL Studio, which change the block size on every call.
+*/
+struct BenchBlockSize {
+  static constexpr size_t maxVariableSize = 1024;
+
+  size_t size = 0;
+
+  bool isVariable() const { return size == 0; }
+  std::string label() const { return isVariable() ? "variable" : std::to_string(size); }
+};
+
+struct BenchPresetOption {
+  std::vector<std::string> presetName; // Empty means all presets.
+  std::string presetJsonPath;
+  std::string outPath;
+  std::vector<double> sampleRate;
+  std::vector<BenchBlockSize> blockSize;
+  double seconds = 2;
+
+  static void printUsage(const std::string &pluginName)
+  {
+    std::cout << "Usage: benchpreset_" << pluginName << R"( [options]
+
+Measures the time of each process call for each combination of preset, sample rate
+and block size. Results are written to a CSV file.
+
+Options:
+  --preset NAME       Preset to measure. Can be specified multiple times.
+                      Default is all presets.
+  --preset-json FILE  Default is `../../presets/json/)"
+              << pluginName << R"(.preset.json`.
+  --out FILE          Output CSV. Default is `bench/)"
+              << pluginName << R"(.csv`.
+  --sample-rate HZ    Can be specified multiple times.
+                      Default is 44100, 48000, 96000 and 192000.
+  --block-size N      Number of frames passed to each process call, or `variable`.
+                      Can be specified multiple times.
+                      Default is 1, 16, 64, 256, 512, 1024, 4096 and variable.
+  --seconds SECONDS   Length of audio rendered for each run. Default is 2.
+)";
+  }
+
+  bool parse(const std::string &pluginName, int argc, char *argv[])
+  {
+    presetJsonPath = "../../presets/json/" + pluginName + ".preset.json";
+    outPath = "bench/" + pluginName + ".csv";
+
+    auto handle = [&](const std::string &arg, const std::string &value) -> std::string {
+      if (arg == "--preset") {
+        presetName.push_back(value);
+      } else if (arg == "--preset-json") {
+        presetJsonPath = value;
+      } else if (arg == "--out") {
+        outPath = value;
+      } else if (arg == "--sample-rate") {
+        sampleRate.push_back(std::stod(value));
+      } else if (arg == "--block-size") {
+        blockSize.push_back({value == "variable" ? 0 : std::stoul(value)});
+        if (blockSize.back().isVariable() && value != "variable") {
+          return "Block size must be positive.";
+        }
+      } else if (arg == "--seconds") {
+        seconds = std::stod(value);
+      } else {
+        return "Unknown option " + arg;
+      }
+      return "";
+    };
+    if (!parseOptionPairs(argc, argv, handle)) return false;
+
+    if (sampleRate.empty()) sampleRate = {44100, 48000, 96000, 192000};
+    if (blockSize.empty()) {
+      blockSize = {{1}, {16}, {64}, {256}, {512}, {1024}, {4096}, {0}};
+    }
+
+    for (const auto &rate : sampleRate) {
+      if (rate > 0) continue;
+      std::cerr << "Error: Sample rate must be positive.\n";
+      return false;
+    }
+    if (!(seconds > 0)) {
+      std::cerr << "Error: Seconds must be positive.\n";
+      return false;
+    }
+    return true;
+  }
+};
+
+/**
+CPU regression benchmark of `DSPCore`. Each run is a combination of preset, sample rate
+and block size, and the time of each block is measured. A block includes
+`SET_PARAMETERS`, `pushMidiNote()` and `process()`, in the same way as
+`PlugProcessor::process()`.
+
+Plugins which take MIDI notes receive a fixed note pattern. Plugins with audio input
+receive the same noise as `FxTester`. Runs are measured one by one on the calling
+thread, to avoid the interference between runs.
+
+Output CSV has a row for each run:
+
+- `meanUs`, `p99Us`, `maxUs`: Statistics of the time of a block in microseconds.
+- `realTimeFactor`: Total processing time divided by rendered audio length. Less than
+  1 means faster than real-time.
+*/
+template<typename DSP_CLASS> class PresetBenchmark {
+public:
+  using Factory = std::function<std::unique_ptr<DSP_CLASS>()>;
+
+  bool isFinished = false;
+
+  PresetBenchmark(
+    std::string pluginName,
+    int argc,
+    char *argv[],
+    Factory factory = []() { return std::make_unique<DSP_CLASS>(); })
+    : pluginName(pluginName), factory(factory)
+  {
+    if (!option.parse(pluginName, argc, argv)) {
+      BenchPresetOption::printUsage(pluginName);
+      return;
+    }
+
+    if (!loadPresetJson(option.presetJsonPath, option.presetName, presets)) return;
+
+    std::error_code err;
+    auto parent = fs::path(option.outPath).parent_path();
+    if (!parent.empty()) fs::create_directories(parent, err);
+    std::ofstream csv(option.outPath);
+    if (!csv.is_open()) {
+      std::cerr << "Error: Failed to open " << option.outPath << "\n";
+      return;
+    }
+    csv << "plugin,preset,sampleRate,blockSize,nBlock,"
+           "meanUs,p99Us,maxUs,realTimeFactor\n";
+    csv << std::fixed << std::setprecision(6);
+
+    for (const auto &preset : presets) {
+      std::string name = preset["name"];
+      std::cout << "Processing preset: " << name << "\n";
+
+      // CSV escape.
+      std::string quoted;
+      for (const auto &c : name) {
+        quoted += c;
+        if (c == '"') quoted += c;
+      }
+
+      for (const auto &sampleRate : option.sampleRate) {
+        for (const auto &blockSize : option.blockSize) {
+          Result result;
+          if (!run(preset, sampleRate, blockSize, result)) return;
+
+          csv << pluginName << ",\"" << quoted << "\"," << std::llround(sampleRate) << ","
+              << blockSize.label() << "," << result.nBlock << "," << result.meanUs << ","
+              << result.p99Us << "," << result.maxUs << "," << result.realTimeFactor
+              << "\n";
+        }
+      }
+    }
+
+    std::cout << "Results are written to " << option.outPath << "\n";
+    isFinished = true;
+  }
+
+private:
+  struct Result {
+    size_t nBlock = 0;
+    double meanUs = 0;
+    double p99Us = 0;
+    double maxUs = 0;
+    double realTimeFactor = 0;
+  };
+
+  std::string pluginName;
+  BenchPresetOption option;
+  Factory factory;
+  std::vector<nlohmann::json> presets;
+
+  template<typename T, typename = void> struct HasMidi : std::false_type {};
+  template<typename T>
+  struct HasMidi<
+    T,
+    std::void_t<decltype(std::declval<T &>().pushMidiNote(
+      true, uint32_t(0), int32_t(0), int16_t(0), 0.0f, 0.0f))>> : std::true_type {};
+
+  static std::vector<std::vector<float>> generateNoise(size_t nFrame)
+  {
+    std::minstd_rand rng{unsigned(26935804702)};
+    std::normal_distribution<float> dist{0.0f, 0.08333333333333333f};
+
+    std::vector<std::vector<float>> data(2);
+    for (auto &dt : data) dt.resize(nFrame);
+    for (size_t i = 0; i < nFrame; ++i) {
+      data[0][i] = std::clamp(dist(rng), -0.25f, 0.25f);
+      data[1][i] = std::clamp(dist(rng), -0.25f, 0.25f);
+    }
+    return data;
+  }
+
+  struct Note {
+    size_t frame;
+    bool isNoteOn;
+    int32_t id;
+    int16_t pitch;
+  };
+
+  // Arpeggio of 2 overlapping notes. A note starts every 0.25 seconds and lasts 0.5
+  // seconds. Sorted by frame.
+  static std::vector<Note> generateNotes(double sampleRate, size_t nFrame)
+  {
+    constexpr std::array<int16_t, 6> pitches{48, 55, 60, 64, 67, 72};
+    const auto interval = size_t(0.25 * sampleRate);
+
+    std::vector<Note> notes;
+    for (size_t i = 0; i * interval < nFrame; ++i) {
+      auto id = int32_t(i);
+      auto pitch = pitches[i % pitches.size()];
+      notes.push_back({i * interval, true, id, pitch});
+      notes.push_back({(i + 2) * interval, false, id, pitch});
+    }
+    std::stable_sort(notes.begin(), notes.end(), [](const Note &a, const Note &b) {
+      if (a.frame != b.frame) return a.frame < b.frame;
+      return !a.isNoteOn && b.isNoteOn;
+    });
+    return notes;
+  }
+
+  void processDsp(
+    size_t length,
+    size_t frame,
+    [[maybe_unused]] const std::vector<std::vector<float>> &input,
+    std::vector<std::vector<float>> &output,
+    std::unique_ptr<DSP_CLASS> &dsp)
+  {
+    auto out0 = output[0].data() + frame;
+    auto out1 = output[1].data() + frame;
+#if HAS_SIDECHAIN
+    auto in0 = input[0].data() + frame;
+    auto in1 = input[1].data() + frame;
+    dsp->process(length, in0, in1, in1, in0, out0, out1);
+#elif defined(HAS_INPUT)
+    dsp->process(length, input[0].data() + frame, input[1].data() + frame, out0, out1);
+#else
+    dsp->process(length, out0, out1);
+#endif
+  }
+
+  bool run(
+    const nlohmann::json &preset,
+    double sampleRate,
+    const BenchBlockSize &blockSize,
+    Result &result)
+  {
+    using Clock = std::chrono::steady_clock;
+
+    auto dsp = factory();
+    if (!dsp) {
+      std::cerr << "Error: Failed to create DSP. Instruction set may not be supported.\n";
+      return false;
+    }
+    dsp->setup(sampleRate);
+
+    applyPresetParameters(*dsp, preset["parameter"]);
+
+    constexpr double tempo = 120.0;
+    setTransport(*dsp, tempo, 0);
+    SET_PARAMETERS;
+    dsp->reset();
+
+    const auto nFrame = std::max(size_t(option.seconds * sampleRate), size_t(1));
+    const auto input = generateNoise(nFrame);
+    std::vector<std::vector<float>> output(2);
+    for (auto &channel : output) channel.resize(nFrame);
+    const auto notes = generateNotes(sampleRate, nFrame);
+
+    std::minstd_rand rng{unsigned(4130071)};
+    std::uniform_int_distribution<size_t> dist{1, BenchBlockSize::maxVariableSize};
+
+    std::vector<double> elapsed; // In microseconds.
+    elapsed.reserve(blockSize.isVariable() ? nFrame : nFrame / blockSize.size + 1);
+
+    size_t noteIndex = 0;
+    for (size_t frame = 0; frame < nFrame;) {
+      const size_t length
+        = std::min(blockSize.isVariable() ? dist(rng) : blockSize.size, nFrame - frame);
+
+      auto start = Clock::now();
+
+      setTransport(*dsp, tempo, double(frame) / sampleRate * tempo / 60.0);
+      SET_PARAMETERS;
+      if constexpr (HasMidi<DSP_CLASS>::value) {
+        for (; noteIndex < notes.size(); ++noteIndex) {
+          const auto &note = notes[noteIndex];
+          if (note.frame >= frame + length) break;
+          dsp->pushMidiNote(
+            note.isNoteOn, uint32_t(note.frame - frame), note.id, note.pitch, 0.0f,
+            0.8f);
+        }
+      }
+      processDsp(length, frame, input, output, dsp);
+
+      auto end = Clock::now();
+      elapsed.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+
+      frame += length;
+    }
+
+    auto isFinite = [](float value) { return std::isfinite(value); };
+    if (
+      !std::all_of(output[0].begin(), output[0].end(), isFinite)
+      || !std::all_of(output[1].begin(), output[1].end(), isFinite))
+    {
+      std::string name = preset["name"];
+      std::cerr << "Warning " << name << " at " << sampleRate << " Hz, block size "
+                << blockSize.label() << ": Non-finite value in output.\n";
+    }
+
+    double sum = 0;
+    for (const auto &value : elapsed) sum += value;
+
+    result.nBlock = elapsed.size();
+    result.meanUs = sum / double(elapsed.size());
+    result.maxUs = *std::max_element(elapsed.begin(), elapsed.end());
+    result.realTimeFactor = sum * 1e-6 / (double(nFrame) / sampleRate);
+
+    auto p99 = elapsed.begin() + size_t(0.99 * double(elapsed.size() - 1));
+    std::nth_element(elapsed.begin(), p99, elapsed.end());
+    result.p99Us = *p99;
+    return true;
+  }
+};
@@ -154,12 +154,11 @@ public:
   }
 };
 
-#ifdef __linux__
-template<typename DSP_IF, typename DSP_AVX512, typename DSP_AVX2, typename DSP_AVX>
-#else
-template<typename DSP_IF, typename DSP_AVX2, typename DSP_AVX>
-#endif
-class FxTesterSimdRuntimeDispatch : public TesterCommon {
+/**
+Calls `createDSPCore_*()` declared in `dspcore.hpp` of the plugin. So `dspcore.hpp`
+must be included before this header.
+*/
+template<typename DSP_IF> class FxTesterSimdRuntimeDispatch : public TesterCommon {
 public:
   FxTesterSimdRuntimeDispatch(
     std::string plugin_name,
@@ -179,16 +178,7 @@ public:
     queue = std::make_shared<PresetQueue>(plugin_name);
 
     for (size_t i = 0; i < n_thread; ++i) {
-#ifdef __linux__
-      std::thread th(
-        &FxTesterSimdRuntimeDispatch<
-          DSPInterface, DSP_AVX512, DSP_AVX2, DSP_AVX>::testSequence,
-        this, queue);
-#else
-      std::thread th(
-        &FxTesterSimdRuntimeDispatch<DSPInterface, DSP_AVX2, DSP_AVX>::testSequence, this,
-        queue);
-#endif
+      std::thread th(&FxTesterSimdRuntimeDispatch::testSequence, this, queue);
       threads.push_back(std::move(th));
     }
     for (auto &th : threads) th.join();
@@ -198,14 +188,17 @@ public:
 
   bool checkInstrset()
   {
+#if defined(__arm64__) || defined(__aarch64__)
+    return true;
+#else
     auto iset = instrset_detect();
 
-#ifdef __linux__
+  #ifdef __linux__
     if (iset >= 10) {
       std::cout << "AVX512 is selected.\n";
       return true;
     } else
-#endif
+  #endif
       if (iset >= 8)
     {
       std::cout << "AVX2 is selected.\n";
@@ -216,24 +209,23 @@ public:
     }
     std::cerr << "\nError: Instruction set AVX or later not supported on this computer";
     return false;
+#endif
   }
 
   std::unique_ptr<DSP_IF> setupDSP()
   {
+#if defined(__arm64__) || defined(__aarch64__)
+    return createDSPCore_FixedInstruction();
+#else
     auto iset = instrset_detect();
 
-#ifdef __linux__
-    if (iset >= 10) {
-      return std::make_unique<DSPCore_AVX512>();
-    } else
-#endif
-      if (iset >= 8)
-    {
-      return std::make_unique<DSPCore_AVX2>();
-    } else if (iset >= 7) {
-      return std::make_unique<DSPCore_AVX>();
-    }
+  #ifdef __linux__
+    if (iset >= 10) return createDSPCore_AVX512();
+  #endif
+    if (iset >= 8) return createDSPCore_AVX2();
+    if (iset >= 7) return createDSPCore_AVX();
     return nullptr;
+#endif
   }
 
   void render(
@@ -0,0 +1,269 @@
+// (c) 2022 Takamitsu Endo
+//
+// This file is part of Uhhyou Plugins.
+//
+// Uhhyou Plugins is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Uhhyou Plugins is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Uhhyou Plugins.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "../lib/ghc/fs_std.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+struct MidiNoteEvent {
+  double seconds;
+  bool isNoteOn;
+  int32_t id; // `channel * 128 + pitch`. Same as host without note ID.
+  int16_t pitch;
+  float velocity; // In [0, 1].
+};
+
+/**
+Reader of Standard MIDI File (SMF) format 0 and 1. Only note on/off and tempo change
+are used. All tracks are merged.
+
+Time is converted to seconds using the tempo map. SMPTE time division is also
+supported, in that case tempo changes don't affect time.
+*/
+class MidiFile {
+private:
+  struct TempoPoint {
+    uint64_t tick;
+    double seconds;
+    double secondsPerTick;
+  };
+
+  struct RawEvent {
+    uint64_t tick;
+    uint8_t status;
+    uint8_t data1;
+    uint8_t data2;
+    uint32_t tempo; // Micro seconds per quarter note. Only for tempo meta event.
+  };
+
+  uint16_t ticksPerQuarter = 480;
+  double smpteSecondsPerTick = 0; // Non zero when SMPTE time division is used.
+  std::vector<TempoPoint> tempoMap;
+
+  std::vector<uint8_t> bytes;
+  size_t pos = 0;
+
+  bool read(size_t size) { return pos + size <= bytes.size(); }
+
+  uint32_t readBigEndian(size_t size)
+  {
+    uint32_t value = 0;
+    for (size_t i = 0; i < size; ++i) value = (value << 8) | bytes[pos++];
+    return value;
+  }
+
+  bool readVariableLength(uint32_t &value)
+  {
+    value = 0;
+    for (size_t i = 0; i < 4; ++i) {
+      if (!read(1)) return false;
+      uint8_t byte = bytes[pos++];
+      value = (value << 7) | (byte & 0x7f);
+      if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+  }
+
+  bool fail(const std::string &message)
+  {
+    error = message;
+    return false;
+  }
+
+  bool readTrack(size_t trackEnd, std::vector<RawEvent> &events)
+  {
+    uint64_t tick = 0;
+    uint8_t runningStatus = 0;
+    while (pos < trackEnd) {
+      uint32_t delta;
+      if (!readVariableLength(delta)) return fail("Broken delta time.");
+      tick += delta;
+
+      if (!read(1)) return fail("Unexpected end of track.");
+      uint8_t status = bytes[pos];
+      if (status & 0x80) {
+        ++pos;
+      } else {
+        if (runningStatus == 0) return fail("Running status without status byte.");
+        status = runningStatus;
+      }
+
+      if (status == 0xff) { // Meta event.
+        if (!read(1)) return fail("Unexpected end of meta event.");
+        uint8_t type = bytes[pos++];
+        uint32_t length;
+        if (!readVariableLength(length) || !read(length))
+          return fail("Broken meta event.");
+        if (type == 0x51 && length == 3) {
+          events.push_back({tick, status, 0, 0, readBigEndian(3)});
+        } else {
+          pos += length;
+        }
+        if (type == 0x2f) break; // End of track.
+        continue;
+      }
+
+      if (status == 0xf0 || status == 0xf7) { // SysEx.
+        uint32_t length;
+        if (!readVariableLength(length) || !read(length)) return fail("Broken SysEx.");
+        pos += length;
+        continue;
+      }
+
+      if (status >= 0xf0) return fail("Unsupported system message in track.");
+
+      runningStatus = status;
+      uint8_t type = status & 0xf0;
+      size_t nData = (type == 0xc0 || type == 0xd0) ? 1 : 2;
+      if (!read(nData)) return fail("Unexpected end of channel message.");
+      uint8_t data1 = bytes[pos++];
+      uint8_t data2 = nData == 2 ? bytes[pos++] : 0;
+      if (type == 0x80 || type == 0x90) {
+        events.push_back({tick, status, data1, data2, 0});
+      }
+    }
+    pos = trackEnd;
+    return true;
+  }
+
+public:
+  std::string error;
+  std::vector<MidiNoteEvent> notes; // Sorted by time.
+
+  bool load(const fs::path &path)
+  {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs.is_open()) return fail("Failed to open file.");
+    bytes.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    pos = 0;
+
+    if (!read(14) || std::string(bytes.begin(), bytes.begin() + 4) != "MThd")
+      return fail("Not a Standard MIDI File.");
+    pos += 4;
+    uint32_t headerLength = readBigEndian(4);
+    if (headerLength < 6 || !read(headerLength)) return fail("Broken header.");
+    uint16_t format = uint16_t(readBigEndian(2));
+    uint16_t nTrack = uint16_t(readBigEndian(2));
+    uint16_t division = uint16_t(readBigEndian(2));
+    pos += headerLength - 6;
+
+    if (format > 1) return fail("SMF format 2 is not supported.");
+    if (division & 0x8000) {
+      auto framesPerSecond = double(-int8_t(division >> 8));
+      if (framesPerSecond == 29) framesPerSecond = 29.97;
+      auto ticksPerFrame = double(division & 0xff);
+      if (framesPerSecond <= 0 || ticksPerFrame <= 0) return fail("Broken division.");
+      smpteSecondsPerTick = 1.0 / (framesPerSecond * ticksPerFrame);
+    } else {
+      if (division == 0) return fail("Broken division.");
+      ticksPerQuarter = division;
+    }
+
+    std::vector<RawEvent> events;
+    for (uint16_t track = 0; track < nTrack; ++track) {
+      if (!read(8)) return fail("Unexpected end of file.");
+      bool isTrack = std::string(bytes.begin() + pos, bytes.begin() + pos + 4) == "MTrk";
+      pos += 4;
+      size_t length = readBigEndian(4);
+      if (!read(length)) return fail("Broken track length.");
+      if (!isTrack) { // Unknown chunk.
+        pos += length;
+        continue;
+      }
+      if (!readTrack(pos + length, events)) return false;
+    }
+    bytes.clear();
+
+    // Note off comes before note on at the same tick, to retrigger the same pitch.
+    auto isNoteOn = [](const RawEvent &ev) {
+      return (ev.status & 0xf0) == 0x90 && ev.data2 > 0;
+    };
+    std::stable_sort(
+      events.begin(), events.end(), [&](const RawEvent &a, const RawEvent &b) {
+        if (a.tick != b.tick) return a.tick < b.tick;
+        return !isNoteOn(a) && isNoteOn(b);
+      });
+
+    tempoMap.clear();
+    tempoMap.push_back({0, 0.0, secondsPerTick(500000)}); // 120 BPM default.
+    notes.clear();
+    for (const auto &ev : events) {
+      double seconds = tickToSeconds(ev.tick);
+      if (ev.status == 0xff) {
+        if (ev.tempo == 0) continue;
+        if (tempoMap.back().tick == ev.tick) tempoMap.pop_back();
+        tempoMap.push_back({ev.tick, seconds, secondsPerTick(ev.tempo)});
+        continue;
+      }
+      auto channel = int32_t(ev.status & 0x0f);
+      notes.push_back(
+        {seconds, isNoteOn(ev), channel * 128 + ev.data1, int16_t(ev.data1),
+         float(ev.data2) / 127.0f});
+    }
+    if (tempoMap.empty()) tempoMap.push_back({0, 0.0, secondsPerTick(500000)});
+    return true;
+  }
+
+  double secondsPerTick(uint32_t microSecondsPerQuarter) const
+  {
+    if (smpteSecondsPerTick > 0) return smpteSecondsPerTick;
+    return double(microSecondsPerQuarter) * 1e-6 / double(ticksPerQuarter);
+  }
+
+  double tickToSeconds(uint64_t tick) const
+  {
+    if (tempoMap.empty()) return 0;
+    auto it = std::upper_bound(
+      tempoMap.begin(), tempoMap.end(), tick,
+      [](uint64_t t, const TempoPoint &point) { return t < point.tick; });
+    const auto &point = *(it == tempoMap.begin() ? it : std::prev(it));
+    return point.seconds + double(tick - point.tick) * point.secondsPerTick;
+  }
+
+  const TempoPoint &tempoAt(double seconds) const
+  {
+    auto it = std::upper_bound(
+      tempoMap.begin(), tempoMap.end(), seconds,
+      [](double s, const TempoPoint &point) { return s < point.seconds; });
+    return *(it == tempoMap.begin() ? it : std::prev(it));
+  }
+
+  // Tempo in BPM at `seconds`.
+  double tempo(double seconds) const
+  {
+    if (tempoMap.empty()) return 120.0;
+    return 60.0 / (tempoAt(seconds).secondsPerTick * double(ticksPerQuarter));
+  }
+
+  // Position in quarter notes at `seconds`.
+  double beats(double seconds) const
+  {
+    if (tempoMap.empty()) return seconds * 2.0;
+    const auto &point = tempoAt(seconds);
+    double tick = double(point.tick) + (seconds - point.seconds) / point.secondsPerTick;
+    return tick / double(ticksPerQuarter);
+  }
+
+  double lastNoteSeconds() const { return notes.empty() ? 0.0 : notes.back().seconds; }
+};
@@ -0,0 +1,137 @@
+// (c) 2022 Takamitsu Endo
+//
+// This file is part of Uhhyou Plugins.
+//
+// Uhhyou Plugins is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Uhhyou Plugins is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Uhhyou Plugins.  If not, see <https://www.gnu.org/licenses/>.
+
+// Common parts of `batchrender.hpp` and `benchpreset.hpp`, which drive `DSPCore` with
+// the presets in `*.preset.json` in the same way as `PlugProcessor::process()`.
+
+#pragma once
+
+#include "../lib/ghc/fs_std.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#undef min
+#undef max
+
+#include "../lib/json.hpp"
+
+/**
+Parses command line options in the form of `--name value`. `handle(name, value)`
+returns an error message, or an empty string if the option is accepted. Number
+conversion in `handle` may throw.
+
+Returns false on `-h`, `--help` or any error. Caller prints usage in that case.
+*/
+template<typename Handler> bool parseOptionPairs(int argc, char *argv[], Handler handle)
+{
+  try {
+    for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      if (arg == "-h" || arg == "--help") return false;
+      if (i + 1 >= argc) {
+        std::cerr << "Error: Missing value for " << arg << "\n";
+        return false;
+      }
+
+      std::string error = handle(arg, std::string(argv[++i]));
+      if (!error.empty()) {
+        std::cerr << "Error: " << error << "\n";
+        return false;
+      }
+    }
+  } catch (const std::exception &) {
+    std::cerr << "Error: Invalid number in options.\n";
+    return false;
+  }
+  return true;
+}
+
+/**
+Reads presets from `path` into `presets`. If `names` is empty, all presets are read.
+Otherwise only the presets with matching names are read, in the order of the file.
+*/
+inline bool loadPresetJson(
+  const std::string &path,
+  const std::vector<std::string> &names,
+  std::vector<nlohmann::json> &presets)
+{
+  std::ifstream ifs(path);
+  if (!ifs.is_open()) {
+    std::cerr << "Error: Failed to open " << path << "\n";
+    return false;
+  }
+  auto data = nlohmann::json::parse(ifs, nullptr, false);
+  if (data.is_discarded() || !data.is_array()) {
+    std::cerr << "Error: Failed to parse " << path << "\n";
+    return false;
+  }
+
+  for (auto &preset : data) {
+    if (names.empty()) {
+      presets.push_back(preset);
+    } else if (std::find(names.begin(), names.end(), preset["name"]) != names.end()) {
+      presets.push_back(preset);
+    }
+  }
+  if (presets.empty()) {
+    std::cerr << "Error: No preset matched.\n";
+    return false;
+  }
+  return true;
+}
+
+// Sets `"parameter"` array of a preset to `dsp.param`.
+template<typename DSP_CLASS>
+void applyPresetParameters(DSP_CLASS &dsp, const nlohmann::json &parameters)
+{
+  size_t index = 0;
+  for (const auto &parameter : parameters) {
+    if (parameter["type"] == "I")
+      dsp.param.value[index]->setFromInt(parameter["value"]);
+    else if (parameter["type"] == "d")
+      dsp.param.value[index]->setFromNormalized(parameter["value"]);
+    ++index;
+  }
+}
+
+template<typename T, typename = void> struct HasTransport : std::false_type {};
+template<typename T>
+struct HasTransport<
+  T,
+  std::void_t<
+    decltype(std::declval<T &>().tempo),
+    decltype(std::declval<T &>().beatsElapsed),
+    decltype(std::declval<T &>().isPlaying)>> : std::true_type {};
+
+// Some `DSPCore` have public transport members, which are set from `ProcessContext`
+// in `PlugProcessor::process()`. Others take tempo from `SET_PARAMETERS`.
+template<typename DSP_CLASS>
+void setTransport(DSP_CLASS &core, double tempo, double beats)
+{
+  if constexpr (HasTransport<DSP_CLASS>::value) {
+    core.tempo = tempo;
+    core.beatsElapsed = beats;
+    core.isPlaying = true;
+  }
+}